@@ -0,0 +1,535 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <argp.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "nanocbor/nanocbor.h"
+#include "nanocbor/query.h"
+
+#define QUERY_ARGS_MAX 16
+#define THREADS_MAX 64
+#define SYNC_RECORDS 4 /**< Records parsed to accept a guessed boundary */
+
+static const struct argp_option cmdline_options[] = {
+    { "input", 'f', "input", 0, "Input CBOR sequence file", 0 },
+    { "where", 'w', "pred", 0,
+      "Predicate as 'path', 'path op value' with op one of == != < <= > >=, "
+      "repeatable",
+      0 },
+    { "select", 's', "path", 0, "Value to emit per record, repeatable", 0 },
+    { "aggregate", 'a', "func:path", 0,
+      "Aggregate with func one of count, sum, min, max, repeatable", 0 },
+    { "cbor", 'c', 0, 0, "Emit CBOR instead of text", 0 },
+    { "jobs", 'j', "threads", 0, "Number of threads", 0 },
+    { 0 },
+};
+
+typedef enum {
+    AGG_COUNT,
+    AGG_SUM,
+    AGG_MIN,
+    AGG_MAX,
+} agg_func_t;
+
+static const char *const _agg_names[] = { "count", "sum", "min", "max" };
+
+struct arguments {
+    char *input;
+    bool cbor;
+    unsigned jobs;
+    nanocbor_query_pred_t where[QUERY_ARGS_MAX];
+    size_t num_where;
+    const char *select[QUERY_ARGS_MAX];
+    size_t num_select;
+    nanocbor_query_agg_t aggs[QUERY_ARGS_MAX];
+    agg_func_t agg_funcs[QUERY_ARGS_MAX];
+    size_t num_aggs;
+};
+
+typedef struct {
+    nanocbor_query_t query;
+    nanocbor_query_agg_t aggs[QUERY_ARGS_MAX];
+    const uint8_t *start; /**< Guessed record boundary the part starts at */
+    const uint8_t *target; /**< Start of the next part */
+    const uint8_t *end; /**< First record boundary at or after target */
+    const uint8_t *buf_end;
+    char *out;
+    size_t out_len;
+    FILE *fp;
+    int res;
+} worker_t;
+
+static struct arguments _args = { .jobs = 1 };
+
+static const struct {
+    const char *token;
+    nanocbor_query_op_t op;
+} _ops[] = {
+    /* Two character operators first */
+    { "==", NANOCBOR_QUERY_EQ }, { "!=", NANOCBOR_QUERY_NE },
+    { "<=", NANOCBOR_QUERY_LE }, { ">=", NANOCBOR_QUERY_GE },
+    { "<", NANOCBOR_QUERY_LT },  { ">", NANOCBOR_QUERY_GT },
+};
+
+static int _parse_operand(nanocbor_query_pred_t *pred, char *value)
+{
+    char *end = NULL;
+
+    while (*value == ' ') {
+        value++;
+    }
+    size_t len = strlen(value);
+    if (len >= 2 && value[0] == '"' && value[len - 1] == '"') {
+        value[len - 1] = '\0';
+        pred->type = NANOCBOR_QUERY_TSTR;
+        pred->value.s = value + 1;
+        return 0;
+    }
+    errno = 0;
+    pred->type = NANOCBOR_QUERY_INT;
+    pred->value.i = strtoll(value, &end, 0);
+    if (*end == '\0' && end != value && errno == 0) {
+        return 0;
+    }
+    pred->type = NANOCBOR_QUERY_FLOAT;
+    pred->value.f = strtod(value, &end);
+    if (*end == '\0' && end != value) {
+        return 0;
+    }
+    return -1;
+}
+
+static int _parse_where(nanocbor_query_pred_t *pred, char *arg)
+{
+    pred->path = arg;
+    pred->op = NANOCBOR_QUERY_EXISTS;
+    for (size_t i = 0; i < sizeof(_ops) / sizeof(_ops[0]); i++) {
+        char *pos = strstr(arg, _ops[i].token);
+        if (pos) {
+            char *value = pos + strlen(_ops[i].token);
+            pred->op = _ops[i].op;
+            *pos = '\0';
+            /* Strip trailing spaces of the path */
+            while (pos > arg && pos[-1] == ' ') {
+                *--pos = '\0';
+            }
+            return _parse_operand(pred, value);
+        }
+    }
+    return 0;
+}
+
+static int _parse_aggregate(struct arguments *arguments, char *arg)
+{
+    char *sep = strchr(arg, ':');
+
+    if (!sep) {
+        return -1;
+    }
+    *sep = '\0';
+    for (size_t i = 0; i < sizeof(_agg_names) / sizeof(_agg_names[0]); i++) {
+        if (strcmp(arg, _agg_names[i]) == 0) {
+            arguments->agg_funcs[arguments->num_aggs] = (agg_func_t)i;
+            arguments->aggs[arguments->num_aggs].path = sep + 1;
+            arguments->num_aggs++;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static error_t _parse_opts(int key, char *arg, struct argp_state *state)
+{
+    struct arguments *arguments = state->input;
+    switch (key) {
+    case 'f':
+        arguments->input = arg;
+        break;
+    case 'c':
+        arguments->cbor = true;
+        break;
+    case 'j':
+        arguments->jobs = (unsigned)strtoul(arg, NULL, 0);
+        if (arguments->jobs == 0 || arguments->jobs > THREADS_MAX) {
+            argp_error(state, "Invalid number of threads");
+        }
+        break;
+    case 'w':
+        if (arguments->num_where == QUERY_ARGS_MAX
+            || _parse_where(&arguments->where[arguments->num_where], arg)
+                < 0) {
+            argp_error(state, "Invalid predicate");
+        }
+        arguments->num_where++;
+        break;
+    case 's':
+        if (arguments->num_select == QUERY_ARGS_MAX) {
+            argp_error(state, "Too many select paths");
+        }
+        arguments->select[arguments->num_select++] = arg;
+        break;
+    case 'a':
+        if (arguments->num_aggs == QUERY_ARGS_MAX
+            || _parse_aggregate(arguments, arg) < 0) {
+            argp_error(state, "Invalid aggregate");
+        }
+        break;
+    case ARGP_KEY_END:
+        if (!arguments->input) {
+            argp_usage(state);
+        }
+        break;
+    default:
+        return ARGP_ERR_UNKNOWN;
+    }
+    return 0;
+}
+
+static void _print_hex(FILE *fp, const uint8_t *buf, size_t len)
+{
+    fprintf(fp, "h'");
+    for (size_t i = 0; i < len; i++) {
+        fprintf(fp, "%.2x", buf[i]);
+    }
+    fprintf(fp, "'");
+}
+
+static void _print_value(FILE *fp, const nanocbor_value_t *value)
+{
+    nanocbor_value_t it = *value;
+    const uint8_t *buf = NULL;
+    size_t len = 0;
+    uint64_t u = 0;
+    int64_t i = 0;
+    double d = 0;
+    bool b = false;
+
+    if (nanocbor_at_end(&it)) {
+        fprintf(fp, "-");
+    }
+    else if (nanocbor_get_uint64(&it, &u) >= 0) {
+        fprintf(fp, "%" PRIu64, u);
+    }
+    else if (nanocbor_get_int64(&it, &i) >= 0) {
+        fprintf(fp, "%" PRIi64, i);
+    }
+    else if (nanocbor_get_double(&it, &d) >= 0) {
+        fprintf(fp, "%g", d);
+    }
+    else if (nanocbor_get_tstr(&it, &buf, &len) >= 0) {
+        fprintf(fp, "\"%.*s\"", (int)len, buf);
+    }
+    else if (nanocbor_get_bool(&it, &b) >= 0) {
+        fprintf(fp, b ? "true" : "false");
+    }
+    else if (nanocbor_get_null(&it) >= 0) {
+        fprintf(fp, "null");
+    }
+    else if (nanocbor_get_subcbor(&it, &buf, &len) >= 0) {
+        _print_hex(fp, buf, len);
+    }
+}
+
+static void _write_cbor(FILE *fp, const nanocbor_value_t *values,
+                        size_t num_values)
+{
+    uint8_t hdr[9];
+    nanocbor_encoder_t enc;
+
+    nanocbor_encoder_init(&enc, hdr, sizeof(hdr));
+    nanocbor_fmt_array(&enc, num_values);
+    fwrite(hdr, 1, nanocbor_encoded_len(&enc), fp);
+    for (size_t i = 0; i < num_values; i++) {
+        nanocbor_value_t it = values[i];
+        const uint8_t *buf = NULL;
+        size_t len = 0;
+        if (nanocbor_at_end(&it)) {
+            nanocbor_encoder_init(&enc, hdr, sizeof(hdr));
+            nanocbor_fmt_null(&enc);
+            fwrite(hdr, 1, nanocbor_encoded_len(&enc), fp);
+        }
+        else if (nanocbor_get_subcbor(&it, &buf, &len) >= 0) {
+            fwrite(buf, 1, len, fp);
+        }
+    }
+}
+
+static int _emit(void *ctx, const uint8_t *record, size_t record_len,
+                 const nanocbor_value_t *values, size_t num_values)
+{
+    FILE *fp = ctx;
+
+    if (num_values == 0) {
+        /* Matching record is copied to the output as is */
+        if (_args.cbor) {
+            fwrite(record, 1, record_len, fp);
+        }
+        else {
+            _print_hex(fp, record, record_len);
+            fprintf(fp, "\n");
+        }
+        return 0;
+    }
+    if (_args.cbor) {
+        _write_cbor(fp, values, num_values);
+        return 0;
+    }
+    for (size_t i = 0; i < num_values; i++) {
+        _print_value(fp, &values[i]);
+        fprintf(fp, i + 1 < num_values ? "\t" : "\n");
+    }
+    return 0;
+}
+
+static void _init_worker(worker_t *worker, const nanocbor_query_agg_t *aggs)
+{
+    memcpy(worker->aggs, aggs, sizeof(worker->aggs));
+    worker->query = (nanocbor_query_t) {
+        .where = _args.where,
+        .num_where = _args.num_where,
+        .select = _args.select,
+        .num_select = _args.num_select,
+        .aggs = worker->aggs,
+        .num_aggs = _args.num_aggs,
+    };
+    worker->out = NULL;
+    worker->out_len = 0;
+    worker->res = 0;
+}
+
+static void *_run_worker(void *arg)
+{
+    worker_t *worker = arg;
+    nanocbor_value_t it;
+    bool emit = _args.num_select > 0 || _args.num_aggs == 0;
+
+    /* The part runs up to the first record boundary at or after the start
+     * of the next part. A decode error extends the part to the end of the
+     * buffer, for the query to report it */
+    nanocbor_decoder_init(&it, worker->start,
+                          (size_t)(worker->buf_end - worker->start));
+    while (it.cur < worker->target && !nanocbor_at_end(&it)) {
+        if (nanocbor_skip(&it) < 0) {
+            it.cur = worker->buf_end;
+            break;
+        }
+    }
+    worker->end = it.cur;
+
+    nanocbor_decoder_init(&it, worker->start,
+                          (size_t)(worker->end - worker->start));
+    worker->fp = open_memstream(&worker->out, &worker->out_len);
+    if (!worker->fp) {
+        worker->res = -1;
+        return NULL;
+    }
+    worker->res = nanocbor_query_run(&worker->query, &it, emit ? _emit : NULL,
+                                     worker->fp);
+    fclose(worker->fp);
+    return NULL;
+}
+
+/* Guesses the first record boundary at or after @p offset. The records of a
+ * sequence usually share their major type, a position is taken when it
+ * starts a few well-formed records of the type of the first record */
+static size_t _sync_point(const uint8_t *buf, size_t len, size_t offset)
+{
+    for (size_t pos = offset; pos < len; pos++) {
+        nanocbor_value_t it;
+        int res = NANOCBOR_OK;
+
+        if ((buf[pos] & NANOCBOR_TYPE_MASK) != (buf[0] & NANOCBOR_TYPE_MASK)) {
+            continue;
+        }
+        nanocbor_decoder_init(&it, buf + pos, len - pos);
+        for (unsigned i = 0; i < SYNC_RECORDS && !nanocbor_at_end(&it); i++) {
+            res = nanocbor_skip(&it);
+            if (res < 0) {
+                break;
+            }
+        }
+        if (res == NANOCBOR_OK) {
+            return pos;
+        }
+    }
+    return len;
+}
+
+/* Splits the sequence into parts of similar size at guessed record
+ * boundaries, the guesses are checked once the previous part is done */
+static void _split(const uint8_t *buf, size_t len, worker_t *workers,
+                   unsigned jobs)
+{
+    workers[0].start = buf;
+    for (unsigned i = 1; i < jobs; i++) {
+        size_t prev = (size_t)(workers[i - 1].start - buf);
+        size_t start = _sync_point(buf, len, len / jobs * i);
+        workers[i].start = buf + (start < prev ? prev : start);
+    }
+    for (unsigned i = 0; i < jobs; i++) {
+        workers[i].target = i + 1 < jobs ? workers[i + 1].start : buf + len;
+        workers[i].buf_end = buf + len;
+    }
+}
+
+static bool _file_fits(nanocbor_encoder_t *enc, void *ctx, size_t len)
+{
+    (void)enc;
+    (void)ctx;
+    (void)len;
+    return true;
+}
+
+static void _file_append(nanocbor_encoder_t *enc, void *ctx,
+                         const uint8_t *data, size_t len)
+{
+    (void)enc;
+    fwrite(data, 1, len, ctx);
+}
+
+/* Writes the aggregates as a trailing item of the output sequence, an array
+ * of [function, path, value] arrays */
+static void _write_aggregates(FILE *fp)
+{
+    nanocbor_encoder_t enc;
+
+    nanocbor_encoder_stream_init(&enc, fp, _file_append, _file_fits);
+    nanocbor_fmt_array(&enc, _args.num_aggs);
+    for (size_t i = 0; i < _args.num_aggs; i++) {
+        const nanocbor_query_agg_t *agg = &_args.aggs[i];
+        nanocbor_fmt_array(&enc, 3);
+        nanocbor_put_tstr(&enc, _agg_names[_args.agg_funcs[i]]);
+        nanocbor_put_tstr(&enc, agg->path);
+        switch (_args.agg_funcs[i]) {
+        case AGG_COUNT:
+            nanocbor_fmt_uint(&enc, agg->count);
+            break;
+        case AGG_SUM:
+            nanocbor_fmt_double(&enc, agg->sum);
+            break;
+        case AGG_MIN:
+            agg->numeric ? nanocbor_fmt_double(&enc, agg->min)
+                         : nanocbor_fmt_null(&enc);
+            break;
+        case AGG_MAX:
+            agg->numeric ? nanocbor_fmt_double(&enc, agg->max)
+                         : nanocbor_fmt_null(&enc);
+            break;
+        }
+    }
+}
+
+static void _print_aggregates(void)
+{
+    if (_args.cbor) {
+        if (_args.num_aggs > 0) {
+            _write_aggregates(stdout);
+        }
+        return;
+    }
+    for (size_t i = 0; i < _args.num_aggs; i++) {
+        const nanocbor_query_agg_t *agg = &_args.aggs[i];
+        printf("%s(%s)\t", _agg_names[_args.agg_funcs[i]], agg->path);
+        switch (_args.agg_funcs[i]) {
+        case AGG_COUNT:
+            printf("%" PRIu64 "\n", agg->count);
+            break;
+        case AGG_SUM:
+            printf("%g\n", agg->sum);
+            break;
+        case AGG_MIN:
+            agg->numeric ? printf("%g\n", agg->min) : printf("-\n");
+            break;
+        case AGG_MAX:
+            agg->numeric ? printf("%g\n", agg->max) : printf("-\n");
+            break;
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    static worker_t workers[THREADS_MAX];
+    static pthread_t threads[THREADS_MAX];
+    struct argp arg_parse
+        = { cmdline_options, _parse_opts, NULL, NULL, NULL, NULL, NULL };
+    struct stat st;
+    const uint8_t *buf = NULL;
+    int res = 0;
+
+    argp_parse(&arg_parse, argc, argv, 0, 0, &_args);
+
+    int fd = open(_args.input, O_RDONLY | O_CLOEXEC);
+    if (fd < 0 || fstat(fd, &st) < 0) {
+        perror(_args.input);
+        return 1;
+    }
+    if (st.st_size > 0) {
+        buf = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (buf == MAP_FAILED) {
+            perror("mmap");
+            return 1;
+        }
+    }
+    close(fd);
+
+    /* Aggregates are merged into _args.aggs, parts start from a copy */
+    nanocbor_query_agg_t aggs[QUERY_ARGS_MAX];
+    memcpy(aggs, _args.aggs, sizeof(aggs));
+    unsigned parts = st.st_size > 0 ? _args.jobs : 1;
+    _split(buf, (size_t)st.st_size, workers, parts);
+    for (unsigned i = 0; i < parts; i++) {
+        worker_t *worker = &workers[i];
+        _init_worker(worker, aggs);
+        if (pthread_create(&threads[i], NULL, _run_worker, worker) != 0) {
+            perror("pthread_create");
+            return 1;
+        }
+    }
+
+    /* Output is written in sequence order once all parts are done */
+    const uint8_t *boundary = buf;
+    for (unsigned i = 0; i < parts; i++) {
+        worker_t *worker = &workers[i];
+        pthread_join(threads[i], NULL);
+        if (worker->start != boundary) {
+            /* Wrong guess, run the part again from where the previous part
+             * ended */
+            free(worker->out);
+            _init_worker(worker, aggs);
+            worker->start = boundary;
+            _run_worker(worker);
+        }
+        boundary = worker->end;
+        if (worker->out) {
+            fwrite(worker->out, 1, worker->out_len, stdout);
+            free(worker->out);
+        }
+        for (size_t j = 0; j < _args.num_aggs; j++) {
+            nanocbor_query_agg_merge(&_args.aggs[j], &worker->aggs[j]);
+        }
+        if (worker->res < 0 && res == 0) {
+            fprintf(stderr, "Query failed: %d\n", worker->res);
+            res = 1;
+        }
+    }
+    _print_aggregates();
+
+    if (buf) {
+        munmap((void *)buf, (size_t)st.st_size);
+    }
+    return res;
+}
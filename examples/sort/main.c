@@ -0,0 +1,225 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <argp.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "nanocbor/nanocbor.h"
+#include "nanocbor/sort.h"
+
+#define RUN_RECORDS_DEFAULT (1U << 20)
+#define RUNS_MAX 1024
+
+static const struct argp_option cmdline_options[] = {
+    { "input", 'f', "input", 0, "Input CBOR sequence file", 0 },
+    { "output", 'o', "output", 0, "Output file, - for stdout", 0 },
+    { "key", 'k', "path", 0, "Path of the sort key", 0 },
+    { "records", 'n', "records", 0,
+      "Number of records sorted in memory per run", 0 },
+    { 0 },
+};
+
+struct arguments {
+    char *input;
+    char *output;
+    char *key;
+    size_t records;
+};
+
+typedef struct {
+    FILE *fp;
+    const uint8_t *buf;
+    size_t len;
+} run_file_t;
+
+static struct arguments _args = { .output = "-",
+                                  .key = "",
+                                  .records = RUN_RECORDS_DEFAULT };
+
+static error_t _parse_opts(int key, char *arg, struct argp_state *state)
+{
+    struct arguments *arguments = state->input;
+    switch (key) {
+    case 'f':
+        arguments->input = arg;
+        break;
+    case 'o':
+        arguments->output = arg;
+        break;
+    case 'k':
+        arguments->key = arg;
+        break;
+    case 'n':
+        arguments->records = strtoul(arg, NULL, 0);
+        if (arguments->records == 0) {
+            argp_error(state, "Invalid number of records");
+        }
+        break;
+    case ARGP_KEY_END:
+        if (!arguments->input) {
+            argp_usage(state);
+        }
+        break;
+    default:
+        return ARGP_ERR_UNKNOWN;
+    }
+    return 0;
+}
+
+static const uint8_t *_map_file(int fd, size_t *len)
+{
+    struct stat st;
+
+    if (fstat(fd, &st) < 0) {
+        return NULL;
+    }
+    *len = (size_t)st.st_size;
+    if (*len == 0) {
+        return (const uint8_t *)"";
+    }
+    void *buf = mmap(NULL, *len, PROT_READ, MAP_PRIVATE, fd, 0);
+    return buf == MAP_FAILED ? NULL : buf;
+}
+
+static int _write_record(void *ctx, const uint8_t *record, size_t len)
+{
+    FILE *fp = ctx;
+    return fwrite(record, 1, len, fp) == len ? 0 : -1;
+}
+
+static int _write_run(FILE *fp, const nanocbor_sort_entry_t *entries,
+                      size_t num_entries)
+{
+    for (size_t i = 0; i < num_entries; i++) {
+        if (_write_record(fp, entries[i].record, entries[i].len) < 0) {
+            return -1;
+        }
+    }
+    return fflush(fp);
+}
+
+/* Sorts the input into runs of bounded size, returns the number of runs */
+static int _create_runs(const uint8_t *buf, size_t len, FILE *out,
+                        run_file_t *files)
+{
+    nanocbor_sort_entry_t *entries = calloc(_args.records, sizeof(*entries));
+    nanocbor_value_t it;
+    int num_runs = 0;
+
+    if (!entries) {
+        return -1;
+    }
+    nanocbor_decoder_init(&it, buf, len);
+    do {
+        size_t num = _args.records;
+        int res = nanocbor_sort_collect(&it, _args.key, entries, &num);
+        if (res < 0) {
+            fprintf(stderr, "Invalid input: %d\n", res);
+            num_runs = -1;
+            break;
+        }
+        nanocbor_sort_entries(entries, num);
+
+        /* Everything fits in a single run, no merge needed */
+        if (num_runs == 0 && nanocbor_at_end(&it)) {
+            num_runs = _write_run(out, entries, num) < 0 ? -1 : 0;
+            break;
+        }
+        if (num_runs == RUNS_MAX) {
+            fprintf(stderr, "Too many runs, increase the run size\n");
+            num_runs = -1;
+            break;
+        }
+        files[num_runs].fp = tmpfile();
+        if (!files[num_runs].fp
+            || _write_run(files[num_runs].fp, entries, num) < 0) {
+            perror("run");
+            num_runs = -1;
+            break;
+        }
+        num_runs++;
+    } while (!nanocbor_at_end(&it));
+
+    free(entries);
+    return num_runs;
+}
+
+static int _merge_runs(run_file_t *files, int num_runs, FILE *out)
+{
+    nanocbor_sort_run_t *runs = calloc((size_t)num_runs, sizeof(*runs));
+    int res = 0;
+
+    if (!runs) {
+        return -1;
+    }
+    for (int i = 0; i < num_runs; i++) {
+        files[i].buf = _map_file(fileno(files[i].fp), &files[i].len);
+        if (!files[i].buf) {
+            perror("mmap");
+            res = -1;
+            break;
+        }
+        nanocbor_decoder_init(&runs[i].it, files[i].buf, files[i].len);
+    }
+    if (res == 0) {
+        res = nanocbor_sort_merge(runs, (size_t)num_runs, _args.key,
+                                  _write_record, out);
+    }
+    for (int i = 0; i < num_runs; i++) {
+        if (files[i].buf && files[i].len > 0) {
+            munmap((void *)files[i].buf, files[i].len);
+        }
+        fclose(files[i].fp);
+    }
+    free(runs);
+    return res;
+}
+
+int main(int argc, char *argv[])
+{
+    static run_file_t files[RUNS_MAX];
+    struct argp arg_parse
+        = { cmdline_options, _parse_opts, NULL, NULL, NULL, NULL, NULL };
+    size_t len = 0;
+    FILE *out = stdout;
+
+    argp_parse(&arg_parse, argc, argv, 0, 0, &_args);
+
+    int fd = open(_args.input, O_RDONLY | O_CLOEXEC);
+    const uint8_t *buf = fd < 0 ? NULL : _map_file(fd, &len);
+    if (!buf) {
+        perror(_args.input);
+        return 1;
+    }
+    close(fd);
+
+    if (strcmp(_args.output, "-") != 0) {
+        out = fopen(_args.output, "wbe");
+        if (!out) {
+            perror(_args.output);
+            return 1;
+        }
+    }
+
+    int num_runs = _create_runs(buf, len, out, files);
+    int res = num_runs;
+    if (num_runs > 0) {
+        res = _merge_runs(files, num_runs, out);
+    }
+    if (fclose(out) != 0) {
+        res = -1;
+    }
+    if (len > 0) {
+        munmap((void *)buf, len);
+    }
+    return res < 0 ? 1 : 0;
+}
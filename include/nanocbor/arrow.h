@@ -0,0 +1,141 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @defgroup    nanocbor_arrow NanoCBOR Arrow export
+ * @brief       Columnar export of query results to the Arrow C Data Interface
+ *
+ * Exports the projected values of the records matching a query as a struct
+ * array of the Arrow C Data Interface, with a child array per select path.
+ * Consumers such as analytics engines import the arrays without depending on
+ * NanoCBOR or linking an Arrow library.
+ *
+ * Integer and floating point values are decoded directly into the value
+ * buffers of their columns. String columns are either copied into a data
+ * buffer with offsets, or exported as string views that reference the bytes
+ * in the CBOR input. Views of strings longer than 12 bytes point into the
+ * input buffer, which must then stay valid until the array is released.
+ *
+ * A missing value, or a value that does not convert to the column type, is
+ * exported as null. Tags are skipped.
+ *
+ * @{
+ *
+ * @file
+ */
+
+#ifndef NANOCBOR_ARROW_H
+#define NANOCBOR_ARROW_H
+
+#include <stdint.h>
+
+#include "nanocbor/config.h"
+#include "nanocbor/nanocbor.h"
+#include "nanocbor/query.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+/**
+ * @name Arrow C Data Interface
+ *
+ * Definitions as specified by the Arrow C Data Interface
+ * @{
+ */
+#define ARROW_FLAG_DICTIONARY_ORDERED 1 /**< Dictionary is ordered */
+#define ARROW_FLAG_NULLABLE 2 /**< Field is nullable */
+#define ARROW_FLAG_MAP_KEYS_SORTED 4 /**< Map keys are sorted */
+
+/**
+ * @brief Arrow type description
+ */
+struct ArrowSchema {
+    const char *format; /**< Type format string */
+    const char *name; /**< Field name */
+    const char *metadata; /**< Binary metadata, NULL if none */
+    int64_t flags; /**< ARROW_FLAG_* flags */
+    int64_t n_children; /**< Number of children */
+    struct ArrowSchema **children; /**< Child types */
+    struct ArrowSchema *dictionary; /**< Dictionary type, NULL if none */
+    void (*release)(struct ArrowSchema *); /**< Release callback */
+    void *private_data; /**< Producer data */
+};
+
+/**
+ * @brief Arrow array data
+ */
+struct ArrowArray {
+    int64_t length; /**< Number of elements */
+    int64_t null_count; /**< Number of null elements */
+    int64_t offset; /**< Offset of the first element in the buffers */
+    int64_t n_buffers; /**< Number of buffers */
+    int64_t n_children; /**< Number of children */
+    const void **buffers; /**< Buffers */
+    struct ArrowArray **children; /**< Child arrays */
+    struct ArrowArray *dictionary; /**< Dictionary array, NULL if none */
+    void (*release)(struct ArrowArray *); /**< Release callback */
+    void *private_data; /**< Producer data */
+};
+/** @} */
+
+#endif /* ARROW_C_DATA_INTERFACE */
+
+/**
+ * @brief Arrow column types
+ */
+typedef enum {
+    NANOCBOR_ARROW_INT64, /**< 64 bit integer, from integers */
+    NANOCBOR_ARROW_DOUBLE, /**< Double, from integers and floats */
+    NANOCBOR_ARROW_UTF8, /**< Copied string, from text strings */
+    NANOCBOR_ARROW_BINARY, /**< Copied binary, from byte strings */
+    NANOCBOR_ARROW_UTF8_VIEW, /**< String view, from text strings */
+    NANOCBOR_ARROW_BINARY_VIEW, /**< Binary view, from byte strings */
+} nanocbor_arrow_type_t;
+
+/**
+ * @brief Arrow column of a select path
+ */
+typedef struct {
+    const char *name; /**< Field name, NULL to use the select path */
+    nanocbor_arrow_type_t type; /**< Column type */
+} nanocbor_arrow_column_t;
+
+/**
+ * @brief Export the projected values of all remaining records of a CBOR
+ *        sequence as Arrow arrays
+ *
+ * The aggregates of @p query are updated as with @ref nanocbor_query_run.
+ * Both @p array and @p schema must be released with their release callback.
+ *
+ * @param[in]   query   Query with a select path per column
+ * @param[in]   columns Columns of the select paths of @p query
+ * @param[in]   it      Decoder positioned at the first record
+ * @param[out]  array   Struct array with a child per column, untouched on
+ *                      errors
+ * @param[out]  schema  Struct type with a field per column, untouched on
+ *                      errors
+ *
+ * @return              NANOCBOR_OK when all records are exported
+ * @return              NANOCBOR_ERR_INVALID_TYPE on an invalid path or
+ *                      column type
+ * @return              NANOCBOR_ERR_OVERFLOW on too many select paths, when
+ *                      allocating failed or when a column or the input
+ *                      exceeds the 32 bit offsets of Arrow
+ * @return              negative on decode errors
+ */
+int nanocbor_arrow_export(const nanocbor_query_t *query,
+                          const nanocbor_arrow_column_t *columns,
+                          nanocbor_value_t *it, struct ArrowArray *array,
+                          struct ArrowSchema *schema);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NANOCBOR_ARROW_H */
+/** @} */
@@ -0,0 +1,110 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @defgroup    nanocbor_base64 NanoCBOR base64 input
+ * @brief       Decoding of base64 and base64url encoded CBOR
+ *
+ * Decodes CBOR received as base64 or base64url text, as in HTTP headers or
+ * JSON envelopes, into the buffer read by the decoder. The text is fed in
+ * chunks as it arrives from the transport, so it does not have to be stored
+ * as a whole. The output may overlap the text, which allows decoding in
+ * place with @ref nanocbor_decoder_init_base64 without a scratch buffer.
+ *
+ * Both alphabets are accepted and padding is optional. Whitespace and other
+ * characters are rejected.
+ *
+ * @{
+ *
+ * @file
+ */
+
+#ifndef NANOCBOR_BASE64_H
+#define NANOCBOR_BASE64_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "nanocbor/config.h"
+#include "nanocbor/nanocbor.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Base64 decoder state
+ */
+typedef struct {
+    uint8_t *out; /**< Output buffer */
+    size_t len; /**< Number of decoded bytes */
+    size_t max_len; /**< Size of the output buffer */
+    uint32_t bits; /**< Pending bits of an incomplete quantum */
+    uint8_t num; /**< Number of pending characters */
+    uint8_t pad; /**< Number of padding characters still allowed */
+    bool padded; /**< Whether padding ended the text */
+} nanocbor_base64_t;
+
+/**
+ * @brief Initialize a base64 decoder
+ *
+ * The output may be the buffer holding the text when every chunk starts at
+ * or after the position of the next decoded byte, as is the case for text
+ * decoded in place from the start of @p out.
+ *
+ * @param[out]  b64     Decoder state
+ * @param[in]   out     Output buffer for the decoded CBOR
+ * @param[in]   len     Size of @p out, three quarters of the text length
+ *                      suffices
+ */
+void nanocbor_base64_init(nanocbor_base64_t *b64, uint8_t *out, size_t len);
+
+/**
+ * @brief Decode a chunk of text
+ *
+ * @param[in]   b64     Decoder state
+ * @param[in]   text    Chunk of base64 or base64url text
+ * @param[in]   len     Length of @p text
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              NANOCBOR_ERR_INVALID_TYPE on an invalid character
+ *                      or misplaced padding
+ * @return              NANOCBOR_ERR_END when the output buffer is full
+ */
+int nanocbor_base64_update(nanocbor_base64_t *b64, const char *text,
+                           size_t len);
+
+/**
+ * @brief Finish decoding and initialize a decoder on the decoded CBOR
+ *
+ * @param[in]   b64     Decoder state
+ * @param[out]  value   Decoder for the decoded CBOR
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              NANOCBOR_ERR_INVALID_TYPE on a truncated text
+ * @return              NANOCBOR_ERR_END when the output buffer is full
+ */
+int nanocbor_base64_finish(nanocbor_base64_t *b64, nanocbor_value_t *value);
+
+/**
+ * @brief Decode base64 or base64url text in place and initialize a decoder
+ *        on the result
+ *
+ * @param[out]  value   Decoder for the decoded CBOR
+ * @param[in]   buf     Buffer with the text, overwritten with the CBOR
+ * @param[in]   len     Length of the text
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              NANOCBOR_ERR_INVALID_TYPE on invalid text
+ */
+int nanocbor_decoder_init_base64(nanocbor_value_t *value, uint8_t *buf,
+                                 size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NANOCBOR_BASE64_H */
+/** @} */
@@ -29,6 +29,100 @@ extern "C" {
 #define NANOCBOR_RECURSION_MAX 10
 #endif
 
+/**
+ * @brief Maximum number of rules in a schema compiled with
+ *        @ref nanocbor_schema_compile
+ */
+#ifndef NANOCBOR_SCHEMA_RULES_MAX
+#define NANOCBOR_SCHEMA_RULES_MAX 16
+#endif
+
+/**
+ * @brief Maximum number of projected values of a query run with
+ *        @ref nanocbor_query_run
+ */
+#ifndef NANOCBOR_QUERY_SELECT_MAX
+#define NANOCBOR_QUERY_SELECT_MAX 16
+#endif
+
+/**
+ * @brief Maximum number of rules of a transform run with
+ *        @ref nanocbor_transform
+ */
+#ifndef NANOCBOR_TRANSFORM_RULES_MAX
+#define NANOCBOR_TRANSFORM_RULES_MAX 16
+#endif
+
+/**
+ * @brief Enables the multithreaded walker and indexer, requires POSIX
+ *        threads
+ */
+#ifndef NANOCBOR_WALK_PARALLEL
+#define NANOCBOR_WALK_PARALLEL 0
+#endif
+
+/**
+ * @brief Enables the double-buffered encoder sink
+ */
+#ifndef NANOCBOR_SINK
+#define NANOCBOR_SINK 0
+#endif
+
+/**
+ * @brief Enables the I/O thread of the double-buffered encoder sink,
+ *        requires POSIX threads
+ */
+#ifndef NANOCBOR_SINK_THREAD
+#define NANOCBOR_SINK_THREAD NANOCBOR_WALK_PARALLEL
+#endif
+
+/**
+ * @brief Maximum number of threads of the multithreaded walker and indexer
+ */
+#ifndef NANOCBOR_WALK_THREADS_MAX
+#define NANOCBOR_WALK_THREADS_MAX 64
+#endif
+
+/**
+ * @brief Enables the memory-mapped file encoder target, requires POSIX
+ *        `mmap` and `ftruncate`
+ */
+#ifndef NANOCBOR_ENCODER_MMAP
+#define NANOCBOR_ENCODER_MMAP 0
+#endif
+
+/**
+ * @brief Default number of bytes by which the memory-mapped file encoder
+ *        target grows its file
+ */
+#ifndef NANOCBOR_MMAP_STEP
+#define NANOCBOR_MMAP_STEP (64UL * 1024UL * 1024UL)
+#endif
+
+/**
+ * @brief Maximum size of a string payload combined with its header into a
+ *        single append call on the stack
+ */
+#ifndef NANOCBOR_ENCODER_STAGING_SIZE
+#define NANOCBOR_ENCODER_STAGING_SIZE 32
+#endif
+
+/**
+ * @brief Number of recorded sizes after which the size history of a
+ *        @ref nanocbor_pool message type is halved
+ */
+#ifndef NANOCBOR_POOL_HISTORY
+#define NANOCBOR_POOL_HISTORY 256
+#endif
+
+/**
+ * @brief Quantile of the recorded sizes, in per mille, used to size the
+ *        buffers of a @ref nanocbor_pool
+ */
+#ifndef NANOCBOR_POOL_QUANTILE
+#define NANOCBOR_POOL_QUANTILE 990
+#endif
+
 /**
  * @brief library providing htonll, be64toh or equivalent. Must also provide
  * the reverse operation (ntohll, htobe64 or equivalent)
@@ -64,6 +158,66 @@ extern "C" {
 #define NANOCBOR_HTOBE32_FUNC(he) htobe32(he)
 #endif
 
+/**
+ * @brief Tag number used for delta encoded integer arrays
+ *
+ * This is an application specific tag from the first come first served range
+ * and not registered with IANA, all peers must agree on the value.
+ */
+#ifndef NANOCBOR_TAG_DELTA_ARRAY
+#define NANOCBOR_TAG_DELTA_ARRAY (0xDE1AU)
+#endif
+
+/**
+ * @brief Tag numbers used for the blocks and index items of a log
+ *
+ * Application specific tags from the first come first served range, not
+ * registered with IANA.
+ */
+#ifndef NANOCBOR_TAG_LOG_BLOCK
+#define NANOCBOR_TAG_LOG_BLOCK (0xDE1BU)
+#endif
+#ifndef NANOCBOR_TAG_LOG_INDEX
+#define NANOCBOR_TAG_LOG_INDEX (0xDE1CU)
+#endif
+
+/**
+ * @brief Number of log blocks covered by a single log index item
+ */
+#ifndef NANOCBOR_LOG_INDEX_INTERVAL
+#define NANOCBOR_LOG_INDEX_INTERVAL 16
+#endif
+
+/**
+ * @brief Tag numbers used for the references and update records of a session
+ *        dictionary
+ *
+ * Application specific tags from the first come first served range, not
+ * registered with IANA. A tag below 256 shortens every reference by a byte.
+ */
+#ifndef NANOCBOR_TAG_DICT_REF
+#define NANOCBOR_TAG_DICT_REF (0xDE1DU)
+#endif
+#ifndef NANOCBOR_TAG_DICT_UPDATE
+#define NANOCBOR_TAG_DICT_UPDATE (0xDE1EU)
+#endif
+
+/**
+ * @brief Number of occurrence counters used by a session dictionary to learn
+ *        frequent strings
+ */
+#ifndef NANOCBOR_DICT_CANDIDATES
+#define NANOCBOR_DICT_CANDIDATES 64
+#endif
+
+/**
+ * @brief Number of occurrences after which a session dictionary learns a
+ *        string
+ */
+#ifndef NANOCBOR_DICT_THRESHOLD
+#define NANOCBOR_DICT_THRESHOLD 3
+#endif
+
 /**
  * @brief configuration for size_t SIZE_MAX equivalent
  */
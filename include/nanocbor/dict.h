@@ -0,0 +1,215 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @defgroup    nanocbor_dict NanoCBOR session dictionary
+ * @brief       Shared string dictionary across the messages of a session
+ *
+ * A session dictionary replaces strings that recur across the messages of a
+ * long-lived CBOR sequence with short references. The encoder and the
+ * decoder of a session each keep a dictionary, which stay identical as long
+ * as every message is delivered in order.
+ *
+ * The encoder counts the occurrences of the strings written through it and
+ * learns a string once it occurred @ref NANOCBOR_DICT_THRESHOLD times, as
+ * long as a reference is shorter than the string. Learned strings are
+ * announced by @ref nanocbor_dict_fmt_update in an update record at the start
+ * of the next message, after which they are written as references. A string
+ * that was not learned is written as is.
+ *
+ * An update record is tagged with @ref NANOCBOR_TAG_DICT_UPDATE and holds an
+ * array with the index of the first new entry followed by the new strings.
+ * A reference is the index of an entry tagged with
+ * @ref NANOCBOR_TAG_DICT_REF.
+ *
+ * The decoder copies the announced strings into its dictionary, and
+ * references resolve to the copies without further copying. Strings are
+ * never evicted, the dictionary stops learning when it is full.
+ *
+ * Keys and values are written and read with the same functions. The
+ * dictionary state changes with every call, so sizing an encoding with a
+ * NULL buffer must use a copy of the dictionary.
+ *
+ * @{
+ *
+ * @file
+ */
+
+#ifndef NANOCBOR_DICT_H
+#define NANOCBOR_DICT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "nanocbor/config.h"
+#include "nanocbor/nanocbor.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Dictionary entry
+ */
+typedef struct {
+    const uint8_t *str; /**< String stored in the dictionary */
+    size_t len; /**< Length of @p str */
+    uint32_t hash; /**< Hash of the type and the string */
+    uint8_t type; /**< NANOCBOR_TYPE_TSTR or NANOCBOR_TYPE_BSTR */
+} nanocbor_dict_entry_t;
+
+/**
+ * @brief Occurrence counter of a string not yet learned
+ */
+typedef struct {
+    uint32_t hash; /**< Hash of the counted string */
+    uint32_t count; /**< Number of occurrences */
+} nanocbor_dict_candidate_t;
+
+/**
+ * @brief Session dictionary
+ */
+typedef struct {
+    nanocbor_dict_entry_t *entries; /**< Entries */
+    size_t max_entries; /**< Capacity of @p entries */
+    size_t num_entries; /**< Number of entries */
+    size_t announced; /**< Entries known to the peer, the remainder is
+                           announced by the next update record */
+    uint8_t *arena; /**< Storage for the strings of the entries */
+    size_t arena_size; /**< Size of @p arena */
+    size_t arena_used; /**< Bytes in use of @p arena */
+    /** Occurrence counters, indexed by hash */
+    nanocbor_dict_candidate_t candidates[NANOCBOR_DICT_CANDIDATES];
+} nanocbor_dict_t;
+
+/**
+ * @brief Initialize an empty session dictionary
+ *
+ * @param[out]  dict        Dictionary to initialize
+ * @param[in]   entries     Storage for the entries
+ * @param[in]   max_entries Number of entries of @p entries
+ * @param[in]   arena       Storage for the strings
+ * @param[in]   arena_size  Size of @p arena
+ */
+void nanocbor_dict_init(nanocbor_dict_t *dict, nanocbor_dict_entry_t *entries,
+                        size_t max_entries, uint8_t *arena, size_t arena_size);
+
+/**
+ * @brief Write an update record announcing the newly learned strings
+ *
+ * Call at the start of every message. Nothing is written when no strings
+ * were learned since the last update record.
+ *
+ * @param[in]   dict    Dictionary of the encoder
+ * @param[in]   enc     Encoder context
+ *
+ * @return              NANOCBOR_OK if the record fits or nothing was written
+ * @return              Negative on error, the strings are announced by the
+ *                      next update record
+ */
+int nanocbor_dict_fmt_update(nanocbor_dict_t *dict, nanocbor_encoder_t *enc);
+
+/**
+ * @brief Write a text string or a reference to it into the buffer
+ *
+ * @param[in]   dict    Dictionary of the encoder
+ * @param[in]   enc     Encoder context
+ * @param[in]   str     Text string to write
+ * @param[in]   len     Length of @p str
+ *
+ * @return              NANOCBOR_OK if the string or reference fits
+ * @return              Negative on error
+ */
+int nanocbor_dict_put_tstrn(nanocbor_dict_t *dict, nanocbor_encoder_t *enc,
+                            const char *str, size_t len);
+
+/**
+ * @brief Write a zero terminated text string or a reference to it into the
+ *        buffer
+ *
+ * @param[in]   dict    Dictionary of the encoder
+ * @param[in]   enc     Encoder context
+ * @param[in]   str     Zero terminated text string to write
+ *
+ * @return              NANOCBOR_OK if the string or reference fits
+ * @return              Negative on error
+ */
+int nanocbor_dict_put_tstr(nanocbor_dict_t *dict, nanocbor_encoder_t *enc,
+                           const char *str);
+
+/**
+ * @brief Write a byte string or a reference to it into the buffer
+ *
+ * @param[in]   dict    Dictionary of the encoder
+ * @param[in]   enc     Encoder context
+ * @param[in]   str     Byte string to write
+ * @param[in]   len     Length of @p str
+ *
+ * @return              NANOCBOR_OK if the string or reference fits
+ * @return              Negative on error
+ */
+int nanocbor_dict_put_bstr(nanocbor_dict_t *dict, nanocbor_encoder_t *enc,
+                           const uint8_t *str, size_t len);
+
+/**
+ * @brief Apply an update record to the dictionary of a decoder
+ *
+ * Call at the start of every message. The decoder is only advanced when the
+ * next item is an update record.
+ *
+ * @param[in]   dict    Dictionary of the decoder
+ * @param[in]   it      CBOR value to decode from
+ *
+ * @return              NANOCBOR_OK when an update record was applied
+ * @return              NANOCBOR_NOT_FOUND if the next item is no update
+ *                      record
+ * @return              NANOCBOR_ERR_INVALID_TYPE on a malformed record or a
+ *                      record not continuing the dictionary, as after a
+ *                      lost message
+ * @return              NANOCBOR_ERR_OVERFLOW when the dictionary is full
+ */
+int nanocbor_dict_get_update(nanocbor_dict_t *dict, nanocbor_value_t *it);
+
+/**
+ * @brief Retrieve a text string or a reference to one from the stream
+ *
+ * For a reference, @p buf points into the dictionary.
+ *
+ * @param[in]   dict    Dictionary of the decoder
+ * @param[in]   it      CBOR value to decode from
+ * @param[out]  buf     Pointer to the string
+ * @param[out]  len     Length of the string
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              NANOCBOR_NOT_FOUND on a reference to an unknown entry
+ * @return              NANOCBOR_ERR_INVALID_TYPE if the item or the
+ *                      referenced entry is no text string
+ */
+int nanocbor_dict_get_tstr(const nanocbor_dict_t *dict, nanocbor_value_t *it,
+                           const uint8_t **buf, size_t *len);
+
+/**
+ * @brief Retrieve a byte string or a reference to one from the stream
+ *
+ * For a reference, @p buf points into the dictionary.
+ *
+ * @param[in]   dict    Dictionary of the decoder
+ * @param[in]   it      CBOR value to decode from
+ * @param[out]  buf     Pointer to the string
+ * @param[out]  len     Length of the string
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              NANOCBOR_NOT_FOUND on a reference to an unknown entry
+ * @return              NANOCBOR_ERR_INVALID_TYPE if the item or the
+ *                      referenced entry is no byte string
+ */
+int nanocbor_dict_get_bstr(const nanocbor_dict_t *dict, nanocbor_value_t *it,
+                           const uint8_t **buf, size_t *len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NANOCBOR_DICT_H */
+/** @} */
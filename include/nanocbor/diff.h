@@ -0,0 +1,100 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @defgroup    nanocbor_diff NanoCBOR diff and patch
+ * @brief       Compact CBOR patches between two versions of a document
+ *
+ * @ref nanocbor_diff compares two versions of a CBOR item and encodes a
+ * patch holding only the changed parts. @ref nanocbor_patch applies a patch
+ * to the old version, copying all unchanged subtrees as raw bytes. Unchanged
+ * parts are found by comparing the encoded subtrees bytewise.
+ *
+ * A patch mirrors the structure of the document. Every patch is an array
+ * starting with a @ref nanocbor_patch_op_t:
+ *
+ * - `[KEEP]` keeps the item.
+ * - `[REPLACE, item]` replaces the item.
+ * - `[REMOVE]` removes a map entry.
+ * - `[MAP, {key: patch, ...}]` patches the entries of a map. Keys are
+ *   matched by their encoding. A key that is not in the old map adds an
+ *   entry and must have a replace patch.
+ * - `[ARRAY, keep, {index: patch, ...}, item, ...]` keeps the first `keep`
+ *   elements of an array, patching the elements at the given indices, and
+ *   appends the remaining items of the patch.
+ *
+ * Tags of a patched map or array are copied from the old item. Containers
+ * of the result are encoded with a definite length. Entries are matched by
+ * scanning the maps, so the run time grows with the product of the number
+ * of old and new entries per map.
+ *
+ * @{
+ *
+ * @file
+ */
+
+#ifndef NANOCBOR_DIFF_H
+#define NANOCBOR_DIFF_H
+
+#include "nanocbor/config.h"
+#include "nanocbor/nanocbor.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Patch operations
+ */
+typedef enum {
+    NANOCBOR_PATCH_KEEP, /**< Keep the item */
+    NANOCBOR_PATCH_REPLACE, /**< Replace the item */
+    NANOCBOR_PATCH_REMOVE, /**< Remove the map entry */
+    NANOCBOR_PATCH_MAP, /**< Patch the entries of a map */
+    NANOCBOR_PATCH_ARRAY, /**< Truncate, patch and append array elements */
+} nanocbor_patch_op_t;
+
+/**
+ * @brief Encode the patch from one version of an item to another
+ *
+ * Every level of patched containers nests the patch two levels deeper than
+ * the item. Containers are replaced as a whole where patching them could
+ * nest the patch deeper than @ref NANOCBOR_RECURSION_MAX allows
+ * @ref nanocbor_patch to decode.
+ *
+ * @param[in]   old     Decoder positioned at the old item, advanced past it
+ * @param[in]   updated Decoder positioned at the new item, advanced past it
+ * @param[in]   enc     Encoder receiving the patch
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              NANOCBOR_ERR_END when the encoder is full
+ * @return              negative on decode errors
+ */
+int nanocbor_diff(nanocbor_value_t *old, nanocbor_value_t *updated,
+                  nanocbor_encoder_t *enc);
+
+/**
+ * @brief Apply a patch to an item
+ *
+ * @param[in]   old     Decoder positioned at the old item, advanced past it
+ * @param[in]   patch   Decoder positioned at the patch, advanced past it
+ * @param[in]   enc     Encoder receiving the new item
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              NANOCBOR_ERR_INVALID_TYPE if the patch does not
+ *                      match the old item
+ * @return              NANOCBOR_ERR_RECURSION if patched containers nest
+ *                      deeper than @ref NANOCBOR_RECURSION_MAX
+ * @return              NANOCBOR_ERR_END when the encoder is full
+ * @return              negative on decode errors
+ */
+int nanocbor_patch(nanocbor_value_t *old, nanocbor_value_t *patch,
+                   nanocbor_encoder_t *enc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NANOCBOR_DIFF_H */
+/** @} */
@@ -0,0 +1,207 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @defgroup    nanocbor_index NanoCBOR structural index
+ * @brief       Flat index of the containers in a CBOR document
+ *
+ * The structural index holds a node for every array and map in a buffer, in
+ * document order. Each node records the position and length of the encoded
+ * container and the links to its parent and to the node following its
+ * subtree, allowing subtrees to be located and skipped without decoding.
+ * The first child container of a node, if any, is the node directly after
+ * it.
+ *
+ * @{
+ *
+ * @file
+ */
+
+#ifndef NANOCBOR_INDEX_H
+#define NANOCBOR_INDEX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "nanocbor/config.h"
+#include "nanocbor/nanocbor.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Node number used for a missing node
+ */
+#define NANOCBOR_INDEX_NONE UINT32_MAX
+
+/**
+ * @brief Structural index node of a container
+ */
+typedef struct {
+    uint32_t offset; /**< Offset of the container in the buffer */
+    uint32_t len; /**< Length of the encoded container */
+    uint32_t parent; /**< Parent node, NANOCBOR_INDEX_NONE at the top */
+    uint32_t next; /**< Node following the subtree of this node */
+    uint32_t items; /**< Number of items in the container, a map counts
+                         both keys and values */
+} nanocbor_index_node_t;
+
+/**
+ * @brief Key table of an indexed map
+ *
+ * Holds the offsets of the keys of a map for lookups without scanning the
+ * map. When the keys are in the deterministic order of RFC 8949 section
+ * 4.2.1, bytewise lexicographic order of their encodings with integer and
+ * string keys in preferred encoding, lookups binary search the keys.
+ */
+typedef struct {
+    const uint8_t *buf; /**< Buffer holding the map */
+    uint32_t *keys; /**< Offsets of the keys in @p buf */
+    size_t num_keys; /**< Number of keys */
+    uint32_t end; /**< Offset of the end of the map */
+    bool sorted; /**< Whether the keys are in deterministic order */
+} nanocbor_index_map_t;
+
+/**
+ * @brief Build the structural index of a buffer
+ *
+ * It is safe to pass `NULL` to @p nodes with @p num_nodes pointing to `0` to
+ * determine the number of nodes.
+ *
+ * @param[in]       buf         Buffer with a CBOR item or sequence
+ * @param[in]       len         Length of @p buf
+ * @param[out]      nodes       Nodes to fill
+ * @param[in,out]   num_nodes   Capacity of @p nodes, set to the number of
+ *                              containers in @p buf
+ *
+ * @return                      NANOCBOR_OK on success
+ * @return                      NANOCBOR_ERR_OVERFLOW if @p nodes is too small
+ *                              or @p buf exceeds the 32 bit offsets
+ * @return                      NANOCBOR_ERR_RECURSION if containers nest
+ *                              deeper than @ref NANOCBOR_RECURSION_MAX
+ * @return                      negative on decode errors
+ */
+int nanocbor_index_build(const uint8_t *buf, size_t len,
+                         nanocbor_index_node_t *nodes, size_t *num_nodes);
+
+/**
+ * @brief Find the innermost container containing a position
+ *
+ * @param[in]   nodes       Structural index
+ * @param[in]   num_nodes   Number of nodes
+ * @param[in]   offset      Position in the buffer
+ *
+ * @return                  Node number, NANOCBOR_INDEX_NONE if @p offset is
+ *                          not inside a container
+ */
+uint32_t nanocbor_index_find(const nanocbor_index_node_t *nodes,
+                             size_t num_nodes, size_t offset);
+
+/**
+ * @brief Find the container starting at a position
+ *
+ * @param[in]   nodes       Structural index
+ * @param[in]   num_nodes   Number of nodes
+ * @param[in]   offset      Position of the container in the buffer
+ *
+ * @return                  Node number, NANOCBOR_INDEX_NONE if no container
+ *                          starts at @p offset
+ */
+uint32_t nanocbor_index_lookup(const nanocbor_index_node_t *nodes,
+                               size_t num_nodes, size_t offset);
+
+/**
+ * @brief Create the key table of an indexed map
+ *
+ * Values that are containers are skipped using the structural index. The
+ * map is flagged as sorted when its keys are in deterministic order.
+ *
+ * @param[out]  map         Key table to initialize
+ * @param[in]   buf         Buffer the index was built from
+ * @param[in]   nodes       Structural index of @p buf
+ * @param[in]   num_nodes   Number of nodes
+ * @param[in]   node        Node of the map
+ * @param[out]  keys        Storage for the key offsets, the number of keys
+ *                          is half the items of @p node
+ * @param[in]   max_keys    Number of entries of @p keys
+ *
+ * @return                  NANOCBOR_OK on success
+ * @return                  NANOCBOR_ERR_INVALID_TYPE if @p node is not a map
+ * @return                  NANOCBOR_ERR_OVERFLOW if @p keys is too small
+ * @return                  negative on decode errors
+ */
+int nanocbor_index_map_init(nanocbor_index_map_t *map, const uint8_t *buf,
+                            const nanocbor_index_node_t *nodes,
+                            size_t num_nodes, uint32_t node, uint32_t *keys,
+                            size_t max_keys);
+
+/**
+ * @brief Look up a text string key in an indexed map
+ *
+ * @param[in]   map     Key table of the map
+ * @param[in]   key     Zero terminated key
+ * @param[out]  value   Decoder positioned at the value, limited to the
+ *                      remainder of the map
+ *
+ * @return              NANOCBOR_OK if @p key was found
+ * @return              NANOCBOR_NOT_FOUND if @p key is not in the map
+ * @return              negative on decode errors
+ */
+int nanocbor_index_map_get_tstr(const nanocbor_index_map_t *map,
+                                const char *key, nanocbor_value_t *value);
+
+/**
+ * @brief Look up an integer key in an indexed map
+ *
+ * @param[in]   map     Key table of the map
+ * @param[in]   key     Integer key
+ * @param[out]  value   Decoder positioned at the value, limited to the
+ *                      remainder of the map
+ *
+ * @return              NANOCBOR_OK if @p key was found
+ * @return              NANOCBOR_NOT_FOUND if @p key is not in the map
+ * @return              negative on decode errors
+ */
+int nanocbor_index_map_get_int(const nanocbor_index_map_t *map, int64_t key,
+                               nanocbor_value_t *value);
+
+#if NANOCBOR_WALK_PARALLEL || defined(DOXYGEN)
+/**
+ * @brief Build the structural index of a buffer on multiple threads
+ *
+ * The buffer is cut into a chunk per thread. Each thread parses its chunk
+ * from a guessed item boundary, after which the chunks are joined in order.
+ * A chunk for which the guess turns out wrong is parsed again from the end
+ * of the previous chunk. The result is identical to
+ * @ref nanocbor_index_build.
+ *
+ * @param[in]       buf         Buffer with a CBOR item or sequence
+ * @param[in]       len         Length of @p buf
+ * @param[out]      nodes       Nodes to fill
+ * @param[in,out]   num_nodes   Capacity of @p nodes, set to the number of
+ *                              containers in @p buf
+ * @param[in]       threads     Number of threads, at most
+ *                              @ref NANOCBOR_WALK_THREADS_MAX
+ *
+ * @return                      NANOCBOR_OK on success
+ * @return                      NANOCBOR_ERR_OVERFLOW if @p nodes is too small,
+ *                              on too many threads or when allocating
+ *                              resources failed
+ * @return                      NANOCBOR_ERR_RECURSION if containers nest
+ *                              deeper than @ref NANOCBOR_RECURSION_MAX
+ * @return                      negative on decode errors
+ */
+int nanocbor_index_build_parallel(const uint8_t *buf, size_t len,
+                                  nanocbor_index_node_t *nodes,
+                                  size_t *num_nodes, unsigned threads);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NANOCBOR_INDEX_H */
+/** @} */
@@ -0,0 +1,223 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @defgroup    nanocbor_log NanoCBOR append-only log
+ * @brief       Append-only log of CBOR records with block index and recovery
+ *
+ * Records are appended to a block buffer and written to storage a block at a
+ * time. The log itself is a CBOR sequence of block and index items:
+ *
+ * - Block: `#6.NANOCBOR_TAG_LOG_BLOCK([record_no, count, first_key, crc,
+ *   records])` where `records` is a byte string holding the CBOR sequence of
+ *   the records of the block and `crc` the CRC-32 of that byte string
+ *   content.
+ * - Index: `#6.NANOCBOR_TAG_LOG_INDEX([prev, entries])`, written after every
+ *   @ref NANOCBOR_LOG_INDEX_INTERVAL blocks, where `prev` is the offset of
+ *   the previous index or null and `entries` a flat array of `offset,
+ *   record_no, first_key` triples of the blocks since the previous index.
+ *
+ * As the records of a block are wrapped in a byte string, scanning over the
+ * blocks does not decode the records. Readers seek by record number or key
+ * through the chain of index items and only scan the blocks after the
+ * closest index entry.
+ *
+ * Keys are application defined, such as a timestamp, and are expected to be
+ * non-decreasing for seeking by key to be meaningful.
+ *
+ * @{
+ *
+ * @file
+ */
+
+#ifndef NANOCBOR_LOG_H
+#define NANOCBOR_LOG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "nanocbor/config.h"
+#include "nanocbor/nanocbor.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief State of a log as found by @ref nanocbor_log_recover
+ */
+typedef struct {
+    size_t len; /**< Length of the valid part of the log */
+    uint64_t records; /**< Number of records in the log */
+    size_t last_index; /**< Offset of the last index item */
+    bool has_index; /**< Whether the log contains an index item */
+} nanocbor_log_info_t;
+
+/**
+ * @brief Index entry of a block
+ */
+typedef struct {
+    size_t offset; /**< Offset of the block in the log */
+    uint64_t record_no; /**< Number of the first record of the block */
+    int64_t first_key; /**< Key of the first record of the block */
+} nanocbor_log_index_entry_t;
+
+/**
+ * @brief Log writer
+ */
+typedef struct {
+    nanocbor_encoder_t *out; /**< Encoder writing to the log storage */
+    uint8_t *buf; /**< Block buffer */
+    size_t buf_len; /**< Size of the block buffer */
+    size_t used; /**< Bytes of the block buffer in use */
+    size_t offset; /**< Length of the log in storage */
+    uint64_t record_no; /**< Number of the first record of the block */
+    uint32_t count; /**< Number of records in the block */
+    uint32_t crc; /**< CRC of the records in the block */
+    int64_t first_key; /**< Key of the first record in the block */
+    size_t last_index; /**< Offset of the last index item */
+    bool has_index; /**< Whether an index item was written */
+    size_t num_entries; /**< Number of blocks since the last index */
+    nanocbor_log_index_entry_t
+        entries[NANOCBOR_LOG_INDEX_INTERVAL]; /**< Blocks since the last
+                                                   index */
+} nanocbor_log_writer_t;
+
+/**
+ * @brief Log reader
+ */
+typedef struct {
+    const uint8_t *buf; /**< Log contents */
+    size_t len; /**< Length of the valid part of the log */
+    size_t next; /**< Offset of the next log item */
+    nanocbor_value_t records; /**< Remaining records of the current block */
+    uint64_t record_no; /**< Number of the next record */
+    size_t last_index; /**< Offset of the last index item */
+    bool has_index; /**< Whether the log contains an index item */
+} nanocbor_log_reader_t;
+
+/**
+ * @brief Initialize a log writer
+ *
+ * @param[out]  log     Log writer to initialize
+ * @param[in]   out     Encoder appending to the log storage, typically
+ *                      initialized with @ref nanocbor_encoder_stream_init
+ * @param[in]   buf     Block buffer
+ * @param[in]   buf_len Size of @p buf, the maximum size of a block
+ * @param[in]   info    State of an existing log to continue, the storage
+ *                      must be truncated to its length. NULL for a new log
+ */
+void nanocbor_log_writer_init(nanocbor_log_writer_t *log,
+                              nanocbor_encoder_t *out, uint8_t *buf,
+                              size_t buf_len, const nanocbor_log_info_t *info);
+
+/**
+ * @brief Append an encoded record to the log
+ *
+ * The record is added to the block buffer, a full block is written to the
+ * storage first. A record larger than the block buffer is written as a
+ * single record block.
+ *
+ * The log must be recovered with @ref nanocbor_log_recover after a failed
+ * write.
+ *
+ * @param[in]   log     Log writer
+ * @param[in]   key     Key of the record
+ * @param[in]   record  Encoded record, a single CBOR item
+ * @param[in]   len     Length of @p record
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              negative when writing to the storage failed
+ */
+int nanocbor_log_append(nanocbor_log_writer_t *log, int64_t key,
+                        const uint8_t *record, size_t len);
+
+/**
+ * @brief Write the pending block to storage
+ *
+ * @param[in]   log     Log writer
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              negative when writing to the storage failed
+ */
+int nanocbor_log_flush(nanocbor_log_writer_t *log);
+
+/**
+ * @brief Find the valid part of a log after a crash
+ *
+ * Walks the blocks and index items of the log without decoding records. Only
+ * the block at the end of the log can be torn by an interrupted write, its
+ * records and CRC are verified. The storage should be truncated to the
+ * resulting length before appending to the log.
+ *
+ * @param[in]   buf     Log contents
+ * @param[in]   len     Length of @p buf
+ * @param[out]  info    State of the log
+ *
+ * @return              NANOCBOR_OK when the log is intact
+ * @return              NANOCBOR_ERR_END when the log was truncated
+ */
+int nanocbor_log_recover(const uint8_t *buf, size_t len,
+                         nanocbor_log_info_t *info);
+
+/**
+ * @brief Initialize a log reader at the first record
+ *
+ * @param[out]  reader  Log reader to initialize
+ * @param[in]   buf     Log contents
+ * @param[in]   info    State of the log from @ref nanocbor_log_recover
+ */
+void nanocbor_log_reader_init(nanocbor_log_reader_t *reader,
+                              const uint8_t *buf,
+                              const nanocbor_log_info_t *info);
+
+/**
+ * @brief Read the next record
+ *
+ * @param[in]   reader  Log reader
+ * @param[out]  record  Encoded record
+ * @param[out]  len     Length of @p record
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              NANOCBOR_ERR_END at the end of the log
+ * @return              negative on decode errors
+ */
+int nanocbor_log_read(nanocbor_log_reader_t *reader, const uint8_t **record,
+                      size_t *len);
+
+/**
+ * @brief Position the reader at a record number
+ *
+ * @param[in]   reader      Log reader
+ * @param[in]   record_no   Number of the record to read next
+ *
+ * @return                  NANOCBOR_OK on success
+ * @return                  NANOCBOR_NOT_FOUND if the log has fewer records
+ * @return                  negative on decode errors
+ */
+int nanocbor_log_seek_record(nanocbor_log_reader_t *reader,
+                             uint64_t record_no);
+
+/**
+ * @brief Position the reader at the block that contains a key
+ *
+ * The reader is positioned at the first record of the last block with a first
+ * key not greater than @p key, or of the first block if all keys are greater.
+ *
+ * @param[in]   reader      Log reader
+ * @param[in]   key         Key to search for
+ *
+ * @return                  NANOCBOR_OK on success
+ * @return                  NANOCBOR_NOT_FOUND if the log is empty
+ * @return                  negative on decode errors
+ */
+int nanocbor_log_seek_key(nanocbor_log_reader_t *reader, int64_t key);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NANOCBOR_LOG_H */
+/** @} */
@@ -0,0 +1,108 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @defgroup    nanocbor_merkle NanoCBOR Merkle hashing
+ * @brief       Hashes of every container of a CBOR document
+ *
+ * Computes a digest for every node of a structural index, see
+ * @ref nanocbor_index. The digest of a container covers its header and its
+ * items, where an item that is a container contributes its digest instead of
+ * its encoding:
+ *
+ *     digest = H('L' header ('L' leaf | 'N' digest)...)
+ *
+ * Leaf items and tag headers are hashed as their encoded bytes. Equal
+ * subtrees thus have equal digests, and after an edit only the digests of
+ * the containers on the path from the edit to the top need to be recomputed
+ * with @ref nanocbor_merkle_update.
+ *
+ * The hash function is supplied by the application. The built-in
+ * @ref nanocbor_hash_fnv1a64 detects accidental differences but offers no
+ * protection against deliberate collisions.
+ *
+ * @{
+ *
+ * @file
+ */
+
+#ifndef NANOCBOR_MERKLE_H
+#define NANOCBOR_MERKLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "nanocbor/index.h"
+#include "nanocbor/nanocbor.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Hash function used for the digests
+ */
+typedef struct {
+    size_t digest_len; /**< Length of a digest in bytes */
+    void (*init)(void *state); /**< Start a new digest */
+    void (*update)(void *state, const uint8_t *data,
+                   size_t len); /**< Add data to the digest */
+    void (*final)(void *state, uint8_t *digest); /**< Write the digest */
+} nanocbor_hash_t;
+
+/**
+ * @brief 64 bit FNV-1a hash, with a `uint64_t` as state
+ */
+extern const nanocbor_hash_t nanocbor_hash_fnv1a64;
+
+/**
+ * @brief Compute the digests of all nodes of a structural index
+ *
+ * @param[in]   buf         Buffer the index was built from
+ * @param[in]   nodes       Structural index
+ * @param[in]   num_nodes   Number of nodes
+ * @param[in]   hash        Hash function
+ * @param[in]   state       State for @p hash
+ * @param[out]  digests     Digests, `num_nodes * hash->digest_len` bytes in
+ *                          node order
+ *
+ * @return                  NANOCBOR_OK on success
+ * @return                  negative on decode errors
+ */
+int nanocbor_merkle_build(const uint8_t *buf,
+                          const nanocbor_index_node_t *nodes, size_t num_nodes,
+                          const nanocbor_hash_t *hash, void *state,
+                          uint8_t *digests);
+
+/**
+ * @brief Update the digests after an edit that kept the encoded length
+ *
+ * Recomputes the digest of the innermost container holding the edit and of
+ * all containers enclosing it.
+ *
+ * @param[in]       buf         Edited buffer
+ * @param[in]       nodes       Structural index
+ * @param[in]       num_nodes   Number of nodes
+ * @param[in]       offset      Position of the edit in @p buf
+ * @param[in]       hash        Hash function
+ * @param[in]       state       State for @p hash
+ * @param[in,out]   digests     Digests from @ref nanocbor_merkle_build
+ *
+ * @return                      NANOCBOR_OK on success
+ * @return                      NANOCBOR_NOT_FOUND if @p offset is not inside
+ *                              a container
+ * @return                      negative on decode errors
+ */
+int nanocbor_merkle_update(const uint8_t *buf,
+                           const nanocbor_index_node_t *nodes,
+                           size_t num_nodes, size_t offset,
+                           const nanocbor_hash_t *hash, void *state,
+                           uint8_t *digests);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NANOCBOR_MERKLE_H */
+/** @} */
@@ -0,0 +1,100 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @defgroup    nanocbor_mmap NanoCBOR memory-mapped file encoder target
+ * @brief       Encodes directly into a memory-mapped file
+ *
+ * The target is an encoder for @ref nanocbor_encoder_stream_init writing
+ * into a shared mapping of a file. When an item does not fit, the file is
+ * extended with `ftruncate` and the mapping is grown with `mremap`, in steps
+ * of a configurable size to keep the number of resizes low for very large
+ * outputs. Without `mremap` the file is unmapped and mapped again. Closing
+ * the target truncates the file to the encoded length.
+ *
+ * Requires @ref NANOCBOR_ENCODER_MMAP.
+ *
+ * @{
+ *
+ * @file
+ */
+
+#ifndef NANOCBOR_MMAP_H
+#define NANOCBOR_MMAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "nanocbor/config.h"
+#include "nanocbor/nanocbor.h"
+
+#if NANOCBOR_ENCODER_MMAP || defined(DOXYGEN)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Memory-mapped file encoder target
+ */
+typedef struct {
+    int fd; /**< File descriptor of the output file */
+    uint8_t *map; /**< Mapping of the file, NULL before the first item */
+    size_t size; /**< Size of the mapping and the file */
+    size_t used; /**< Bytes written to the mapping */
+    size_t step; /**< Growth step, a multiple of the page size */
+    bool failed; /**< Whether growing the file failed */
+} nanocbor_mmap_t;
+
+/**
+ * @brief Initialize a memory-mapped file target
+ *
+ * The file is truncated to zero length. It is only mapped once the first
+ * item is encoded.
+ *
+ * @param[out]  target  Target to initialize
+ * @param[in]   fd      File descriptor opened for reading and writing
+ * @param[in]   step    Number of bytes by which the file grows, rounded up to
+ *                      the page size, 0 for @ref NANOCBOR_MMAP_STEP
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              NANOCBOR_ERR_OVERFLOW when truncating the file failed
+ */
+int nanocbor_mmap_init(nanocbor_mmap_t *target, int fd, size_t step);
+
+/**
+ * @brief Initialize an encoder writing into a memory-mapped file target
+ *
+ * Encoding fails with NANOCBOR_ERR_END once growing the file failed.
+ *
+ * @param[out]  enc     Encoder to initialize
+ * @param[in]   target  Initialized target
+ */
+void nanocbor_mmap_encoder_init(nanocbor_encoder_t *enc,
+                                nanocbor_mmap_t *target);
+
+/**
+ * @brief Unmap the file and truncate it to the encoded length
+ *
+ * The file descriptor is not closed.
+ *
+ * @param[in]   target  Target
+ * @param[in]   enc     Encoder writing into @p target
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              NANOCBOR_ERR_OVERFLOW when growing, unmapping or
+ *                      truncating the file failed, the file then holds the
+ *                      items encoded before the failure
+ */
+int nanocbor_mmap_close(nanocbor_mmap_t *target, nanocbor_encoder_t *enc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NANOCBOR_ENCODER_MMAP */
+
+#endif /* NANOCBOR_MMAP_H */
+/** @} */
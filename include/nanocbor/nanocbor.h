@@ -31,6 +31,7 @@
 #define NANOCBOR_NANOCBOR_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 
@@ -149,6 +150,15 @@ typedef struct nanocbor_value {
     uint8_t flags; /**< Flags for decoding hints                   */
 } nanocbor_value_t;
 
+/**
+ * @brief Numeric value decoded by @ref nanocbor_get_number
+ */
+typedef struct {
+    bool is_int; /**< @p i holds the exact value */
+    int64_t i; /**< Integer value, only valid when @p is_int is set */
+    double f; /**< Value as double */
+} nanocbor_number_t;
+
 /**
  * @brief Encoder context forward declaration
  */
@@ -191,6 +201,32 @@ typedef bool (*nanocbor_encoder_fits)(nanocbor_encoder_t *enc, void *ctx, size_t
  */
 typedef void (*nanocbor_encoder_append)(nanocbor_encoder_t *enc, void *ctx, const uint8_t *data, size_t len);
 
+/**
+ * @brief Segment of data passed to a @ref nanocbor_encoder_append_vec
+ *        function
+ */
+typedef struct {
+    const uint8_t *data; /**< Data of the segment */
+    size_t len; /**< Length of the segment in bytes */
+} nanocbor_encoder_vec_t;
+
+/**
+ * @brief Vectored append function for streaming encoder data
+ *
+ * Optional user supplied function appending multiple segments at once, used
+ * for the header and payload of strings instead of copying them together.
+ * Called under the same conditions as @ref nanocbor_encoder_append.
+ *
+ * @param   enc     The encoder context struct
+ * @param   ctx     The context ptr supplied in the
+ *                  @ref nanocbor_encoder_stream_init call
+ * @param   vec     Segments emitted by the encoder, in order
+ * @param   num     Number of segments
+ */
+typedef void (*nanocbor_encoder_append_vec)(nanocbor_encoder_t *enc, void *ctx,
+                                            const nanocbor_encoder_vec_t *vec,
+                                            size_t num);
+
 /** @} */
 
 /**
@@ -207,8 +243,61 @@ struct nanocbor_encoder {
         void *context; /**< Context ptr supplied to the custom functions */
     };
     uint8_t *end; /**< end of the buffer                      */
+    nanocbor_encoder_append_vec append_vec; /**< Optional function used to
+                                             *   append multiple segments */
 };
 
+/**
+ * @brief Field types for descriptor based struct encoding
+ */
+typedef enum {
+    NANOCBOR_FIELD_BOOL, /**< bool */
+    NANOCBOR_FIELD_UINT8, /**< uint8_t */
+    NANOCBOR_FIELD_UINT16, /**< uint16_t */
+    NANOCBOR_FIELD_UINT32, /**< uint32_t */
+    NANOCBOR_FIELD_UINT64, /**< uint64_t */
+    NANOCBOR_FIELD_INT8, /**< int8_t */
+    NANOCBOR_FIELD_INT16, /**< int16_t */
+    NANOCBOR_FIELD_INT32, /**< int32_t */
+    NANOCBOR_FIELD_INT64, /**< int64_t */
+    NANOCBOR_FIELD_FLOAT, /**< float */
+    NANOCBOR_FIELD_DOUBLE, /**< double */
+    NANOCBOR_FIELD_TSTR, /**< const char *, null terminated */
+} nanocbor_field_type_t;
+
+/**
+ * @brief Omit the field from a map when it has the default (zero, false or
+ *        NULL) value
+ */
+#define NANOCBOR_FIELD_FLAG_OMIT_DEFAULT (0x01U)
+
+/**
+ * @brief Descriptor of a single struct member for struct encoding
+ */
+typedef struct {
+    const uint8_t *key; /**< Pre-encoded CBOR map key */
+    size_t key_len; /**< Length of the pre-encoded key in bytes */
+    size_t offset; /**< Offset of the member in the struct */
+    uint8_t type; /**< Member type, one of @ref nanocbor_field_type_t */
+    uint8_t flags; /**< Field flags */
+} nanocbor_field_t;
+
+/**
+ * @brief Initializer for a @ref nanocbor_field_t
+ *
+ * @param   key     Pre-encoded CBOR key as string literal, e.g. `"\x01"` for
+ *                  integer key 1 or `"\x62" "id"` for text key "id"
+ * @param   type    @ref nanocbor_field_type_t of the member
+ * @param   st      struct type
+ * @param   member  struct member name
+ * @param   flags   field flags
+ */
+#define NANOCBOR_FIELD(key, type, st, member, flags)                    \
+    {                                                                   \
+        (const uint8_t *)(key), sizeof(key) - 1, offsetof(st, member),  \
+            (type), (flags)                                             \
+    }
+
 /**
  * @name decoder flags
  * @{
@@ -434,6 +523,26 @@ int nanocbor_get_bstr(nanocbor_value_t *cvalue, const uint8_t **buf,
 int nanocbor_get_tstr(nanocbor_value_t *cvalue, const uint8_t **buf,
                       size_t *len);
 
+/**
+ * @brief Retrieve an array of signed integers from the stream
+ *
+ * Both a plain array of integers and a delta encoded array, as written by
+ * @ref nanocbor_fmt_delta_array, are accepted.
+ *
+ * The content of @p values is undefined if the result is an error condition
+ *
+ * @param[in]       cvalue  CBOR value to decode from
+ * @param[out]      values  returned integers
+ * @param[in,out]   len     capacity of @p values, set to the number of
+ *                          integers retrieved
+ *
+ * @return                  NANOCBOR_OK on success
+ * @return                  NANOCBOR_ERR_OVERFLOW if @p values is too small
+ * @return                  negative on error
+ */
+int nanocbor_get_int64_array(nanocbor_value_t *cvalue, int64_t *values,
+                             size_t *len);
+
 /**
  * @brief Search for a tstr key in a map.
  *
@@ -486,6 +595,25 @@ int nanocbor_enter_map(const nanocbor_value_t *it, nanocbor_value_t *map);
 void nanocbor_leave_container(nanocbor_value_t *it,
                               nanocbor_value_t *container);
 
+/**
+ * @brief leave the container before all items are consumed
+ *
+ * Skips over the remaining items in @p container and leaves it. This can be
+ * called at any position inside the container, for example after the
+ * required entries of a map are retrieved with @ref nanocbor_get_key_tstr.
+ *
+ * This must be called with the same @ref nanocbor_value_t struct that was used
+ * to enter the container.
+ *
+ * @param[in]   it          parent CBOR structure
+ * @param[in]   container   CBOR container to leave
+ *
+ * @return                  NANOCBOR_OK on success
+ * @return                  negative on error
+ */
+int nanocbor_leave_container_early(nanocbor_value_t *it,
+                                   nanocbor_value_t *container);
+
 /**
  * @brief Retrieve a tag as positive uint32_t from the stream
  *
@@ -503,6 +631,9 @@ int nanocbor_get_tag(nanocbor_value_t *cvalue, uint32_t *tag);
  *
  * The resulting @p value is undefined if the result is an error condition
  *
+ * As with @ref nanocbor_get_tag, the tag does not count as an item of the
+ * enclosing container, only the tagged item that follows does.
+ *
  * @param[in]   cvalue  CBOR value to decode from
  * @param[out]  tag     returned tag as positive integer
  *
@@ -592,6 +723,21 @@ int nanocbor_get_float(nanocbor_value_t *cvalue, float *value);
  */
 int nanocbor_get_double(nanocbor_value_t *cvalue, double *value);
 
+/**
+ * @brief Retrieve an integer or floating point value from the stream
+ *
+ * Integers are kept exact when they fit an int64_t, all values are also
+ * converted to a double.
+ *
+ * @param[in]   cvalue  CBOR value to decode from
+ * @param[out]  num     Number retrieved from the stream
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              NANOCBOR_ERR_INVALID_TYPE if the item is no number
+ * @return              negative on other errors
+ */
+int nanocbor_get_number(nanocbor_value_t *cvalue, nanocbor_number_t *num);
+
 /**
  * @brief Skip to the next value in the CBOR stream
  *
@@ -600,10 +746,14 @@ int nanocbor_get_double(nanocbor_value_t *cvalue, double *value);
  *
  * Recursion is limited with @ref NANOCBOR_RECURSION_MAX
  *
+ * A tagged item is skipped together with its tags, tags do not count
+ * towards the recursion limit.
+ *
  * @param[in]   it  CBOR stream to skip a value from
  *
  * @return              NANOCBOR_OK on success
- * @return              negative on error
+ * @return              NANOCBOR_ERR_END if a container or tag is truncated
+ * @return              negative on other errors
  */
 int nanocbor_skip(nanocbor_value_t *it);
 
@@ -620,6 +770,18 @@ int nanocbor_skip(nanocbor_value_t *it);
  */
 int nanocbor_skip_simple(nanocbor_value_t *it);
 
+/**
+ * @brief Skip the tags in front of the next item in the CBOR stream
+ *
+ * The stream is left at the tagged content, an untagged item is left as is.
+ *
+ * @param[in]   it  CBOR value to skip the tags of
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              negative on error
+ */
+int nanocbor_skip_tags(nanocbor_value_t *it);
+
 /**
  * @brief Retrieve part of the CBOR stream for separate parsing
  *
@@ -636,6 +798,24 @@ int nanocbor_skip_simple(nanocbor_value_t *it);
 int nanocbor_get_subcbor(nanocbor_value_t *it, const uint8_t **start,
                          size_t *len);
 
+/**
+ * @brief Compare two CBOR items in a deterministic total order
+ *
+ * Tags are ignored for the comparison of the tagged content. Integer and
+ * floating point numbers compare by their numeric value and sort before all
+ * other types, with NaN after all other numbers. Text strings and byte
+ * strings compare lexicographically by their content. All other items, and
+ * items that are equal by the rules above, are ordered by the bytewise
+ * lexicographic order of their encoding.
+ *
+ * @param[in]   a   First CBOR item
+ * @param[in]   b   Second CBOR item
+ *
+ * @return          negative, zero or positive when @p a is less than, equal
+ *                  to or greater than @p b
+ */
+int nanocbor_compare(const nanocbor_value_t *a, const nanocbor_value_t *b);
+
 /**
  * @brief Retrieve the number of remaining values in a CBOR container: either array or map
  *
@@ -709,6 +889,23 @@ static inline bool nanocbor_in_container(const nanocbor_value_t *container)
     return container->flags & (NANOCBOR_DECODER_FLAG_CONTAINER);
 }
 
+/**
+ * @brief Check whether the buffer ended before the container was closed
+ *
+ * @param[in]   container   value inside a CBOR container
+ *
+ * @return                  True when the buffer is exhausted while the
+ *                          container expects more items or its end marker
+ * @return                  False otherwise
+ */
+static inline bool
+nanocbor_container_truncated(const nanocbor_value_t *container)
+{
+    return container->cur >= container->end
+        && (nanocbor_container_indefinite(container)
+            || container->remaining > 0);
+}
+
 /** @} */
 
 /**
@@ -740,6 +937,20 @@ void nanocbor_encoder_stream_init(nanocbor_encoder_t *enc, void *ctx,
                                   nanocbor_encoder_append append_func,
                                   nanocbor_encoder_fits fits_func);
 
+/**
+ * @brief Sets a vectored append function on a streaming encoder
+ *
+ * Every encoded item results in a single call to the fits function and a
+ * single call to an append function. Without a vectored append function,
+ * strings up to @ref NANOCBOR_ENCODER_STAGING_SIZE bytes are combined with
+ * their header on the stack and larger strings are appended in two calls.
+ *
+ * @param[in]   enc             Encoder context
+ * @param[in]   append_vec_func Called to append multiple segments
+ */
+void nanocbor_encoder_set_append_vec(
+    nanocbor_encoder_t *enc, nanocbor_encoder_append_vec append_vec_func);
+
 /**
  * @brief Retrieve the encoded length of the CBOR structure
  *
@@ -799,6 +1010,38 @@ int nanocbor_fmt_tag(nanocbor_encoder_t *enc, uint64_t num);
  */
 int nanocbor_fmt_int(nanocbor_encoder_t *enc, int64_t num);
 
+/**
+ * @brief Write an array of signed integers into the buffer
+ *
+ * @param[in]   enc     Encoder context
+ * @param[in]   values  signed integers to write
+ * @param[in]   len     number of integers in @p values
+ *
+ * @return              number of bytes written
+ * @return              Negative on error
+ */
+int nanocbor_fmt_int64_array(nanocbor_encoder_t *enc, const int64_t *values,
+                             size_t len);
+
+/**
+ * @brief Write a delta encoded array of signed integers into the buffer
+ *
+ * The array is tagged with @ref NANOCBOR_TAG_DELTA_ARRAY and contains the
+ * first value followed by the difference of every value to its predecessor,
+ * each as shortest form CBOR integer. This is compact for slowly changing
+ * series such as counters and timestamps. Use @ref nanocbor_fmt_int64_array
+ * for peers that don't support the tag.
+ *
+ * @param[in]   enc     Encoder context
+ * @param[in]   values  signed integers to write
+ * @param[in]   len     number of integers in @p values
+ *
+ * @return              number of bytes written
+ * @return              Negative on error
+ */
+int nanocbor_fmt_delta_array(nanocbor_encoder_t *enc, const int64_t *values,
+                             size_t len);
+
 /**
  * @brief Write a byte string indicator for a byte string with specific length
  * into the encoder buffer
@@ -841,6 +1084,21 @@ int nanocbor_fmt_tstr(nanocbor_encoder_t *enc, size_t len);
  */
 int nanocbor_put_bstr(nanocbor_encoder_t *enc, const uint8_t *str, size_t len);
 
+/**
+ * @brief Copy pre-encoded CBOR into the encoder buffer as is
+ *
+ * The data is not validated. Combined with @ref nanocbor_get_subcbor this
+ * copies items from a decoder without decoding and re-encoding them.
+ *
+ * @param[in]   enc     Encoder context
+ * @param[in]   data    Encoded CBOR
+ * @param[in]   len     Length of @p data
+ *
+ * @return              NANOCBOR_OK if the data fits
+ * @return              Negative on error
+ */
+int nanocbor_put_raw(nanocbor_encoder_t *enc, const uint8_t *data, size_t len);
+
 /**
  * @brief Copy a text string with indicator into the encoder buffer
  *
@@ -915,7 +1173,65 @@ int nanocbor_fmt_array_indefinite(nanocbor_encoder_t *enc);
 int nanocbor_fmt_map_indefinite(nanocbor_encoder_t *enc);
 
 /**
- * @brief Write a stop code for indefinite length containers
+ * @brief Write an indefinite-length byte string indicator
+ *
+ * The byte string content must be added in chunks with
+ * @ref nanocbor_put_bstr_chunk and terminated with
+ * @ref nanocbor_fmt_end_indefinite.
+ *
+ * @param[in]   enc     Encoder context
+ *
+ * @return              Number of bytes written
+ * @return              Negative on error
+ */
+int nanocbor_fmt_bstr_indefinite(nanocbor_encoder_t *enc);
+
+/**
+ * @brief Write an indefinite-length text string indicator
+ *
+ * The text string content must be added in chunks with
+ * @ref nanocbor_put_tstr_chunk and terminated with
+ * @ref nanocbor_fmt_end_indefinite.
+ *
+ * @param[in]   enc     Encoder context
+ *
+ * @return              Number of bytes written
+ * @return              Negative on error
+ */
+int nanocbor_fmt_tstr_indefinite(nanocbor_encoder_t *enc);
+
+/**
+ * @brief Copy a chunk of an indefinite-length byte string into the encoder
+ *        buffer
+ *
+ * @param[in]   enc     Encoder context
+ * @param[in]   str     byte string chunk to encode
+ * @param[in]   len     Length of the chunk
+ *
+ * @return              NANOCBOR_OK if the chunk fits
+ * @return              Negative on error
+ */
+int nanocbor_put_bstr_chunk(nanocbor_encoder_t *enc, const uint8_t *str,
+                            size_t len);
+
+/**
+ * @brief Copy a chunk of an indefinite-length text string into the encoder
+ *        buffer
+ *
+ * A chunk must not split a multi-byte UTF-8 character.
+ *
+ * @param[in]   enc     Encoder context
+ * @param[in]   str     text string chunk to encode
+ * @param[in]   len     number of string bytes to copy
+ *
+ * @return              NANOCBOR_OK if the chunk fits
+ * @return              Negative on error
+ */
+int nanocbor_put_tstr_chunk(nanocbor_encoder_t *enc, const char *str,
+                            size_t len);
+
+/**
+ * @brief Write a stop code for indefinite length containers and strings
  *
  * @param[in]   enc     Encoder context
  *
@@ -956,6 +1272,87 @@ int nanocbor_fmt_float(nanocbor_encoder_t *enc, float num);
  */
 int nanocbor_fmt_double(nanocbor_encoder_t *enc, double num);
 
+/**
+ * @brief Write a double floating point value into the encoder buffer,
+ *        allowing precision loss within a tolerance
+ *
+ * The value is encoded with the smallest floating point size that rounds,
+ * to nearest, to within the tolerance of @p num. The allowed error is the
+ * larger of @p abs_tol and @p rel_tol times the magnitude of @p num, pass zero
+ * for a tolerance that should not be used. Values that can be reduced without
+ * loss are encoded as with @ref nanocbor_fmt_double.
+ *
+ * @note On platforms where double is single precision, this is identical to
+ * @ref nanocbor_fmt_float
+ *
+ * @param[in]   enc     Encoder context
+ * @param[in]   num     Floating point to encode
+ * @param[in]   abs_tol Absolute error allowed
+ * @param[in]   rel_tol Relative error allowed
+ *
+ * @return              Number of bytes written
+ * @return              Negative on error
+ */
+int nanocbor_fmt_double_lossy(nanocbor_encoder_t *enc, double num,
+                              double abs_tol, double rel_tol);
+
+/**
+ * @brief Write an array of double floating point values into the encoder
+ *        buffer, allowing precision loss within a tolerance
+ *
+ * Every value is encoded as with @ref nanocbor_fmt_double_lossy.
+ *
+ * @param[in]   enc     Encoder context
+ * @param[in]   nums    Floating points to encode
+ * @param[in]   len     Number of floating points in @p nums
+ * @param[in]   abs_tol Absolute error allowed
+ * @param[in]   rel_tol Relative error allowed
+ *
+ * @return              Number of bytes written
+ * @return              Negative on error
+ */
+int nanocbor_fmt_double_array_lossy(nanocbor_encoder_t *enc,
+                                    const double *nums, size_t len,
+                                    double abs_tol, double rel_tol);
+
+/**
+ * @brief Write a struct as CBOR map using a field descriptor table
+ *
+ * Every field is written as its pre-encoded key followed by the shortest
+ * encoding of the struct member. Fields with
+ * @ref NANOCBOR_FIELD_FLAG_OMIT_DEFAULT are left out when the member has the
+ * default value.
+ *
+ * @param[in]   enc         Encoder context
+ * @param[in]   fields      Field descriptor table
+ * @param[in]   num_fields  Number of entries in @p fields
+ * @param[in]   data        Pointer to the struct to encode
+ *
+ * @return                  Number of bytes written
+ * @return                  Negative on error
+ */
+int nanocbor_fmt_struct_map(nanocbor_encoder_t *enc,
+                            const nanocbor_field_t *fields, size_t num_fields,
+                            const void *data);
+
+/**
+ * @brief Write a struct as CBOR array using a field descriptor table
+ *
+ * Every field is written in table order, the keys and the
+ * @ref NANOCBOR_FIELD_FLAG_OMIT_DEFAULT flag are ignored.
+ *
+ * @param[in]   enc         Encoder context
+ * @param[in]   fields      Field descriptor table
+ * @param[in]   num_fields  Number of entries in @p fields
+ * @param[in]   data        Pointer to the struct to encode
+ *
+ * @return                  Number of bytes written
+ * @return                  Negative on error
+ */
+int nanocbor_fmt_struct_array(nanocbor_encoder_t *enc,
+                              const nanocbor_field_t *fields,
+                              size_t num_fields, const void *data);
+
 /**
  * @brief Write a decimal fraction into the encoder buffer
  *
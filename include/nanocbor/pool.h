@@ -0,0 +1,183 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @defgroup    nanocbor_pool NanoCBOR adaptive encoder buffer pool
+ * @brief       Pre-sized encoder buffers learned from message sizes
+ *
+ * Encoding into a heap buffer of unknown size usually takes a sizing pass
+ * with a NULL buffer, an allocation and a second pass. The pool instead
+ * keeps a size history per message type and hands out a buffer sized to the
+ * @ref NANOCBOR_POOL_QUANTILE quantile of the recent sizes of that type. A
+ * message that does not fit is encoded again into a buffer of the exact
+ * size reported by @ref nanocbor_encoded_len.
+ *
+ * The history is a histogram with four buckets per power of two, so a
+ * buffer is at most 25% larger than the quantile size. The counts are
+ * halved every @ref NANOCBOR_POOL_HISTORY recorded sizes to follow changes
+ * in the message sizes.
+ *
+ * Every message type caches a single released buffer for reuse. The pool is
+ * not thread-safe.
+ *
+ * @{
+ *
+ * @file
+ */
+
+#ifndef NANOCBOR_POOL_H
+#define NANOCBOR_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "nanocbor/config.h"
+#include "nanocbor/nanocbor.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Number of size buckets of a message type, sizes from 112 KiB up
+ *        share the last bucket
+ */
+#define NANOCBOR_POOL_BUCKETS 64
+
+/**
+ * @brief Size history and cached buffer of a message type
+ */
+typedef struct {
+    uint16_t counts[NANOCBOR_POOL_BUCKETS]; /**< Sizes per bucket */
+    uint32_t total; /**< Sum of @p counts */
+    size_t max_len; /**< Largest size in the last bucket */
+    uint8_t *buf; /**< Cached buffer, NULL if none */
+    size_t buf_len; /**< Size of the cached buffer */
+    uint32_t encodes; /**< Number of messages encoded */
+    uint32_t retries; /**< Number of messages encoded twice */
+} nanocbor_pool_class_t;
+
+/**
+ * @brief Encoder buffer pool
+ */
+typedef struct {
+    nanocbor_pool_class_t *classes; /**< Message types */
+    size_t num_classes; /**< Number of message types */
+} nanocbor_pool_t;
+
+/**
+ * @brief Encode a message
+ *
+ * @param   enc     Encoder to encode the message with
+ * @param   arg     Argument passed to @ref nanocbor_pool_encode
+ *
+ * @return          negative to abort the encoding, NANOCBOR_ERR_END from a
+ *                  failed encoder call to have the message encoded again into
+ *                  a larger buffer
+ */
+typedef int (*nanocbor_pool_encode_t)(nanocbor_encoder_t *enc, void *arg);
+
+/**
+ * @brief Initialize a pool
+ *
+ * @param[out]  pool        Pool to initialize
+ * @param[in]   classes     Storage for the message types
+ * @param[in]   num_classes Number of message types
+ */
+void nanocbor_pool_init(nanocbor_pool_t *pool, nanocbor_pool_class_t *classes,
+                        size_t num_classes);
+
+/**
+ * @brief Free the cached buffers of a pool
+ *
+ * @param[in]   pool    Pool
+ */
+void nanocbor_pool_deinit(nanocbor_pool_t *pool);
+
+/**
+ * @brief Record the encoded size of a message
+ *
+ * @param[in]   pool    Pool
+ * @param[in]   type    Message type, less than the number of message types
+ * @param[in]   len     Encoded size
+ */
+void nanocbor_pool_record(nanocbor_pool_t *pool, unsigned type, size_t len);
+
+/**
+ * @brief Estimate the buffer size for a message type
+ *
+ * @param[in]   pool    Pool
+ * @param[in]   type    Message type
+ *
+ * @return              Size covering the quantile of the recorded sizes, 0
+ *                      without history
+ */
+size_t nanocbor_pool_estimate(const nanocbor_pool_t *pool, unsigned type);
+
+/**
+ * @brief Take a buffer of at least the estimated size for a message type
+ *
+ * @param[in]   pool    Pool
+ * @param[in]   type    Message type
+ * @param[out]  buf     Buffer, to be returned with @ref nanocbor_pool_release
+ * @param[out]  len     Size of @p buf
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              NANOCBOR_ERR_OVERFLOW when allocating failed
+ */
+int nanocbor_pool_acquire(nanocbor_pool_t *pool, unsigned type, uint8_t **buf,
+                          size_t *len);
+
+/**
+ * @brief Return a buffer to the pool
+ *
+ * The buffer is cached for the message type or freed when a buffer is
+ * already cached.
+ *
+ * @param[in]   pool    Pool
+ * @param[in]   type    Message type
+ * @param[in]   buf     Buffer from @ref nanocbor_pool_acquire or
+ *                      @ref nanocbor_pool_encode
+ * @param[in]   len     Size of @p buf
+ */
+void nanocbor_pool_release(nanocbor_pool_t *pool, unsigned type, uint8_t *buf,
+                           size_t len);
+
+/**
+ * @brief Encode a message into a pool buffer
+ *
+ * Calls @p encode with an encoder on a buffer from
+ * @ref nanocbor_pool_acquire, and once more with a buffer of the exact size
+ * when the message did not fit. The encoded size is recorded.
+ *
+ * The message did not fit when the encoded length exceeds the buffer. This
+ * is the case both when @p encode ignores the results of the encoder calls
+ * and when it returns NANOCBOR_ERR_END from the first call that did not fit.
+ * In the latter case, @p encode is called once more with an encoder that
+ * only counts, to determine the exact size.
+ *
+ * @param[in]   pool    Pool
+ * @param[in]   type    Message type
+ * @param[in]   encode  Function encoding the message, called up to three
+ *                      times
+ * @param[in]   arg     Argument passed to @p encode
+ * @param[out]  buf     Buffer with the message, to be returned with
+ *                      @ref nanocbor_pool_release
+ * @param[out]  size    Size of @p buf
+ * @param[out]  len     Encoded length of the message
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              NANOCBOR_ERR_OVERFLOW when allocating failed
+ * @return              negative result of @p encode, the buffer is released
+ */
+int nanocbor_pool_encode(nanocbor_pool_t *pool, unsigned type,
+                         nanocbor_pool_encode_t encode, void *arg,
+                         uint8_t **buf, size_t *size, size_t *len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NANOCBOR_POOL_H */
+/** @} */
@@ -0,0 +1,186 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @defgroup    nanocbor_query NanoCBOR query
+ * @brief       Filter, projection and aggregation over CBOR sequences
+ *
+ * A query selects the records of a CBOR sequence that match all of its
+ * predicates. For every matching record the projected values are handed to a
+ * callback together with the raw bytes of the record, allowing the record or
+ * the values to be copied to the output without re-encoding them. Aggregates
+ * are updated with the values of every matching record.
+ *
+ * Values are addressed with a path similar to a JSON pointer: `/temp/0`
+ * descends into the map entry with text key `temp` and then into the first
+ * array element. A numeric path segment also matches integer map keys. Tags
+ * are skipped while descending and when comparing values. The empty path
+ * addresses the record itself.
+ *
+ * @{
+ *
+ * @file
+ */
+
+#ifndef NANOCBOR_QUERY_H
+#define NANOCBOR_QUERY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "nanocbor/config.h"
+#include "nanocbor/nanocbor.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Predicate comparison operators
+ */
+typedef enum {
+    NANOCBOR_QUERY_EXISTS, /**< Path is present in the record */
+    NANOCBOR_QUERY_EQ, /**< Value equals the operand */
+    NANOCBOR_QUERY_NE, /**< Value is not equal to the operand */
+    NANOCBOR_QUERY_LT, /**< Value is less than the operand */
+    NANOCBOR_QUERY_LE, /**< Value is less than or equal to the operand */
+    NANOCBOR_QUERY_GT, /**< Value is greater than the operand */
+    NANOCBOR_QUERY_GE, /**< Value is greater than or equal to the operand */
+} nanocbor_query_op_t;
+
+/**
+ * @brief Predicate operand types
+ */
+typedef enum {
+    NANOCBOR_QUERY_INT, /**< Integer operand, compared exactly with integers */
+    NANOCBOR_QUERY_FLOAT, /**< Floating point operand */
+    NANOCBOR_QUERY_TSTR, /**< Text string operand, compared bytewise */
+} nanocbor_query_type_t;
+
+/**
+ * @brief Query predicate
+ *
+ * Numeric operands are compared with integer and floating point values,
+ * text string operands with text string values. A comparison against a value
+ * of another type or a missing value never matches.
+ */
+typedef struct {
+    const char *path; /**< Path of the compared value */
+    nanocbor_query_op_t op; /**< Comparison operator */
+    nanocbor_query_type_t type; /**< Type of the operand */
+    union {
+        int64_t i; /**< Integer operand */
+        double f; /**< Floating point operand */
+        const char *s; /**< Zero terminated text string operand */
+    } value; /**< Operand */
+} nanocbor_query_pred_t;
+
+/**
+ * @brief Aggregate over the matching records
+ *
+ * Initialize with all counters set to zero.
+ */
+typedef struct {
+    const char *path; /**< Path of the aggregated value */
+    uint64_t count; /**< Number of matching records containing the path */
+    uint64_t numeric; /**< Number of numeric values aggregated */
+    double sum; /**< Sum of the numeric values */
+    double min; /**< Minimum numeric value, valid if numeric is not zero */
+    double max; /**< Maximum numeric value, valid if numeric is not zero */
+} nanocbor_query_agg_t;
+
+/**
+ * @brief Query definition
+ */
+typedef struct {
+    const nanocbor_query_pred_t *where; /**< Predicates, all must match */
+    size_t num_where; /**< Number of predicates */
+    const char *const *select; /**< Paths of the projected values */
+    size_t num_select; /**< Number of projected values, at most
+                            @ref NANOCBOR_QUERY_SELECT_MAX */
+    nanocbor_query_agg_t *aggs; /**< Aggregates to update */
+    size_t num_aggs; /**< Number of aggregates */
+} nanocbor_query_t;
+
+/**
+ * @brief Callback for every matching record
+ *
+ * A projected value that is missing in the record is passed as a value that
+ * is at its end.
+ *
+ * @param   ctx         Context passed to @ref nanocbor_query_run
+ * @param   record      Encoded record
+ * @param   record_len  Length of @p record in bytes
+ * @param   values      Projected values, in the order of the select paths
+ * @param   num_values  Number of projected values
+ *
+ * @return              negative to abort the query
+ */
+typedef int (*nanocbor_query_cb_t)(void *ctx, const uint8_t *record,
+                                   size_t record_len,
+                                   const nanocbor_value_t *values,
+                                   size_t num_values);
+
+/**
+ * @brief Look up a value by path
+ *
+ * @param[in]   it      CBOR item to start from
+ * @param[in]   path    Zero terminated path
+ * @param[out]  value   Set to the addressed value
+ *
+ * @return              NANOCBOR_OK if the value is found
+ * @return              NANOCBOR_NOT_FOUND if the path is not present
+ * @return              NANOCBOR_ERR_INVALID_TYPE if the path does not start
+ *                      with a `/`
+ * @return              negative on decode errors
+ */
+int nanocbor_query_path(const nanocbor_value_t *it, const char *path,
+                        nanocbor_value_t *value);
+
+/**
+ * @brief Check whether a single record matches all predicates of a query
+ *
+ * @param[in]   query   Query to evaluate
+ * @param[in]   record  Record to check
+ *
+ * @return              true if the record matches
+ */
+bool nanocbor_query_match(const nanocbor_query_t *query,
+                          const nanocbor_value_t *record);
+
+/**
+ * @brief Run a query over all remaining records of a CBOR sequence
+ *
+ * The aggregates of @p query are updated with the matching records, allowing
+ * a query to be run over multiple parts of a sequence.
+ *
+ * @param[in]   query   Query to run
+ * @param[in]   it      Decoder positioned at the first record
+ * @param[in]   cb      Callback for the matching records, may be NULL
+ * @param[in]   ctx     Context passed to @p cb
+ *
+ * @return              NANOCBOR_OK when all records are processed
+ * @return              NANOCBOR_ERR_INVALID_TYPE on an invalid path
+ * @return              NANOCBOR_ERR_OVERFLOW on too many select paths
+ * @return              negative on decode errors or the result of @p cb
+ */
+int nanocbor_query_run(const nanocbor_query_t *query, nanocbor_value_t *it,
+                       nanocbor_query_cb_t cb, void *ctx);
+
+/**
+ * @brief Merge the counters of an aggregate into another
+ *
+ * @param[in,out]   dst     Aggregate to merge into
+ * @param[in]       src     Aggregate to merge from
+ */
+void nanocbor_query_agg_merge(nanocbor_query_agg_t *dst,
+                              const nanocbor_query_agg_t *src);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NANOCBOR_QUERY_H */
+/** @} */
@@ -0,0 +1,100 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @defgroup    nanocbor_resume NanoCBOR resumable decoding
+ * @brief       Time-sliced skipping and walking of large items
+ *
+ * Skipping or walking a large item with @ref nanocbor_skip runs until the
+ * whole item is decoded. The resumable decoder instead keeps the open
+ * containers in a state struct and stops after a caller-set budget of
+ * items, returning @ref NANOCBOR_RESUME_YIELD. A cooperative task calls
+ * @ref nanocbor_resume_run again on its next time slice to continue exactly
+ * where it stopped, until the item is completely checked for
+ * well-formedness and the decoder is advanced past it.
+ *
+ * Each array, map, tag and other item counts as one item of the budget.
+ * The optional visitor is called for all items that are not an array, map
+ * or tag.
+ *
+ * @{
+ *
+ * @file
+ */
+
+#ifndef NANOCBOR_RESUME_H
+#define NANOCBOR_RESUME_H
+
+#include <stdint.h>
+
+#include "nanocbor/config.h"
+#include "nanocbor/nanocbor.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Status returned when the budget is used up before the item is
+ *        decoded
+ */
+#define NANOCBOR_RESUME_YIELD 1
+
+/**
+ * @brief Visit an item
+ *
+ * @param   ctx     Context passed to @ref nanocbor_resume_init
+ * @param   item    Item to visit
+ * @param   depth   Number of containers around the item
+ *
+ * @return          negative to abort decoding
+ */
+typedef int (*nanocbor_resume_visit_t)(void *ctx, const nanocbor_value_t *item,
+                                       unsigned depth);
+
+/**
+ * @brief Resumable decoder state
+ */
+typedef struct {
+    nanocbor_value_t *it; /**< Decoder positioned at the item */
+    nanocbor_value_t stack[NANOCBOR_RECURSION_MAX]; /**< Open containers */
+    uint8_t depth; /**< Number of open containers */
+    nanocbor_resume_visit_t visit; /**< Visitor, NULL to only skip */
+    void *ctx; /**< Context passed to @p visit */
+} nanocbor_resume_t;
+
+/**
+ * @brief Initialize resumable decoding of an item
+ *
+ * @param[out]  state   State to initialize
+ * @param[in]   it      Decoder positioned at the item, must remain valid
+ *                      until decoding finished
+ * @param[in]   visit   Visitor, NULL to only skip the item
+ * @param[in]   ctx     Context passed to @p visit
+ */
+void nanocbor_resume_init(nanocbor_resume_t *state, nanocbor_value_t *it,
+                          nanocbor_resume_visit_t visit, void *ctx);
+
+/**
+ * @brief Continue decoding an item for at most a number of items
+ *
+ * @param[in]   state   State of the item
+ * @param[in]   budget  Maximum number of items to decode
+ *
+ * @return              NANOCBOR_OK when the item is decoded, the decoder
+ *                      of @ref nanocbor_resume_init is advanced past it
+ * @return              NANOCBOR_RESUME_YIELD when @p budget is used up
+ * @return              NANOCBOR_ERR_RECURSION if containers nest deeper
+ *                      than @ref NANOCBOR_RECURSION_MAX
+ * @return              negative on decode errors or the result of the
+ *                      visitor, the state can not be resumed
+ */
+int nanocbor_resume_run(nanocbor_resume_t *state, uint32_t budget);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NANOCBOR_RESUME_H */
+/** @} */
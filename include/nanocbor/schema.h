@@ -0,0 +1,93 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @defgroup    nanocbor_schema NanoCBOR schema validation
+ * @brief       Validates CBOR structures against a compiled CDDL schema
+ *
+ * A CDDL schema is compiled once into a compact bytecode program with
+ * @ref nanocbor_schema_compile. Messages are validated against the program
+ * with @ref nanocbor_schema_validate in a single pass without recursion or
+ * allocation.
+ *
+ * Supported is a subset of CDDL:
+ *  - Rules with references to other rules, the first rule is the root
+ *  - The prelude types any, uint, nint, int, bstr, bytes, tstr, text, bool,
+ *    true, false, null, nil, undefined and the float types
+ *  - Integer and text string literals
+ *  - Type choices with `/`
+ *  - Arrays and maps with `?`, `*` and `+` occurrence indicators
+ *  - Map keys as `name:`, `1:`, `"name":` or `type =>`
+ *  - Tags as `#6.n(type)`
+ *
+ * Choices and occurrences are resolved on the first match of the current item
+ * without backtracking. A scalar alternative must match completely, an array,
+ * map or tag alternative is taken as soon as the item has the same type.
+ *
+ * @{
+ *
+ * @file
+ */
+
+#ifndef NANOCBOR_SCHEMA_H
+#define NANOCBOR_SCHEMA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "nanocbor/nanocbor.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Compile a CDDL schema into a validation program
+ *
+ * It is safe to pass `NULL` to @p buf with @p len pointing to `0` to determine
+ * the size of the program.
+ *
+ * @param[out]      buf         Buffer to write the program into
+ * @param[in,out]   len         Length of @p buf, set to the length of the
+ *                              program
+ * @param[in]       cddl        CDDL schema text
+ * @param[in]       cddl_len    Length of @p cddl in bytes
+ *
+ * @return                      NANOCBOR_OK on success
+ * @return                      NANOCBOR_ERR_END if @p buf is too small
+ * @return                      NANOCBOR_ERR_INVALID_TYPE on syntax errors
+ * @return                      NANOCBOR_NOT_FOUND on an undefined rule name
+ * @return                      NANOCBOR_ERR_RECURSION if rules nest too deep
+ * @return                      NANOCBOR_ERR_OVERFLOW if the schema exceeds a
+ *                              limit
+ */
+int nanocbor_schema_compile(uint8_t *buf, size_t *len, const char *cddl,
+                            size_t cddl_len);
+
+/**
+ * @brief Validate the next CBOR item against a compiled schema
+ *
+ * @p it is advanced past the item on success. The position of @p it is
+ * undefined on failure.
+ *
+ * @param[in]   prog        Program compiled with @ref nanocbor_schema_compile
+ * @param[in]   prog_len    Length of @p prog in bytes
+ * @param[in]   it          CBOR value to validate
+ *
+ * @return                  NANOCBOR_OK if the item matches the schema
+ * @return                  NANOCBOR_ERR_INVALID_TYPE on a mismatch
+ * @return                  NANOCBOR_NOT_FOUND on a missing map entry
+ * @return                  NANOCBOR_ERR_RECURSION if the item nests deeper
+ *                          than @ref NANOCBOR_RECURSION_MAX
+ * @return                  negative on other decode errors
+ */
+int nanocbor_schema_validate(const uint8_t *prog, size_t prog_len,
+                             nanocbor_value_t *it);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NANOCBOR_SCHEMA_H */
+/** @} */
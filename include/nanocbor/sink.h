@@ -0,0 +1,194 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @defgroup    nanocbor_sink NanoCBOR double-buffered encoder sink
+ * @brief       Overlaps encoding with writing the encoded data
+ *
+ * The sink is a target for @ref nanocbor_encoder_stream_init with two
+ * buffers. The encoder fills one buffer while the other is written, and the
+ * buffers are swapped when the filled one is full. The encoder only blocks
+ * when it filled its buffer while the other is still being written.
+ *
+ * Buffers are written in one of two ways:
+ *
+ * - With a submit function that starts an asynchronous write, such as a DMA
+ *   transfer, and returns. The write is finished by calling
+ *   @ref nanocbor_sink_complete from any thread or from within the submit
+ *   function.
+ * - With a blocking write function run on an I/O thread owned by the sink,
+ *   see @ref nanocbor_sink_init_thread.
+ *
+ * Only one buffer is written at a time and buffers are written in order.
+ * Requires @ref NANOCBOR_SINK. The submit function mode needs no threads
+ * library: the encoder and the completing context hand over buffers through
+ * an atomic flag, so @ref nanocbor_sink_complete may be called from an
+ * interrupt handler. The encoder spins while waiting for a write to
+ * complete. The I/O thread additionally requires
+ * @ref NANOCBOR_SINK_THREAD for the POSIX threads primitives.
+ *
+ * @{
+ *
+ * @file
+ */
+
+#ifndef NANOCBOR_SINK_H
+#define NANOCBOR_SINK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "nanocbor/config.h"
+#include "nanocbor/nanocbor.h"
+
+#if NANOCBOR_SINK || defined(DOXYGEN)
+#if NANOCBOR_SINK_THREAD
+#include <pthread.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Double-buffered sink forward declaration
+ */
+typedef struct nanocbor_sink nanocbor_sink_t;
+
+/**
+ * @brief Start writing a filled buffer
+ *
+ * The buffer must not be accessed after the write is finished with
+ * @ref nanocbor_sink_complete.
+ *
+ * @param   sink    Sink the buffer belongs to
+ * @param   ctx     Context supplied at initialization
+ * @param   buf     Encoded data
+ * @param   len     Length of @p buf
+ */
+typedef void (*nanocbor_sink_submit)(nanocbor_sink_t *sink, void *ctx,
+                                     const uint8_t *buf, size_t len);
+
+#if NANOCBOR_SINK_THREAD || defined(DOXYGEN)
+/**
+ * @brief Write a filled buffer, called on the I/O thread
+ *
+ * @param   ctx     Context supplied at initialization
+ * @param   buf     Encoded data
+ * @param   len     Length of @p buf
+ *
+ * @return          NANOCBOR_OK on success, negative on failure
+ */
+typedef int (*nanocbor_sink_write)(void *ctx, const uint8_t *buf, size_t len);
+#endif
+
+/**
+ * @brief Double-buffered sink
+ */
+struct nanocbor_sink {
+    uint8_t *bufs[2]; /**< Buffers */
+    size_t size; /**< Size of each buffer */
+    size_t used; /**< Bytes in use of the buffer being filled */
+    unsigned fill; /**< Index of the buffer being filled */
+    volatile bool busy; /**< Whether the other buffer is being written */
+    volatile int status; /**< First error reported by a write */
+    bool failed; /**< Whether the encoder has seen a failed write */
+    nanocbor_sink_submit submit; /**< Function starting a write */
+    void *ctx; /**< Context of the write functions */
+#if NANOCBOR_SINK_THREAD || defined(DOXYGEN)
+    nanocbor_sink_write write; /**< Write function of the I/O thread */
+    const uint8_t *pending; /**< Buffer handed to the I/O thread */
+    size_t pending_len; /**< Length of the pending buffer */
+    bool stop; /**< Whether the I/O thread is asked to stop */
+    bool threaded; /**< Whether the sink owns an I/O thread */
+    pthread_t thread; /**< I/O thread */
+    pthread_mutex_t lock; /**< Protects the write state */
+    pthread_cond_t cond; /**< Signals write state changes */
+#endif
+};
+
+/**
+ * @brief Initialize a sink with an asynchronous submit function
+ *
+ * @param[out]  sink    Sink to initialize
+ * @param[in]   buf     Memory for both buffers, split in two halves
+ * @param[in]   len     Length of @p buf, at least 2 bytes
+ * @param[in]   submit  Function starting the write of a filled buffer
+ * @param[in]   ctx     Context passed to @p submit
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              NANOCBOR_ERR_OVERFLOW when @p buf is too small
+ */
+int nanocbor_sink_init(nanocbor_sink_t *sink, uint8_t *buf, size_t len,
+                       nanocbor_sink_submit submit, void *ctx);
+
+#if NANOCBOR_SINK_THREAD || defined(DOXYGEN)
+/**
+ * @brief Initialize a sink writing from an I/O thread
+ *
+ * @param[out]  sink    Sink to initialize
+ * @param[in]   buf     Memory for both buffers, split in two halves
+ * @param[in]   len     Length of @p buf, at least 2 bytes
+ * @param[in]   write   Blocking write function run on the I/O thread
+ * @param[in]   ctx     Context passed to @p write
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              NANOCBOR_ERR_OVERFLOW when @p buf is too small,
+ *                      allocating the synchronization primitives or starting
+ *                      the thread failed
+ */
+int nanocbor_sink_init_thread(nanocbor_sink_t *sink, uint8_t *buf, size_t len,
+                              nanocbor_sink_write write, void *ctx);
+#endif
+
+/**
+ * @brief Initialize an encoder writing into a sink
+ *
+ * Encoding fails with NANOCBOR_ERR_END once a failed write is noticed when
+ * swapping buffers.
+ *
+ * @param[out]  enc     Encoder to initialize
+ * @param[in]   sink    Initialized sink
+ */
+void nanocbor_sink_encoder_init(nanocbor_encoder_t *enc,
+                                nanocbor_sink_t *sink);
+
+/**
+ * @brief Finish the write of the submitted buffer
+ *
+ * Safe to call from an interrupt handler in the submit function mode.
+ *
+ * @param[in]   sink    Sink
+ * @param[in]   res     NANOCBOR_OK on success, negative on failure
+ */
+void nanocbor_sink_complete(nanocbor_sink_t *sink, int res);
+
+/**
+ * @brief Write the partially filled buffer and wait for all writes
+ *
+ * @param[in]   sink    Sink
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              the first error reported by a write
+ */
+int nanocbor_sink_flush(nanocbor_sink_t *sink);
+
+/**
+ * @brief Flush the sink, stop its I/O thread and release its resources
+ *
+ * @param[in]   sink    Sink
+ *
+ * @return              the result of @ref nanocbor_sink_flush
+ */
+int nanocbor_sink_close(nanocbor_sink_t *sink);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NANOCBOR_SINK */
+
+#endif /* NANOCBOR_SINK_H */
+/** @} */
@@ -0,0 +1,119 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @defgroup    nanocbor_sort NanoCBOR sequence sorting
+ * @brief       Sorting of CBOR sequences by the value at a path
+ *
+ * Building blocks for an external merge sort of a CBOR sequence. A bounded
+ * number of records is collected with @ref nanocbor_sort_collect and ordered
+ * with @ref nanocbor_sort_entries to form a sorted run. Multiple sorted runs
+ * are merged with @ref nanocbor_sort_merge. Records are never decoded or
+ * copied, only pointers to them are moved.
+ *
+ * Records are ordered by the key at the path, see @ref nanocbor_query_path,
+ * using @ref nanocbor_compare. Records without the key sort first. The sort
+ * is stable: records with equal keys keep the order of the input.
+ *
+ * @{
+ *
+ * @file
+ */
+
+#ifndef NANOCBOR_SORT_H
+#define NANOCBOR_SORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "nanocbor/nanocbor.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Reference to a record and its sort key
+ */
+typedef struct {
+    const uint8_t *record; /**< Encoded record */
+    size_t len; /**< Length of the encoded record */
+    nanocbor_value_t key; /**< Sort key, at its end if missing */
+    size_t seq; /**< Position in the input, for stability */
+} nanocbor_sort_entry_t;
+
+/**
+ * @brief Sorted run to merge
+ *
+ * Initialize @p it with a decoder over the sorted run, the head is managed by
+ * @ref nanocbor_sort_merge.
+ */
+typedef struct {
+    nanocbor_value_t it; /**< Remaining records of the run */
+    nanocbor_sort_entry_t head; /**< Current record of the run */
+} nanocbor_sort_run_t;
+
+/**
+ * @brief Callback for every record in sorted order
+ *
+ * @param   ctx     Context passed to @ref nanocbor_sort_merge
+ * @param   record  Encoded record
+ * @param   len     Length of @p record in bytes
+ *
+ * @return          negative to abort the merge
+ */
+typedef int (*nanocbor_sort_cb_t)(void *ctx, const uint8_t *record,
+                                  size_t len);
+
+/**
+ * @brief Collect records of a sequence for sorting
+ *
+ * Collects records from @p it until the sequence ends or @p entries is full.
+ *
+ * @param[in]       it          Decoder positioned at the first record
+ * @param[in]       path        Path of the sort key
+ * @param[out]      entries     Entries to fill
+ * @param[in,out]   num_entries Capacity of @p entries, set to the number of
+ *                              collected records
+ *
+ * @return                      NANOCBOR_OK on success
+ * @return                      NANOCBOR_ERR_INVALID_TYPE on an invalid path
+ * @return                      negative on decode errors
+ */
+int nanocbor_sort_collect(nanocbor_value_t *it, const char *path,
+                          nanocbor_sort_entry_t *entries, size_t *num_entries);
+
+/**
+ * @brief Sort collected entries by their key
+ *
+ * @param[in,out]   entries     Entries to sort
+ * @param[in]       num_entries Number of entries
+ */
+void nanocbor_sort_entries(nanocbor_sort_entry_t *entries, size_t num_entries);
+
+/**
+ * @brief Merge sorted runs
+ *
+ * The runs are reordered while merging, runs earlier in @p runs win ties.
+ *
+ * @param[in,out]   runs        Runs to merge
+ * @param[in]       num_runs    Number of runs
+ * @param[in]       path        Path of the sort key
+ * @param[in]       cb          Callback for every record in sorted order
+ * @param[in]       ctx         Context passed to @p cb
+ *
+ * @return                      NANOCBOR_OK when all runs are merged
+ * @return                      NANOCBOR_ERR_INVALID_TYPE on an invalid path
+ * @return                      negative on decode errors or the result of
+ *                              @p cb
+ */
+int nanocbor_sort_merge(nanocbor_sort_run_t *runs, size_t num_runs,
+                        const char *path, nanocbor_sort_cb_t cb, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NANOCBOR_SORT_H */
+/** @} */
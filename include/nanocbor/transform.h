@@ -0,0 +1,95 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @defgroup    nanocbor_transform NanoCBOR transform
+ * @brief       Rule based rewriting of CBOR items without re-encoding them
+ *
+ * A transform copies items from a decoder to an encoder while applying
+ * rules to the entries addressed by their path. Subtrees that no rule
+ * addresses are copied as raw bytes with @ref nanocbor_get_subcbor, so only
+ * the containers on the way to a rewritten entry are decoded. The item
+ * counts of definite-length containers are adjusted for dropped entries.
+ *
+ * Paths use the syntax of @ref nanocbor_query, with an additional `*`
+ * segment matching any map key or array element. The path with the segments
+ * `users`, `*` and `email` addresses the `email` entry of every element of
+ * `users`. Tags are copied while descending. The empty path addresses every
+ * item of the sequence itself.
+ *
+ * When multiple rules address the same entry, a rename is combined with the
+ * first of the other rules.
+ *
+ * @{
+ *
+ * @file
+ */
+
+#ifndef NANOCBOR_TRANSFORM_H
+#define NANOCBOR_TRANSFORM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "nanocbor/config.h"
+#include "nanocbor/nanocbor.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Transform operations
+ */
+typedef enum {
+    NANOCBOR_TRANSFORM_DROP, /**< Remove the map entry or array element */
+    NANOCBOR_TRANSFORM_RENAME, /**< Replace the key of a map entry */
+    NANOCBOR_TRANSFORM_REPLACE, /**< Replace the value */
+    /**
+     * @brief Replace the value by an empty value of the same major type:
+     *        zero, an empty string, array or map, or null for simple values
+     *        and floats
+     */
+    NANOCBOR_TRANSFORM_REDACT,
+} nanocbor_transform_op_t;
+
+/**
+ * @brief Transform rule
+ */
+typedef struct {
+    const char *path; /**< Path of the rewritten entry */
+    nanocbor_transform_op_t op; /**< Operation */
+    const uint8_t *data; /**< Pre-encoded key for a rename or value for a
+                              replacement */
+    size_t len; /**< Length of @p data */
+} nanocbor_transform_rule_t;
+
+/**
+ * @brief Transform all remaining items of a CBOR sequence
+ *
+ * @param[in]   rules       Rules to apply
+ * @param[in]   num_rules   Number of rules, at most
+ *                          @ref NANOCBOR_TRANSFORM_RULES_MAX
+ * @param[in]   it          Decoder positioned at the first item
+ * @param[in]   enc         Encoder receiving the transformed items
+ *
+ * @return                  NANOCBOR_OK when all items are transformed
+ * @return                  NANOCBOR_ERR_INVALID_TYPE on an invalid path or a
+ *                          rename or replacement without data
+ * @return                  NANOCBOR_ERR_OVERFLOW on too many rules
+ * @return                  NANOCBOR_ERR_RECURSION if addressed containers
+ *                          nest deeper than @ref NANOCBOR_RECURSION_MAX
+ * @return                  NANOCBOR_ERR_END when the encoder is full
+ * @return                  negative on decode errors
+ */
+int nanocbor_transform(const nanocbor_transform_rule_t *rules,
+                       size_t num_rules, nanocbor_value_t *it,
+                       nanocbor_encoder_t *enc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NANOCBOR_TRANSFORM_H */
+/** @} */
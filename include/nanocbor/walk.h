@@ -0,0 +1,124 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @defgroup    nanocbor_walk NanoCBOR document walker
+ * @brief       Visits all leaf items of a document with a reduction
+ *
+ * The walker calls a visitor for every item of a document that is not an
+ * array, map or tag, using the structural index of @ref nanocbor_index to
+ * locate containers. Results are accumulated per task into an accumulator
+ * and combined into the final result.
+ *
+ * With @ref NANOCBOR_WALK_PARALLEL enabled, @ref nanocbor_walk_parallel
+ * splits containers recursively into tasks of items until a task is below
+ * the grain size and runs them on a pool of threads with work-stealing
+ * deques. Unbalanced documents, where a single subtree holds most of the
+ * data, are thus split at every level. The visitor must be thread-safe and
+ * the combine operation associative and commutative, as the order of
+ * visits across tasks is undefined.
+ *
+ * @{
+ *
+ * @file
+ */
+
+#ifndef NANOCBOR_WALK_H
+#define NANOCBOR_WALK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "nanocbor/config.h"
+#include "nanocbor/index.h"
+#include "nanocbor/nanocbor.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Walker operations
+ */
+typedef struct {
+    size_t acc_size; /**< Size of an accumulator in bytes */
+    /**
+     * @brief Initialize an empty accumulator
+     */
+    void (*init)(void *ctx, void *acc);
+    /**
+     * @brief Visit a leaf item
+     *
+     * @param   ctx     Context passed to the walker
+     * @param   acc     Accumulator of the task
+     * @param   item    Item to visit
+     * @param   node    Container of the item, NANOCBOR_INDEX_NONE at the top
+     * @param   index   Position of the item in the container, keys of a map
+     *                  are at even and values at odd positions
+     *
+     * @return          negative to abort the walk
+     */
+    int (*visit)(void *ctx, void *acc, const nanocbor_value_t *item,
+                 uint32_t node, uint32_t index);
+    /**
+     * @brief Combine accumulator @p other into @p acc
+     */
+    void (*combine)(void *ctx, void *acc, const void *other);
+} nanocbor_walk_ops_t;
+
+/**
+ * @brief Walk all leaf items of a buffer in document order
+ *
+ * @param[in]   buf         Buffer with a CBOR item or sequence
+ * @param[in]   len         Length of @p buf
+ * @param[in]   nodes       Structural index of @p buf
+ * @param[in]   num_nodes   Number of nodes
+ * @param[in]   ops         Walker operations
+ * @param[in]   ctx         Context passed to the operations
+ * @param[out]  result      Accumulator for the result
+ *
+ * @return                  NANOCBOR_OK on success
+ * @return                  NANOCBOR_ERR_RECURSION if containers nest
+ *                          deeper than @ref NANOCBOR_RECURSION_MAX
+ * @return                  negative on decode errors or the result of the
+ *                          visitor
+ */
+int nanocbor_walk(const uint8_t *buf, size_t len,
+                  const nanocbor_index_node_t *nodes, size_t num_nodes,
+                  const nanocbor_walk_ops_t *ops, void *ctx, void *result);
+
+#if NANOCBOR_WALK_PARALLEL || defined(DOXYGEN)
+/**
+ * @brief Walk all leaf items of a buffer on multiple threads
+ *
+ * @param[in]   buf         Buffer with a CBOR item or sequence
+ * @param[in]   len         Length of @p buf
+ * @param[in]   nodes       Structural index of @p buf
+ * @param[in]   num_nodes   Number of nodes
+ * @param[in]   ops         Walker operations
+ * @param[in]   ctx         Context passed to the operations
+ * @param[in]   threads     Number of threads, at most
+ *                          @ref NANOCBOR_WALK_THREADS_MAX
+ * @param[in]   grain       Size in bytes below which a task is not split
+ * @param[out]  result      Accumulator for the result
+ *
+ * @return                  NANOCBOR_OK on success
+ * @return                  NANOCBOR_ERR_OVERFLOW on too many threads or
+ *                          when allocating resources failed
+ * @return                  negative on decode errors or the result of the
+ *                          visitor
+ */
+int nanocbor_walk_parallel(const uint8_t *buf, size_t len,
+                           const nanocbor_index_node_t *nodes,
+                           size_t num_nodes, const nanocbor_walk_ops_t *ops,
+                           void *ctx, unsigned threads, size_t grain,
+                           void *result);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NANOCBOR_WALK_H */
+/** @} */
@@ -0,0 +1,802 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @file
+ * @brief   CPython extension module around the NanoCBOR decoder and encoder
+ *
+ * Items are decoded into the builtin Python types, tags into
+ * `nanocbor.Tag(tag, value)`. Byte strings are returned as `bytes`, or as
+ * `memoryview` slices of the input with `zero_copy=True`. Objects with the
+ * buffer protocol and an integer or floating point item format, such as
+ * `array.array`, are encoded as arrays straight from their buffer.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "nanocbor/nanocbor.h"
+
+#define BUFFER_MIN_SIZE 256
+
+static PyObject *_decode_error;
+
+static PyStructSequence_Field _tag_fields[] = {
+    { "tag", "Tag number" },
+    { "value", "Tagged item" },
+    { NULL, NULL },
+};
+
+static PyStructSequence_Desc _tag_desc = {
+    "nanocbor.Tag",
+    "Tagged CBOR item",
+    _tag_fields,
+    2,
+};
+
+static PyTypeObject *_tag_type;
+
+typedef struct {
+    const uint8_t *start; /**< Start of the input */
+    PyObject *view; /**< memoryview of the input for zero copy byte strings */
+} _decoder_t;
+
+typedef struct {
+    uint8_t *data;
+    size_t len;
+    size_t size;
+} _buffer_t;
+
+static PyObject *_error(int res, const _decoder_t *dec,
+                        const nanocbor_value_t *it)
+{
+    PyErr_Format(_decode_error, "CBOR decode error %d at offset %zd", res,
+                 (Py_ssize_t)(it->cur - dec->start));
+    return NULL;
+}
+
+static PyObject *_decode(const _decoder_t *dec, nanocbor_value_t *it);
+
+static PyObject *_decode_bstr(const _decoder_t *dec, nanocbor_value_t *it)
+{
+    const uint8_t *buf = NULL;
+    size_t len = 0;
+    int res = nanocbor_get_bstr(it, &buf, &len);
+
+    if (res < 0) {
+        return _error(res, dec, it);
+    }
+    if (dec->view) {
+        Py_ssize_t start = buf - dec->start;
+        return PySequence_GetSlice(dec->view, start, start + (Py_ssize_t)len);
+    }
+    return PyBytes_FromStringAndSize((const char *)buf, (Py_ssize_t)len);
+}
+
+static PyObject *_decode_tstr(const _decoder_t *dec, nanocbor_value_t *it)
+{
+    const uint8_t *buf = NULL;
+    size_t len = 0;
+    int res = nanocbor_get_tstr(it, &buf, &len);
+
+    if (res < 0) {
+        return _error(res, dec, it);
+    }
+    return PyUnicode_DecodeUTF8((const char *)buf, (Py_ssize_t)len, NULL);
+}
+
+static PyObject *_decode_array(const _decoder_t *dec, nanocbor_value_t *it)
+{
+    nanocbor_value_t arr;
+    int res = nanocbor_enter_array(it, &arr);
+
+    if (res < 0) {
+        return _error(res, dec, it);
+    }
+    PyObject *list = PyList_New(0);
+    if (!list) {
+        return NULL;
+    }
+    while (!nanocbor_at_end(&arr)) {
+        PyObject *item = _decode(dec, &arr);
+        if (!item || PyList_Append(list, item) < 0) {
+            Py_XDECREF(item);
+            Py_DECREF(list);
+            return NULL;
+        }
+        Py_DECREF(item);
+    }
+    res = nanocbor_leave_container_early(it, &arr);
+    if (res < 0) {
+        Py_DECREF(list);
+        return _error(res, dec, it);
+    }
+    return list;
+}
+
+static PyObject *_decode_map(const _decoder_t *dec, nanocbor_value_t *it)
+{
+    nanocbor_value_t map;
+    int res = nanocbor_enter_map(it, &map);
+
+    if (res < 0) {
+        return _error(res, dec, it);
+    }
+    PyObject *dict = PyDict_New();
+    if (!dict) {
+        return NULL;
+    }
+    while (!nanocbor_at_end(&map)) {
+        PyObject *key = _decode(dec, &map);
+        PyObject *value = key ? _decode(dec, &map) : NULL;
+        if (!value || PyDict_SetItem(dict, key, value) < 0) {
+            Py_XDECREF(key);
+            Py_XDECREF(value);
+            Py_DECREF(dict);
+            return NULL;
+        }
+        Py_DECREF(key);
+        Py_DECREF(value);
+    }
+    res = nanocbor_leave_container_early(it, &map);
+    if (res < 0) {
+        Py_DECREF(dict);
+        return _error(res, dec, it);
+    }
+    return dict;
+}
+
+static PyObject *_decode_tag(const _decoder_t *dec, nanocbor_value_t *it)
+{
+    uint64_t num = 0;
+    int res = nanocbor_get_tag64(it, &num);
+
+    if (res < 0) {
+        return _error(res, dec, it);
+    }
+    PyObject *tag = PyStructSequence_New(_tag_type);
+    if (!tag) {
+        return NULL;
+    }
+    PyObject *number = PyLong_FromUnsignedLongLong(num);
+    PyObject *value = number ? _decode(dec, it) : NULL;
+    if (!value) {
+        Py_XDECREF(number);
+        Py_DECREF(tag);
+        return NULL;
+    }
+    PyStructSequence_SetItem(tag, 0, number);
+    PyStructSequence_SetItem(tag, 1, value);
+    return tag;
+}
+
+static PyObject *_decode_simple(const _decoder_t *dec, nanocbor_value_t *it)
+{
+    bool flag = false;
+    double num = 0;
+
+    if (nanocbor_get_bool(it, &flag) == NANOCBOR_OK) {
+        return PyBool_FromLong(flag);
+    }
+    if (nanocbor_get_null(it) == NANOCBOR_OK
+        || nanocbor_get_undefined(it) == NANOCBOR_OK) {
+        Py_RETURN_NONE;
+    }
+    int res = nanocbor_get_double(it, &num);
+    if (res < 0) {
+        return _error(res, dec, it);
+    }
+    return PyFloat_FromDouble(num);
+}
+
+/* NOLINTNEXTLINE(misc-no-recursion) */
+static PyObject *_decode(const _decoder_t *dec, nanocbor_value_t *it)
+{
+    PyObject *obj = NULL;
+    int res = NANOCBOR_OK;
+
+    if (Py_EnterRecursiveCall(" while decoding CBOR")) {
+        return NULL;
+    }
+    switch (nanocbor_get_type(it)) {
+    case NANOCBOR_TYPE_UINT: {
+        uint64_t num = 0;
+        res = nanocbor_get_uint64(it, &num);
+        obj = res < 0 ? NULL : PyLong_FromUnsignedLongLong(num);
+        break;
+    }
+    case NANOCBOR_TYPE_NINT: {
+        int64_t num = 0;
+        res = nanocbor_get_int64(it, &num);
+        obj = res < 0 ? NULL : PyLong_FromLongLong(num);
+        break;
+    }
+    case NANOCBOR_TYPE_BSTR:
+        obj = _decode_bstr(dec, it);
+        break;
+    case NANOCBOR_TYPE_TSTR:
+        obj = _decode_tstr(dec, it);
+        break;
+    case NANOCBOR_TYPE_ARR:
+        obj = _decode_array(dec, it);
+        break;
+    case NANOCBOR_TYPE_MAP:
+        obj = _decode_map(dec, it);
+        break;
+    case NANOCBOR_TYPE_TAG:
+        obj = _decode_tag(dec, it);
+        break;
+    case NANOCBOR_TYPE_FLOAT:
+        obj = _decode_simple(dec, it);
+        break;
+    default:
+        res = NANOCBOR_ERR_END;
+        break;
+    }
+    Py_LeaveRecursiveCall();
+    if (res < 0) {
+        return _error(res, dec, it);
+    }
+    return obj;
+}
+
+static PyObject *_loads(PyObject *data, int zero_copy, bool sequence)
+{
+    Py_buffer view;
+    _decoder_t dec = { NULL, NULL };
+    nanocbor_value_t it;
+    PyObject *result = NULL;
+
+    if (PyObject_GetBuffer(data, &view, PyBUF_C_CONTIGUOUS) < 0) {
+        return NULL;
+    }
+    dec.start = view.buf;
+    if (zero_copy) {
+        dec.view = PyMemoryView_FromObject(data);
+        if (!dec.view) {
+            PyBuffer_Release(&view);
+            return NULL;
+        }
+    }
+    nanocbor_decoder_init(&it, view.buf, (size_t)view.len);
+    if (sequence) {
+        result = PyList_New(0);
+        while (result && !nanocbor_at_end(&it)) {
+            PyObject *item = _decode(&dec, &it);
+            if (!item || PyList_Append(result, item) < 0) {
+                Py_CLEAR(result);
+            }
+            Py_XDECREF(item);
+        }
+    }
+    else {
+        result = _decode(&dec, &it);
+        if (result && !nanocbor_at_end(&it)) {
+            Py_CLEAR(result);
+            PyErr_Format(_decode_error, "Trailing data at offset %zd",
+                         (Py_ssize_t)(it.cur - dec.start));
+        }
+    }
+    Py_XDECREF(dec.view);
+    PyBuffer_Release(&view);
+    return result;
+}
+
+static char *_loads_kwlist[] = { "data", "zero_copy", NULL };
+
+PyDoc_STRVAR(_loads_doc,
+             "loads(data, *, zero_copy=False)\n--\n\n"
+             "Decode a single CBOR item from a bytes-like object.\n\n"
+             "With zero_copy, byte strings are returned as memoryview "
+             "slices of data.");
+
+static PyObject *_py_loads(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    PyObject *data = NULL;
+    int zero_copy = 0;
+
+    (void)self;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|$p", _loads_kwlist,
+                                     &data, &zero_copy)) {
+        return NULL;
+    }
+    return _loads(data, zero_copy, false);
+}
+
+PyDoc_STRVAR(_loads_seq_doc,
+             "loads_seq(data, *, zero_copy=False)\n--\n\n"
+             "Decode a CBOR sequence into a list of items.");
+
+static PyObject *_py_loads_seq(PyObject *self, PyObject *args,
+                               PyObject *kwargs)
+{
+    PyObject *data = NULL;
+    int zero_copy = 0;
+
+    (void)self;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|$p", _loads_kwlist,
+                                     &data, &zero_copy)) {
+        return NULL;
+    }
+    return _loads(data, zero_copy, true);
+}
+
+/* Counts the items of the array at it */
+static int _array_len(const nanocbor_value_t *it, size_t *len)
+{
+    nanocbor_value_t tmp = *it;
+    nanocbor_value_t arr;
+    uint64_t tag = 0;
+
+    if (nanocbor_get_type(&tmp) == NANOCBOR_TYPE_TAG) {
+        int res = nanocbor_get_tag64(&tmp, &tag);
+        if (res < 0) {
+            return res;
+        }
+    }
+    int res = nanocbor_enter_array(&tmp, &arr);
+    if (res < 0) {
+        return res;
+    }
+    for (*len = 0; !nanocbor_at_end(&arr); (*len)++) {
+        res = nanocbor_skip(&arr);
+        if (res < 0) {
+            return res;
+        }
+    }
+    return NANOCBOR_OK;
+}
+
+static int _get_double_array(nanocbor_value_t *it, double *values,
+                             size_t len)
+{
+    nanocbor_value_t arr;
+    int res = nanocbor_enter_array(it, &arr);
+
+    for (size_t i = 0; res == NANOCBOR_OK && i < len; i++) {
+        res = nanocbor_get_double(&arr, &values[i]);
+        res = res < 0 ? res : NANOCBOR_OK;
+    }
+    return res < 0 ? res : nanocbor_leave_container_early(it, &arr);
+}
+
+static char *_loads_array_kwlist[] = { "data", "typecode", NULL };
+
+PyDoc_STRVAR(_loads_array_doc,
+             "loads_array(data, typecode='q')\n--\n\n"
+             "Decode a CBOR array of integers ('q') or floating point "
+             "numbers ('d')\ninto a memoryview of that format. Delta "
+             "encoded integer arrays are\nsupported.");
+
+static PyObject *_py_loads_array(PyObject *self, PyObject *args,
+                                 PyObject *kwargs)
+{
+    Py_buffer view;
+    _decoder_t dec = { NULL, NULL };
+    nanocbor_value_t it;
+    PyObject *data = NULL;
+    const char *typecode = "q";
+    size_t len = 0;
+
+    (void)self;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|s", _loads_array_kwlist,
+                                     &data, &typecode)) {
+        return NULL;
+    }
+    if (strcmp(typecode, "q") != 0 && strcmp(typecode, "d") != 0) {
+        PyErr_SetString(PyExc_ValueError, "typecode must be 'q' or 'd'");
+        return NULL;
+    }
+    if (PyObject_GetBuffer(data, &view, PyBUF_C_CONTIGUOUS) < 0) {
+        return NULL;
+    }
+    dec.start = view.buf;
+    nanocbor_decoder_init(&it, view.buf, (size_t)view.len);
+
+    PyObject *result = NULL;
+    int res = _array_len(&it, &len);
+    if (res < 0) {
+        _error(res, &dec, &it);
+    }
+    else if (len > (size_t)PY_SSIZE_T_MAX / sizeof(int64_t)) {
+        PyErr_NoMemory();
+    }
+    else {
+        result = PyBytes_FromStringAndSize(NULL,
+                                           (Py_ssize_t)(len * sizeof(int64_t)));
+    }
+    if (result) {
+        void *values = PyBytes_AS_STRING(result);
+        res = typecode[0] == 'q'
+            ? nanocbor_get_int64_array(&it, values, &len)
+            : _get_double_array(&it, values, len);
+        if (res < 0) {
+            Py_CLEAR(result);
+            _error(res, &dec, &it);
+        }
+    }
+    PyBuffer_Release(&view);
+    if (!result) {
+        return NULL;
+    }
+    PyObject *bytes_view = PyMemoryView_FromObject(result);
+    Py_DECREF(result);
+    if (!bytes_view) {
+        return NULL;
+    }
+    PyObject *typed
+        = PyObject_CallMethod(bytes_view, "cast", "s", typecode);
+    Py_DECREF(bytes_view);
+    return typed;
+}
+
+static bool _buffer_fits(nanocbor_encoder_t *enc, void *ctx, size_t len)
+{
+    _buffer_t *buffer = ctx;
+
+    (void)enc;
+    if (buffer->size - buffer->len >= len) {
+        return true;
+    }
+    size_t size = buffer->size ? buffer->size : BUFFER_MIN_SIZE;
+    while (size - buffer->len < len) {
+        size *= 2;
+    }
+    uint8_t *data = PyMem_Realloc(buffer->data, size);
+    if (!data) {
+        return false;
+    }
+    buffer->data = data;
+    buffer->size = size;
+    return true;
+}
+
+static void _buffer_append(nanocbor_encoder_t *enc, void *ctx,
+                           const uint8_t *data, size_t len)
+{
+    _buffer_t *buffer = ctx;
+
+    (void)enc;
+    memcpy(buffer->data + buffer->len, data, len);
+    buffer->len += len;
+}
+
+static int _encode(nanocbor_encoder_t *enc, PyObject *obj);
+
+static int64_t _read_int(const uint8_t *item, size_t size)
+{
+    int8_t i8 = 0;
+    int16_t i16 = 0;
+    int32_t i32 = 0;
+    int64_t i64 = 0;
+
+    switch (size) {
+    case sizeof(int8_t):
+        memcpy(&i8, item, size);
+        return i8;
+    case sizeof(int16_t):
+        memcpy(&i16, item, size);
+        return i16;
+    case sizeof(int32_t):
+        memcpy(&i32, item, size);
+        return i32;
+    default:
+        memcpy(&i64, item, sizeof(i64));
+        return i64;
+    }
+}
+
+static uint64_t _read_uint(const uint8_t *item, size_t size)
+{
+    uint8_t u8 = 0;
+    uint16_t u16 = 0;
+    uint32_t u32 = 0;
+    uint64_t u64 = 0;
+
+    switch (size) {
+    case sizeof(uint8_t):
+        memcpy(&u8, item, size);
+        return u8;
+    case sizeof(uint16_t):
+        memcpy(&u16, item, size);
+        return u16;
+    case sizeof(uint32_t):
+        memcpy(&u32, item, size);
+        return u32;
+    default:
+        memcpy(&u64, item, sizeof(u64));
+        return u64;
+    }
+}
+
+/* Encodes the elements of a typed buffer as an array */
+static int _encode_typed(nanocbor_encoder_t *enc, const Py_buffer *view)
+{
+    size_t size = (size_t)view->itemsize;
+    size_t len = (size_t)view->len / size;
+    const char *format = view->format;
+
+    if (format[0] == '@' || format[0] == '=' || format[0] == '<') {
+        format++;
+    }
+    if (format[0] == '\0' || format[1] != '\0'
+        || !strchr("bhilqBHILQfd", format[0])
+        || (size != 1 && size != 2 && size != 4 && size != 8)) {
+        return -1;
+    }
+    if (strchr("lq", format[0]) && size == sizeof(int64_t)) {
+        return nanocbor_fmt_int64_array(enc, view->buf, len);
+    }
+    int res = nanocbor_fmt_array(enc, len);
+    for (size_t i = 0; res >= 0 && i < len; i++) {
+        const uint8_t *item = (const uint8_t *)view->buf + i * size;
+        float fnum = 0;
+        double dnum = 0;
+        if (format[0] == 'f') {
+            memcpy(&fnum, item, sizeof(fnum));
+            res = nanocbor_fmt_float(enc, fnum);
+        }
+        else if (format[0] == 'd') {
+            memcpy(&dnum, item, sizeof(dnum));
+            res = nanocbor_fmt_double(enc, dnum);
+        }
+        else if (strchr("bhilq", format[0])) {
+            res = nanocbor_fmt_int(enc, _read_int(item, size));
+        }
+        else {
+            res = nanocbor_fmt_uint(enc, _read_uint(item, size));
+        }
+    }
+    return res;
+}
+
+static int _encode_buffer(nanocbor_encoder_t *enc, PyObject *obj)
+{
+    Py_buffer view;
+
+    if (PyObject_GetBuffer(obj, &view, PyBUF_FORMAT | PyBUF_C_CONTIGUOUS)
+        < 0) {
+        return -1;
+    }
+    int res;
+    if (view.format == NULL || strcmp(view.format, "B") == 0
+        || strcmp(view.format, "c") == 0) {
+        res = nanocbor_put_bstr(enc, view.buf, (size_t)view.len);
+    }
+    else {
+        res = _encode_typed(enc, &view);
+        if (res == -1 && !PyErr_Occurred()) {
+            PyErr_Format(PyExc_TypeError, "Unsupported buffer format '%s'",
+                         view.format);
+        }
+    }
+    PyBuffer_Release(&view);
+    return res;
+}
+
+static int _encode_int(nanocbor_encoder_t *enc, PyObject *obj)
+{
+    int overflow = 0;
+    long long num = PyLong_AsLongLongAndOverflow(obj, &overflow);
+
+    if (overflow > 0) {
+        unsigned long long unum = PyLong_AsUnsignedLongLong(obj);
+        if (PyErr_Occurred()) {
+            return -1;
+        }
+        return nanocbor_fmt_uint(enc, unum);
+    }
+    if (overflow < 0) {
+        PyErr_SetString(PyExc_OverflowError,
+                        "Integer too small for a 64 bit CBOR integer");
+        return -1;
+    }
+    if (num == -1 && PyErr_Occurred()) {
+        return -1;
+    }
+    return nanocbor_fmt_int(enc, num);
+}
+
+static int _encode_str(nanocbor_encoder_t *enc, PyObject *obj)
+{
+    Py_ssize_t len = 0;
+    const char *str = PyUnicode_AsUTF8AndSize(obj, &len);
+
+    if (!str) {
+        return -1;
+    }
+    return nanocbor_put_tstrn(enc, str, (size_t)len);
+}
+
+static int _encode_list(nanocbor_encoder_t *enc, PyObject *obj)
+{
+    PyObject *seq = PySequence_Fast(obj, "Expected a sequence");
+
+    if (!seq) {
+        return -1;
+    }
+    Py_ssize_t len = PySequence_Fast_GET_SIZE(seq);
+    PyObject **items = PySequence_Fast_ITEMS(seq);
+    int res = nanocbor_fmt_array(enc, (size_t)len);
+    for (Py_ssize_t i = 0; res >= 0 && i < len; i++) {
+        res = _encode(enc, items[i]);
+    }
+    Py_DECREF(seq);
+    return res;
+}
+
+static int _encode_dict(nanocbor_encoder_t *enc, PyObject *obj)
+{
+    PyObject *key = NULL;
+    PyObject *value = NULL;
+    Py_ssize_t pos = 0;
+    int res = nanocbor_fmt_map(enc, (size_t)PyDict_Size(obj));
+
+    while (res >= 0 && PyDict_Next(obj, &pos, &key, &value)) {
+        res = _encode(enc, key);
+        if (res >= 0) {
+            res = _encode(enc, value);
+        }
+    }
+    return res;
+}
+
+/* NOLINTNEXTLINE(misc-no-recursion) */
+static int _encode(nanocbor_encoder_t *enc, PyObject *obj)
+{
+    int res = -1;
+
+    if (Py_EnterRecursiveCall(" while encoding CBOR")) {
+        return -1;
+    }
+    if (obj == Py_None) {
+        res = nanocbor_fmt_null(enc);
+    }
+    else if (PyBool_Check(obj)) {
+        res = nanocbor_fmt_bool(enc, obj == Py_True);
+    }
+    else if (PyLong_Check(obj)) {
+        res = _encode_int(enc, obj);
+    }
+    else if (PyFloat_Check(obj)) {
+        res = nanocbor_fmt_double(enc, PyFloat_AS_DOUBLE(obj));
+    }
+    else if (PyUnicode_Check(obj)) {
+        res = _encode_str(enc, obj);
+    }
+    else if (PyBytes_Check(obj)) {
+        res = nanocbor_put_bstr(enc, (const uint8_t *)PyBytes_AS_STRING(obj),
+                                (size_t)PyBytes_GET_SIZE(obj));
+    }
+    else if (Py_IS_TYPE(obj, _tag_type)) {
+        PyObject *num = PyStructSequence_GetItem(obj, 0);
+        unsigned long long tag = PyLong_AsUnsignedLongLong(num);
+        if (!PyErr_Occurred()) {
+            res = nanocbor_fmt_tag(enc, tag);
+            if (res >= 0) {
+                res = _encode(enc, PyStructSequence_GetItem(obj, 1));
+            }
+        }
+    }
+    else if (PyList_Check(obj) || PyTuple_Check(obj)) {
+        res = _encode_list(enc, obj);
+    }
+    else if (PyDict_Check(obj)) {
+        res = _encode_dict(enc, obj);
+    }
+    else if (PyObject_CheckBuffer(obj)) {
+        res = _encode_buffer(enc, obj);
+    }
+    else {
+        PyErr_Format(PyExc_TypeError, "Cannot encode objects of type %s",
+                     Py_TYPE(obj)->tp_name);
+    }
+    Py_LeaveRecursiveCall();
+    if (res < 0 && !PyErr_Occurred()) {
+        PyErr_NoMemory();
+    }
+    return res;
+}
+
+static PyObject *_dumps(PyObject *obj, bool sequence)
+{
+    nanocbor_encoder_t enc;
+    _buffer_t buffer = { NULL, 0, 0 };
+    PyObject *result = NULL;
+    int res = 0;
+
+    nanocbor_encoder_stream_init(&enc, &buffer, _buffer_append, _buffer_fits);
+    if (sequence) {
+        PyObject *iter = PyObject_GetIter(obj);
+        PyObject *item = NULL;
+        res = iter ? 0 : -1;
+        while (res >= 0 && (item = PyIter_Next(iter))) {
+            res = _encode(&enc, item);
+            Py_DECREF(item);
+        }
+        Py_XDECREF(iter);
+        if (PyErr_Occurred()) {
+            res = -1;
+        }
+    }
+    else {
+        res = _encode(&enc, obj);
+    }
+    if (res >= 0) {
+        result = PyBytes_FromStringAndSize((const char *)buffer.data,
+                                           (Py_ssize_t)buffer.len);
+    }
+    PyMem_Free(buffer.data);
+    return result;
+}
+
+PyDoc_STRVAR(_dumps_doc,
+             "dumps(obj)\n--\n\n"
+             "Encode an object as CBOR.\n\n"
+             "Buffers with an integer or floating point format, such as "
+             "array.array,\nare encoded as arrays of numbers.");
+
+static PyObject *_py_dumps(PyObject *self, PyObject *obj)
+{
+    (void)self;
+    return _dumps(obj, false);
+}
+
+PyDoc_STRVAR(_dumps_seq_doc,
+             "dumps_seq(iterable)\n--\n\n"
+             "Encode the objects of an iterable as a CBOR sequence.");
+
+static PyObject *_py_dumps_seq(PyObject *self, PyObject *obj)
+{
+    (void)self;
+    return _dumps(obj, true);
+}
+
+static PyMethodDef _methods[] = {
+    { "loads", (PyCFunction)(void (*)(void))_py_loads,
+      METH_VARARGS | METH_KEYWORDS, _loads_doc },
+    { "loads_seq", (PyCFunction)(void (*)(void))_py_loads_seq,
+      METH_VARARGS | METH_KEYWORDS, _loads_seq_doc },
+    { "loads_array", (PyCFunction)(void (*)(void))_py_loads_array,
+      METH_VARARGS | METH_KEYWORDS, _loads_array_doc },
+    { "dumps", _py_dumps, METH_O, _dumps_doc },
+    { "dumps_seq", _py_dumps_seq, METH_O, _dumps_seq_doc },
+    { NULL, NULL, 0, NULL },
+};
+
+static struct PyModuleDef _module = {
+    PyModuleDef_HEAD_INIT,
+    "nanocbor",
+    "CBOR decoding and encoding with NanoCBOR",
+    -1,
+    _methods,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+};
+
+PyMODINIT_FUNC PyInit_nanocbor(void)
+{
+    PyObject *module = PyModule_Create(&_module);
+
+    if (!module) {
+        return NULL;
+    }
+    _tag_type = PyStructSequence_NewType(&_tag_desc);
+    _decode_error = PyErr_NewException("nanocbor.DecodeError",
+                                       PyExc_ValueError, NULL);
+    if (!_tag_type || !_decode_error
+        || PyModule_AddObjectRef(module, "Tag", (PyObject *)_tag_type) < 0
+        || PyModule_AddObjectRef(module, "DecodeError", _decode_error) < 0) {
+        Py_DECREF(module);
+        return NULL;
+    }
+    return module;
+}
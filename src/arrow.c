@@ -0,0 +1,499 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @ingroup nanocbor_arrow
+ * @{
+ * @file
+ * @brief   Arrow C Data Interface export implementation
+ *
+ * The values of every column are appended to growing buffers while the
+ * query runs. The buffers are then handed to the child arrays, which free
+ * them on release. Child arrays and schemas own their allocations so that a
+ * consumer can move them out of their parent.
+ * @}
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nanocbor/arrow.h"
+#include "nanocbor/config.h"
+#include "nanocbor/nanocbor.h"
+#include "nanocbor/query.h"
+
+#define BUFFER_MIN 64U
+
+/* Binary view layout: length, then either the inlined bytes or a prefix,
+ * the index of the variadic buffer and the offset in that buffer */
+#define VIEW_SIZE 16U
+#define VIEW_INLINE 12U
+#define VIEW_PREFIX 4U
+#define VIEW_INDEX 8U
+#define VIEW_OFFSET 12U
+
+#define BUFFERS_MAX 4
+
+/* Growing buffers of a column */
+typedef struct {
+    uint8_t *validity;
+    size_t validity_cap;
+    uint8_t *values;
+    size_t values_cap;
+    uint8_t *data;
+    size_t data_len;
+    size_t data_cap;
+    int64_t null_count;
+} _builder_t;
+
+/* Private data of a column array */
+typedef struct {
+    _builder_t builder;
+    const void *buffers[BUFFERS_MAX];
+    int64_t sizes[1];
+} _child_t;
+
+/* Private data of the struct array */
+typedef struct {
+    const void *buffers[1];
+    struct ArrowArray *children[NANOCBOR_QUERY_SELECT_MAX];
+    struct ArrowArray arrays[NANOCBOR_QUERY_SELECT_MAX];
+} _struct_array_t;
+
+/* Private data of the struct type */
+typedef struct {
+    struct ArrowSchema *children[NANOCBOR_QUERY_SELECT_MAX];
+    struct ArrowSchema schemas[NANOCBOR_QUERY_SELECT_MAX];
+} _struct_schema_t;
+
+typedef struct {
+    const nanocbor_arrow_column_t *columns;
+    size_t num_columns;
+    int64_t rows;
+    const uint8_t *base;
+    size_t base_len;
+    _child_t *children[NANOCBOR_QUERY_SELECT_MAX];
+    char *names[NANOCBOR_QUERY_SELECT_MAX];
+    _struct_array_t *array;
+    _struct_schema_t *schema;
+} _export_t;
+
+static int _reserve(uint8_t **buf, size_t *cap, size_t len)
+{
+    size_t size = *cap ? *cap : BUFFER_MIN;
+
+    if (len <= *cap) {
+        return NANOCBOR_OK;
+    }
+    while (size < len) {
+        size *= 2;
+    }
+    uint8_t *res = realloc(*buf, size);
+    if (!res) {
+        return NANOCBOR_ERR_OVERFLOW;
+    }
+    *buf = res;
+    *cap = size;
+    return NANOCBOR_OK;
+}
+
+static bool _is_binary(nanocbor_arrow_type_t type)
+{
+    return type == NANOCBOR_ARROW_BINARY
+        || type == NANOCBOR_ARROW_BINARY_VIEW;
+}
+
+static bool _is_view(nanocbor_arrow_type_t type)
+{
+    return type == NANOCBOR_ARROW_UTF8_VIEW
+        || type == NANOCBOR_ARROW_BINARY_VIEW;
+}
+
+static bool _has_offsets(nanocbor_arrow_type_t type)
+{
+    return type == NANOCBOR_ARROW_UTF8 || type == NANOCBOR_ARROW_BINARY;
+}
+
+static const char *_format(nanocbor_arrow_type_t type)
+{
+    switch (type) {
+    case NANOCBOR_ARROW_INT64:
+        return "l";
+    case NANOCBOR_ARROW_DOUBLE:
+        return "g";
+    case NANOCBOR_ARROW_UTF8:
+        return "u";
+    case NANOCBOR_ARROW_BINARY:
+        return "z";
+    case NANOCBOR_ARROW_UTF8_VIEW:
+        return "vu";
+    case NANOCBOR_ARROW_BINARY_VIEW:
+        return "vz";
+    default:
+        return NULL;
+    }
+}
+
+static bool _get_str(nanocbor_value_t *it, bool binary, const uint8_t **str,
+                     size_t *len)
+{
+    int res = binary ? nanocbor_get_bstr(it, str, len)
+                     : nanocbor_get_tstr(it, str, len);
+    return res >= 0;
+}
+
+static int _append_int64(_builder_t *builder, size_t row,
+                         nanocbor_value_t *value, bool *valid)
+{
+    int64_t num = 0;
+    int res = _reserve(&builder->values, &builder->values_cap,
+                       (row + 1) * sizeof(num));
+
+    if (res < 0) {
+        return res;
+    }
+    *valid = nanocbor_get_int64(value, &num) >= 0;
+    if (!*valid) {
+        num = 0;
+    }
+    memcpy(builder->values + row * sizeof(num), &num, sizeof(num));
+    return NANOCBOR_OK;
+}
+
+static int _append_double(_builder_t *builder, size_t row,
+                          nanocbor_value_t *value, bool *valid)
+{
+    nanocbor_number_t num;
+    int res = _reserve(&builder->values, &builder->values_cap,
+                       (row + 1) * sizeof(num.f));
+
+    if (res < 0) {
+        return res;
+    }
+    *valid = nanocbor_get_number(value, &num) == NANOCBOR_OK;
+    if (!*valid) {
+        num.f = 0;
+    }
+    memcpy(builder->values + row * sizeof(num.f), &num.f, sizeof(num.f));
+    return NANOCBOR_OK;
+}
+
+static int _append_str(_builder_t *builder, size_t row, bool binary,
+                       nanocbor_value_t *value, bool *valid)
+{
+    const uint8_t *str = NULL;
+    size_t len = 0;
+    int32_t offset = 0;
+    /* The offsets have an entry more than there are rows */
+    int res = _reserve(&builder->values, &builder->values_cap,
+                       (row + 2) * sizeof(offset));
+
+    if (res < 0) {
+        return res;
+    }
+    *valid = _get_str(value, binary, &str, &len);
+    if (!*valid) {
+        len = 0;
+    }
+    if (len > (size_t)INT32_MAX - builder->data_len) {
+        return NANOCBOR_ERR_OVERFLOW;
+    }
+    res = _reserve(&builder->data, &builder->data_cap, builder->data_len + len);
+    if (res < 0) {
+        return res;
+    }
+    if (len > 0) {
+        memcpy(builder->data + builder->data_len, str, len);
+    }
+    builder->data_len += len;
+    offset = (int32_t)builder->data_len;
+    memcpy(builder->values + (row + 1) * sizeof(offset), &offset,
+           sizeof(offset));
+    return NANOCBOR_OK;
+}
+
+static int _append_view(const _export_t *exp, _builder_t *builder,
+                        size_t row, bool binary, nanocbor_value_t *value,
+                        bool *valid)
+{
+    const uint8_t *str = NULL;
+    size_t len = 0;
+    int res = _reserve(&builder->values, &builder->values_cap,
+                       (row + 1) * VIEW_SIZE);
+
+    if (res < 0) {
+        return res;
+    }
+    uint8_t *view = builder->values + row * VIEW_SIZE;
+    memset(view, 0, VIEW_SIZE);
+    *valid = _get_str(value, binary, &str, &len);
+    if (!*valid) {
+        return NANOCBOR_OK;
+    }
+    size_t offset = (size_t)(str - exp->base);
+    if (offset > INT32_MAX || len > INT32_MAX) {
+        return NANOCBOR_ERR_OVERFLOW;
+    }
+    int32_t size = (int32_t)len;
+    memcpy(view, &size, sizeof(size));
+    if (len <= VIEW_INLINE) {
+        memcpy(view + sizeof(size), str, len);
+        return NANOCBOR_OK;
+    }
+    /* The input is the only variadic buffer */
+    int32_t index = 0;
+    int32_t pos = (int32_t)offset;
+    memcpy(view + sizeof(size), str, VIEW_PREFIX);
+    memcpy(view + VIEW_INDEX, &index, sizeof(index));
+    memcpy(view + VIEW_OFFSET, &pos, sizeof(pos));
+    return NANOCBOR_OK;
+}
+
+static int _append(_export_t *exp, size_t col, nanocbor_value_t *value)
+{
+    _builder_t *builder = &exp->children[col]->builder;
+    nanocbor_arrow_type_t type = exp->columns[col].type;
+    size_t row = (size_t)exp->rows;
+    bool valid = false;
+    int res = _reserve(&builder->validity, &builder->validity_cap,
+                       row / 8 + 1);
+
+    if (res < 0) {
+        return res;
+    }
+    if (row % 8 == 0) {
+        builder->validity[row / 8] = 0;
+    }
+    nanocbor_skip_tags(value);
+    if (type == NANOCBOR_ARROW_INT64) {
+        res = _append_int64(builder, row, value, &valid);
+    }
+    else if (type == NANOCBOR_ARROW_DOUBLE) {
+        res = _append_double(builder, row, value, &valid);
+    }
+    else if (_is_view(type)) {
+        res = _append_view(exp, builder, row, _is_binary(type), value,
+                           &valid);
+    }
+    else {
+        res = _append_str(builder, row, _is_binary(type), value, &valid);
+    }
+    if (res < 0) {
+        return res;
+    }
+    if (valid) {
+        builder->validity[row / 8] |= (uint8_t)(1U << (row % 8));
+    }
+    else {
+        builder->null_count++;
+    }
+    return NANOCBOR_OK;
+}
+
+static int _record(void *ctx, const uint8_t *record, size_t record_len,
+                   const nanocbor_value_t *values, size_t num_values)
+{
+    _export_t *exp = ctx;
+
+    (void)record;
+    (void)record_len;
+    for (size_t i = 0; i < num_values; i++) {
+        nanocbor_value_t value = values[i];
+        int res = _append(exp, i, &value);
+        if (res < 0) {
+            return res;
+        }
+    }
+    exp->rows++;
+    return NANOCBOR_OK;
+}
+
+static void _builder_free(_builder_t *builder)
+{
+    free(builder->validity);
+    free(builder->values);
+    free(builder->data);
+}
+
+static void _export_free(_export_t *exp)
+{
+    for (size_t i = 0; i < exp->num_columns; i++) {
+        if (exp->children[i]) {
+            _builder_free(&exp->children[i]->builder);
+        }
+        free(exp->children[i]);
+        free(exp->names[i]);
+    }
+    free(exp->array);
+    free(exp->schema);
+}
+
+static int _export_alloc(_export_t *exp, const nanocbor_query_t *query)
+{
+    exp->array = calloc(1, sizeof(*exp->array));
+    exp->schema = calloc(1, sizeof(*exp->schema));
+    if (!exp->array || !exp->schema) {
+        return NANOCBOR_ERR_OVERFLOW;
+    }
+    for (size_t i = 0; i < exp->num_columns; i++) {
+        const char *name = exp->columns[i].name ? exp->columns[i].name
+                                                : query->select[i];
+        size_t len = strlen(name) + 1;
+        exp->children[i] = calloc(1, sizeof(*exp->children[i]));
+        exp->names[i] = malloc(len);
+        if (!exp->children[i] || !exp->names[i]) {
+            return NANOCBOR_ERR_OVERFLOW;
+        }
+        memcpy(exp->names[i], name, len);
+        if (!_format(exp->columns[i].type)) {
+            return NANOCBOR_ERR_INVALID_TYPE;
+        }
+        /* Offsets of copied strings start with a zero entry */
+        if (_has_offsets(exp->columns[i].type)) {
+            _builder_t *builder = &exp->children[i]->builder;
+            int32_t offset = 0;
+            int res = _reserve(&builder->values, &builder->values_cap,
+                               sizeof(offset));
+            if (res < 0) {
+                return res;
+            }
+            memcpy(builder->values, &offset, sizeof(offset));
+        }
+    }
+    return NANOCBOR_OK;
+}
+
+static void _release_child(struct ArrowArray *array)
+{
+    _child_t *child = array->private_data;
+
+    _builder_free(&child->builder);
+    free(child);
+    array->release = NULL;
+}
+
+static void _release_struct(struct ArrowArray *array)
+{
+    _struct_array_t *priv = array->private_data;
+
+    for (int64_t i = 0; i < array->n_children; i++) {
+        struct ArrowArray *child = array->children[i];
+        if (child->release) {
+            child->release(child);
+        }
+    }
+    free(priv);
+    array->release = NULL;
+}
+
+static void _release_field(struct ArrowSchema *schema)
+{
+    free(schema->private_data);
+    schema->release = NULL;
+}
+
+static void _release_struct_schema(struct ArrowSchema *schema)
+{
+    _struct_schema_t *priv = schema->private_data;
+
+    for (int64_t i = 0; i < schema->n_children; i++) {
+        struct ArrowSchema *child = schema->children[i];
+        if (child->release) {
+            child->release(child);
+        }
+    }
+    free(priv);
+    schema->release = NULL;
+}
+
+static void _export_child(const _export_t *exp, size_t col,
+                          struct ArrowArray *array)
+{
+    _child_t *child = exp->children[col];
+    nanocbor_arrow_type_t type = exp->columns[col].type;
+
+    memset(array, 0, sizeof(*array));
+    array->length = exp->rows;
+    array->null_count = child->builder.null_count;
+    array->n_buffers = 2;
+    array->buffers = child->buffers;
+    child->buffers[0] = child->builder.validity;
+    child->buffers[1] = child->builder.values;
+    if (_is_view(type)) {
+        /* The input followed by the sizes of the variadic buffers */
+        child->sizes[0] = (int64_t)exp->base_len;
+        child->buffers[2] = exp->base;
+        child->buffers[3] = child->sizes;
+        array->n_buffers = 4;
+    }
+    else if (_has_offsets(type)) {
+        child->buffers[2] = child->builder.data;
+        array->n_buffers = 3;
+    }
+    array->release = _release_child;
+    array->private_data = child;
+}
+
+static void _export_field(const _export_t *exp, size_t col,
+                          struct ArrowSchema *schema)
+{
+    memset(schema, 0, sizeof(*schema));
+    schema->format = _format(exp->columns[col].type);
+    schema->name = exp->names[col];
+    schema->flags = ARROW_FLAG_NULLABLE;
+    schema->release = _release_field;
+    schema->private_data = exp->names[col];
+}
+
+int nanocbor_arrow_export(const nanocbor_query_t *query,
+                          const nanocbor_arrow_column_t *columns,
+                          nanocbor_value_t *it, struct ArrowArray *array,
+                          struct ArrowSchema *schema)
+{
+    _export_t exp = { 0 };
+
+    if (query->num_select > NANOCBOR_QUERY_SELECT_MAX) {
+        return NANOCBOR_ERR_OVERFLOW;
+    }
+    exp.columns = columns;
+    exp.num_columns = query->num_select;
+    exp.base = it->cur;
+    exp.base_len = (size_t)(it->end - it->cur);
+    int res = _export_alloc(&exp, query);
+    if (res >= 0) {
+        res = nanocbor_query_run(query, it, _record, &exp);
+    }
+    if (res < 0) {
+        _export_free(&exp);
+        return res;
+    }
+
+    memset(array, 0, sizeof(*array));
+    array->length = exp.rows;
+    array->n_buffers = 1;
+    array->n_children = (int64_t)exp.num_columns;
+    array->buffers = exp.array->buffers;
+    array->children = exp.array->children;
+    array->release = _release_struct;
+    array->private_data = exp.array;
+
+    memset(schema, 0, sizeof(*schema));
+    schema->format = "+s";
+    schema->name = "";
+    schema->n_children = (int64_t)exp.num_columns;
+    schema->children = exp.schema->children;
+    schema->release = _release_struct_schema;
+    schema->private_data = exp.schema;
+
+    for (size_t i = 0; i < exp.num_columns; i++) {
+        exp.array->children[i] = &exp.array->arrays[i];
+        exp.schema->children[i] = &exp.schema->schemas[i];
+        _export_child(&exp, i, exp.array->children[i]);
+        _export_field(&exp, i, exp.schema->children[i]);
+    }
+    return NANOCBOR_OK;
+}
@@ -0,0 +1,193 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @ingroup nanocbor_base64
+ * @{
+ * @file
+ * @brief   Base64 input implementation
+ *
+ * Complete quanta of four characters are decoded a block at a time while no
+ * bits are pending. Padding, invalid characters and quanta split across
+ * chunks fall back to decoding a character at a time.
+ * @}
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "nanocbor/base64.h"
+#include "nanocbor/config.h"
+#include "nanocbor/nanocbor.h"
+
+#define SEXTET_BITS 6U
+#define QUANTUM_CHARS 4U
+#define QUANTUM_BYTES 3U
+#define ASCII_MAX 0x7FU
+
+/* Sextet value plus one of the characters of both alphabets, zero for
+ * invalid characters */
+static const uint8_t _values[ASCII_MAX + 1] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 63, 0, 63, 0, 64,
+    53, 54, 55, 56, 57, 58, 59, 60, 61, 62, 0, 0, 0, 0, 0, 0,
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+    16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 0, 0, 0, 0, 64,
+    0, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41,
+    42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 52, 0, 0, 0, 0, 0,
+};
+
+static uint32_t _value(uint8_t c)
+{
+    return c > ASCII_MAX ? 0 : _values[c];
+}
+
+void nanocbor_base64_init(nanocbor_base64_t *b64, uint8_t *out, size_t len)
+{
+    b64->out = out;
+    b64->len = 0;
+    b64->max_len = len;
+    b64->bits = 0;
+    b64->num = 0;
+    b64->pad = 0;
+    b64->padded = false;
+}
+
+/* Writes the top @p bytes bytes of a 24 bit quantum */
+static int _put(nanocbor_base64_t *b64, uint32_t bits, unsigned bytes)
+{
+    if (b64->max_len - b64->len < bytes) {
+        return NANOCBOR_ERR_END;
+    }
+    for (unsigned i = 0; i < bytes; i++) {
+        b64->out[b64->len++] = (uint8_t)(bits >> (16U - 8U * i));
+    }
+    return NANOCBOR_OK;
+}
+
+/* Writes the bytes of an incomplete quantum */
+static int _flush(nanocbor_base64_t *b64)
+{
+    unsigned num = b64->num;
+
+    if (num == 0) {
+        return NANOCBOR_OK;
+    }
+    if (num == 1) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    uint32_t bits = b64->bits << (SEXTET_BITS * (QUANTUM_CHARS - num));
+    b64->bits = 0;
+    b64->num = 0;
+    return _put(b64, bits, num - 1);
+}
+
+static const uint8_t *_decode_blocks(nanocbor_base64_t *b64,
+                                     const uint8_t *cur, const uint8_t *end)
+{
+    uint8_t *out = b64->out + b64->len;
+    size_t blocks = (size_t)(end - cur) / QUANTUM_CHARS;
+    size_t room = (b64->max_len - b64->len) / QUANTUM_BYTES;
+
+    if (blocks > room) {
+        blocks = room;
+    }
+    for (; blocks > 0; blocks--) {
+        uint32_t a = _value(cur[0]);
+        uint32_t b = _value(cur[1]);
+        uint32_t c = _value(cur[2]);
+        uint32_t d = _value(cur[3]);
+        /* Padding and invalid characters are handled one by one */
+        if (!a || !b || !c || !d) {
+            break;
+        }
+        uint32_t bits = ((a - 1) << (3 * SEXTET_BITS))
+            | ((b - 1) << (2 * SEXTET_BITS)) | ((c - 1) << SEXTET_BITS)
+            | (d - 1);
+        out[0] = (uint8_t)(bits >> 16U);
+        out[1] = (uint8_t)(bits >> 8U);
+        out[2] = (uint8_t)bits;
+        out += QUANTUM_BYTES;
+        cur += QUANTUM_CHARS;
+    }
+    b64->len = (size_t)(out - b64->out);
+    return cur;
+}
+
+static int _decode_char(nanocbor_base64_t *b64, uint8_t c)
+{
+    uint32_t value = _value(c);
+
+    if (c == '=') {
+        if (b64->padded) {
+            if (b64->pad == 0) {
+                return NANOCBOR_ERR_INVALID_TYPE;
+            }
+            b64->pad--;
+            return NANOCBOR_OK;
+        }
+        /* Padding completes a quantum of two or three characters */
+        b64->padded = true;
+        b64->pad = (uint8_t)(QUANTUM_CHARS - 1 - b64->num);
+        return b64->num < 2 ? NANOCBOR_ERR_INVALID_TYPE : _flush(b64);
+    }
+    if (!value || b64->padded) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    b64->bits = (b64->bits << SEXTET_BITS) | (value - 1);
+    if (++b64->num < QUANTUM_CHARS) {
+        return NANOCBOR_OK;
+    }
+    uint32_t bits = b64->bits;
+    b64->bits = 0;
+    b64->num = 0;
+    return _put(b64, bits, QUANTUM_BYTES);
+}
+
+int nanocbor_base64_update(nanocbor_base64_t *b64, const char *text,
+                           size_t len)
+{
+    const uint8_t *cur = (const uint8_t *)text;
+    const uint8_t *end = cur + len;
+
+    while (cur < end) {
+        if (b64->num == 0 && !b64->padded) {
+            cur = _decode_blocks(b64, cur, end);
+            if (cur == end) {
+                break;
+            }
+        }
+        int res = _decode_char(b64, *cur++);
+        if (res < 0) {
+            return res;
+        }
+    }
+    return NANOCBOR_OK;
+}
+
+int nanocbor_base64_finish(nanocbor_base64_t *b64, nanocbor_value_t *value)
+{
+    int res = _flush(b64);
+
+    if (res < 0) {
+        return res;
+    }
+    nanocbor_decoder_init(value, b64->out, b64->len);
+    return NANOCBOR_OK;
+}
+
+int nanocbor_decoder_init_base64(nanocbor_value_t *value, uint8_t *buf,
+                                 size_t len)
+{
+    nanocbor_base64_t b64;
+
+    nanocbor_base64_init(&b64, buf, len);
+    int res = nanocbor_base64_update(&b64, (const char *)buf, len);
+    if (res < 0) {
+        return res;
+    }
+    return nanocbor_base64_finish(&b64, value);
+}
@@ -273,7 +273,14 @@ int nanocbor_get_tag(nanocbor_value_t *cvalue, uint32_t *tag)
 
 int nanocbor_get_tag64(nanocbor_value_t *cvalue, uint64_t *tag)
 {
-    return _get_and_advance_uint64(cvalue, tag, NANOCBOR_TYPE_TAG);
+    int res = _get_uint64(cvalue, tag, NANOCBOR_SIZE_LONG, NANOCBOR_TYPE_TAG);
+
+    /* The tag and the tagged item count as a single container item */
+    if (res >= 0) {
+        cvalue->cur += res;
+        res = NANOCBOR_OK;
+    }
+    return res;
 }
 
 int nanocbor_get_decimal_frac(nanocbor_value_t *cvalue, int32_t *e, int32_t *m)
@@ -299,6 +306,77 @@ int nanocbor_get_decimal_frac(nanocbor_value_t *cvalue, int32_t *e, int32_t *m)
     return res;
 }
 
+static int _get_and_advance_delta(nanocbor_value_t *cvalue, uint64_t *value)
+{
+    int type = nanocbor_get_type(cvalue);
+    if (type != NANOCBOR_TYPE_UINT && type != NANOCBOR_TYPE_NINT) {
+        return type < 0 ? type : NANOCBOR_ERR_INVALID_TYPE;
+    }
+    uint64_t delta = 0;
+    int res = _get_uint64(cvalue, &delta, NANOCBOR_SIZE_LONG, type);
+    /* Wrapping arithmetic, the encoded delta can exceed the int64_t range */
+    if (type == NANOCBOR_TYPE_UINT) {
+        *value += delta;
+    }
+    else {
+        *value -= delta + 1;
+    }
+    return _advance_if(cvalue, res);
+}
+
+int nanocbor_get_int64_array(nanocbor_value_t *cvalue, int64_t *values,
+                             size_t *len)
+{
+    nanocbor_value_t it = *cvalue;
+    nanocbor_value_t arr;
+    uint64_t tag = 0;
+    bool delta = false;
+
+    if (nanocbor_get_type(&it) == NANOCBOR_TYPE_TAG) {
+        int res = _get_uint64(&it, &tag, NANOCBOR_SIZE_LONG, NANOCBOR_TYPE_TAG);
+        if (res < 0) {
+            return res;
+        }
+        if (tag != NANOCBOR_TAG_DELTA_ARRAY) {
+            return NANOCBOR_ERR_INVALID_TYPE;
+        }
+        it.cur += res;
+        delta = true;
+    }
+
+    int res = nanocbor_enter_array(&it, &arr);
+    if (res < 0) {
+        return res;
+    }
+
+    size_t count = 0;
+    uint64_t cur = 0;
+    while (!nanocbor_at_end(&arr)) {
+        if (count == *len) {
+            return NANOCBOR_ERR_OVERFLOW;
+        }
+        if (delta && count > 0) {
+            res = _get_and_advance_delta(&arr, &cur);
+            values[count] = (int64_t)cur;
+        }
+        else {
+            res = nanocbor_get_int64(&arr, &values[count]);
+            cur = (uint64_t)values[count];
+        }
+        if (res < 0) {
+            return res;
+        }
+        count++;
+    }
+    if (nanocbor_container_truncated(&arr)) {
+        return NANOCBOR_ERR_END;
+    }
+    nanocbor_leave_container(&it, &arr);
+    *cvalue = it;
+    *len = count;
+    return NANOCBOR_OK;
+}
+
 static int _get_str(nanocbor_value_t *cvalue, const uint8_t **buf, size_t *len,
                     uint8_t type)
 {
@@ -306,16 +384,16 @@ static int _get_str(nanocbor_value_t *cvalue, const uint8_t **buf, size_t *len,
     int res = _get_uint64(cvalue, &tmp, NANOCBOR_SIZE_SIZET, type);
     *len = tmp;
 
-    if (cvalue->end - cvalue->cur < 0
-        || (size_t)(cvalue->end - cvalue->cur) < *len) {
-        return NANOCBOR_ERR_END;
+    if (res < 0) {
+        return res;
     }
-    if (res >= 0) {
-        *buf = (cvalue->cur) + res;
-        _advance(cvalue, (unsigned int)((size_t)res + *len));
-        res = NANOCBOR_OK;
+    /* The string starts after the header */
+    if ((size_t)(cvalue->end - cvalue->cur) - (size_t)res < *len) {
+        return NANOCBOR_ERR_END;
     }
-    return res;
+    *buf = (cvalue->cur) + res;
+    _advance(cvalue, (unsigned int)((size_t)res + *len));
+    return NANOCBOR_OK;
 }
 
 int nanocbor_get_bstr(nanocbor_value_t *cvalue, const uint8_t **buf,
@@ -412,8 +490,11 @@ static int _decode_half_float(nanocbor_value_t *cvalue, float *value)
         static const float *fmagic = (float *)&magic;
 
         if (exponent == 0) {
+            /* Zero and subnormal numbers, keeping the sign */
+            uint32_t sign = *ifloat;
             *ifloat = magic + significant;
             *value -= *fmagic;
+            *ifloat |= sign;
         }
         else {
             if (exponent == (HALF_EXP_MASK << HALF_EXP_POS)) {
@@ -476,6 +557,33 @@ int nanocbor_get_double(nanocbor_value_t *cvalue, double *value)
     return _decode_double(cvalue, value);
 }
 
+int nanocbor_get_number(nanocbor_value_t *cvalue, nanocbor_number_t *num)
+{
+    uint64_t u = 0;
+    int res = NANOCBOR_ERR_INVALID_TYPE;
+
+    switch (nanocbor_get_type(cvalue)) {
+    case NANOCBOR_TYPE_UINT:
+        res = nanocbor_get_uint64(cvalue, &u);
+        num->is_int = u <= INT64_MAX;
+        num->i = (int64_t)u;
+        num->f = (double)u;
+        break;
+    case NANOCBOR_TYPE_NINT:
+        res = nanocbor_get_int64(cvalue, &num->i);
+        num->is_int = true;
+        num->f = (double)num->i;
+        break;
+    case NANOCBOR_TYPE_FLOAT:
+        res = nanocbor_get_double(cvalue, &num->f);
+        num->is_int = false;
+        break;
+    default:
+        break;
+    }
+    return res < 0 ? res : NANOCBOR_OK;
+}
+
 static int _enter_container(const nanocbor_value_t *it,
                             nanocbor_value_t *container, uint8_t type)
 {
@@ -531,10 +639,38 @@ void nanocbor_leave_container(nanocbor_value_t *it, nanocbor_value_t *container)
     }
 }
 
+/* Skip the chunks of an indefinite-length string up to the break */
+static int _skip_str_indefinite(nanocbor_value_t *it, uint8_t type)
+{
+    nanocbor_value_t chunk = *it;
+
+    /* The chunks are no items of the container */
+    chunk.flags = 0;
+    chunk.cur++;
+    while (!_over_end(&chunk)
+           && *chunk.cur != (NANOCBOR_MASK_FLOAT | NANOCBOR_SIZE_INDEFINITE)) {
+        const uint8_t *tmp = NULL;
+        size_t len = 0;
+        int res = _get_str(&chunk, &tmp, &len, type);
+        if (res < 0) {
+            return res;
+        }
+    }
+    if (_over_end(&chunk)) {
+        return NANOCBOR_ERR_END;
+    }
+    _advance(it, (unsigned int)(chunk.cur + 1 - it->cur));
+    return NANOCBOR_OK;
+}
+
 static int _skip_simple(nanocbor_value_t *it)
 {
     int type = nanocbor_get_type(it);
     uint64_t tmp = 0;
+    if ((type == NANOCBOR_TYPE_BSTR || type == NANOCBOR_TYPE_TSTR)
+        && (*it->cur & NANOCBOR_VALUE_MASK) == NANOCBOR_SIZE_INDEFINITE) {
+        return _skip_str_indefinite(it, (uint8_t)type);
+    }
     if (type == NANOCBOR_TYPE_BSTR || type == NANOCBOR_TYPE_TSTR) {
         const uint8_t *tmp = NULL;
         size_t len = 0;
@@ -559,6 +695,18 @@ int nanocbor_skip_simple(nanocbor_value_t *it)
     return _skip_simple(it);
 }
 
+int nanocbor_skip_tags(nanocbor_value_t *it)
+{
+    while (nanocbor_get_type(it) == NANOCBOR_TYPE_TAG) {
+        uint64_t tag = 0;
+        int res = nanocbor_get_tag64(it, &tag);
+        if (res < 0) {
+            return res;
+        }
+    }
+    return NANOCBOR_OK;
+}
+
 /* NOLINTNEXTLINE(misc-no-recursion): Recursion is limited by design */
 static int _skip_limited(nanocbor_value_t *it, uint8_t limit)
 {
@@ -580,9 +728,20 @@ static int _skip_limited(nanocbor_value_t *it, uint8_t limit)
                     break;
                 }
             }
+            if (res >= 0 && nanocbor_container_truncated(&recurse)) {
+                res = NANOCBOR_ERR_END;
+            }
             nanocbor_leave_container(it, &recurse);
         }
     }
+    else if (type == NANOCBOR_TYPE_TAG) {
+        /* Skip the tags together with the tagged item, tags don't count
+         * towards the container recursion limit */
+        res = nanocbor_skip_tags(it);
+        if (res == NANOCBOR_OK) {
+            res = _skip_limited(it, limit);
+        }
+    }
     else if (type >= 0) {
         res = _skip_simple(it);
     }
@@ -594,6 +753,22 @@ int nanocbor_skip(nanocbor_value_t *it)
     return _skip_limited(it, NANOCBOR_RECURSION_MAX);
 }
 
+int nanocbor_leave_container_early(nanocbor_value_t *it,
+                                   nanocbor_value_t *container)
+{
+    while (!nanocbor_at_end(container)) {
+        int res = nanocbor_skip(container);
+        if (res < 0) {
+            return res;
+        }
+    }
+    if (nanocbor_container_truncated(container)) {
+        return NANOCBOR_ERR_END;
+    }
+    nanocbor_leave_container(it, container);
+    return NANOCBOR_OK;
+}
+
 int nanocbor_get_key_tstr(nanocbor_value_t *start, const char *key,
                           nanocbor_value_t *value)
 {
@@ -623,3 +798,105 @@ int nanocbor_get_key_tstr(nanocbor_value_t *start, const char *key,
 
     return res;
 }
+
+static int _compare_int_double(int64_t i, double f)
+{
+    /* NaN sorts after all numbers */
+    if (f != f || f >= 9223372036854775808.0) {
+        return -1;
+    }
+    if (f < -9223372036854775808.0) {
+        return 1;
+    }
+    int64_t trunc = (int64_t)f;
+    if (i != trunc) {
+        return i < trunc ? -1 : 1;
+    }
+    double frac = f - (double)trunc;
+    return (frac < 0) - (frac > 0);
+}
+
+static int _compare_number(const nanocbor_number_t *a,
+                           const nanocbor_number_t *b)
+{
+    if (a->is_int && b->is_int) {
+        return (a->i > b->i) - (a->i < b->i);
+    }
+    if (a->is_int) {
+        return _compare_int_double(a->i, b->f);
+    }
+    if (b->is_int) {
+        return -_compare_int_double(b->i, a->f);
+    }
+    bool a_nan = a->f != a->f;
+    bool b_nan = b->f != b->f;
+    if (a_nan || b_nan) {
+        return a_nan - b_nan;
+    }
+    return (a->f > b->f) - (a->f < b->f);
+}
+
+static int _compare_bytes(const uint8_t *a, size_t a_len, const uint8_t *b,
+                          size_t b_len)
+{
+    int cmp = memcmp(a, b, a_len < b_len ? a_len : b_len);
+    if (cmp != 0) {
+        return cmp < 0 ? -1 : 1;
+    }
+    return (a_len > b_len) - (a_len < b_len);
+}
+
+static void _get_encoded(const nanocbor_value_t *value, const uint8_t **buf,
+                         size_t *len)
+{
+    nanocbor_value_t it = *value;
+    if (nanocbor_get_subcbor(&it, buf, len) < 0) {
+        *len = (size_t)(value->end - value->cur);
+    }
+}
+
+int nanocbor_compare(const nanocbor_value_t *a, const nanocbor_value_t *b)
+{
+    nanocbor_value_t x = *a;
+    nanocbor_value_t y = *b;
+    nanocbor_number_t x_num;
+    nanocbor_number_t y_num;
+
+    /* Tagged values compare by their content */
+    nanocbor_skip_tags(&x);
+    nanocbor_skip_tags(&y);
+
+    int type = nanocbor_get_type(&x);
+    bool x_is_num = nanocbor_get_number(&x, &x_num) == NANOCBOR_OK;
+    bool y_is_num = nanocbor_get_number(&y, &y_num) == NANOCBOR_OK;
+    int cmp = 0;
+    if (x_is_num && y_is_num) {
+        cmp = _compare_number(&x_num, &y_num);
+    }
+    else if (x_is_num || y_is_num) {
+        return x_is_num ? -1 : 1;
+    }
+    else if (type == nanocbor_get_type(&y)
+             && (type == NANOCBOR_TYPE_TSTR || type == NANOCBOR_TYPE_BSTR)) {
+        const uint8_t *x_str = NULL;
+        const uint8_t *y_str = NULL;
+        size_t x_len = 0;
+        size_t y_len = 0;
+        if (_get_str(&x, &x_str, &x_len, (uint8_t)type) >= 0
+            && _get_str(&y, &y_str, &y_len, (uint8_t)type) >= 0) {
+            cmp = _compare_bytes(x_str, x_len, y_str, y_len);
+        }
+    }
+    if (cmp != 0) {
+        return cmp;
+    }
+
+    /* Tie break on the encoding keeps the order total */
+    const uint8_t *a_buf = NULL;
+    const uint8_t *b_buf = NULL;
+    size_t a_len = 0;
+    size_t b_len = 0;
+    _get_encoded(a, &a_buf, &a_len);
+    _get_encoded(b, &b_buf, &b_len);
+    return _compare_bytes(a_buf, a_len, b_buf, b_len);
+}
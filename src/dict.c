@@ -0,0 +1,284 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @ingroup nanocbor_dict
+ * @{
+ * @file
+ * @brief   Session dictionary implementation
+ *
+ * Strings are identified by a 32 bit FNV-1a hash over their major type and
+ * content. The occurrence counters form a direct mapped table, a string
+ * hashing to an occupied counter of another string takes the counter over.
+ * A hash collision between counted strings at most learns a string early.
+ * @}
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "nanocbor/config.h"
+#include "nanocbor/dict.h"
+#include "nanocbor/nanocbor.h"
+
+#define FNV_OFFSET 2166136261U
+#define FNV_PRIME 16777619U
+
+static uint32_t _hash(uint8_t type, const uint8_t *str, size_t len)
+{
+    uint32_t hash = (FNV_OFFSET ^ type) * FNV_PRIME;
+
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ str[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+/* Size of the head of an item with argument @p val */
+static size_t _head_size(uint64_t val)
+{
+    if (val < NANOCBOR_SIZE_BYTE) {
+        return 1;
+    }
+    if (val <= UINT8_MAX) {
+        return 2;
+    }
+    if (val <= UINT16_MAX) {
+        return 3;
+    }
+    return val <= UINT32_MAX ? 5 : 9;
+}
+
+static size_t _find(const nanocbor_dict_t *dict, uint32_t hash, uint8_t type,
+                    const uint8_t *str, size_t len)
+{
+    for (size_t i = 0; i < dict->num_entries; i++) {
+        const nanocbor_dict_entry_t *entry = &dict->entries[i];
+        if (entry->hash == hash && entry->type == type && entry->len == len
+            && memcmp(entry->str, str, len) == 0) {
+            return i;
+        }
+    }
+    return dict->num_entries;
+}
+
+static bool _add(nanocbor_dict_t *dict, uint32_t hash, uint8_t type,
+                 const uint8_t *str, size_t len)
+{
+    if (dict->num_entries == dict->max_entries
+        || len > dict->arena_size - dict->arena_used) {
+        return false;
+    }
+    nanocbor_dict_entry_t *entry = &dict->entries[dict->num_entries++];
+    uint8_t *copy = dict->arena + dict->arena_used;
+
+    if (len > 0) {
+        memcpy(copy, str, len);
+    }
+    dict->arena_used += len;
+    entry->str = copy;
+    entry->len = len;
+    entry->hash = hash;
+    entry->type = type;
+    return true;
+}
+
+static void _learn(nanocbor_dict_t *dict, uint32_t hash, uint8_t type,
+                   const uint8_t *str, size_t len)
+{
+    /* Learning only pays off when the reference is shorter */
+    size_t ref_len = _head_size(NANOCBOR_TAG_DICT_REF)
+        + _head_size(dict->num_entries);
+    if (_head_size(len) + len <= ref_len) {
+        return;
+    }
+    nanocbor_dict_candidate_t *cand
+        = &dict->candidates[hash % NANOCBOR_DICT_CANDIDATES];
+    if (cand->hash != hash || cand->count == 0) {
+        cand->hash = hash;
+        cand->count = 0;
+    }
+    if (++cand->count < NANOCBOR_DICT_THRESHOLD) {
+        return;
+    }
+    /* A full dictionary stops learning */
+    _add(dict, hash, type, str, len);
+    cand->count = 0;
+}
+
+static int _put_str(nanocbor_encoder_t *enc, uint8_t type, const uint8_t *str,
+                    size_t len)
+{
+    return type == NANOCBOR_TYPE_TSTR
+        ? nanocbor_put_tstrn(enc, (const char *)str, len)
+        : nanocbor_put_bstr(enc, str, len);
+}
+
+static int _put(nanocbor_dict_t *dict, nanocbor_encoder_t *enc, uint8_t type,
+                const uint8_t *str, size_t len)
+{
+    uint32_t hash = _hash(type, str, len);
+    size_t idx = _find(dict, hash, type, str, len);
+
+    if (idx < dict->announced) {
+        if (nanocbor_fmt_tag(enc, NANOCBOR_TAG_DICT_REF) < 0
+            || nanocbor_fmt_uint(enc, idx) < 0) {
+            return NANOCBOR_ERR_END;
+        }
+        return NANOCBOR_OK;
+    }
+    int res = _put_str(enc, type, str, len);
+    /* Learned strings waiting for their announcement are not counted */
+    if (res >= 0 && idx == dict->num_entries) {
+        _learn(dict, hash, type, str, len);
+    }
+    return res;
+}
+
+static int _get(const nanocbor_dict_t *dict, nanocbor_value_t *it,
+                uint8_t type, const uint8_t **buf, size_t *len)
+{
+    nanocbor_value_t item = *it;
+    uint64_t tag = 0;
+
+    if (nanocbor_get_tag64(&item, &tag) < 0
+        || tag != NANOCBOR_TAG_DICT_REF) {
+        return type == NANOCBOR_TYPE_TSTR ? nanocbor_get_tstr(it, buf, len)
+                                          : nanocbor_get_bstr(it, buf, len);
+    }
+    uint32_t idx = 0;
+    if (nanocbor_get_uint32(&item, &idx) < 0) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    if (idx >= dict->announced) {
+        return NANOCBOR_NOT_FOUND;
+    }
+    const nanocbor_dict_entry_t *entry = &dict->entries[idx];
+    if (entry->type != type) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    *buf = entry->str;
+    *len = entry->len;
+    *it = item;
+    return NANOCBOR_OK;
+}
+
+static int _get_entries(nanocbor_dict_t *dict, nanocbor_value_t *arr)
+{
+    while (!nanocbor_at_end(arr)) {
+        int type = nanocbor_get_type(arr);
+        const uint8_t *str = NULL;
+        size_t len = 0;
+        int res = NANOCBOR_ERR_INVALID_TYPE;
+
+        if (type == NANOCBOR_TYPE_TSTR) {
+            res = nanocbor_get_tstr(arr, &str, &len);
+        }
+        else if (type == NANOCBOR_TYPE_BSTR) {
+            res = nanocbor_get_bstr(arr, &str, &len);
+        }
+        if (res < 0) {
+            return NANOCBOR_ERR_INVALID_TYPE;
+        }
+        if (!_add(dict, _hash((uint8_t)type, str, len), (uint8_t)type, str,
+                  len)) {
+            return NANOCBOR_ERR_OVERFLOW;
+        }
+    }
+    return NANOCBOR_OK;
+}
+
+void nanocbor_dict_init(nanocbor_dict_t *dict, nanocbor_dict_entry_t *entries,
+                        size_t max_entries, uint8_t *arena, size_t arena_size)
+{
+    memset(dict, 0, sizeof(*dict));
+    dict->entries = entries;
+    dict->max_entries = max_entries;
+    dict->arena = arena;
+    dict->arena_size = arena_size;
+}
+
+int nanocbor_dict_fmt_update(nanocbor_dict_t *dict, nanocbor_encoder_t *enc)
+{
+    if (dict->announced == dict->num_entries) {
+        return NANOCBOR_OK;
+    }
+    if (nanocbor_fmt_tag(enc, NANOCBOR_TAG_DICT_UPDATE) < 0
+        || nanocbor_fmt_array(enc, 1 + dict->num_entries - dict->announced)
+            < 0
+        || nanocbor_fmt_uint(enc, dict->announced) < 0) {
+        return NANOCBOR_ERR_END;
+    }
+    for (size_t i = dict->announced; i < dict->num_entries; i++) {
+        const nanocbor_dict_entry_t *entry = &dict->entries[i];
+        if (_put_str(enc, entry->type, entry->str, entry->len) < 0) {
+            return NANOCBOR_ERR_END;
+        }
+    }
+    dict->announced = dict->num_entries;
+    return NANOCBOR_OK;
+}
+
+int nanocbor_dict_put_tstrn(nanocbor_dict_t *dict, nanocbor_encoder_t *enc,
+                            const char *str, size_t len)
+{
+    return _put(dict, enc, NANOCBOR_TYPE_TSTR, (const uint8_t *)str, len);
+}
+
+int nanocbor_dict_put_tstr(nanocbor_dict_t *dict, nanocbor_encoder_t *enc,
+                           const char *str)
+{
+    return nanocbor_dict_put_tstrn(dict, enc, str, strlen(str));
+}
+
+int nanocbor_dict_put_bstr(nanocbor_dict_t *dict, nanocbor_encoder_t *enc,
+                           const uint8_t *str, size_t len)
+{
+    return _put(dict, enc, NANOCBOR_TYPE_BSTR, str, len);
+}
+
+int nanocbor_dict_get_update(nanocbor_dict_t *dict, nanocbor_value_t *it)
+{
+    nanocbor_value_t item = *it;
+    nanocbor_value_t arr;
+    uint64_t tag = 0;
+    uint32_t first = 0;
+
+    if (nanocbor_get_tag64(&item, &tag) < 0
+        || tag != NANOCBOR_TAG_DICT_UPDATE) {
+        return NANOCBOR_NOT_FOUND;
+    }
+    if (nanocbor_enter_array(&item, &arr) < 0
+        || nanocbor_get_uint32(&arr, &first) < 0
+        || first != dict->num_entries) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    size_t num_entries = dict->num_entries;
+    size_t arena_used = dict->arena_used;
+    int res = _get_entries(dict, &arr);
+    if (res < 0) {
+        /* Drop the entries of the partially applied record */
+        dict->num_entries = num_entries;
+        dict->arena_used = arena_used;
+        return res;
+    }
+    nanocbor_leave_container(&item, &arr);
+    dict->announced = dict->num_entries;
+    *it = item;
+    return NANOCBOR_OK;
+}
+
+int nanocbor_dict_get_tstr(const nanocbor_dict_t *dict, nanocbor_value_t *it,
+                           const uint8_t **buf, size_t *len)
+{
+    return _get(dict, it, NANOCBOR_TYPE_TSTR, buf, len);
+}
+
+int nanocbor_dict_get_bstr(const nanocbor_dict_t *dict, nanocbor_value_t *it,
+                           const uint8_t **buf, size_t *len)
+{
+    return _get(dict, it, NANOCBOR_TYPE_BSTR, buf, len);
+}
@@ -0,0 +1,656 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @ingroup nanocbor_diff
+ * @{
+ * @file
+ * @brief   Diff and patch implementation
+ *
+ * Both directions walk the old item and the other input side by side. The
+ * entries of a container are visited twice, first counting the entries of
+ * the output for its definite-length header and then encoding them.
+ * @}
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "nanocbor/config.h"
+#include "nanocbor/diff.h"
+#include "nanocbor/nanocbor.h"
+
+/* Size of an encoded unsigned integer */
+#define UINT_MAX_SIZE (1 + sizeof(uint64_t))
+
+static int _diff_item(nanocbor_encoder_t *enc, nanocbor_value_t *old,
+                      nanocbor_value_t *updated, unsigned depth);
+static int _patch_item(nanocbor_encoder_t *enc, nanocbor_value_t *old,
+                       nanocbor_value_t *patch, unsigned depth);
+
+static bool _same(const uint8_t *a, size_t a_len, const uint8_t *b,
+                  size_t b_len)
+{
+    return a_len == b_len && !memcmp(a, b, a_len);
+}
+
+/* Compares two items bytewise without advancing the decoders */
+static int _same_item(const nanocbor_value_t *a, const nanocbor_value_t *b)
+{
+    nanocbor_value_t a_it = *a;
+    nanocbor_value_t b_it = *b;
+    const uint8_t *a_start = NULL;
+    const uint8_t *b_start = NULL;
+    size_t a_len = 0;
+    size_t b_len = 0;
+
+    int res = nanocbor_get_subcbor(&a_it, &a_start, &a_len);
+    if (res >= 0) {
+        res = nanocbor_get_subcbor(&b_it, &b_start, &b_len);
+    }
+    if (res < 0) {
+        return res;
+    }
+    return _same(a_start, a_len, b_start, b_len);
+}
+
+static int _copy(nanocbor_encoder_t *enc, nanocbor_value_t *it)
+{
+    const uint8_t *start = NULL;
+    size_t len = 0;
+
+    int res = nanocbor_get_subcbor(it, &start, &len);
+    if (res < 0) {
+        return res;
+    }
+    return nanocbor_put_raw(enc, start, len);
+}
+
+/* Encodes the start of a patch with @p items items including the op */
+static int _op(nanocbor_encoder_t *enc, nanocbor_patch_op_t op, size_t items)
+{
+    int res = nanocbor_fmt_array(enc, items);
+
+    if (res >= 0) {
+        res = nanocbor_fmt_uint(enc, (uint64_t)op);
+    }
+    return res < 0 ? res : NANOCBOR_OK;
+}
+
+/* Finds the entry of a map with an encoded key, positioning @p value at the
+ * value of the entry */
+static int _find_key(const nanocbor_value_t *map, const uint8_t *key,
+                     size_t len, nanocbor_value_t *value)
+{
+    nanocbor_value_t it = *map;
+
+    while (!nanocbor_at_end(&it)) {
+        const uint8_t *cur = NULL;
+        size_t cur_len = 0;
+        int res = nanocbor_get_subcbor(&it, &cur, &cur_len);
+        if (res < 0) {
+            return res;
+        }
+        if (_same(cur, cur_len, key, len)) {
+            *value = it;
+            return NANOCBOR_OK;
+        }
+        res = nanocbor_skip(&it);
+        if (res < 0) {
+            return res;
+        }
+    }
+    return NANOCBOR_NOT_FOUND;
+}
+
+/* Finds the patch of an array element by its index */
+static int _find_index(const nanocbor_value_t *map, uint64_t index,
+                       nanocbor_value_t *value)
+{
+    uint8_t key[UINT_MAX_SIZE];
+    nanocbor_encoder_t enc;
+
+    nanocbor_encoder_init(&enc, key, sizeof(key));
+    nanocbor_fmt_uint(&enc, index);
+    return _find_key(map, key, nanocbor_encoded_len(&enc), value);
+}
+
+static int _get_op(const nanocbor_value_t *patch, uint32_t *op)
+{
+    nanocbor_value_t arr;
+
+    int res = nanocbor_enter_array(patch, &arr);
+    if (res < 0) {
+        return res;
+    }
+    res = nanocbor_get_uint32(&arr, op);
+    return res < 0 ? res : NANOCBOR_OK;
+}
+
+/* Whether the containers of an item nest at most @p levels deep, advances
+ * past the item */
+/* NOLINTNEXTLINE(misc-no-recursion): Recursion is limited by design */
+static bool _nests_within(nanocbor_value_t *it, unsigned levels)
+{
+    nanocbor_value_t container;
+
+    if (nanocbor_skip_tags(it) < 0) {
+        return false;
+    }
+    int type = nanocbor_get_type(it);
+    if (type != NANOCBOR_TYPE_ARR && type != NANOCBOR_TYPE_MAP) {
+        return nanocbor_skip_simple(it) == NANOCBOR_OK;
+    }
+    if (levels == 0) {
+        return false;
+    }
+    int res = type == NANOCBOR_TYPE_MAP ? nanocbor_enter_map(it, &container)
+                                        : nanocbor_enter_array(it, &container);
+    while (res >= 0 && !nanocbor_at_end(&container)) {
+        if (!_nests_within(&container, levels - 1)) {
+            return false;
+        }
+    }
+    return res >= 0
+        && nanocbor_leave_container_early(it, &container) == NANOCBOR_OK;
+}
+
+/* Every level of patched containers nests the patch two levels deeper, as
+ * the patch of an element sits in the entries map of its container patch.
+ * The new item at @p depth is only patched when replacing any of its
+ * elements keeps the patch within the nesting that nanocbor_skip, and so
+ * nanocbor_patch, can decode */
+static bool _patchable(const nanocbor_value_t *updated, unsigned depth)
+{
+    nanocbor_value_t it = *updated;
+
+    if (2 * depth + 2 >= NANOCBOR_RECURSION_MAX) {
+        return false;
+    }
+    return _nests_within(&it, NANOCBOR_RECURSION_MAX - 2 * depth - 2);
+}
+
+/* Encodes the patch of an old entry if it changed or was removed, counting
+ * the patched entries */
+static int _diff_changed(nanocbor_encoder_t *enc, nanocbor_value_t *it,
+                         const nanocbor_value_t *updated, unsigned depth,
+                         uint64_t *count)
+{
+    nanocbor_value_t value;
+    const uint8_t *key = NULL;
+    size_t len = 0;
+
+    int res = nanocbor_get_subcbor(it, &key, &len);
+    if (res < 0) {
+        return res;
+    }
+    int found = _find_key(updated, key, len, &value);
+    if (found == NANOCBOR_OK) {
+        res = _same_item(it, &value);
+        if (res != 0) {
+            return res < 0 ? res : nanocbor_skip(it);
+        }
+    }
+    else if (found != NANOCBOR_NOT_FOUND) {
+        return found;
+    }
+    (*count)++;
+    if (!enc) {
+        return nanocbor_skip(it);
+    }
+    res = nanocbor_put_raw(enc, key, len);
+    if (res < 0) {
+        return res;
+    }
+    if (found == NANOCBOR_NOT_FOUND) {
+        res = _op(enc, NANOCBOR_PATCH_REMOVE, 1);
+        return res < 0 ? res : nanocbor_skip(it);
+    }
+    return _diff_item(enc, it, &value, depth);
+}
+
+/* Encodes a new entry if it is not in the old map */
+static int _diff_added(nanocbor_encoder_t *enc, nanocbor_value_t *it,
+                       const nanocbor_value_t *old, uint64_t *count)
+{
+    nanocbor_value_t value;
+    const uint8_t *key = NULL;
+    size_t len = 0;
+
+    int res = nanocbor_get_subcbor(it, &key, &len);
+    if (res < 0) {
+        return res;
+    }
+    res = _find_key(old, key, len, &value);
+    if (res != NANOCBOR_NOT_FOUND) {
+        return res < 0 ? res : nanocbor_skip(it);
+    }
+    (*count)++;
+    if (!enc) {
+        return nanocbor_skip(it);
+    }
+    res = nanocbor_put_raw(enc, key, len);
+    if (res >= 0) {
+        res = _op(enc, NANOCBOR_PATCH_REPLACE, 2);
+    }
+    if (res < 0) {
+        return res;
+    }
+    return _copy(enc, it);
+}
+
+/* Encodes the entries of a map patch, or only counts them without an
+ * encoder */
+static int _diff_entries(nanocbor_encoder_t *enc, const nanocbor_value_t *old,
+                         const nanocbor_value_t *updated, unsigned depth,
+                         uint64_t *count)
+{
+    nanocbor_value_t it = *old;
+    int res = NANOCBOR_OK;
+
+    *count = 0;
+    while (res >= 0 && !nanocbor_at_end(&it)) {
+        res = _diff_changed(enc, &it, updated, depth, count);
+    }
+    it = *updated;
+    while (res >= 0 && !nanocbor_at_end(&it)) {
+        res = _diff_added(enc, &it, old, count);
+    }
+    return res;
+}
+
+static int _diff_map(nanocbor_encoder_t *enc, const nanocbor_value_t *old,
+                     const nanocbor_value_t *updated, unsigned depth)
+{
+    nanocbor_value_t from;
+    nanocbor_value_t to;
+    uint64_t count = 0;
+
+    int res = nanocbor_enter_map(old, &from);
+    if (res >= 0) {
+        res = nanocbor_enter_map(updated, &to);
+    }
+    if (res >= 0) {
+        res = _diff_entries(NULL, &from, &to, depth, &count);
+    }
+    if (res >= 0) {
+        res = _op(enc, NANOCBOR_PATCH_MAP, 2);
+    }
+    if (res >= 0) {
+        res = nanocbor_fmt_map(enc, count);
+    }
+    if (res < 0) {
+        return res;
+    }
+    return _diff_entries(enc, &from, &to, depth, &count);
+}
+
+/* Encodes the changed elements of the common part of two arrays, or only
+ * counts them without an encoder */
+static int _diff_elements(nanocbor_encoder_t *enc, nanocbor_value_t *from,
+                          nanocbor_value_t *to, unsigned depth,
+                          uint64_t *keep, uint64_t *changed)
+{
+    *keep = 0;
+    *changed = 0;
+    while (!nanocbor_at_end(from) && !nanocbor_at_end(to)) {
+        int same = _same_item(from, to);
+        int res = NANOCBOR_OK;
+        if (same < 0) {
+            return same;
+        }
+        if (!same) {
+            (*changed)++;
+        }
+        if (!same && enc) {
+            res = nanocbor_fmt_uint(enc, *keep);
+            if (res >= 0) {
+                res = _diff_item(enc, from, to, depth);
+            }
+        }
+        else {
+            res = nanocbor_skip(from);
+            if (res >= 0) {
+                res = nanocbor_skip(to);
+            }
+        }
+        if (res < 0) {
+            return res;
+        }
+        (*keep)++;
+    }
+    return NANOCBOR_OK;
+}
+
+static int _diff_array(nanocbor_encoder_t *enc, const nanocbor_value_t *old,
+                       const nanocbor_value_t *updated, unsigned depth)
+{
+    nanocbor_value_t from;
+    nanocbor_value_t to;
+    uint64_t keep = 0;
+    uint64_t changed = 0;
+    size_t appended = 0;
+
+    int res = nanocbor_enter_array(old, &from);
+    if (res >= 0) {
+        res = nanocbor_enter_array(updated, &to);
+    }
+    if (res < 0) {
+        return res;
+    }
+    nanocbor_value_t from_it = from;
+    nanocbor_value_t to_it = to;
+    res = _diff_elements(NULL, &from_it, &to_it, depth, &keep, &changed);
+    for (; res >= 0 && !nanocbor_at_end(&to_it); appended++) {
+        res = nanocbor_skip(&to_it);
+    }
+    if (res >= 0) {
+        res = _op(enc, NANOCBOR_PATCH_ARRAY, 3 + appended);
+    }
+    if (res >= 0) {
+        res = nanocbor_fmt_uint(enc, keep);
+    }
+    if (res >= 0) {
+        res = nanocbor_fmt_map(enc, changed);
+    }
+    if (res >= 0) {
+        res = _diff_elements(enc, &from, &to, depth, &keep, &changed);
+    }
+    while (res >= 0 && !nanocbor_at_end(&to)) {
+        res = _copy(enc, &to);
+    }
+    return res < 0 ? res : NANOCBOR_OK;
+}
+
+static int _diff_item(nanocbor_encoder_t *enc, nanocbor_value_t *old,
+                      nanocbor_value_t *updated, unsigned depth)
+{
+    nanocbor_value_t from = *old;
+    nanocbor_value_t to = *updated;
+    const uint8_t *old_start = NULL;
+    const uint8_t *new_start = NULL;
+    size_t old_len = 0;
+    size_t new_len = 0;
+
+    int res = nanocbor_get_subcbor(old, &old_start, &old_len);
+    if (res >= 0) {
+        res = nanocbor_get_subcbor(updated, &new_start, &new_len);
+    }
+    if (res < 0) {
+        return res;
+    }
+    if (_same(old_start, old_len, new_start, new_len)) {
+        return _op(enc, NANOCBOR_PATCH_KEEP, 1);
+    }
+    nanocbor_skip_tags(&from);
+    nanocbor_skip_tags(&to);
+    /* Containers with the same tags are patched, other items replaced */
+    int type = nanocbor_get_type(&from);
+    if (_patchable(&to, depth) && type == nanocbor_get_type(&to)
+        && _same(old_start, (size_t)(from.cur - old_start), new_start,
+                 (size_t)(to.cur - new_start))) {
+        if (type == NANOCBOR_TYPE_MAP) {
+            return _diff_map(enc, &from, &to, depth + 1);
+        }
+        if (type == NANOCBOR_TYPE_ARR) {
+            return _diff_array(enc, &from, &to, depth + 1);
+        }
+    }
+    res = _op(enc, NANOCBOR_PATCH_REPLACE, 2);
+    if (res < 0) {
+        return res;
+    }
+    return nanocbor_put_raw(enc, new_start, new_len);
+}
+
+int nanocbor_diff(nanocbor_value_t *old, nanocbor_value_t *updated,
+                  nanocbor_encoder_t *enc)
+{
+    return _diff_item(enc, old, updated, 0);
+}
+
+/* Encodes an old entry unless it is removed, counting the kept entries */
+static int _patch_kept(nanocbor_encoder_t *enc, nanocbor_value_t *it,
+                       const nanocbor_value_t *entries, unsigned depth,
+                       uint64_t *count)
+{
+    nanocbor_value_t patch;
+    const uint8_t *key = NULL;
+    size_t len = 0;
+    uint32_t op = NANOCBOR_PATCH_KEEP;
+
+    int res = nanocbor_get_subcbor(it, &key, &len);
+    if (res < 0) {
+        return res;
+    }
+    int found = _find_key(entries, key, len, &patch);
+    if (found == NANOCBOR_OK) {
+        res = _get_op(&patch, &op);
+        if (res < 0) {
+            return res;
+        }
+    }
+    else if (found != NANOCBOR_NOT_FOUND) {
+        return found;
+    }
+    if (op == NANOCBOR_PATCH_REMOVE) {
+        return nanocbor_skip(it);
+    }
+    (*count)++;
+    if (!enc) {
+        return nanocbor_skip(it);
+    }
+    res = nanocbor_put_raw(enc, key, len);
+    if (res < 0) {
+        return res;
+    }
+    return found == NANOCBOR_NOT_FOUND ? _copy(enc, it)
+                                       : _patch_item(enc, it, &patch, depth);
+}
+
+/* Encodes an entry of the patch that is not in the old map */
+static int _patch_added(nanocbor_encoder_t *enc, nanocbor_value_t *it,
+                        const nanocbor_value_t *from, uint64_t *count)
+{
+    nanocbor_value_t value;
+    nanocbor_value_t ops;
+    const uint8_t *key = NULL;
+    size_t len = 0;
+    uint32_t op = NANOCBOR_PATCH_KEEP;
+
+    int res = nanocbor_get_subcbor(it, &key, &len);
+    if (res < 0) {
+        return res;
+    }
+    res = _find_key(from, key, len, &value);
+    if (res != NANOCBOR_NOT_FOUND) {
+        return res < 0 ? res : nanocbor_skip(it);
+    }
+    res = nanocbor_enter_array(it, &ops);
+    if (res >= 0) {
+        res = nanocbor_get_uint32(&ops, &op);
+    }
+    if (res < 0) {
+        return res;
+    }
+    if (op != NANOCBOR_PATCH_REPLACE) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    (*count)++;
+    if (enc) {
+        res = nanocbor_put_raw(enc, key, len);
+        if (res >= 0) {
+            res = _copy(enc, &ops);
+        }
+        if (res < 0) {
+            return res;
+        }
+    }
+    return nanocbor_skip(it);
+}
+
+/* Encodes the entries of a patched map, or only counts them without an
+ * encoder */
+static int _patch_entries(nanocbor_encoder_t *enc,
+                          const nanocbor_value_t *from,
+                          const nanocbor_value_t *entries, unsigned depth,
+                          uint64_t *count)
+{
+    nanocbor_value_t it = *from;
+    int res = NANOCBOR_OK;
+
+    *count = 0;
+    while (res >= 0 && !nanocbor_at_end(&it)) {
+        res = _patch_kept(enc, &it, entries, depth, count);
+    }
+    it = *entries;
+    while (res >= 0 && !nanocbor_at_end(&it)) {
+        res = _patch_added(enc, &it, from, count);
+    }
+    return res;
+}
+
+static int _patch_map(nanocbor_encoder_t *enc, nanocbor_value_t *old,
+                      nanocbor_value_t *ops, unsigned depth)
+{
+    nanocbor_value_t from;
+    nanocbor_value_t entries;
+    uint64_t count = 0;
+
+    if (nanocbor_get_type(old) != NANOCBOR_TYPE_MAP) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    int res = nanocbor_enter_map(old, &from);
+    if (res >= 0) {
+        res = nanocbor_enter_map(ops, &entries);
+    }
+    if (res >= 0) {
+        res = _patch_entries(NULL, &from, &entries, depth, &count);
+    }
+    if (res >= 0) {
+        res = nanocbor_fmt_map(enc, count);
+    }
+    if (res >= 0) {
+        res = _patch_entries(enc, &from, &entries, depth, &count);
+    }
+    if (res >= 0) {
+        res = nanocbor_leave_container_early(old, &from);
+    }
+    if (res >= 0) {
+        res = nanocbor_skip(ops);
+    }
+    return res;
+}
+
+static int _patch_array(nanocbor_encoder_t *enc, nanocbor_value_t *old,
+                        nanocbor_value_t *ops, unsigned depth)
+{
+    nanocbor_value_t from;
+    nanocbor_value_t changes;
+    uint64_t keep = 0;
+    size_t appended = 0;
+
+    if (nanocbor_get_type(old) != NANOCBOR_TYPE_ARR) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    int res = nanocbor_enter_array(old, &from);
+    if (res >= 0) {
+        res = nanocbor_get_uint64(ops, &keep);
+    }
+    if (res >= 0) {
+        res = nanocbor_enter_map(ops, &changes);
+    }
+    if (res >= 0) {
+        res = nanocbor_skip(ops);
+    }
+    nanocbor_value_t it = *ops;
+    for (; res >= 0 && !nanocbor_at_end(&it); appended++) {
+        res = nanocbor_skip(&it);
+    }
+    if (res >= 0 && keep > UINT64_MAX - appended) {
+        res = NANOCBOR_ERR_OVERFLOW;
+    }
+    if (res >= 0) {
+        res = nanocbor_fmt_array(enc, keep + appended);
+    }
+    for (uint64_t index = 0; res >= 0 && index < keep; index++) {
+        nanocbor_value_t patch;
+        if (nanocbor_at_end(&from)) {
+            return NANOCBOR_ERR_INVALID_TYPE;
+        }
+        res = _find_index(&changes, index, &patch);
+        if (res == NANOCBOR_NOT_FOUND) {
+            res = _copy(enc, &from);
+        }
+        else if (res >= 0) {
+            res = _patch_item(enc, &from, &patch, depth);
+        }
+    }
+    if (res >= 0) {
+        res = nanocbor_leave_container_early(old, &from);
+    }
+    while (res >= 0 && !nanocbor_at_end(ops)) {
+        res = _copy(enc, ops);
+    }
+    return res;
+}
+
+static int _patch_item(nanocbor_encoder_t *enc, nanocbor_value_t *old,
+                       nanocbor_value_t *patch, unsigned depth)
+{
+    nanocbor_value_t ops;
+    uint32_t op = NANOCBOR_PATCH_KEEP;
+
+    int res = nanocbor_enter_array(patch, &ops);
+    if (res >= 0) {
+        res = nanocbor_get_uint32(&ops, &op);
+    }
+    if (res < 0) {
+        return res;
+    }
+    switch (op) {
+    case NANOCBOR_PATCH_KEEP:
+        res = _copy(enc, old);
+        break;
+    case NANOCBOR_PATCH_REPLACE:
+        res = _copy(enc, &ops);
+        if (res >= 0) {
+            res = nanocbor_skip(old);
+        }
+        break;
+    case NANOCBOR_PATCH_MAP:
+    case NANOCBOR_PATCH_ARRAY:
+        if (depth >= NANOCBOR_RECURSION_MAX) {
+            return NANOCBOR_ERR_RECURSION;
+        }
+        /* Tags of a patched container are kept */
+        while (res >= 0 && nanocbor_get_type(old) == NANOCBOR_TYPE_TAG) {
+            uint64_t tag = 0;
+            res = nanocbor_get_tag64(old, &tag);
+            if (res >= 0) {
+                res = nanocbor_fmt_tag(enc, tag);
+            }
+        }
+        if (res >= 0) {
+            res = op == NANOCBOR_PATCH_MAP
+                ? _patch_map(enc, old, &ops, depth + 1)
+                : _patch_array(enc, old, &ops, depth + 1);
+        }
+        break;
+    default:
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    if (res < 0) {
+        return res;
+    }
+    return nanocbor_leave_container_early(patch, &ops);
+}
+
+int nanocbor_patch(nanocbor_value_t *old, nanocbor_value_t *patch,
+                   nanocbor_encoder_t *enc)
+{
+    return _patch_item(enc, old, patch, 0);
+}
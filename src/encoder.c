@@ -36,6 +36,15 @@ static void _encoder_mem_append(nanocbor_encoder_t *enc, void *ctx, const uint8_
     enc->cur += len;
 }
 
+static void _encoder_mem_append_vec(nanocbor_encoder_t *enc, void *ctx,
+                                    const nanocbor_encoder_vec_t *vec,
+                                    size_t num)
+{
+    for (size_t i = 0; i < num; i++) {
+        _encoder_mem_append(enc, ctx, vec[i].data, vec[i].len);
+    }
+}
+
 void nanocbor_encoder_init(nanocbor_encoder_t *enc, uint8_t *buf, size_t len)
 {
     enc->len = 0;
@@ -43,6 +52,7 @@ void nanocbor_encoder_init(nanocbor_encoder_t *enc, uint8_t *buf, size_t len)
     enc->end = buf + len;
     enc->append = _encoder_mem_append;
     enc->fits = _encoder_mem_fits;
+    enc->append_vec = _encoder_mem_append_vec;
 }
 
 void nanocbor_encoder_stream_init(nanocbor_encoder_t *enc, void *ctx,
@@ -53,6 +63,13 @@ void nanocbor_encoder_stream_init(nanocbor_encoder_t *enc, void *ctx,
     enc->append = append_func;
     enc->fits = fits_func;
     enc->context = ctx;
+    enc->append_vec = NULL;
+}
+
+void nanocbor_encoder_set_append_vec(
+    nanocbor_encoder_t *enc, nanocbor_encoder_append_vec append_vec_func)
+{
+    enc->append_vec = append_vec_func;
 }
 
 size_t nanocbor_encoded_len(nanocbor_encoder_t *enc)
@@ -75,6 +92,31 @@ static inline int _fits(nanocbor_encoder_t *enc, size_t len)
     return enc->fits(enc, enc->context, len) ? (int)len : NANOCBOR_ERR_END;
 }
 
+/* Appends a header and its payload. Small payloads are staged behind the
+ * header in @p head, which must have room for
+ * NANOCBOR_ENCODER_STAGING_SIZE bytes after the header */
+static void _append_pair(nanocbor_encoder_t *enc, uint8_t *head,
+                         size_t head_len, const uint8_t *data, size_t len)
+{
+    if (enc->append_vec) {
+        const nanocbor_encoder_vec_t vec[2] = {
+            { head, head_len },
+            { data, len },
+        };
+        enc->append_vec(enc, enc->context, vec, len ? 2 : 1);
+    }
+    else if (len <= NANOCBOR_ENCODER_STAGING_SIZE) {
+        if (len) {
+            memcpy(head + head_len, data, len);
+        }
+        _append(enc, head, head_len + len);
+    }
+    else {
+        _append(enc, head, head_len);
+        _append(enc, data, len);
+    }
+}
+
 static int _fmt_single(nanocbor_encoder_t *enc, uint8_t single)
 {
     _incr_len(enc, 1);
@@ -95,7 +137,21 @@ int nanocbor_fmt_bool(nanocbor_encoder_t *enc, bool content)
     return _fmt_single(enc, single);
 }
 
-static int _fmt_uint64(nanocbor_encoder_t *enc, uint64_t num, uint8_t type)
+/* Accumulate the bytes written by multiple calls, keeping the first error.
+ * Callers keep encoding after an error to keep the encoded length correct */
+static inline int _add_res(int res, int item)
+{
+    if (res < 0) {
+        return res;
+    }
+    return item < 0 ? item : res + item;
+}
+
+/* Maximum length of an item header, the type and a 64 bit argument */
+#define HEADER_MAX (1 + sizeof(uint64_t))
+
+/* Writes the header of an item to @p buf, returning its length */
+static size_t _fmt_header(uint8_t *buf, uint64_t num, uint8_t type)
 {
     unsigned extrabytes = 0;
 
@@ -122,17 +178,23 @@ static int _fmt_uint64(nanocbor_encoder_t *enc, uint64_t num, uint8_t type)
             extrabytes = sizeof(uint8_t);
         }
     }
-    _incr_len(enc, extrabytes + 1);
-    int res = _fits(enc, extrabytes + 1);
-    if (res > 0) {
-        _append(enc, &type, 1);
-
-        /* NOLINTNEXTLINE: user supplied function */
-        uint64_t benum = NANOCBOR_HTOBE64_FUNC(num);
+    buf[0] = type;
+    /* NOLINTNEXTLINE: user supplied function */
+    uint64_t benum = NANOCBOR_HTOBE64_FUNC(num);
+    memcpy(buf + 1, (uint8_t *)&benum + sizeof(benum) - extrabytes,
+           extrabytes);
+    return extrabytes + 1;
+}
 
+static int _fmt_uint64(nanocbor_encoder_t *enc, uint64_t num, uint8_t type)
+{
+    uint8_t buf[HEADER_MAX];
+    size_t len = _fmt_header(buf, num, type);
 
-        _append(enc, (uint8_t *)&benum + sizeof(benum) - extrabytes,
-               extrabytes);
+    _incr_len(enc, len);
+    int res = _fits(enc, len);
+    if (res > 0) {
+        _append(enc, buf, len);
     }
     return res;
 }
@@ -157,6 +219,43 @@ int nanocbor_fmt_int(nanocbor_encoder_t *enc, int64_t num)
     return nanocbor_fmt_uint(enc, (uint64_t)num);
 }
 
+int nanocbor_fmt_int64_array(nanocbor_encoder_t *enc, const int64_t *values,
+                             size_t len)
+{
+    int res = nanocbor_fmt_array(enc, len);
+    for (size_t i = 0; i < len; i++) {
+        res = _add_res(res, nanocbor_fmt_int(enc, values[i]));
+    }
+    return res;
+}
+
+int nanocbor_fmt_delta_array(nanocbor_encoder_t *enc, const int64_t *values,
+                             size_t len)
+{
+    int res = nanocbor_fmt_tag(enc, NANOCBOR_TAG_DELTA_ARRAY);
+    res = _add_res(res, nanocbor_fmt_array(enc, len));
+    for (size_t i = 0; i < len; i++) {
+        int item = 0;
+        if (i == 0) {
+            item = nanocbor_fmt_int(enc, values[0]);
+        }
+        /* The difference of two int64_t needs up to 65 bits, use the
+         * separate CBOR major types for the sign */
+        else if (values[i] >= values[i - 1]) {
+            item = _fmt_uint64(enc,
+                               (uint64_t)values[i] - (uint64_t)values[i - 1],
+                               NANOCBOR_MASK_UINT);
+        }
+        else {
+            item = _fmt_uint64(
+                enc, (uint64_t)values[i - 1] - (uint64_t)values[i] - 1,
+                NANOCBOR_MASK_NINT);
+        }
+        res = _add_res(res, item);
+    }
+    return res;
+}
+
 int nanocbor_fmt_bstr(nanocbor_encoder_t *enc, size_t len)
 {
     return _fmt_uint64(enc, (uint64_t)len, NANOCBOR_MASK_BSTR);
@@ -179,24 +278,44 @@ static int _put_bytes(nanocbor_encoder_t *enc, const uint8_t *str, size_t len)
     return res;
 }
 
-int nanocbor_put_tstr(nanocbor_encoder_t *enc, const char *str)
+/* Encodes a string with a single fits and append call, returning the number
+ * of bytes written */
+static int _put_str(nanocbor_encoder_t *enc, uint8_t type, const uint8_t *str,
+                    size_t len)
 {
-    size_t len = strlen(str);
+    uint8_t buf[HEADER_MAX + NANOCBOR_ENCODER_STAGING_SIZE];
+    size_t head = _fmt_header(buf, (uint64_t)len, type);
+
+    _incr_len(enc, head + len);
+    int res = _fits(enc, head + len);
+    if (res >= 0) {
+        _append_pair(enc, buf, head, str, len);
+    }
+    return res;
+}
 
-    nanocbor_fmt_tstr(enc, len);
-    return _put_bytes(enc, (const uint8_t *)str, len);
+int nanocbor_put_tstr(nanocbor_encoder_t *enc, const char *str)
+{
+    return nanocbor_put_tstrn(enc, str, strlen(str));
 }
 
 int nanocbor_put_tstrn(nanocbor_encoder_t *enc, const char *str, size_t len)
 {
-    nanocbor_fmt_tstr(enc, len);
-    return _put_bytes(enc, (const uint8_t *)str, len);
+    int res = _put_str(enc, NANOCBOR_MASK_TSTR, (const uint8_t *)str, len);
+
+    return res < 0 ? res : NANOCBOR_OK;
 }
 
 int nanocbor_put_bstr(nanocbor_encoder_t *enc, const uint8_t *str, size_t len)
 {
-    nanocbor_fmt_bstr(enc, len);
-    return _put_bytes(enc, str, len);
+    int res = _put_str(enc, NANOCBOR_MASK_BSTR, str, len);
+
+    return res < 0 ? res : NANOCBOR_OK;
+}
+
+int nanocbor_put_raw(nanocbor_encoder_t *enc, const uint8_t *data, size_t len)
+{
+    return _put_bytes(enc, data, len);
 }
 
 int nanocbor_fmt_array(nanocbor_encoder_t *enc, size_t len)
@@ -219,6 +338,29 @@ int nanocbor_fmt_map_indefinite(nanocbor_encoder_t *enc)
     return _fmt_single(enc, NANOCBOR_MASK_MAP | NANOCBOR_SIZE_INDEFINITE);
 }
 
+int nanocbor_fmt_bstr_indefinite(nanocbor_encoder_t *enc)
+{
+    return _fmt_single(enc, NANOCBOR_MASK_BSTR | NANOCBOR_SIZE_INDEFINITE);
+}
+
+int nanocbor_fmt_tstr_indefinite(nanocbor_encoder_t *enc)
+{
+    return _fmt_single(enc, NANOCBOR_MASK_TSTR | NANOCBOR_SIZE_INDEFINITE);
+}
+
+int nanocbor_put_bstr_chunk(nanocbor_encoder_t *enc, const uint8_t *str,
+                            size_t len)
+{
+    /* Chunks of an indefinite-length string are definite-length strings */
+    return nanocbor_put_bstr(enc, str, len);
+}
+
+int nanocbor_put_tstr_chunk(nanocbor_encoder_t *enc, const char *str,
+                            size_t len)
+{
+    return nanocbor_put_tstrn(enc, str, len);
+}
+
 int nanocbor_fmt_end_indefinite(nanocbor_encoder_t *enc)
 {
     /* End is marked with float major and indefinite minor number */
@@ -240,6 +382,7 @@ int nanocbor_fmt_null(nanocbor_encoder_t *enc)
 #define DOUBLE_EXP_IS_NAN (0x7FFU)
 #define DOUBLE_IS_ZERO (~(DOUBLE_SIGN_MASK))
 #define DOUBLE_FLOAT_LOSS (0x1FFFFFFFU)
+#define DOUBLE_FRAC_MASK ((uint64_t)0xFFFFFFFFFFFFFU)
 
 /* float bit mask related defines */
 #define FLOAT_EXP_OFFSET (127U)
@@ -351,11 +494,12 @@ int nanocbor_fmt_float(nanocbor_encoder_t *enc, float num)
     _incr_len(enc, sizeof(float) + 1);
     int res = _fits(enc, 1 + sizeof(float));
     if (res > 0) {
-        const uint8_t tmp = NANOCBOR_MASK_FLOAT | NANOCBOR_SIZE_WORD;
-        _append(enc, &tmp, sizeof(tmp));
+        uint8_t tmp[1 + sizeof(float)] = {
+            NANOCBOR_MASK_FLOAT | NANOCBOR_SIZE_WORD };
         /* NOLINTNEXTLINE: user supplied function */
         uint32_t bnum = NANOCBOR_HTOBE32_FUNC(*unum);
-        _append(enc, (uint8_t*)&bnum, sizeof(bnum));
+        memcpy(tmp + 1, &bnum, sizeof(bnum));
+        _append(enc, tmp, sizeof(tmp));
     }
     return res;
 }
@@ -384,16 +528,131 @@ int nanocbor_fmt_double(nanocbor_encoder_t *enc, double num)
     _incr_len(enc, sizeof(double) + 1);
     int res = _fits(enc, 1 + sizeof(double));
     if (res > 0) {
-        const uint8_t tmp = NANOCBOR_MASK_FLOAT | NANOCBOR_SIZE_LONG;
-        _append(enc, &tmp, 1);
+        uint8_t tmp[1 + sizeof(double)] = {
+            NANOCBOR_MASK_FLOAT | NANOCBOR_SIZE_LONG };
         /* NOLINTNEXTLINE: user supplied function */
         uint64_t bnum = NANOCBOR_HTOBE64_FUNC(*unum);
-        _append(enc, (uint8_t*)&bnum, sizeof(bnum));
+        memcpy(tmp + 1, &bnum, sizeof(bnum));
+        _append(enc, tmp, sizeof(tmp));
+    }
+    return res;
+#endif
+}
+
+#if __SIZEOF_DOUBLE__ != __SIZEOF_FLOAT__
+/* Round a finite double to the nearest half float, ties to even. Out of range
+ * values are rounded to infinity */
+static uint16_t _double_to_half(uint64_t unum)
+{
+    uint16_t sign = (unum >> (DOUBLE_SIZE - HALF_SIZE)) & HALF_SIGN_MASK;
+    int32_t exp = (int32_t)((unum >> DOUBLE_EXP_POS) & DOUBLE_EXP_MASK)
+        - (int32_t)DOUBLE_EXP_OFFSET + (int32_t)HALF_EXP_OFFSET;
+    uint64_t frac = unum & DOUBLE_FRAC_MASK;
+    unsigned shift = DOUBLE_EXP_POS - HALF_EXP_POS;
+
+    if (exp >= (int32_t)HALF_EXP_MASK) {
+        return sign | (HALF_EXP_MASK << HALF_EXP_POS);
+    }
+    if (exp <= 0) {
+        /* Below 2^-26 everything rounds to zero */
+        if (exp < -(int32_t)(HALF_EXP_POS + 1)) {
+            return sign;
+        }
+        /* Subnormal half float, make the implicit leading bit explicit */
+        frac |= (uint64_t)1 << DOUBLE_EXP_POS;
+        shift += (unsigned)(1 - exp);
+        exp = 0;
+    }
+    uint64_t rem = frac & (((uint64_t)1 << shift) - 1);
+    uint64_t halfway = (uint64_t)1 << (shift - 1);
+    uint32_t half = ((uint32_t)exp << HALF_EXP_POS) + (uint32_t)(frac >> shift);
+    /* A carry out of the fraction correctly increments the exponent */
+    if (rem > halfway || (rem == halfway && (half & 1U))) {
+        half++;
+    }
+    return sign | (uint16_t)half;
+}
+
+static double _half_to_double(uint16_t half)
+{
+    uint64_t exp = (half >> HALF_EXP_POS) & HALF_EXP_MASK;
+    uint64_t frac = half & HALF_FRAC_MASK;
+    double res = 0;
+
+    if (exp == 0) {
+        /* Subnormal, fraction times 2^-24 */
+        res = (double)frac
+            / (double)(1UL << (HALF_EXP_OFFSET + HALF_EXP_POS - 1));
+        return (half & HALF_SIGN_MASK) ? -res : res;
     }
+    if (exp == HALF_EXP_MASK) {
+        exp = DOUBLE_EXP_MASK;
+    }
+    else {
+        exp = exp + DOUBLE_EXP_OFFSET - HALF_EXP_OFFSET;
+    }
+    uint64_t unum
+        = ((uint64_t)(half & HALF_SIGN_MASK) << (DOUBLE_SIZE - HALF_SIZE))
+        | (exp << DOUBLE_EXP_POS) | (frac << (DOUBLE_EXP_POS - HALF_EXP_POS));
+    memcpy(&res, &unum, sizeof(res));
     return res;
+}
+
+static double _abs_double(double num)
+{
+    return num < 0 ? -num : num;
+}
+
+static bool _within_tolerance(double num, double approx, double abs_tol,
+                              double rel_tol)
+{
+    double allowed = rel_tol * _abs_double(num);
+    if (abs_tol > allowed) {
+        allowed = abs_tol;
+    }
+    return _abs_double(num - approx) <= allowed;
+}
+#endif
+
+int nanocbor_fmt_double_lossy(nanocbor_encoder_t *enc, double num,
+                              double abs_tol, double rel_tol)
+{
+#if __SIZEOF_DOUBLE__ == __SIZEOF_FLOAT__
+    (void)abs_tol;
+    (void)rel_tol;
+    return nanocbor_fmt_float(enc, num);
+#else
+    uint64_t unum = 0;
+    memcpy(&unum, &num, sizeof(unum));
+    uint16_t exp = (unum >> DOUBLE_EXP_POS) & DOUBLE_EXP_MASK;
+
+    if (_double_is_inf_nan(exp) || _double_is_zero(unum)) {
+        return nanocbor_fmt_double(enc, num);
+    }
+    uint16_t half = _double_to_half(unum);
+    if (_within_tolerance(num, _half_to_double(half), abs_tol, rel_tol)) {
+        return _fmt_halffloat(enc, half);
+    }
+    float single = (float)num;
+    if (_within_tolerance(num, single, abs_tol, rel_tol)) {
+        return nanocbor_fmt_float(enc, single);
+    }
+    return nanocbor_fmt_double(enc, num);
 #endif
 }
 
+int nanocbor_fmt_double_array_lossy(nanocbor_encoder_t *enc,
+                                    const double *nums, size_t len,
+                                    double abs_tol, double rel_tol)
+{
+    int res = nanocbor_fmt_array(enc, len);
+    for (size_t i = 0; i < len; i++) {
+        int item = nanocbor_fmt_double_lossy(enc, nums[i], abs_tol, rel_tol);
+        res = _add_res(res, item);
+    }
+    return res;
+}
+
 int nanocbor_fmt_decimal_frac(nanocbor_encoder_t *enc, int32_t e, int32_t m)
 {
     int res = nanocbor_fmt_tag(enc, NANOCBOR_TAG_DEC_FRAC);
@@ -402,3 +661,113 @@ int nanocbor_fmt_decimal_frac(nanocbor_encoder_t *enc, int32_t e, int32_t m)
     res += nanocbor_fmt_int(enc, m);
     return res;
 }
+
+static bool _field_is_default(const nanocbor_field_t *field, const void *member)
+{
+    switch (field->type) {
+    case NANOCBOR_FIELD_BOOL:
+        return !*(const bool *)member;
+    case NANOCBOR_FIELD_UINT8:
+    case NANOCBOR_FIELD_INT8:
+        return *(const uint8_t *)member == 0;
+    case NANOCBOR_FIELD_UINT16:
+    case NANOCBOR_FIELD_INT16:
+        return *(const uint16_t *)member == 0;
+    case NANOCBOR_FIELD_UINT32:
+    case NANOCBOR_FIELD_INT32:
+        return *(const uint32_t *)member == 0;
+    case NANOCBOR_FIELD_UINT64:
+    case NANOCBOR_FIELD_INT64:
+        return *(const uint64_t *)member == 0;
+    case NANOCBOR_FIELD_FLOAT:
+        return *(const float *)member == 0;
+    case NANOCBOR_FIELD_DOUBLE:
+        return *(const double *)member == 0;
+    case NANOCBOR_FIELD_TSTR:
+        return *(const char *const *)member == NULL;
+    default:
+        return false;
+    }
+}
+
+static int _fmt_field(nanocbor_encoder_t *enc, const nanocbor_field_t *field,
+                      const void *member)
+{
+    switch (field->type) {
+    case NANOCBOR_FIELD_BOOL:
+        return nanocbor_fmt_bool(enc, *(const bool *)member);
+    case NANOCBOR_FIELD_UINT8:
+        return nanocbor_fmt_uint(enc, *(const uint8_t *)member);
+    case NANOCBOR_FIELD_UINT16:
+        return nanocbor_fmt_uint(enc, *(const uint16_t *)member);
+    case NANOCBOR_FIELD_UINT32:
+        return nanocbor_fmt_uint(enc, *(const uint32_t *)member);
+    case NANOCBOR_FIELD_UINT64:
+        return nanocbor_fmt_uint(enc, *(const uint64_t *)member);
+    case NANOCBOR_FIELD_INT8:
+        return nanocbor_fmt_int(enc, *(const int8_t *)member);
+    case NANOCBOR_FIELD_INT16:
+        return nanocbor_fmt_int(enc, *(const int16_t *)member);
+    case NANOCBOR_FIELD_INT32:
+        return nanocbor_fmt_int(enc, *(const int32_t *)member);
+    case NANOCBOR_FIELD_INT64:
+        return nanocbor_fmt_int(enc, *(const int64_t *)member);
+    case NANOCBOR_FIELD_FLOAT:
+        return nanocbor_fmt_float(enc, *(const float *)member);
+    case NANOCBOR_FIELD_DOUBLE:
+        return nanocbor_fmt_double(enc, *(const double *)member);
+    case NANOCBOR_FIELD_TSTR: {
+        const char *str = *(const char *const *)member;
+        if (!str) {
+            return nanocbor_fmt_null(enc);
+        }
+        return _put_str(enc, NANOCBOR_MASK_TSTR, (const uint8_t *)str,
+                        strlen(str));
+    }
+    default:
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+}
+
+int nanocbor_fmt_struct_map(nanocbor_encoder_t *enc,
+                            const nanocbor_field_t *fields, size_t num_fields,
+                            const void *data)
+{
+    const uint8_t *base = data;
+    size_t count = 0;
+
+    for (size_t i = 0; i < num_fields; i++) {
+        if (!(fields[i].flags & NANOCBOR_FIELD_FLAG_OMIT_DEFAULT)
+            || !_field_is_default(&fields[i], base + fields[i].offset)) {
+            count++;
+        }
+    }
+
+    int res = nanocbor_fmt_map(enc, count);
+    for (size_t i = 0; i < num_fields; i++) {
+        const uint8_t *member = base + fields[i].offset;
+        if ((fields[i].flags & NANOCBOR_FIELD_FLAG_OMIT_DEFAULT)
+            && _field_is_default(&fields[i], member)) {
+            continue;
+        }
+        /* Keys are pre-encoded and copied as is */
+        int key = _put_bytes(enc, fields[i].key, fields[i].key_len);
+        res = _add_res(res, key < 0 ? key : (int)fields[i].key_len);
+        res = _add_res(res, _fmt_field(enc, &fields[i], member));
+    }
+    return res;
+}
+
+int nanocbor_fmt_struct_array(nanocbor_encoder_t *enc,
+                              const nanocbor_field_t *fields,
+                              size_t num_fields, const void *data)
+{
+    const uint8_t *base = data;
+
+    int res = nanocbor_fmt_array(enc, num_fields);
+    for (size_t i = 0; i < num_fields; i++) {
+        const uint8_t *member = base + fields[i].offset;
+        res = _add_res(res, _fmt_field(enc, &fields[i], member));
+    }
+    return res;
+}
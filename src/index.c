@@ -0,0 +1,878 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @ingroup nanocbor_index
+ * @{
+ * @file
+ * @brief   Structural index implementation
+ * @}
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "nanocbor/config.h"
+#include "nanocbor/index.h"
+#include "nanocbor/nanocbor.h"
+
+#if NANOCBOR_WALK_PARALLEL
+#include <pthread.h>
+#include <stdlib.h>
+#endif
+
+typedef struct {
+    nanocbor_value_t it;
+    uint32_t node;
+} _level_t;
+
+static int _enter(nanocbor_value_t *it, nanocbor_value_t *container)
+{
+    if (nanocbor_get_type(it) == NANOCBOR_TYPE_ARR) {
+        return nanocbor_enter_array(it, container);
+    }
+    return nanocbor_enter_map(it, container);
+}
+
+int nanocbor_index_build(const uint8_t *buf, size_t len,
+                         nanocbor_index_node_t *nodes, size_t *num_nodes)
+{
+    /* Level 0 is the buffer itself, the others are the open containers */
+    _level_t stack[NANOCBOR_RECURSION_MAX + 1];
+    size_t depth = 0;
+    size_t capacity = nodes ? *num_nodes : 0;
+    uint32_t count = 0;
+
+    if (len > UINT32_MAX) {
+        return NANOCBOR_ERR_OVERFLOW;
+    }
+    nanocbor_decoder_init(&stack[0].it, buf, len);
+    stack[0].node = NANOCBOR_INDEX_NONE;
+
+    for (;;) {
+        _level_t *level = &stack[depth];
+
+        if (nanocbor_at_end(&level->it)) {
+            if (depth == 0) {
+                break;
+            }
+            _level_t *parent = &stack[depth - 1];
+            const uint8_t *start = parent->it.cur;
+            int res = nanocbor_leave_container_early(&parent->it, &level->it);
+            if (res < 0) {
+                return res;
+            }
+            if (level->node < capacity) {
+                nodes[level->node].len = (uint32_t)(parent->it.cur - start);
+                nodes[level->node].next = count;
+            }
+            depth--;
+            continue;
+        }
+
+        if (level->node < capacity) {
+            nodes[level->node].items++;
+        }
+        int type = nanocbor_get_type(&level->it);
+        if (type == NANOCBOR_TYPE_TAG) {
+            uint64_t tag = 0;
+            int res = nanocbor_get_tag64(&level->it, &tag);
+            if (res < 0) {
+                return res;
+            }
+            /* The tagged item is not a separate item of the container */
+            if (level->node < capacity) {
+                nodes[level->node].items--;
+            }
+        }
+        else if (type == NANOCBOR_TYPE_ARR || type == NANOCBOR_TYPE_MAP) {
+            if (depth == NANOCBOR_RECURSION_MAX) {
+                return NANOCBOR_ERR_RECURSION;
+            }
+            _level_t *child = &stack[depth + 1];
+            int res = _enter(&level->it, &child->it);
+            if (res < 0) {
+                return res;
+            }
+            child->node = count;
+            if (count < capacity) {
+                nodes[count].offset = (uint32_t)(level->it.cur - buf);
+                nodes[count].parent = level->node;
+                nodes[count].items = 0;
+            }
+            count++;
+            depth++;
+        }
+        else {
+            int res = nanocbor_skip(&level->it);
+            if (res < 0) {
+                return res;
+            }
+        }
+    }
+    *num_nodes = count;
+    return count > capacity ? NANOCBOR_ERR_OVERFLOW : NANOCBOR_OK;
+}
+
+uint32_t nanocbor_index_find(const nanocbor_index_node_t *nodes,
+                             size_t num_nodes, size_t offset)
+{
+    uint32_t found = NANOCBOR_INDEX_NONE;
+    size_t end = num_nodes;
+    size_t i = 0;
+
+    while (i < end) {
+        const nanocbor_index_node_t *node = &nodes[i];
+        if (offset >= node->offset && offset - node->offset < node->len) {
+            /* Continue with the children of the node */
+            found = (uint32_t)i;
+            end = node->next;
+            i++;
+        }
+        else {
+            i = node->next;
+        }
+    }
+    return found;
+}
+
+/* Number of nodes starting before a position */
+static size_t _nodes_before(const nanocbor_index_node_t *nodes,
+                            size_t num_nodes, size_t offset)
+{
+    size_t low = 0;
+    size_t high = num_nodes;
+
+    /* Nodes are in document order, sorted by offset */
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (nodes[mid].offset < offset) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+uint32_t nanocbor_index_lookup(const nanocbor_index_node_t *nodes,
+                               size_t num_nodes, size_t offset)
+{
+    size_t low = _nodes_before(nodes, num_nodes, offset);
+
+    if (low < num_nodes && nodes[low].offset == offset) {
+        return (uint32_t)low;
+    }
+    return NANOCBOR_INDEX_NONE;
+}
+
+/* Size of an encoded header: initial byte and a 64 bit argument */
+#define KEY_HEADER_MAX (1 + sizeof(uint64_t))
+
+#define MAJOR_OFFSET 5U
+#define MINOR_MASK 0x1FU
+
+/* Whether an integer or string key uses the shortest argument encoding */
+static bool _key_preferred(const uint8_t *key, size_t len)
+{
+    unsigned major = key[0] >> MAJOR_OFFSET;
+    unsigned minor = key[0] & MINOR_MASK;
+    uint64_t arg = 0;
+    size_t size = 0;
+
+    if (major > NANOCBOR_TYPE_TSTR || minor < NANOCBOR_SIZE_BYTE) {
+        return true;
+    }
+    if (minor > NANOCBOR_SIZE_LONG) {
+        return false;
+    }
+    size = (size_t)1 << (minor - NANOCBOR_SIZE_BYTE);
+    if (len < 1 + size) {
+        return false;
+    }
+    for (size_t i = 0; i < size; i++) {
+        arg = (arg << 8) | key[1 + i];
+    }
+    /* The argument must not fit in the next smaller size */
+    if (size == 1) {
+        return arg >= NANOCBOR_SIZE_BYTE;
+    }
+    return arg >> (4 * size) != 0;
+}
+
+/* Bytewise lexicographic comparison of two encoded keys */
+static int _key_cmp(const uint8_t *a, size_t a_len, const uint8_t *b,
+                    size_t b_len)
+{
+    int res = memcmp(a, b, a_len < b_len ? a_len : b_len);
+
+    if (res != 0 || a_len == b_len) {
+        return res;
+    }
+    return a_len < b_len ? -1 : 1;
+}
+
+int nanocbor_index_map_init(nanocbor_index_map_t *map, const uint8_t *buf,
+                            const nanocbor_index_node_t *nodes,
+                            size_t num_nodes, uint32_t node, uint32_t *keys,
+                            size_t max_keys)
+{
+    nanocbor_value_t it;
+    nanocbor_value_t container;
+
+    if (node >= num_nodes) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    const nanocbor_index_node_t *cur = &nodes[node];
+    size_t num_keys = cur->items / 2;
+    nanocbor_decoder_init(&it, buf + cur->offset, cur->len);
+    if (nanocbor_get_type(&it) != NANOCBOR_TYPE_MAP) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    int res = nanocbor_enter_map(&it, &container);
+    if (res < 0) {
+        return res;
+    }
+    if (num_keys > max_keys) {
+        return NANOCBOR_ERR_OVERFLOW;
+    }
+    map->buf = buf;
+    map->keys = keys;
+    map->num_keys = num_keys;
+    map->end = cur->offset + cur->len;
+    map->sorted = true;
+
+    /* The children of the map follow its node in document order */
+    uint32_t child = node + 1;
+    const uint8_t *prev = NULL;
+    size_t prev_len = 0;
+    nanocbor_decoder_init(&it, container.cur, buf + map->end - container.cur);
+    for (size_t i = 0; i < num_keys; i++) {
+        const uint8_t *key = it.cur;
+        res = nanocbor_skip(&it);
+        if (res < 0) {
+            return res;
+        }
+        size_t key_len = (size_t)(it.cur - key);
+        keys[i] = (uint32_t)(key - buf);
+        if (map->sorted
+            && (!_key_preferred(key, key_len)
+                || (prev && _key_cmp(prev, prev_len, key, key_len) >= 0))) {
+            map->sorted = false;
+        }
+        prev = key;
+        prev_len = key_len;
+
+        /* Skip containers within the key */
+        while (child < num_nodes && child < cur->next
+               && nodes[child].offset < (size_t)(it.cur - buf)) {
+            child = nodes[child].next;
+        }
+        while (nanocbor_get_type(&it) == NANOCBOR_TYPE_TAG) {
+            uint64_t tag = 0;
+            res = nanocbor_get_tag64(&it, &tag);
+            if (res < 0) {
+                return res;
+            }
+        }
+        if (child < num_nodes && child < cur->next
+            && nodes[child].offset == (size_t)(it.cur - buf)) {
+            uint32_t next = nodes[child].offset + nodes[child].len;
+            nanocbor_decoder_init(&it, buf + next, map->end - next);
+            child = nodes[child].next;
+        }
+        else {
+            res = nanocbor_skip(&it);
+            if (res < 0) {
+                return res;
+            }
+        }
+    }
+    return NANOCBOR_OK;
+}
+
+/* Compares the encoded key @p head followed by @p payload with the key at
+ * position @p index of the map */
+static int _lookup_cmp(const nanocbor_index_map_t *map, size_t index,
+                       const uint8_t *head, size_t head_len,
+                       const uint8_t *payload, size_t payload_len)
+{
+    const uint8_t *key = map->buf + map->keys[index];
+    size_t avail = (size_t)(map->buf + map->end - key);
+
+    /* Equal headers imply equal lengths of the keys */
+    int res = _key_cmp(head, head_len, key,
+                       avail < head_len ? avail : head_len);
+    if (res != 0 || payload_len == 0) {
+        return res;
+    }
+    if (avail - head_len < payload_len) {
+        return 1;
+    }
+    return memcmp(payload, key + head_len, payload_len);
+}
+
+static int _lookup(const nanocbor_index_map_t *map, const uint8_t *head,
+                   size_t head_len, const uint8_t *payload,
+                   size_t payload_len, nanocbor_value_t *value)
+{
+    size_t found = map->num_keys;
+
+    if (map->sorted) {
+        size_t low = 0;
+        size_t high = map->num_keys;
+        while (low < high) {
+            size_t mid = low + (high - low) / 2;
+            int cmp
+                = _lookup_cmp(map, mid, head, head_len, payload, payload_len);
+            if (cmp == 0) {
+                found = mid;
+                break;
+            }
+            if (cmp < 0) {
+                high = mid;
+            }
+            else {
+                low = mid + 1;
+            }
+        }
+    }
+    else {
+        for (size_t i = 0; i < map->num_keys; i++) {
+            if (_lookup_cmp(map, i, head, head_len, payload, payload_len)
+                == 0) {
+                found = i;
+                break;
+            }
+        }
+    }
+    if (found == map->num_keys) {
+        return NANOCBOR_NOT_FOUND;
+    }
+    uint32_t offset = map->keys[found];
+    nanocbor_decoder_init(value, map->buf + offset, map->end - offset);
+    return nanocbor_skip(value);
+}
+
+int nanocbor_index_map_get_tstr(const nanocbor_index_map_t *map,
+                                const char *key, nanocbor_value_t *value)
+{
+    uint8_t head[KEY_HEADER_MAX];
+    nanocbor_encoder_t enc;
+    size_t len = strlen(key);
+
+    nanocbor_encoder_init(&enc, head, sizeof(head));
+    nanocbor_fmt_tstr(&enc, len);
+    return _lookup(map, head, nanocbor_encoded_len(&enc),
+                   (const uint8_t *)key, len, value);
+}
+
+int nanocbor_index_map_get_int(const nanocbor_index_map_t *map, int64_t key,
+                               nanocbor_value_t *value)
+{
+    uint8_t head[KEY_HEADER_MAX];
+    nanocbor_encoder_t enc;
+
+    nanocbor_encoder_init(&enc, head, sizeof(head));
+    nanocbor_fmt_int(&enc, key);
+    return _lookup(map, head, nanocbor_encoded_len(&enc), NULL, 0, value);
+}
+
+#if NANOCBOR_WALK_PARALLEL
+
+#define BREAK_BYTE                                                            \
+    ((NANOCBOR_TYPE_FLOAT << NANOCBOR_TYPE_OFFSET) | NANOCBOR_VALUE_MASK)
+#define SYNC_ITEMS 16 /**< Items parsed to find a boundary in a chunk */
+#define NODE_OPEN NANOCBOR_INDEX_NONE /**< next of an unfinished node */
+#define PARENT_FLOOR (NANOCBOR_INDEX_NONE - 1) /**< Parent outside a chunk */
+
+/*
+ * The buffer is cut into one chunk per thread. Each chunk is parsed from a
+ * guessed item boundary, indexing the containers it opens. Items at the
+ * floor of a chunk, outside the containers opened in it, belong to
+ * containers opened in an earlier chunk. Their number is recorded, together
+ * with the positions of the containers and break markers at the floor.
+ *
+ * The stitch pass then runs over the chunks in order, resolving the floor
+ * items against the containers still open from the earlier chunks. A chunk
+ * is parsed again when its guessed boundary is not where the previous chunk
+ * ended.
+ */
+
+typedef struct {
+    uint32_t node; /**< Local node at the floor, or NONE for a break */
+    uint32_t ordinal; /**< Number of floor items before the event */
+    uint32_t offset; /**< Position of the event */
+    uint32_t height; /**< Nesting depth of the subtree of the node */
+} _event_t;
+
+typedef struct {
+    uint64_t remaining;
+    uint32_t node;
+    bool indefinite;
+} _open_t;
+
+typedef struct {
+    const uint8_t *buf;
+    size_t len;
+    uint32_t start; /**< Guessed boundary to start parsing at */
+    uint32_t target; /**< Position to stop parsing at */
+    uint32_t exit; /**< Boundary at which parsing stopped */
+    int res;
+    bool started; /**< Parsed on a separate thread */
+    nanocbor_index_node_t *nodes; /**< Nodes with chunk local numbers */
+    size_t num_nodes;
+    size_t cap_nodes;
+    _event_t *events;
+    size_t num_events;
+    size_t cap_events;
+    uint32_t floor_items;
+    uint32_t height;
+    _open_t open[NANOCBOR_RECURSION_MAX];
+    size_t depth;
+} _chunk_t;
+
+typedef struct {
+    uint32_t offset;
+    uint32_t ordinal;
+} _cursor_t;
+
+typedef struct {
+    nanocbor_index_node_t *nodes;
+    size_t capacity;
+    size_t count;
+    _open_t open[NANOCBOR_RECURSION_MAX];
+    size_t depth;
+} _stitch_t;
+
+static void _reinit(nanocbor_value_t *it, const uint8_t *cur)
+{
+    nanocbor_decoder_init(it, cur, (size_t)(it->end - cur));
+}
+
+static bool _grow(void **array, size_t *capacity, size_t num, size_t size)
+{
+    if (num < *capacity) {
+        return true;
+    }
+    size_t grown = *capacity ? *capacity * 2 : 64;
+    void *tmp = realloc(*array, grown * size);
+    if (!tmp) {
+        return false;
+    }
+    *array = tmp;
+    *capacity = grown;
+    return true;
+}
+
+static uint32_t _sync_point(const uint8_t *buf, size_t len, size_t offset)
+{
+    nanocbor_value_t it;
+
+    nanocbor_decoder_init(&it, buf + offset, len - offset);
+    for (unsigned i = 0; i < SYNC_ITEMS && !nanocbor_at_end(&it); i++) {
+        nanocbor_value_t container;
+        uint64_t tag = 0;
+        int res = NANOCBOR_OK;
+        int type = nanocbor_get_type(&it);
+
+        if (*it.cur == BREAK_BYTE) {
+            _reinit(&it, it.cur + 1);
+        }
+        else if (type == NANOCBOR_TYPE_ARR || type == NANOCBOR_TYPE_MAP) {
+            res = _enter(&it, &container);
+            if (res == NANOCBOR_OK) {
+                _reinit(&it, container.cur);
+            }
+        }
+        else if (type == NANOCBOR_TYPE_TAG) {
+            res = nanocbor_get_tag64(&it, &tag);
+        }
+        else {
+            res = nanocbor_skip(&it);
+        }
+        if (res < 0) {
+            return (uint32_t)offset;
+        }
+    }
+    return (uint32_t)(it.cur - buf);
+}
+
+static int _chunk_event(_chunk_t *chunk, uint32_t node, uint32_t ordinal,
+                        uint32_t offset)
+{
+    if (!_grow((void **)&chunk->events, &chunk->cap_events,
+               chunk->num_events, sizeof(_event_t))) {
+        return NANOCBOR_ERR_OVERFLOW;
+    }
+    _event_t *event = &chunk->events[chunk->num_events++];
+    event->node = node;
+    event->ordinal = ordinal;
+    event->offset = offset;
+    event->height = 1;
+    return NANOCBOR_OK;
+}
+
+/* Closes the innermost open container, and its parents when complete */
+static void _chunk_close(_chunk_t *chunk, uint32_t end, bool top)
+{
+    while (top
+           || (chunk->depth > 0 && !chunk->open[chunk->depth - 1].indefinite
+               && chunk->open[chunk->depth - 1].remaining == 0)) {
+        nanocbor_index_node_t *node
+            = &chunk->nodes[chunk->open[--chunk->depth].node];
+        node->len = end - node->offset;
+        node->next = (uint32_t)chunk->num_nodes;
+        if (chunk->depth == 0) {
+            chunk->events[chunk->num_events - 1].height = chunk->height;
+        }
+        top = false;
+    }
+}
+
+static int _chunk_open(_chunk_t *chunk, nanocbor_value_t *it)
+{
+    nanocbor_value_t container;
+    uint32_t offset = (uint32_t)(it->cur - chunk->buf);
+    _open_t *parent = chunk->depth ? &chunk->open[chunk->depth - 1] : NULL;
+
+    if (chunk->depth == NANOCBOR_RECURSION_MAX) {
+        return NANOCBOR_ERR_RECURSION;
+    }
+    int res = _enter(it, &container);
+    if (res < 0) {
+        return res;
+    }
+    if (!_grow((void **)&chunk->nodes, &chunk->cap_nodes, chunk->num_nodes,
+               sizeof(nanocbor_index_node_t))) {
+        return NANOCBOR_ERR_OVERFLOW;
+    }
+    if (!parent) {
+        /* The floor item is already counted */
+        res = _chunk_event(chunk, (uint32_t)chunk->num_nodes,
+                           chunk->floor_items - 1, offset);
+        if (res < 0) {
+            return res;
+        }
+        chunk->height = 0;
+    }
+    nanocbor_index_node_t *node = &chunk->nodes[chunk->num_nodes];
+    node->offset = offset;
+    node->len = 0;
+    node->parent = parent ? parent->node : PARENT_FLOOR;
+    node->next = NODE_OPEN;
+    node->items = 0;
+
+    _open_t *open = &chunk->open[chunk->depth++];
+    open->remaining = container.remaining;
+    open->node = (uint32_t)chunk->num_nodes++;
+    open->indefinite = nanocbor_container_indefinite(&container);
+    if (chunk->depth > chunk->height) {
+        chunk->height = (uint32_t)chunk->depth;
+    }
+    _reinit(it, container.cur);
+    _chunk_close(chunk, (uint32_t)(container.cur - chunk->buf), false);
+    return NANOCBOR_OK;
+}
+
+static int _chunk_item(_chunk_t *chunk, nanocbor_value_t *it)
+{
+    uint32_t offset = (uint32_t)(it->cur - chunk->buf);
+    _open_t *top = chunk->depth ? &chunk->open[chunk->depth - 1] : NULL;
+
+    if (*it->cur == BREAK_BYTE) {
+        _reinit(it, it->cur + 1);
+        if (!top) {
+            return _chunk_event(chunk, NANOCBOR_INDEX_NONE,
+                                chunk->floor_items, offset);
+        }
+        if (!top->indefinite) {
+            return NANOCBOR_ERR_INVALID_TYPE;
+        }
+        _chunk_close(chunk, offset + 1, true);
+        return NANOCBOR_OK;
+    }
+
+    int type = nanocbor_get_type(it);
+    if (type == NANOCBOR_TYPE_TAG) {
+        uint64_t tag = 0;
+        int res = nanocbor_get_tag64(it, &tag);
+        return res < 0 ? res : NANOCBOR_OK;
+    }
+    if (!top) {
+        chunk->floor_items++;
+    }
+    else {
+        chunk->nodes[top->node].items++;
+        if (!top->indefinite) {
+            top->remaining--;
+        }
+    }
+    if (type == NANOCBOR_TYPE_ARR || type == NANOCBOR_TYPE_MAP) {
+        return _chunk_open(chunk, it);
+    }
+    int res = nanocbor_skip(it);
+    if (res < 0) {
+        return res;
+    }
+    _chunk_close(chunk, (uint32_t)(it->cur - chunk->buf), false);
+    return NANOCBOR_OK;
+}
+
+static void *_chunk_parse(void *arg)
+{
+    _chunk_t *chunk = arg;
+    nanocbor_value_t it;
+
+    chunk->num_nodes = 0;
+    chunk->num_events = 0;
+    chunk->floor_items = 0;
+    chunk->depth = 0;
+    chunk->res = NANOCBOR_OK;
+    nanocbor_decoder_init(&it, chunk->buf + chunk->start,
+                          chunk->len - chunk->start);
+    while (!nanocbor_at_end(&it)
+           && (size_t)(it.cur - chunk->buf) < chunk->target) {
+        chunk->res = _chunk_item(chunk, &it);
+        if (chunk->res < 0) {
+            break;
+        }
+    }
+    if (chunk->depth > 0) {
+        chunk->events[chunk->num_events - 1].height = chunk->height;
+    }
+    chunk->exit = (uint32_t)(it.cur - chunk->buf);
+    return NULL;
+}
+
+/* Advances the cursor past a number of floor items of a chunk */
+static int _floor_end(const _chunk_t *chunk, _cursor_t *cursor,
+                      uint32_t ordinal)
+{
+    while (cursor->ordinal < ordinal) {
+        nanocbor_value_t it;
+        if (cursor->offset >= chunk->len) {
+            return NANOCBOR_ERR_END;
+        }
+        nanocbor_decoder_init(&it, chunk->buf + cursor->offset,
+                              chunk->len - cursor->offset);
+        if (*it.cur == BREAK_BYTE) {
+            cursor->offset++;
+            continue;
+        }
+        int res = nanocbor_skip_tags(&it);
+        if (res < 0) {
+            return res;
+        }
+        int type = nanocbor_get_type(&it);
+        if (type == NANOCBOR_TYPE_ARR || type == NANOCBOR_TYPE_MAP) {
+            uint32_t node = nanocbor_index_lookup(
+                chunk->nodes, chunk->num_nodes,
+                (size_t)(it.cur - chunk->buf));
+            if (node == NANOCBOR_INDEX_NONE) {
+                return NANOCBOR_ERR_INVALID_TYPE;
+            }
+            if (chunk->nodes[node].next == NODE_OPEN) {
+                /* The item is completed in a later chunk */
+                return NANOCBOR_NOT_FOUND;
+            }
+            cursor->offset = chunk->nodes[node].offset + chunk->nodes[node].len;
+        }
+        else {
+            res = nanocbor_skip(&it);
+            if (res < 0) {
+                return res;
+            }
+            cursor->offset = (uint32_t)(it.cur - chunk->buf);
+        }
+        cursor->ordinal++;
+    }
+    return NANOCBOR_OK;
+}
+
+static void _stitch_close(_stitch_t *stitch, const _chunk_t *chunk,
+                          size_t base, uint32_t end)
+{
+    uint32_t node = stitch->open[--stitch->depth].node;
+
+    if (node < stitch->capacity) {
+        stitch->nodes[node].len = end - stitch->nodes[node].offset;
+        stitch->nodes[node].next = (uint32_t)(
+            base + _nodes_before(chunk->nodes, chunk->num_nodes, end));
+    }
+}
+
+static int _stitch_floor(_stitch_t *stitch, const _chunk_t *chunk,
+                         size_t base)
+{
+    _cursor_t cursor = { chunk->start, 0 };
+    uint32_t ordinal = 0;
+    size_t event = 0;
+    size_t brk = 0; /* Next break event */
+
+    for (;;) {
+        _open_t *top = stitch->depth ? &stitch->open[stitch->depth - 1] : NULL;
+
+        while (brk < chunk->num_events
+               && (brk < event
+                   || chunk->events[brk].node != NANOCBOR_INDEX_NONE)) {
+            brk++;
+        }
+        if (top && !top->indefinite && top->remaining == 0) {
+            int res = _floor_end(chunk, &cursor, ordinal);
+            if (res == NANOCBOR_NOT_FOUND) {
+                /* Closed after the open item at the end of the chunk */
+                return NANOCBOR_OK;
+            }
+            if (res < 0) {
+                return res;
+            }
+            _stitch_close(stitch, chunk, base, cursor.offset);
+            continue;
+        }
+        if (brk < chunk->num_events && event == brk
+            && chunk->events[brk].ordinal == ordinal) {
+            const _event_t *cur = &chunk->events[event++];
+            if (!top || !top->indefinite) {
+                return NANOCBOR_ERR_INVALID_TYPE;
+            }
+            _stitch_close(stitch, chunk, base, cur->offset + 1);
+            cursor.offset = cur->offset + 1;
+            cursor.ordinal = ordinal;
+            continue;
+        }
+        uint32_t limit = brk < chunk->num_events ? chunk->events[brk].ordinal
+                                                 : chunk->floor_items;
+        if (ordinal == limit) {
+            return NANOCBOR_OK;
+        }
+        uint32_t count = limit - ordinal;
+        if (top && !top->indefinite && top->remaining < count) {
+            count = (uint32_t)top->remaining;
+        }
+        for (; event < brk && chunk->events[event].ordinal < ordinal + count;
+             event++) {
+            const _event_t *cur = &chunk->events[event];
+            if (stitch->depth + cur->height > NANOCBOR_RECURSION_MAX) {
+                return NANOCBOR_ERR_RECURSION;
+            }
+            if (base + cur->node < stitch->capacity) {
+                stitch->nodes[base + cur->node].parent
+                    = top ? top->node : NANOCBOR_INDEX_NONE;
+            }
+        }
+        if (top) {
+            if (!top->indefinite) {
+                top->remaining -= count;
+            }
+            if (top->node < stitch->capacity) {
+                stitch->nodes[top->node].items += count;
+            }
+        }
+        ordinal += count;
+    }
+}
+
+static int _stitch(_stitch_t *stitch, const _chunk_t *chunk)
+{
+    size_t base = stitch->count;
+
+    for (size_t i = 0; i < chunk->num_nodes && base + i < stitch->capacity;
+         i++) {
+        nanocbor_index_node_t *node = &stitch->nodes[base + i];
+        *node = chunk->nodes[i];
+        if (node->parent != PARENT_FLOOR) {
+            node->parent += (uint32_t)base;
+        }
+        if (node->next != NODE_OPEN) {
+            node->next += (uint32_t)base;
+        }
+    }
+    stitch->count += chunk->num_nodes;
+
+    int res = _stitch_floor(stitch, chunk, base);
+    if (res < 0) {
+        return res;
+    }
+    for (size_t i = 0; i < chunk->depth; i++) {
+        _open_t *open = &stitch->open[stitch->depth++];
+        *open = chunk->open[i];
+        open->node += (uint32_t)base;
+    }
+    return NANOCBOR_OK;
+}
+
+int nanocbor_index_build_parallel(const uint8_t *buf, size_t len,
+                                  nanocbor_index_node_t *nodes,
+                                  size_t *num_nodes, unsigned threads)
+{
+    pthread_t tids[NANOCBOR_WALK_THREADS_MAX];
+    _stitch_t stitch = { .nodes = nodes, .capacity = nodes ? *num_nodes : 0 };
+    uint32_t exit = 0;
+    int res = NANOCBOR_OK;
+
+    if (threads == 0 || threads > NANOCBOR_WALK_THREADS_MAX
+        || len > UINT32_MAX) {
+        return NANOCBOR_ERR_OVERFLOW;
+    }
+    _chunk_t *chunks = calloc(threads, sizeof(_chunk_t));
+    if (!chunks) {
+        return NANOCBOR_ERR_OVERFLOW;
+    }
+    for (unsigned i = 0; i < threads; i++) {
+        chunks[i].buf = buf;
+        chunks[i].len = len;
+        chunks[i].start = i ? _sync_point(buf, len, len * i / threads) : 0;
+        if (i) {
+            chunks[i - 1].target = chunks[i].start;
+        }
+    }
+    chunks[threads - 1].target = (uint32_t)len;
+
+    /* The calling thread parses the first chunk */
+    for (unsigned i = 1; i < threads; i++) {
+        chunks[i].started
+            = pthread_create(&tids[i], NULL, _chunk_parse, &chunks[i]) == 0;
+    }
+    _chunk_parse(&chunks[0]);
+    for (unsigned i = 1; i < threads; i++) {
+        if (chunks[i].started) {
+            pthread_join(tids[i], NULL);
+        }
+    }
+
+    for (unsigned i = 0; i < threads && res == NANOCBOR_OK; i++) {
+        _chunk_t *chunk = &chunks[i];
+        if (chunk->start != exit || (i > 0 && !chunk->started)) {
+            /* Wrong guess, parse again from where the previous chunk ended */
+            chunk->start = exit;
+            _chunk_parse(chunk);
+        }
+        res = chunk->res;
+        if (res == NANOCBOR_OK) {
+            res = _stitch(&stitch, chunk);
+        }
+        exit = chunk->exit;
+    }
+    if (res == NANOCBOR_OK && stitch.depth > 0) {
+        res = NANOCBOR_ERR_END;
+    }
+
+    for (unsigned i = 0; i < threads; i++) {
+        free(chunks[i].nodes);
+        free(chunks[i].events);
+    }
+    free(chunks);
+    if (res < 0) {
+        return res;
+    }
+    *num_nodes = stitch.count;
+    return stitch.count > stitch.capacity ? NANOCBOR_ERR_OVERFLOW
+                                          : NANOCBOR_OK;
+}
+
+#endif /* NANOCBOR_WALK_PARALLEL */
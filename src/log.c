@@ -0,0 +1,461 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @ingroup nanocbor_log
+ * @{
+ * @file
+ * @brief   Append-only log implementation
+ * @}
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "nanocbor/config.h"
+#include "nanocbor/log.h"
+#include "nanocbor/nanocbor.h"
+
+#define BLOCK_ITEMS (5U)
+#define INDEX_ITEMS (2U)
+#define INDEX_ENTRY_ITEMS (3U)
+
+typedef struct {
+    uint64_t record_no;
+    uint32_t count;
+    int64_t first_key;
+    uint32_t crc;
+    const uint8_t *records;
+    size_t len;
+} _block_t;
+
+/* CRC-32 as used by IEEE 802.3 with a nibble table */
+static uint32_t _crc32(uint32_t crc, const uint8_t *buf, size_t len)
+{
+    static const uint32_t table[16] = {
+        0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac,
+        0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+        0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+        0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c,
+    };
+
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= buf[i];
+        crc = (crc >> 4) ^ table[crc & 0x0f];
+        crc = (crc >> 4) ^ table[crc & 0x0f];
+    }
+    return ~crc;
+}
+
+static int _write_index(nanocbor_log_writer_t *log)
+{
+    nanocbor_encoder_t *out = log->out;
+    size_t start = nanocbor_encoded_len(out);
+
+    if (nanocbor_fmt_tag(out, NANOCBOR_TAG_LOG_INDEX) < 0
+        || nanocbor_fmt_array(out, INDEX_ITEMS) < 0
+        || (log->has_index ? nanocbor_fmt_uint(out, log->last_index)
+                           : nanocbor_fmt_null(out))
+            < 0
+        || nanocbor_fmt_array(out, INDEX_ENTRY_ITEMS * log->num_entries)
+            < 0) {
+        return NANOCBOR_ERR_END;
+    }
+    for (size_t i = 0; i < log->num_entries; i++) {
+        const nanocbor_log_index_entry_t *entry = &log->entries[i];
+        if (nanocbor_fmt_uint(out, entry->offset) < 0
+            || nanocbor_fmt_uint(out, entry->record_no) < 0
+            || nanocbor_fmt_int(out, entry->first_key) < 0) {
+            return NANOCBOR_ERR_END;
+        }
+    }
+    log->last_index = log->offset;
+    log->has_index = true;
+    log->offset += nanocbor_encoded_len(out) - start;
+    log->num_entries = 0;
+    return NANOCBOR_OK;
+}
+
+static int _write_block(nanocbor_log_writer_t *log, const uint8_t *records,
+                        size_t len, uint32_t count, int64_t first_key,
+                        uint32_t crc)
+{
+    nanocbor_encoder_t *out = log->out;
+    size_t start = nanocbor_encoded_len(out);
+
+    if (nanocbor_fmt_tag(out, NANOCBOR_TAG_LOG_BLOCK) < 0
+        || nanocbor_fmt_array(out, BLOCK_ITEMS) < 0
+        || nanocbor_fmt_uint(out, log->record_no) < 0
+        || nanocbor_fmt_uint(out, count) < 0
+        || nanocbor_fmt_int(out, first_key) < 0
+        || nanocbor_fmt_uint(out, crc) < 0
+        || nanocbor_put_bstr(out, records, len) < 0) {
+        return NANOCBOR_ERR_END;
+    }
+    nanocbor_log_index_entry_t *entry = &log->entries[log->num_entries++];
+    entry->offset = log->offset;
+    entry->record_no = log->record_no;
+    entry->first_key = first_key;
+
+    log->offset += nanocbor_encoded_len(out) - start;
+    log->record_no += count;
+    if (log->num_entries == NANOCBOR_LOG_INDEX_INTERVAL) {
+        return _write_index(log);
+    }
+    return NANOCBOR_OK;
+}
+
+void nanocbor_log_writer_init(nanocbor_log_writer_t *log,
+                              nanocbor_encoder_t *out, uint8_t *buf,
+                              size_t buf_len, const nanocbor_log_info_t *info)
+{
+    memset(log, 0, sizeof(*log));
+    log->out = out;
+    log->buf = buf;
+    log->buf_len = buf_len;
+    if (info) {
+        log->offset = info->len;
+        log->record_no = info->records;
+        log->last_index = info->last_index;
+        log->has_index = info->has_index;
+    }
+}
+
+int nanocbor_log_flush(nanocbor_log_writer_t *log)
+{
+    if (log->count == 0) {
+        return NANOCBOR_OK;
+    }
+    int res = _write_block(log, log->buf, log->used, log->count,
+                           log->first_key, log->crc);
+    log->used = 0;
+    log->count = 0;
+    log->crc = 0;
+    return res;
+}
+
+int nanocbor_log_append(nanocbor_log_writer_t *log, int64_t key,
+                        const uint8_t *record, size_t len)
+{
+    if (log->used + len > log->buf_len) {
+        int res = nanocbor_log_flush(log);
+        if (res < 0) {
+            return res;
+        }
+    }
+    if (len > log->buf_len) {
+        return _write_block(log, record, len, 1, key, _crc32(0, record, len));
+    }
+    if (log->count == 0) {
+        log->first_key = key;
+    }
+    memcpy(log->buf + log->used, record, len);
+    log->used += len;
+    log->count++;
+    log->crc = _crc32(log->crc, record, len);
+    return NANOCBOR_OK;
+}
+
+/* Reads the tag and enters the array of the log item at offset */
+static int _read_item(const uint8_t *buf, size_t len, size_t offset,
+                      uint64_t *tag, nanocbor_value_t *arr, size_t *next)
+{
+    nanocbor_value_t it;
+    nanocbor_value_t item;
+
+    nanocbor_decoder_init(&it, buf + offset, len - offset);
+    item = it;
+    if (nanocbor_skip(&it) < 0) {
+        return NANOCBOR_ERR_END;
+    }
+    *next = offset + (size_t)(it.cur - item.cur);
+    if (nanocbor_get_tag64(&item, tag) < 0
+        || nanocbor_enter_array(&item, arr) < 0) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    return NANOCBOR_OK;
+}
+
+static int _parse_block(nanocbor_value_t *arr, _block_t *blk)
+{
+    if (nanocbor_array_items_remaining(arr) != BLOCK_ITEMS
+        || nanocbor_get_uint64(arr, &blk->record_no) < 0
+        || nanocbor_get_uint32(arr, &blk->count) < 0
+        || nanocbor_get_int64(arr, &blk->first_key) < 0
+        || nanocbor_get_uint32(arr, &blk->crc) < 0
+        || nanocbor_get_bstr(arr, &blk->records, &blk->len) < 0) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    return NANOCBOR_OK;
+}
+
+static int _parse_index(nanocbor_value_t *arr, bool *has_prev, size_t *prev,
+                        nanocbor_value_t *entries)
+{
+    uint64_t offset = 0;
+
+    if (nanocbor_array_items_remaining(arr) != INDEX_ITEMS) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    *has_prev = nanocbor_get_null(arr) < 0;
+    if (*has_prev) {
+        if (nanocbor_get_uint64(arr, &offset) < 0) {
+            return NANOCBOR_ERR_INVALID_TYPE;
+        }
+        *prev = (size_t)offset;
+    }
+    return nanocbor_enter_array(arr, entries) < 0 ? NANOCBOR_ERR_INVALID_TYPE
+                                                  : NANOCBOR_OK;
+}
+
+static int _get_entry(nanocbor_value_t *entries,
+                      nanocbor_log_index_entry_t *entry)
+{
+    uint64_t offset = 0;
+
+    if (nanocbor_get_uint64(entries, &offset) < 0
+        || nanocbor_get_uint64(entries, &entry->record_no) < 0
+        || nanocbor_get_int64(entries, &entry->first_key) < 0) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    entry->offset = (size_t)offset;
+    return NANOCBOR_OK;
+}
+
+static bool _block_intact(const _block_t *blk)
+{
+    nanocbor_value_t it;
+    uint32_t count = 0;
+
+    if (_crc32(0, blk->records, blk->len) != blk->crc) {
+        return false;
+    }
+    nanocbor_decoder_init(&it, blk->records, blk->len);
+    while (!nanocbor_at_end(&it)) {
+        if (nanocbor_skip(&it) < 0) {
+            return false;
+        }
+        count++;
+    }
+    return count == blk->count;
+}
+
+int nanocbor_log_recover(const uint8_t *buf, size_t len,
+                         nanocbor_log_info_t *info)
+{
+    size_t offset = 0;
+    size_t last_block = 0;
+    bool block_last = false;
+    _block_t blk = { 0 };
+
+    memset(info, 0, sizeof(*info));
+    while (offset < len) {
+        nanocbor_value_t arr;
+        uint64_t tag = 0;
+        size_t next = 0;
+
+        if (_read_item(buf, len, offset, &tag, &arr, &next) < 0) {
+            break;
+        }
+        if (tag == NANOCBOR_TAG_LOG_BLOCK) {
+            if (_parse_block(&arr, &blk) < 0
+                || blk.record_no != info->records) {
+                break;
+            }
+            last_block = offset;
+            block_last = true;
+            info->records += blk.count;
+        }
+        else if (tag == NANOCBOR_TAG_LOG_INDEX) {
+            nanocbor_value_t entries;
+            bool has_prev = false;
+            size_t prev = 0;
+            if (_parse_index(&arr, &has_prev, &prev, &entries) < 0
+                || has_prev != info->has_index
+                || (has_prev && prev != info->last_index)) {
+                break;
+            }
+            info->last_index = offset;
+            info->has_index = true;
+            block_last = false;
+        }
+        else {
+            break;
+        }
+        offset = next;
+    }
+
+    /* Only the block written last can be torn by an interrupted write */
+    if (block_last && !_block_intact(&blk)) {
+        offset = last_block;
+        info->records -= blk.count;
+    }
+    info->len = offset;
+    return offset == len ? NANOCBOR_OK : NANOCBOR_ERR_END;
+}
+
+void nanocbor_log_reader_init(nanocbor_log_reader_t *reader,
+                              const uint8_t *buf,
+                              const nanocbor_log_info_t *info)
+{
+    reader->buf = buf;
+    reader->len = info->len;
+    reader->next = 0;
+    reader->record_no = 0;
+    reader->last_index = info->last_index;
+    reader->has_index = info->has_index;
+    nanocbor_decoder_init(&reader->records, NULL, 0);
+}
+
+int nanocbor_log_read(nanocbor_log_reader_t *reader, const uint8_t **record,
+                      size_t *len)
+{
+    while (nanocbor_at_end(&reader->records)) {
+        nanocbor_value_t arr;
+        uint64_t tag = 0;
+        _block_t blk;
+
+        if (reader->next >= reader->len) {
+            return NANOCBOR_ERR_END;
+        }
+        int res = _read_item(reader->buf, reader->len, reader->next, &tag,
+                             &arr, &reader->next);
+        if (res < 0) {
+            return res;
+        }
+        if (tag != NANOCBOR_TAG_LOG_BLOCK) {
+            continue;
+        }
+        res = _parse_block(&arr, &blk);
+        if (res < 0) {
+            return res;
+        }
+        nanocbor_decoder_init(&reader->records, blk.records, blk.len);
+        reader->record_no = blk.record_no;
+    }
+    int res = nanocbor_get_subcbor(&reader->records, record, len);
+    if (res < 0) {
+        return res;
+    }
+    reader->record_no++;
+    return NANOCBOR_OK;
+}
+
+static bool _at_or_before(uint64_t record_no, int64_t first_key, bool by_key,
+                          uint64_t target_no, int64_t target_key)
+{
+    return by_key ? first_key <= target_key : record_no <= target_no;
+}
+
+/* Finds the offset of the closest indexed block at or before the target */
+static int _seek_start(const nanocbor_log_reader_t *reader, bool by_key,
+                       uint64_t record_no, int64_t key, size_t *start)
+{
+    bool has_index = reader->has_index;
+    size_t index = reader->last_index;
+
+    *start = 0;
+    while (has_index) {
+        nanocbor_value_t arr;
+        nanocbor_value_t entries;
+        nanocbor_log_index_entry_t entry;
+        uint64_t tag = 0;
+        size_t next = 0;
+        bool found = false;
+
+        int res = _read_item(reader->buf, reader->len, index, &tag, &arr,
+                             &next);
+        if (res < 0) {
+            return res;
+        }
+        res = _parse_index(&arr, &has_index, &index, &entries);
+        if (res < 0) {
+            return res;
+        }
+        while (!nanocbor_at_end(&entries)) {
+            res = _get_entry(&entries, &entry);
+            if (res < 0) {
+                return res;
+            }
+            if (!_at_or_before(entry.record_no, entry.first_key, by_key,
+                               record_no, key)) {
+                break;
+            }
+            *start = entry.offset;
+            found = true;
+        }
+        if (found) {
+            break;
+        }
+    }
+    return NANOCBOR_OK;
+}
+
+static int _seek(nanocbor_log_reader_t *reader, bool by_key,
+                 uint64_t record_no, int64_t key)
+{
+    size_t offset = 0;
+    size_t block_next = 0;
+    bool found = false;
+    _block_t blk = { 0 };
+
+    int res = _seek_start(reader, by_key, record_no, key, &offset);
+    if (res < 0) {
+        return res;
+    }
+    while (offset < reader->len) {
+        nanocbor_value_t arr;
+        uint64_t tag = 0;
+        size_t next = 0;
+        _block_t cur;
+
+        res = _read_item(reader->buf, reader->len, offset, &tag, &arr, &next);
+        if (res < 0) {
+            return res;
+        }
+        if (tag == NANOCBOR_TAG_LOG_BLOCK) {
+            res = _parse_block(&arr, &cur);
+            if (res < 0) {
+                return res;
+            }
+            if (found
+                && !_at_or_before(cur.record_no, cur.first_key, by_key,
+                                  record_no, key)) {
+                break;
+            }
+            blk = cur;
+            block_next = next;
+            found = true;
+        }
+        offset = next;
+    }
+    if (!found || (!by_key && record_no >= blk.record_no + blk.count)) {
+        return NANOCBOR_NOT_FOUND;
+    }
+
+    nanocbor_decoder_init(&reader->records, blk.records, blk.len);
+    reader->record_no = blk.record_no;
+    reader->next = block_next;
+    for (; !by_key && reader->record_no < record_no; reader->record_no++) {
+        res = nanocbor_skip(&reader->records);
+        if (res < 0) {
+            return res;
+        }
+    }
+    return NANOCBOR_OK;
+}
+
+int nanocbor_log_seek_record(nanocbor_log_reader_t *reader,
+                             uint64_t record_no)
+{
+    return _seek(reader, false, record_no, 0);
+}
+
+int nanocbor_log_seek_key(nanocbor_log_reader_t *reader, int64_t key)
+{
+    return _seek(reader, true, 0, key);
+}
@@ -0,0 +1,165 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @ingroup nanocbor_merkle
+ * @{
+ * @file
+ * @brief   Merkle hashing implementation
+ * @}
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "nanocbor/index.h"
+#include "nanocbor/merkle.h"
+#include "nanocbor/nanocbor.h"
+
+#define FNV1A64_OFFSET (0xcbf29ce484222325ULL)
+#define FNV1A64_PRIME (0x100000001b3ULL)
+
+static const uint8_t _leaf_marker = 'L';
+static const uint8_t _node_marker = 'N';
+
+static void _fnv1a64_init(void *state)
+{
+    *(uint64_t *)state = FNV1A64_OFFSET;
+}
+
+static void _fnv1a64_update(void *state, const uint8_t *data, size_t len)
+{
+    uint64_t hash = *(uint64_t *)state;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= data[i];
+        hash *= FNV1A64_PRIME;
+    }
+    *(uint64_t *)state = hash;
+}
+
+static void _fnv1a64_final(void *state, uint8_t *digest)
+{
+    uint64_t hash = *(uint64_t *)state;
+    for (size_t i = sizeof(hash); i > 0; i--) {
+        digest[i - 1] = (uint8_t)hash;
+        hash >>= 8;
+    }
+}
+
+const nanocbor_hash_t nanocbor_hash_fnv1a64 = {
+    .digest_len = sizeof(uint64_t),
+    .init = _fnv1a64_init,
+    .update = _fnv1a64_update,
+    .final = _fnv1a64_final,
+};
+
+static void _hash_part(const nanocbor_hash_t *hash, void *state,
+                       const uint8_t *marker, const uint8_t *data, size_t len)
+{
+    hash->update(state, marker, 1);
+    hash->update(state, data, len);
+}
+
+/* Moves past the container of @p child, using the index for its length */
+static int _jump(const uint8_t *buf, const nanocbor_index_node_t *nodes,
+                 size_t num_nodes, uint32_t child, nanocbor_value_t *it)
+{
+    if (child >= num_nodes || buf + nodes[child].offset != it->cur
+        || nodes[child].len > (size_t)(it->end - it->cur)) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    it->cur += nodes[child].len;
+    it->remaining--;
+    return NANOCBOR_OK;
+}
+
+static int _hash_node(const uint8_t *buf, const nanocbor_index_node_t *nodes,
+                      size_t num_nodes, uint32_t node,
+                      const nanocbor_hash_t *hash, void *state,
+                      uint8_t *digests)
+{
+    const nanocbor_index_node_t *cur = &nodes[node];
+    uint32_t child = node + 1;
+    nanocbor_value_t it;
+    nanocbor_value_t container;
+
+    nanocbor_decoder_init(&it, buf + cur->offset, cur->len);
+    int res = nanocbor_get_type(&it) == NANOCBOR_TYPE_ARR
+        ? nanocbor_enter_array(&it, &container)
+        : nanocbor_enter_map(&it, &container);
+    if (res < 0) {
+        return res;
+    }
+
+    hash->init(state);
+    _hash_part(hash, state, &_leaf_marker, it.cur,
+               (size_t)(container.cur - it.cur));
+    while (!nanocbor_at_end(&container)) {
+        const uint8_t *start = container.cur;
+        int type = nanocbor_get_type(&container);
+        size_t len = 0;
+
+        if (type == NANOCBOR_TYPE_ARR || type == NANOCBOR_TYPE_MAP) {
+            res = _jump(buf, nodes, num_nodes, child, &container);
+            if (res == NANOCBOR_OK) {
+                _hash_part(hash, state, &_node_marker,
+                           digests + (size_t)child * hash->digest_len,
+                           hash->digest_len);
+                child = nodes[child].next;
+            }
+        }
+        else if (type == NANOCBOR_TYPE_TAG) {
+            uint64_t tag = 0;
+            res = nanocbor_get_tag64(&container, &tag);
+            len = (size_t)(container.cur - start);
+        }
+        else {
+            res = nanocbor_get_subcbor(&container, &start, &len);
+        }
+        if (res < 0) {
+            return res;
+        }
+        if (len > 0) {
+            _hash_part(hash, state, &_leaf_marker, start, len);
+        }
+    }
+    hash->final(state, digests + (size_t)node * hash->digest_len);
+    return NANOCBOR_OK;
+}
+
+int nanocbor_merkle_build(const uint8_t *buf,
+                          const nanocbor_index_node_t *nodes, size_t num_nodes,
+                          const nanocbor_hash_t *hash, void *state,
+                          uint8_t *digests)
+{
+    /* Children follow their parent in the index, hash them first */
+    for (size_t i = num_nodes; i > 0; i--) {
+        int res = _hash_node(buf, nodes, num_nodes, (uint32_t)(i - 1), hash,
+                             state, digests);
+        if (res < 0) {
+            return res;
+        }
+    }
+    return NANOCBOR_OK;
+}
+
+int nanocbor_merkle_update(const uint8_t *buf,
+                           const nanocbor_index_node_t *nodes,
+                           size_t num_nodes, size_t offset,
+                           const nanocbor_hash_t *hash, void *state,
+                           uint8_t *digests)
+{
+    uint32_t node = nanocbor_index_find(nodes, num_nodes, offset);
+
+    if (node == NANOCBOR_INDEX_NONE) {
+        return NANOCBOR_NOT_FOUND;
+    }
+    for (; node != NANOCBOR_INDEX_NONE; node = nodes[node].parent) {
+        int res = _hash_node(buf, nodes, num_nodes, node, hash, state, digests);
+        if (res < 0) {
+            return res;
+        }
+    }
+    return NANOCBOR_OK;
+}
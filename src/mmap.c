@@ -0,0 +1,154 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @ingroup nanocbor_mmap
+ * @{
+ * @file
+ * @brief   Memory-mapped file encoder target implementation
+ *
+ * The file and the mapping always have the same size. The file is extended
+ * before the mapping grows, so no page of the mapping lies beyond the end of
+ * the file.
+ * @}
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* mremap */
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "nanocbor/config.h"
+#include "nanocbor/mmap.h"
+#include "nanocbor/nanocbor.h"
+
+#if NANOCBOR_ENCODER_MMAP
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+static uint8_t *_map(int fd, size_t size)
+{
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    return map == MAP_FAILED ? NULL : map;
+}
+
+static bool _grow(nanocbor_mmap_t *target, size_t len)
+{
+    if (len > SIZE_MAX - target->used - target->step) {
+        return false;
+    }
+    size_t size = (target->used + len + target->step - 1) / target->step
+        * target->step;
+
+    if (ftruncate(target->fd, (off_t)size) != 0) {
+        return false;
+    }
+    void *map = NULL;
+    if (target->map == NULL) {
+        map = _map(target->fd, size);
+    }
+    else {
+#ifdef MREMAP_MAYMOVE
+        map = mremap(target->map, target->size, size, MREMAP_MAYMOVE);
+        map = map == MAP_FAILED ? NULL : map;
+#else
+        munmap(target->map, target->size);
+        target->map = NULL;
+        map = _map(target->fd, size);
+#endif
+    }
+    if (map == NULL) {
+        /* The file is truncated to the written bytes when closing */
+        return false;
+    }
+    target->map = map;
+    target->size = size;
+    return true;
+}
+
+static bool _mmap_fits(nanocbor_encoder_t *enc, void *ctx, size_t len)
+{
+    nanocbor_mmap_t *target = ctx;
+
+    (void)enc;
+    if (target->failed) {
+        return false;
+    }
+    if (len > target->size - target->used && !_grow(target, len)) {
+        target->failed = true;
+        return false;
+    }
+    return true;
+}
+
+static void _mmap_append(nanocbor_encoder_t *enc, void *ctx,
+                         const uint8_t *data, size_t len)
+{
+    nanocbor_mmap_t *target = ctx;
+
+    (void)enc;
+    memcpy(target->map + target->used, data, len);
+    target->used += len;
+}
+
+static void _mmap_append_vec(nanocbor_encoder_t *enc, void *ctx,
+                             const nanocbor_encoder_vec_t *vec, size_t num)
+{
+    for (size_t i = 0; i < num; i++) {
+        _mmap_append(enc, ctx, vec[i].data, vec[i].len);
+    }
+}
+
+int nanocbor_mmap_init(nanocbor_mmap_t *target, int fd, size_t step)
+{
+    long page = sysconf(_SC_PAGESIZE);
+
+    if (page <= 0) {
+        page = 4096;
+    }
+    if (step == 0) {
+        step = NANOCBOR_MMAP_STEP;
+    }
+    if (step > SIZE_MAX / 2) {
+        return NANOCBOR_ERR_OVERFLOW;
+    }
+    memset(target, 0, sizeof(*target));
+    target->fd = fd;
+    target->step = (step + (size_t)page - 1) / (size_t)page * (size_t)page;
+    if (ftruncate(fd, 0) != 0) {
+        return NANOCBOR_ERR_OVERFLOW;
+    }
+    return NANOCBOR_OK;
+}
+
+void nanocbor_mmap_encoder_init(nanocbor_encoder_t *enc,
+                                nanocbor_mmap_t *target)
+{
+    nanocbor_encoder_stream_init(enc, target, _mmap_append, _mmap_fits);
+    nanocbor_encoder_set_append_vec(enc, _mmap_append_vec);
+}
+
+int nanocbor_mmap_close(nanocbor_mmap_t *target, nanocbor_encoder_t *enc)
+{
+    int res = target->failed ? NANOCBOR_ERR_OVERFLOW : NANOCBOR_OK;
+    size_t len = target->failed ? target->used : nanocbor_encoded_len(enc);
+
+    if (target->map != NULL && munmap(target->map, target->size) != 0) {
+        res = NANOCBOR_ERR_OVERFLOW;
+    }
+    target->map = NULL;
+    if (ftruncate(target->fd, (off_t)len) != 0) {
+        res = NANOCBOR_ERR_OVERFLOW;
+    }
+    target->size = len;
+    return res;
+}
+
+#endif /* NANOCBOR_ENCODER_MMAP */
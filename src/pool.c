@@ -0,0 +1,238 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @ingroup nanocbor_pool
+ * @{
+ * @file
+ * @brief   Adaptive encoder buffer pool implementation
+ *
+ * Sizes below 8 have a bucket each. Larger sizes are bucketed by their power
+ * of two and the two bits below the leading one, giving buckets of
+ * `[4 + sub, 5 + sub) << (log - 2)` with `sub` in 0 to 3.
+ * @}
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nanocbor/config.h"
+#include "nanocbor/nanocbor.h"
+#include "nanocbor/pool.h"
+
+#define EXACT_BUCKETS 8U
+#define SUB_BUCKETS 4U
+#define EXACT_LOG 3U
+
+static unsigned _log2(size_t len)
+{
+    unsigned log = 0;
+
+    while (len >>= 1) {
+        log++;
+    }
+    return log;
+}
+
+static unsigned _bucket(size_t len)
+{
+    if (len < EXACT_BUCKETS) {
+        return (unsigned)len;
+    }
+    unsigned log = _log2(len);
+    size_t bucket = EXACT_BUCKETS + (log - EXACT_LOG) * SUB_BUCKETS
+        + ((len >> (log - 2)) & (SUB_BUCKETS - 1));
+    return bucket < NANOCBOR_POOL_BUCKETS ? (unsigned)bucket
+                                          : NANOCBOR_POOL_BUCKETS - 1;
+}
+
+static size_t _bucket_bound(const nanocbor_pool_class_t *cls, unsigned bucket)
+{
+    if (bucket < EXACT_BUCKETS) {
+        return bucket;
+    }
+    if (bucket == NANOCBOR_POOL_BUCKETS - 1) {
+        return cls->max_len;
+    }
+    unsigned log = EXACT_LOG + (bucket - EXACT_BUCKETS) / SUB_BUCKETS;
+    size_t sub = (bucket - EXACT_BUCKETS) % SUB_BUCKETS;
+    return ((SUB_BUCKETS + 1 + sub) << (log - 2)) - 1;
+}
+
+void nanocbor_pool_init(nanocbor_pool_t *pool, nanocbor_pool_class_t *classes,
+                        size_t num_classes)
+{
+    memset(classes, 0, num_classes * sizeof(*classes));
+    pool->classes = classes;
+    pool->num_classes = num_classes;
+}
+
+void nanocbor_pool_deinit(nanocbor_pool_t *pool)
+{
+    for (size_t i = 0; i < pool->num_classes; i++) {
+        free(pool->classes[i].buf);
+        pool->classes[i].buf = NULL;
+        pool->classes[i].buf_len = 0;
+    }
+}
+
+void nanocbor_pool_record(nanocbor_pool_t *pool, unsigned type, size_t len)
+{
+    nanocbor_pool_class_t *cls = &pool->classes[type];
+    unsigned bucket = _bucket(len);
+
+    if (bucket == NANOCBOR_POOL_BUCKETS - 1 && len > cls->max_len) {
+        cls->max_len = len;
+    }
+    cls->counts[bucket]++;
+    cls->total++;
+    if (cls->total >= NANOCBOR_POOL_HISTORY) {
+        cls->total = 0;
+        for (unsigned i = 0; i < NANOCBOR_POOL_BUCKETS; i++) {
+            cls->counts[i] /= 2;
+            cls->total += cls->counts[i];
+        }
+    }
+}
+
+size_t nanocbor_pool_estimate(const nanocbor_pool_t *pool, unsigned type)
+{
+    const nanocbor_pool_class_t *cls = &pool->classes[type];
+    uint32_t rank = (uint32_t)(((uint64_t)cls->total * NANOCBOR_POOL_QUANTILE
+                                + 999)
+                               / 1000);
+    uint32_t seen = 0;
+
+    if (cls->total == 0) {
+        return 0;
+    }
+    for (unsigned i = 0; i < NANOCBOR_POOL_BUCKETS; i++) {
+        seen += cls->counts[i];
+        if (seen >= rank) {
+            return _bucket_bound(cls, i);
+        }
+    }
+    return _bucket_bound(cls, NANOCBOR_POOL_BUCKETS - 1);
+}
+
+static int _reserve(size_t len, uint8_t **buf, size_t *size)
+{
+    uint8_t *res = realloc(*buf, len ? len : 1);
+
+    if (!res) {
+        return NANOCBOR_ERR_OVERFLOW;
+    }
+    *buf = res;
+    *size = len;
+    return NANOCBOR_OK;
+}
+
+int nanocbor_pool_acquire(nanocbor_pool_t *pool, unsigned type, uint8_t **buf,
+                          size_t *len)
+{
+    nanocbor_pool_class_t *cls = &pool->classes[type];
+    size_t estimate = nanocbor_pool_estimate(pool, type);
+
+    *buf = cls->buf;
+    *len = cls->buf_len;
+    cls->buf = NULL;
+    cls->buf_len = 0;
+    /* Reuse the cached buffer unless it is too small or twice too large */
+    if (*buf && *len >= estimate && *len / 2 <= estimate) {
+        return NANOCBOR_OK;
+    }
+    int res = _reserve(estimate, buf, len);
+    if (res < 0) {
+        free(*buf);
+        *buf = NULL;
+        *len = 0;
+    }
+    return res;
+}
+
+void nanocbor_pool_release(nanocbor_pool_t *pool, unsigned type, uint8_t *buf,
+                           size_t len)
+{
+    nanocbor_pool_class_t *cls = &pool->classes[type];
+
+    if (cls->buf) {
+        free(buf);
+        return;
+    }
+    cls->buf = buf;
+    cls->buf_len = len;
+}
+
+static bool _count_fits(nanocbor_encoder_t *enc, void *ctx, size_t len)
+{
+    (void)enc;
+    (void)ctx;
+    (void)len;
+    return true;
+}
+
+static void _count_append(nanocbor_encoder_t *enc, void *ctx,
+                          const uint8_t *data, size_t len)
+{
+    (void)enc;
+    (void)ctx;
+    (void)data;
+    (void)len;
+}
+
+/* Size of a message encoded by a function that stops at the first error */
+static int _count(nanocbor_pool_encode_t encode, void *arg, size_t *len)
+{
+    nanocbor_encoder_t enc;
+
+    nanocbor_encoder_stream_init(&enc, NULL, _count_append, _count_fits);
+    int res = encode(&enc, arg);
+    *len = nanocbor_encoded_len(&enc);
+    return res;
+}
+
+int nanocbor_pool_encode(nanocbor_pool_t *pool, unsigned type,
+                         nanocbor_pool_encode_t encode, void *arg,
+                         uint8_t **buf, size_t *size, size_t *len)
+{
+    nanocbor_pool_class_t *cls = &pool->classes[type];
+    nanocbor_encoder_t enc;
+    int res = nanocbor_pool_acquire(pool, type, buf, size);
+
+    if (res < 0) {
+        return res;
+    }
+    nanocbor_encoder_init(&enc, *buf, *size);
+    res = encode(&enc, arg);
+    size_t needed = nanocbor_encoded_len(&enc);
+    if (res == NANOCBOR_ERR_END && needed > *size) {
+        /* The encode function returned at the item that did not fit */
+        res = _count(encode, arg, &needed);
+    }
+    if (res >= 0 && needed > *size) {
+        cls->retries++;
+        res = _reserve(needed, buf, size);
+        if (res >= 0) {
+            nanocbor_encoder_init(&enc, *buf, *size);
+            res = encode(&enc, arg);
+        }
+        if (res >= 0 && nanocbor_encoded_len(&enc) > *size) {
+            /* The message grew between both passes */
+            res = NANOCBOR_ERR_END;
+        }
+    }
+    if (res < 0) {
+        nanocbor_pool_release(pool, type, *buf, *size);
+        *buf = NULL;
+        *size = 0;
+        return res;
+    }
+    cls->encodes++;
+    *len = nanocbor_encoded_len(&enc);
+    nanocbor_pool_record(pool, type, *len);
+    return NANOCBOR_OK;
+}
@@ -0,0 +1,342 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @ingroup nanocbor_query
+ * @{
+ * @file
+ * @brief   Query engine implementation
+ * @}
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "nanocbor/config.h"
+#include "nanocbor/nanocbor.h"
+#include "nanocbor/query.h"
+
+static bool _parse_index(const char *seg, size_t len, int64_t *index)
+{
+    bool negative = false;
+    uint64_t value = 0;
+
+    if (len > 0 && seg[0] == '-') {
+        negative = true;
+        seg++;
+        len--;
+    }
+    if (len == 0 || len > 18) {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (seg[i] < '0' || seg[i] > '9') {
+            return false;
+        }
+        value = value * 10 + (uint64_t)(seg[i] - '0');
+    }
+    *index = negative ? -(int64_t)value : (int64_t)value;
+    return true;
+}
+
+static int _find_map_entry(nanocbor_value_t *map, const char *seg, size_t len,
+                           nanocbor_value_t *value)
+{
+    int64_t index = 0;
+    bool numeric = _parse_index(seg, len, &index);
+
+    while (!nanocbor_at_end(map)) {
+        int type = nanocbor_get_type(map);
+        bool match = false;
+        int res = NANOCBOR_ERR_INVALID_TYPE;
+
+        if (type == NANOCBOR_TYPE_TSTR) {
+            const uint8_t *key = NULL;
+            size_t key_len = 0;
+            res = nanocbor_get_tstr(map, &key, &key_len);
+            match = res >= 0 && key_len == len && !memcmp(key, seg, len);
+        }
+        else if (numeric
+                 && (type == NANOCBOR_TYPE_UINT
+                     || type == NANOCBOR_TYPE_NINT)) {
+            int64_t key = 0;
+            res = nanocbor_get_int64(map, &key);
+            match = res >= 0 && key == index;
+        }
+        /* Key not consumed yet */
+        if (res < 0) {
+            res = nanocbor_skip(map);
+            if (res < 0) {
+                return res;
+            }
+        }
+        if (match) {
+            *value = *map;
+            return NANOCBOR_OK;
+        }
+        res = nanocbor_skip(map);
+        if (res < 0) {
+            return res;
+        }
+    }
+    return NANOCBOR_NOT_FOUND;
+}
+
+static int _find_array_item(nanocbor_value_t *arr, const char *seg, size_t len,
+                            nanocbor_value_t *value)
+{
+    int64_t index = 0;
+
+    if (!_parse_index(seg, len, &index) || index < 0) {
+        return NANOCBOR_NOT_FOUND;
+    }
+    for (; index > 0 && !nanocbor_at_end(arr); index--) {
+        int res = nanocbor_skip(arr);
+        if (res < 0) {
+            return res;
+        }
+    }
+    if (nanocbor_at_end(arr)) {
+        return NANOCBOR_NOT_FOUND;
+    }
+    *value = *arr;
+    return NANOCBOR_OK;
+}
+
+int nanocbor_query_path(const nanocbor_value_t *it, const char *path,
+                        nanocbor_value_t *value)
+{
+    nanocbor_value_t cur = *it;
+
+    if (*path != '\0' && *path != '/') {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    while (*path == '/') {
+        const char *seg = path + 1;
+        size_t len = strcspn(seg, "/");
+        nanocbor_value_t container;
+
+        int res = nanocbor_skip_tags(&cur);
+        if (res < 0) {
+            return res;
+        }
+        if (nanocbor_enter_map(&cur, &container) == NANOCBOR_OK) {
+            res = _find_map_entry(&container, seg, len, &cur);
+        }
+        else if (nanocbor_enter_array(&cur, &container) == NANOCBOR_OK) {
+            res = _find_array_item(&container, seg, len, &cur);
+        }
+        else {
+            res = NANOCBOR_NOT_FOUND;
+        }
+        if (res < 0) {
+            return res;
+        }
+        path = seg + len;
+    }
+    *value = cur;
+    return NANOCBOR_OK;
+}
+
+static bool _cmp_matches(nanocbor_query_op_t op, int cmp)
+{
+    switch (op) {
+    case NANOCBOR_QUERY_EQ:
+        return cmp == 0;
+    case NANOCBOR_QUERY_NE:
+        return cmp != 0;
+    case NANOCBOR_QUERY_LT:
+        return cmp < 0;
+    case NANOCBOR_QUERY_LE:
+        return cmp <= 0;
+    case NANOCBOR_QUERY_GT:
+        return cmp > 0;
+    case NANOCBOR_QUERY_GE:
+        return cmp >= 0;
+    default:
+        return true;
+    }
+}
+
+static bool _pred_number(const nanocbor_query_pred_t *pred,
+                         nanocbor_value_t *value)
+{
+    nanocbor_number_t num;
+
+    if (nanocbor_skip_tags(value) < 0
+        || nanocbor_get_number(value, &num) < 0) {
+        return false;
+    }
+    if (num.is_int && pred->type == NANOCBOR_QUERY_INT) {
+        int64_t operand = pred->value.i;
+        return _cmp_matches(pred->op, (num.i > operand) - (num.i < operand));
+    }
+    double f = num.f;
+    double operand = pred->type == NANOCBOR_QUERY_INT ? (double)pred->value.i
+                                                      : pred->value.f;
+    if (f != f || operand != operand) {
+        /* NaN is unordered */
+        return pred->op == NANOCBOR_QUERY_NE;
+    }
+    return _cmp_matches(pred->op, (f > operand) - (f < operand));
+}
+
+static bool _pred_tstr(const nanocbor_query_pred_t *pred,
+                       nanocbor_value_t *value)
+{
+    const uint8_t *str = NULL;
+    size_t len = 0;
+
+    if (nanocbor_skip_tags(value) < 0
+        || nanocbor_get_tstr(value, &str, &len) < 0) {
+        return false;
+    }
+    size_t operand_len = strlen(pred->value.s);
+    size_t min_len = len < operand_len ? len : operand_len;
+    int cmp = memcmp(str, pred->value.s, min_len);
+    if (cmp == 0) {
+        cmp = (len > operand_len) - (len < operand_len);
+    }
+    return _cmp_matches(pred->op, cmp);
+}
+
+static bool _pred_matches(const nanocbor_query_pred_t *pred,
+                          const nanocbor_value_t *record)
+{
+    nanocbor_value_t value;
+
+    if (nanocbor_query_path(record, pred->path, &value) < 0) {
+        return false;
+    }
+    if (pred->op == NANOCBOR_QUERY_EXISTS) {
+        return true;
+    }
+    if (pred->type == NANOCBOR_QUERY_TSTR) {
+        return _pred_tstr(pred, &value);
+    }
+    return _pred_number(pred, &value);
+}
+
+bool nanocbor_query_match(const nanocbor_query_t *query,
+                          const nanocbor_value_t *record)
+{
+    for (size_t i = 0; i < query->num_where; i++) {
+        if (!_pred_matches(&query->where[i], record)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void _agg_update(nanocbor_query_agg_t *agg,
+                        const nanocbor_value_t *record)
+{
+    nanocbor_value_t value;
+    nanocbor_number_t num;
+
+    if (nanocbor_query_path(record, agg->path, &value) < 0) {
+        return;
+    }
+    agg->count++;
+    if (nanocbor_skip_tags(&value) < 0
+        || nanocbor_get_number(&value, &num) < 0) {
+        return;
+    }
+    double f = num.f;
+    if (agg->numeric == 0 || f < agg->min) {
+        agg->min = f;
+    }
+    if (agg->numeric == 0 || f > agg->max) {
+        agg->max = f;
+    }
+    agg->sum += f;
+    agg->numeric++;
+}
+
+void nanocbor_query_agg_merge(nanocbor_query_agg_t *dst,
+                              const nanocbor_query_agg_t *src)
+{
+    if (src->numeric > 0) {
+        if (dst->numeric == 0 || src->min < dst->min) {
+            dst->min = src->min;
+        }
+        if (dst->numeric == 0 || src->max > dst->max) {
+            dst->max = src->max;
+        }
+    }
+    dst->count += src->count;
+    dst->numeric += src->numeric;
+    dst->sum += src->sum;
+}
+
+static bool _path_valid(const char *path)
+{
+    return *path == '\0' || *path == '/';
+}
+
+static int _query_check(const nanocbor_query_t *query)
+{
+    if (query->num_select > NANOCBOR_QUERY_SELECT_MAX) {
+        return NANOCBOR_ERR_OVERFLOW;
+    }
+    for (size_t i = 0; i < query->num_where; i++) {
+        if (!_path_valid(query->where[i].path)) {
+            return NANOCBOR_ERR_INVALID_TYPE;
+        }
+    }
+    for (size_t i = 0; i < query->num_select; i++) {
+        if (!_path_valid(query->select[i])) {
+            return NANOCBOR_ERR_INVALID_TYPE;
+        }
+    }
+    for (size_t i = 0; i < query->num_aggs; i++) {
+        if (!_path_valid(query->aggs[i].path)) {
+            return NANOCBOR_ERR_INVALID_TYPE;
+        }
+    }
+    return NANOCBOR_OK;
+}
+
+int nanocbor_query_run(const nanocbor_query_t *query, nanocbor_value_t *it,
+                       nanocbor_query_cb_t cb, void *ctx)
+{
+    nanocbor_value_t values[NANOCBOR_QUERY_SELECT_MAX];
+
+    int res = _query_check(query);
+    if (res < 0) {
+        return res;
+    }
+    while (!nanocbor_at_end(it)) {
+        nanocbor_value_t record = *it;
+        const uint8_t *start = NULL;
+        size_t len = 0;
+
+        res = nanocbor_get_subcbor(it, &start, &len);
+        if (res < 0) {
+            return res;
+        }
+        if (!nanocbor_query_match(query, &record)) {
+            continue;
+        }
+        for (size_t i = 0; i < query->num_aggs; i++) {
+            _agg_update(&query->aggs[i], &record);
+        }
+        if (!cb) {
+            continue;
+        }
+        for (size_t i = 0; i < query->num_select; i++) {
+            if (nanocbor_query_path(&record, query->select[i], &values[i])
+                < 0) {
+                nanocbor_decoder_init(&values[i], NULL, 0);
+            }
+        }
+        res = cb(ctx, start, len, values, query->num_select);
+        if (res < 0) {
+            return res;
+        }
+    }
+    return NANOCBOR_OK;
+}
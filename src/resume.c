@@ -0,0 +1,107 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @ingroup nanocbor_resume
+ * @{
+ * @file
+ * @brief   Resumable decoding implementation
+ * @}
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "nanocbor/config.h"
+#include "nanocbor/nanocbor.h"
+#include "nanocbor/resume.h"
+
+void nanocbor_resume_init(nanocbor_resume_t *state, nanocbor_value_t *it,
+                          nanocbor_resume_visit_t visit, void *ctx)
+{
+    state->it = it;
+    state->depth = 0;
+    state->visit = visit;
+    state->ctx = ctx;
+}
+
+/* Decoder of the container at a depth, the caller's decoder at the top */
+static nanocbor_value_t *_level(nanocbor_resume_t *state, unsigned depth)
+{
+    return depth == 0 ? state->it : &state->stack[depth - 1];
+}
+
+/* Leaves all containers without remaining items */
+static int _unwind(nanocbor_resume_t *state)
+{
+    while (state->depth > 0) {
+        nanocbor_value_t *container = _level(state, state->depth);
+        if (!nanocbor_at_end(container)) {
+            break;
+        }
+        int res = nanocbor_leave_container_early(
+            _level(state, state->depth - 1U), container);
+        if (res < 0) {
+            return res;
+        }
+        state->depth--;
+    }
+    return NANOCBOR_OK;
+}
+
+static int _step(nanocbor_resume_t *state, nanocbor_value_t *it)
+{
+    int type = nanocbor_get_type(it);
+
+    if (type == NANOCBOR_TYPE_TAG) {
+        uint64_t tag = 0;
+        return nanocbor_get_tag64(it, &tag);
+    }
+    if (type == NANOCBOR_TYPE_ARR || type == NANOCBOR_TYPE_MAP) {
+        if (state->depth == NANOCBOR_RECURSION_MAX) {
+            return NANOCBOR_ERR_RECURSION;
+        }
+        nanocbor_value_t *container = &state->stack[state->depth];
+        int res = type == NANOCBOR_TYPE_MAP
+            ? nanocbor_enter_map(it, container)
+            : nanocbor_enter_array(it, container);
+        if (res < 0) {
+            return res;
+        }
+        state->depth++;
+        return _unwind(state);
+    }
+    if (type < 0) {
+        return type;
+    }
+    if (state->visit) {
+        int res = state->visit(state->ctx, it, state->depth);
+        if (res < 0) {
+            return res;
+        }
+    }
+    int res = nanocbor_skip_simple(it);
+    if (res < 0) {
+        return res;
+    }
+    return _unwind(state);
+}
+
+int nanocbor_resume_run(nanocbor_resume_t *state, uint32_t budget)
+{
+    for (; budget > 0; budget--) {
+        nanocbor_value_t *it = _level(state, state->depth);
+        /* A tag is decoded together with the item following it */
+        bool tag = nanocbor_get_type(it) == NANOCBOR_TYPE_TAG;
+        int res = _step(state, it);
+        if (res < 0) {
+            return res;
+        }
+        if (state->depth == 0 && !tag) {
+            return NANOCBOR_OK;
+        }
+    }
+    return NANOCBOR_RESUME_YIELD;
+}
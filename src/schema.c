@@ -0,0 +1,1005 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @ingroup nanocbor_schema
+ * @{
+ * @file
+ * @brief   CDDL schema compiler and validator implementation
+ *
+ * The program is a tree of nodes stored in prefix order. Every node starts
+ * with a one byte opcode and the big endian 16 bit length of the node
+ * including this header, allowing a node to be skipped without decoding it.
+ *
+ * - Type nodes have no payload
+ * - `OP_LIT_INT` holds the big endian int64_t value
+ * - `OP_LIT_TSTR` holds the string bytes
+ * - `OP_TAG` holds the big endian tag number followed by the tagged node
+ * - `OP_CHOICE` holds the alternative nodes
+ * - `OP_ARRAY` holds entries of an occurrence byte followed by a node
+ * - `OP_MAP` holds entries of an occurrence byte, a key node and a value node
+ * @}
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "nanocbor/config.h"
+#include "nanocbor/nanocbor.h"
+#include "nanocbor/schema.h"
+
+#define NODE_HDR (3U) /**< Opcode and length */
+#define NODE_LEN_MAX (UINT16_MAX)
+#define LIT_INT_LEN (NODE_HDR + sizeof(uint64_t))
+#define MAP_ENTRIES_MAX (32U) /**< Limited by the bitmask of seen entries */
+/* A nesting level of a schema can take both a rule reference and a type */
+#define COMPILE_DEPTH_MAX (2U * NANOCBOR_RECURSION_MAX)
+
+enum {
+    OP_ANY = 0x01,
+    OP_UINT,
+    OP_NINT,
+    OP_INT,
+    OP_BSTR,
+    OP_TSTR,
+    OP_BOOL,
+    OP_TRUE,
+    OP_FALSE,
+    OP_NULL,
+    OP_UNDEF,
+    OP_FLOAT,
+    OP_LIT_INT = 0x20,
+    OP_LIT_TSTR,
+    OP_TAG = 0x30,
+    OP_CHOICE,
+    OP_ARRAY,
+    OP_MAP,
+};
+
+enum {
+    OCC_ONE = 0,
+    OCC_OPT,
+    OCC_STAR,
+    OCC_PLUS,
+};
+
+static size_t _node_len(const uint8_t *node)
+{
+    return ((size_t)node[1] << 8U) | node[2];
+}
+
+static const uint8_t *_node_end(const uint8_t *node)
+{
+    return node + _node_len(node);
+}
+
+/* Check that the node header and content are within the parent */
+static bool _node_valid(const uint8_t *node, const uint8_t *end)
+{
+    if (node >= end || (size_t)(end - node) < NODE_HDR) {
+        return false;
+    }
+    size_t len = _node_len(node);
+    if (len < NODE_HDR || len > (size_t)(end - node)) {
+        return false;
+    }
+    if (node[0] == OP_LIT_INT) {
+        return len == LIT_INT_LEN;
+    }
+    if (node[0] == OP_TAG) {
+        return len >= LIT_INT_LEN + NODE_HDR;
+    }
+    return true;
+}
+
+static uint64_t _read_u64(const uint8_t *buf)
+{
+    uint64_t res = 0;
+    for (unsigned i = 0; i < sizeof(uint64_t); i++) {
+        res = (res << 8U) | buf[i];
+    }
+    return res;
+}
+
+/* Match the item against a node without nested validation, advances @p it on
+ * success */
+static int _match_scalar(nanocbor_value_t *it, const uint8_t *node)
+{
+    int type = nanocbor_get_type(it);
+    int res = NANOCBOR_ERR_INVALID_TYPE;
+    bool bval = false;
+    double dval = 0;
+
+    if (type < 0) {
+        return type;
+    }
+
+    switch (node[0]) {
+    case OP_ANY:
+        return nanocbor_skip(it);
+    case OP_UINT:
+    case OP_NINT:
+    case OP_INT:
+        if ((type == NANOCBOR_TYPE_UINT && node[0] != OP_NINT)
+            || (type == NANOCBOR_TYPE_NINT && node[0] != OP_UINT)) {
+            res = nanocbor_skip_simple(it);
+        }
+        break;
+    case OP_BSTR:
+    case OP_TSTR:
+        if ((type == NANOCBOR_TYPE_BSTR && node[0] == OP_BSTR)
+            || (type == NANOCBOR_TYPE_TSTR && node[0] == OP_TSTR)) {
+            res = nanocbor_skip_simple(it);
+        }
+        break;
+    case OP_BOOL:
+        res = nanocbor_get_bool(it, &bval);
+        break;
+    case OP_TRUE:
+    case OP_FALSE:
+        res = nanocbor_get_bool(it, &bval);
+        if (res >= 0 && bval != (node[0] == OP_TRUE)) {
+            res = NANOCBOR_ERR_INVALID_TYPE;
+        }
+        break;
+    case OP_NULL:
+        res = nanocbor_get_null(it);
+        break;
+    case OP_UNDEF:
+        res = nanocbor_get_undefined(it);
+        break;
+    case OP_FLOAT:
+        res = nanocbor_get_double(it, &dval);
+        break;
+    case OP_LIT_INT: {
+        int64_t ival = 0;
+        res = nanocbor_get_int64(it, &ival);
+        if (res >= 0 && (uint64_t)ival != _read_u64(node + NODE_HDR)) {
+            res = NANOCBOR_ERR_INVALID_TYPE;
+        }
+        break;
+    }
+    case OP_LIT_TSTR: {
+        const uint8_t *str = NULL;
+        size_t len = 0;
+        res = nanocbor_get_tstr(it, &str, &len);
+        if (res >= 0
+            && (len != _node_len(node) - NODE_HDR
+                || memcmp(str, node + NODE_HDR, len) != 0)) {
+            res = NANOCBOR_ERR_INVALID_TYPE;
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    return res < 0 ? res : NANOCBOR_OK;
+}
+
+/* Check whether the item could match the node: scalars must match
+ * completely, containers and tags must have the same type */
+/* NOLINTNEXTLINE(misc-no-recursion): Only one level, choices are flat */
+static bool _starts(const nanocbor_value_t *it, const uint8_t *node)
+{
+    nanocbor_value_t tmp = *it;
+    uint64_t tag = 0;
+    const uint8_t *end = _node_end(node);
+
+    switch (node[0]) {
+    case OP_ARRAY:
+        return nanocbor_get_type(it) == NANOCBOR_TYPE_ARR;
+    case OP_MAP:
+        return nanocbor_get_type(it) == NANOCBOR_TYPE_MAP;
+    case OP_TAG:
+        return nanocbor_get_tag64(&tmp, &tag) == NANOCBOR_OK
+            && tag == _read_u64(node + NODE_HDR);
+    case OP_CHOICE:
+        /* Nested choices are flattened by the compiler */
+        for (const uint8_t *alt = node + NODE_HDR; _node_valid(alt, end);
+             alt = _node_end(alt)) {
+            if (alt[0] != OP_CHOICE && _starts(it, alt)) {
+                return true;
+            }
+        }
+        return false;
+    default:
+        return _match_scalar(&tmp, node) == NANOCBOR_OK;
+    }
+}
+
+/* Resolve choices and tags until a type, array or map node remains */
+static int _resolve(nanocbor_value_t *it, const uint8_t **node)
+{
+    while ((*node)[0] == OP_CHOICE || (*node)[0] == OP_TAG) {
+        const uint8_t *end = _node_end(*node);
+        const uint8_t *next = NULL;
+
+        if ((*node)[0] == OP_TAG) {
+            uint64_t tag = 0;
+            if (nanocbor_get_tag64(it, &tag) < 0
+                || tag != _read_u64(*node + NODE_HDR)) {
+                return NANOCBOR_ERR_INVALID_TYPE;
+            }
+            next = *node + LIT_INT_LEN;
+            if (!_node_valid(next, end)) {
+                return NANOCBOR_ERR_INVALID_TYPE;
+            }
+        }
+        else {
+            for (const uint8_t *alt = *node + NODE_HDR; _node_valid(alt, end);
+                 alt = _node_end(alt)) {
+                if (alt[0] != OP_CHOICE && _starts(it, alt)) {
+                    next = alt;
+                    break;
+                }
+            }
+            if (!next) {
+                return NANOCBOR_ERR_INVALID_TYPE;
+            }
+        }
+        *node = next;
+    }
+    return NANOCBOR_OK;
+}
+
+typedef struct {
+    nanocbor_value_t it; /**< Iterator inside the container */
+    const uint8_t *entry; /**< Current array entry or first map entry */
+    const uint8_t *end; /**< End of the container node */
+    uint32_t state; /**< Array: matches of the entry, map: entries seen */
+    bool map; /**< Container is a map */
+} _frame_t;
+
+static int _step_array(_frame_t *frame, const uint8_t **node)
+{
+    while (true) {
+        bool at_end = nanocbor_at_end(&frame->it);
+        if (at_end && nanocbor_container_truncated(&frame->it)) {
+            return NANOCBOR_ERR_END;
+        }
+        if (frame->entry == frame->end) {
+            if (!at_end) {
+                /* More items than entries */
+                return NANOCBOR_ERR_INVALID_TYPE;
+            }
+            *node = NULL;
+            return NANOCBOR_OK;
+        }
+        const uint8_t *child = frame->entry + 1;
+        if (!_node_valid(child, frame->end)) {
+            return NANOCBOR_ERR_INVALID_TYPE;
+        }
+        uint8_t occ = frame->entry[0];
+
+        if (!at_end && (occ == OCC_ONE || _starts(&frame->it, child))) {
+            frame->state++;
+            if (occ == OCC_ONE || occ == OCC_OPT) {
+                frame->entry = _node_end(child);
+                frame->state = 0;
+            }
+            *node = child;
+            return NANOCBOR_OK;
+        }
+        if (occ == OCC_ONE || (occ == OCC_PLUS && frame->state == 0)) {
+            return NANOCBOR_ERR_INVALID_TYPE;
+        }
+        frame->entry = _node_end(child);
+        frame->state = 0;
+    }
+}
+
+static int _match_key(nanocbor_value_t *it, const uint8_t *node)
+{
+    if (node[0] == OP_CHOICE) {
+        nanocbor_value_t tmp = *it;
+        return _resolve(&tmp, &node) == NANOCBOR_OK
+            ? _match_scalar(it, node)
+            : NANOCBOR_ERR_INVALID_TYPE;
+    }
+    return _match_scalar(it, node);
+}
+
+/* Retrieve the key and value node of a map entry */
+static bool _map_entry(const uint8_t *entry, const uint8_t *end,
+                       const uint8_t **key, const uint8_t **value)
+{
+    *key = entry + 1;
+    if (!_node_valid(*key, end)) {
+        return false;
+    }
+    *value = _node_end(*key);
+    return _node_valid(*value, end);
+}
+
+static int _step_map(_frame_t *frame, const uint8_t **node)
+{
+    const uint8_t *entry = frame->entry;
+    const uint8_t *key = NULL;
+    const uint8_t *value = NULL;
+
+    if (nanocbor_at_end(&frame->it)) {
+        if (nanocbor_container_truncated(&frame->it)) {
+            return NANOCBOR_ERR_END;
+        }
+        for (unsigned i = 0; entry < frame->end; i++) {
+            if (!_map_entry(entry, frame->end, &key, &value)) {
+                return NANOCBOR_ERR_INVALID_TYPE;
+            }
+            if ((entry[0] == OCC_ONE || entry[0] == OCC_PLUS)
+                && !(frame->state & (1UL << i))) {
+                return NANOCBOR_NOT_FOUND;
+            }
+            entry = _node_end(value);
+        }
+        *node = NULL;
+        return NANOCBOR_OK;
+    }
+
+    for (unsigned i = 0; entry < frame->end; i++) {
+        if (!_map_entry(entry, frame->end, &key, &value)) {
+            return NANOCBOR_ERR_INVALID_TYPE;
+        }
+        nanocbor_value_t tmp = frame->it;
+        if (_match_key(&tmp, key) == NANOCBOR_OK) {
+            frame->it = tmp;
+            frame->state |= 1UL << i;
+            *node = value;
+            return NANOCBOR_OK;
+        }
+        entry = _node_end(value);
+    }
+    /* Key not described by the schema */
+    return NANOCBOR_ERR_INVALID_TYPE;
+}
+
+int nanocbor_schema_validate(const uint8_t *prog, size_t prog_len,
+                             nanocbor_value_t *it)
+{
+    _frame_t stack[NANOCBOR_RECURSION_MAX];
+    unsigned depth = 0;
+    nanocbor_value_t *cur = it;
+    const uint8_t *node = prog;
+
+    if (!_node_valid(prog, prog + prog_len)) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+
+    while (true) {
+        if (node) {
+            int res = _resolve(cur, &node);
+            if (res < 0) {
+                return res;
+            }
+            if (node[0] == OP_ARRAY || node[0] == OP_MAP) {
+                if (depth == NANOCBOR_RECURSION_MAX) {
+                    return NANOCBOR_ERR_RECURSION;
+                }
+                _frame_t *frame = &stack[depth];
+                res = node[0] == OP_MAP ? nanocbor_enter_map(cur, &frame->it)
+                                        : nanocbor_enter_array(cur, &frame->it);
+                if (res < 0) {
+                    return res;
+                }
+                frame->entry = node + NODE_HDR;
+                frame->end = _node_end(node);
+                frame->state = 0;
+                frame->map = node[0] == OP_MAP;
+                depth++;
+            }
+            else {
+                res = _match_scalar(cur, node);
+                if (res < 0) {
+                    return res;
+                }
+            }
+            node = NULL;
+        }
+        if (depth == 0) {
+            return NANOCBOR_OK;
+        }
+
+        _frame_t *frame = &stack[depth - 1];
+        int res = frame->map ? _step_map(frame, &node)
+                             : _step_array(frame, &node);
+        if (res < 0) {
+            return res;
+        }
+        if (node) {
+            cur = &frame->it;
+        }
+        else {
+            nanocbor_value_t *parent = depth > 1 ? &stack[depth - 2].it : it;
+            nanocbor_leave_container(parent, &frame->it);
+            depth--;
+        }
+    }
+}
+
+/* Compiler */
+
+typedef struct {
+    const char *name;
+    size_t name_len;
+    const char *type; /**< Start of the type expression */
+} _rule_t;
+
+typedef struct {
+    const char *cur;
+    const char *end;
+    uint8_t *buf;
+    size_t cap;
+    size_t pos;
+    size_t max; /**< Highest position written, the required buffer size */
+    unsigned depth;
+    size_t num_rules;
+    _rule_t rules[NANOCBOR_SCHEMA_RULES_MAX];
+} _compiler_t;
+
+typedef struct {
+    const char *name;
+    uint8_t op;
+} _prelude_t;
+
+static const _prelude_t _prelude[] = {
+    { "any", OP_ANY },         { "uint", OP_UINT },
+    { "nint", OP_NINT },       { "int", OP_INT },
+    { "bstr", OP_BSTR },       { "bytes", OP_BSTR },
+    { "tstr", OP_TSTR },       { "text", OP_TSTR },
+    { "bool", OP_BOOL },       { "true", OP_TRUE },
+    { "false", OP_FALSE },     { "null", OP_NULL },
+    { "nil", OP_NULL },        { "undefined", OP_UNDEF },
+    { "float", OP_FLOAT },     { "float16", OP_FLOAT },
+    { "float32", OP_FLOAT },   { "float64", OP_FLOAT },
+    { "float16-32", OP_FLOAT }, { "float32-64", OP_FLOAT },
+};
+
+static bool _is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static bool _is_id_start(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_'
+        || c == '@' || c == '$';
+}
+
+static bool _is_id_char(char c)
+{
+    return _is_id_start(c) || _is_digit(c) || c == '-' || c == '.';
+}
+
+static char _peek(_compiler_t *c)
+{
+    while (c->cur < c->end) {
+        if (*c->cur == ';') {
+            while (c->cur < c->end && *c->cur != '\n') {
+                c->cur++;
+            }
+        }
+        else if (*c->cur == ' ' || *c->cur == '\t' || *c->cur == '\n'
+                 || *c->cur == '\r') {
+            c->cur++;
+        }
+        else {
+            return *c->cur;
+        }
+    }
+    return '\0';
+}
+
+/* Peek at the character after the next one */
+static char _peek2(_compiler_t *c)
+{
+    return (_peek(c) && c->cur + 1 < c->end) ? c->cur[1] : '\0';
+}
+
+static bool _accept(_compiler_t *c, char chr)
+{
+    if (_peek(c) == chr && chr) {
+        c->cur++;
+        return true;
+    }
+    return false;
+}
+
+static size_t _ident(_compiler_t *c, const char **name)
+{
+    *name = NULL;
+    if (!_is_id_start(_peek(c))) {
+        return 0;
+    }
+    *name = c->cur;
+    while (c->cur < c->end && _is_id_char(*c->cur)) {
+        c->cur++;
+    }
+    /* Identifiers can't end with a '-' or '.' */
+    while (c->cur[-1] == '-' || c->cur[-1] == '.') {
+        c->cur--;
+    }
+    return (size_t)(c->cur - *name);
+}
+
+static int _number(_compiler_t *c, int64_t *num)
+{
+    bool negative = _accept(c, '-');
+    uint64_t res = 0;
+    unsigned base = 10;
+
+    if (c->cur + 1 < c->end && c->cur[0] == '0'
+        && (c->cur[1] == 'x' || c->cur[1] == 'X')) {
+        base = 16;
+        c->cur += 2;
+    }
+    const char *start = c->cur;
+    while (c->cur < c->end) {
+        char chr = *c->cur;
+        unsigned digit = 0;
+        if (_is_digit(chr)) {
+            digit = (unsigned)(chr - '0');
+        }
+        else if (base == 16 && chr >= 'a' && chr <= 'f') {
+            digit = (unsigned)(chr - 'a' + 10);
+        }
+        else if (base == 16 && chr >= 'A' && chr <= 'F') {
+            digit = (unsigned)(chr - 'A' + 10);
+        }
+        else {
+            break;
+        }
+        if (res > (UINT64_MAX - digit) / base) {
+            return NANOCBOR_ERR_OVERFLOW;
+        }
+        res = res * base + digit;
+        c->cur++;
+    }
+    if (c->cur == start) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    if (res > (uint64_t)INT64_MAX + (negative ? 1U : 0U)) {
+        return NANOCBOR_ERR_OVERFLOW;
+    }
+    *num = negative ? (int64_t)(0 - res) : (int64_t)res;
+    return NANOCBOR_OK;
+}
+
+static void _emit(_compiler_t *c, uint8_t byte)
+{
+    if (c->pos < c->cap) {
+        c->buf[c->pos] = byte;
+    }
+    c->pos++;
+    if (c->pos > c->max) {
+        c->max = c->pos;
+    }
+}
+
+/* Remove a node header, only valid while the buffer never overflowed */
+static void _drop_hdr(_compiler_t *c, size_t start)
+{
+    if (c->max <= c->cap) {
+        memmove(c->buf + start, c->buf + start + NODE_HDR,
+                c->pos - start - NODE_HDR);
+    }
+    c->pos -= NODE_HDR;
+}
+
+static void _emit_u64(_compiler_t *c, uint64_t val)
+{
+    for (unsigned i = sizeof(uint64_t); i > 0; i--) {
+        _emit(c, (uint8_t)(val >> ((i - 1) * 8U)));
+    }
+}
+
+static size_t _emit_hdr(_compiler_t *c, uint8_t op)
+{
+    size_t start = c->pos;
+    _emit(c, op);
+    _emit(c, 0);
+    _emit(c, 0);
+    return start;
+}
+
+static int _patch(_compiler_t *c, size_t start)
+{
+    size_t len = c->pos - start;
+    if (len > NODE_LEN_MAX) {
+        return NANOCBOR_ERR_OVERFLOW;
+    }
+    if (start + NODE_HDR <= c->cap) {
+        c->buf[start + 1] = (uint8_t)(len >> 8U);
+        c->buf[start + 2] = (uint8_t)len;
+    }
+    return NANOCBOR_OK;
+}
+
+static int _emit_tstr(_compiler_t *c, const char *str, size_t len)
+{
+    size_t start = _emit_hdr(c, OP_LIT_TSTR);
+    for (size_t i = 0; i < len; i++) {
+        _emit(c, (uint8_t)str[i]);
+    }
+    return _patch(c, start);
+}
+
+static int _text(_compiler_t *c)
+{
+    c->cur++; /* Opening quote */
+    const char *start = c->cur;
+    while (c->cur < c->end && *c->cur != '"') {
+        /* Escapes are not supported */
+        if (*c->cur == '\\') {
+            return NANOCBOR_ERR_INVALID_TYPE;
+        }
+        c->cur++;
+    }
+    if (c->cur == c->end) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    c->cur++; /* Closing quote */
+    return _emit_tstr(c, start, (size_t)(c->cur - start - 1));
+}
+
+static int _compile_type(_compiler_t *c, unsigned *alts);
+
+static int _compile_literal_int(_compiler_t *c)
+{
+    int64_t num = 0;
+    int res = _number(c, &num);
+    if (res == NANOCBOR_OK) {
+        size_t start = _emit_hdr(c, OP_LIT_INT);
+        _emit_u64(c, (uint64_t)num);
+        res = _patch(c, start);
+    }
+    return res;
+}
+
+/* NOLINTNEXTLINE(misc-no-recursion): Recursion is limited by design */
+static int _compile_rule_ref(_compiler_t *c, const char *name, size_t len,
+                             unsigned *alts)
+{
+    for (size_t i = 0; i < sizeof(_prelude) / sizeof(_prelude[0]); i++) {
+        if (strlen(_prelude[i].name) == len
+            && memcmp(_prelude[i].name, name, len) == 0) {
+            size_t start = _emit_hdr(c, _prelude[i].op);
+            return _patch(c, start);
+        }
+    }
+    for (size_t i = 0; i < c->num_rules; i++) {
+        if (c->rules[i].name_len == len
+            && memcmp(c->rules[i].name, name, len) == 0) {
+            /* Rules are expanded in place */
+            const char *cur = c->cur;
+            c->cur = c->rules[i].type;
+            int res = _compile_type(c, alts);
+            c->cur = cur;
+            return res;
+        }
+    }
+    return NANOCBOR_NOT_FOUND;
+}
+
+/* NOLINTNEXTLINE(misc-no-recursion): Recursion is limited by design */
+static int _compile_tag(_compiler_t *c)
+{
+    int64_t tag = 0;
+    /* Only major type 6 is supported */
+    if (!_accept(c, '#') || c->end - c->cur < 2 || c->cur[0] != '6'
+        || c->cur[1] != '.') {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    c->cur += 2;
+    if (_number(c, &tag) < 0 || tag < 0 || !_accept(c, '(')) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    size_t start = _emit_hdr(c, OP_TAG);
+    _emit_u64(c, (uint64_t)tag);
+    int res = _compile_type(c, NULL);
+    if (res < 0) {
+        return res;
+    }
+    if (!_accept(c, ')')) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    return _patch(c, start);
+}
+
+static int _compile_group(_compiler_t *c, bool map, char close);
+
+/* Compile a single type, @p alts is set to the number of alternatives when
+ * a rule reference or parenthesized type results in a choice */
+/* NOLINTNEXTLINE(misc-no-recursion): Recursion is limited by design */
+static int _compile_type1(_compiler_t *c, unsigned *alts)
+{
+    char chr = _peek(c);
+    int res = NANOCBOR_ERR_INVALID_TYPE;
+
+    *alts = 1;
+    if (chr == '[' || chr == '{') {
+        c->cur++;
+        size_t start = _emit_hdr(c, chr == '[' ? OP_ARRAY : OP_MAP);
+        res = _compile_group(c, chr == '{', chr == '[' ? ']' : '}');
+        if (res == NANOCBOR_OK) {
+            res = _patch(c, start);
+        }
+    }
+    else if (chr == '(') {
+        c->cur++;
+        res = _compile_type(c, alts);
+        if (res == NANOCBOR_OK && !_accept(c, ')')) {
+            res = NANOCBOR_ERR_INVALID_TYPE;
+        }
+    }
+    else if (chr == '"') {
+        res = _text(c);
+    }
+    else if (chr == '-' || _is_digit(chr)) {
+        res = _compile_literal_int(c);
+    }
+    else if (chr == '#') {
+        res = _compile_tag(c);
+    }
+    else {
+        const char *name = NULL;
+        size_t len = _ident(c, &name);
+        if (len) {
+            res = _compile_rule_ref(c, name, len, alts);
+        }
+    }
+    return res;
+}
+
+/* Compile the alternatives of a type into the choice node at @p start, of
+ * which the first @p count are already compiled. A single alternative is
+ * emitted as is. @p alts, if not NULL, is set to the number of alternatives */
+/* NOLINTNEXTLINE(misc-no-recursion): Recursion is limited by design */
+static int _compile_alts(_compiler_t *c, size_t start, unsigned count,
+                         unsigned *alts)
+{
+    int res = NANOCBOR_OK;
+
+    while (count == 0 || _accept(c, '/')) {
+        /* Group choices are not supported */
+        if (_peek(c) == '/') {
+            return NANOCBOR_ERR_INVALID_TYPE;
+        }
+        size_t alt = c->pos;
+        unsigned nested = 0;
+        res = _compile_type1(c, &nested);
+        if (res < 0) {
+            return res;
+        }
+        /* Flatten nested choices */
+        if (nested > 1) {
+            _drop_hdr(c, alt);
+        }
+        count += nested;
+    }
+    if (count == 1) {
+        _drop_hdr(c, start);
+    }
+    else {
+        res = _patch(c, start);
+    }
+    if (alts) {
+        *alts = count;
+    }
+    return res;
+}
+
+/* Compile a type with choices, multiple alternatives are wrapped in a flat
+ * choice node. @p alts, if not NULL, is set to the number of alternatives */
+/* NOLINTNEXTLINE(misc-no-recursion): Recursion is limited by design */
+static int _compile_type(_compiler_t *c, unsigned *alts)
+{
+    if (c->depth >= COMPILE_DEPTH_MAX) {
+        return NANOCBOR_ERR_RECURSION;
+    }
+    c->depth++;
+    size_t start = _emit_hdr(c, OP_CHOICE);
+    int res = _compile_alts(c, start, 0, alts);
+    c->depth--;
+    return res;
+}
+
+/* Compile a group member with its key if one is present. The type following
+ * the occurrence is compiled once, it is the key when followed by ':' or
+ * '=>' and the first alternative of the member type otherwise. Keys of array
+ * members are only documentation and dropped */
+/* NOLINTNEXTLINE(misc-no-recursion): Recursion is limited by design */
+static int _compile_member(_compiler_t *c, bool map, bool *has_key)
+{
+    const char *cur = c->cur;
+    const char *name = NULL;
+    size_t len = _ident(c, &name);
+
+    *has_key = true;
+    /* Bareword key */
+    if (len && _peek(c) == ':') {
+        c->cur++;
+        if (map) {
+            int res = _emit_tstr(c, name, len);
+            if (res < 0) {
+                return res;
+            }
+        }
+        return _compile_type(c, NULL);
+    }
+    c->cur = cur;
+
+    if (c->depth >= COMPILE_DEPTH_MAX) {
+        return NANOCBOR_ERR_RECURSION;
+    }
+    c->depth++;
+    char chr = _peek(c);
+    size_t start = _emit_hdr(c, OP_CHOICE);
+    size_t first = c->pos;
+    unsigned nested = 0;
+    int res = _compile_type1(c, &nested);
+    c->depth--;
+    bool key = false;
+    if (res == NANOCBOR_OK) {
+        /* Literal key followed by ':' or any type followed by '=>' */
+        key = (chr == '"' || chr == '-' || _is_digit(chr)) && _accept(c, ':');
+        if (!key && _peek(c) == '=' && _peek2(c) == '>') {
+            c->cur += 2;
+            key = true;
+        }
+    }
+    if (res == NANOCBOR_OK && key) {
+        if (map) {
+            _drop_hdr(c, start);
+        }
+        else {
+            c->pos = start;
+        }
+        res = _compile_type(c, NULL);
+    }
+    else if (res == NANOCBOR_OK) {
+        *has_key = false;
+        if (nested > 1) {
+            _drop_hdr(c, first);
+        }
+        c->depth++;
+        res = _compile_alts(c, start, nested, NULL);
+        c->depth--;
+    }
+    return res;
+}
+
+/* NOLINTNEXTLINE(misc-no-recursion): Recursion is limited by design */
+static int _compile_group(_compiler_t *c, bool map, char close)
+{
+    unsigned entries = 0;
+
+    while (!_accept(c, close)) {
+        if (_peek(c) == '\0') {
+            return NANOCBOR_ERR_INVALID_TYPE;
+        }
+        uint8_t occ = OCC_ONE;
+        if (_accept(c, '?')) {
+            occ = OCC_OPT;
+        }
+        else if (_accept(c, '*')) {
+            occ = OCC_STAR;
+        }
+        else if (_accept(c, '+')) {
+            occ = OCC_PLUS;
+        }
+        _emit(c, occ);
+
+        bool has_key = false;
+        int res = _compile_member(c, map, &has_key);
+        if (res < 0) {
+            return res;
+        }
+        if (map && !has_key) {
+            return NANOCBOR_ERR_INVALID_TYPE;
+        }
+        entries++;
+        if (map && entries > MAP_ENTRIES_MAX) {
+            return NANOCBOR_ERR_OVERFLOW;
+        }
+        _accept(c, ',');
+    }
+    return NANOCBOR_OK;
+}
+
+/* Skip over a rule definition to find the start of the next rule */
+static void _skip_rule(_compiler_t *c)
+{
+    unsigned nesting = 0;
+
+    while (_peek(c)) {
+        char chr = *c->cur;
+        if (chr == '"') {
+            c->cur++;
+            while (c->cur < c->end && *c->cur != '"') {
+                c->cur++;
+            }
+            c->cur += c->cur < c->end ? 1 : 0;
+        }
+        else if (chr == '[' || chr == '{' || chr == '(') {
+            nesting++;
+            c->cur++;
+        }
+        else if (chr == ']' || chr == '}' || chr == ')') {
+            nesting -= nesting ? 1 : 0;
+            c->cur++;
+        }
+        else if (_is_id_start(chr)) {
+            const char *start = c->cur;
+            const char *name = NULL;
+            _ident(c, &name);
+            if (nesting == 0 && _peek(c) == '=' && _peek2(c) != '>') {
+                c->cur = start;
+                return;
+            }
+        }
+        else {
+            c->cur++;
+        }
+    }
+}
+
+static int _collect_rules(_compiler_t *c)
+{
+    while (_peek(c)) {
+        const char *name = NULL;
+        size_t len = _ident(c, &name);
+        if (!len || !_accept(c, '=')) {
+            return NANOCBOR_ERR_INVALID_TYPE;
+        }
+        if (c->num_rules == NANOCBOR_SCHEMA_RULES_MAX) {
+            return NANOCBOR_ERR_OVERFLOW;
+        }
+        _rule_t *rule = &c->rules[c->num_rules++];
+        rule->name = name;
+        rule->name_len = len;
+        rule->type = c->cur;
+        _skip_rule(c);
+    }
+    return c->num_rules ? NANOCBOR_OK : NANOCBOR_ERR_INVALID_TYPE;
+}
+
+int nanocbor_schema_compile(uint8_t *buf, size_t *len, const char *cddl,
+                            size_t cddl_len)
+{
+    _compiler_t c = {
+        .cur = cddl,
+        .end = cddl + cddl_len,
+        .buf = buf,
+        .cap = buf ? *len : 0,
+    };
+
+    int res = _collect_rules(&c);
+    if (res < 0) {
+        return res;
+    }
+    c.cur = c.rules[0].type;
+    res = _compile_type(&c, NULL);
+    if (res < 0) {
+        return res;
+    }
+    /* The root rule must be followed by the next rule or the end */
+    const char *end = c.cur;
+    c.cur = c.rules[0].type;
+    _skip_rule(&c);
+    _peek(&c);
+    const char *rule_end = c.cur;
+    c.cur = end;
+    _peek(&c);
+    if (c.cur != rule_end) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+
+    if (c.max > c.cap) {
+        *len = c.max;
+        return NANOCBOR_ERR_END;
+    }
+    *len = c.pos;
+    return NANOCBOR_OK;
+}
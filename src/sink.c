@@ -0,0 +1,258 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @ingroup nanocbor_sink
+ * @{
+ * @file
+ * @brief   Double-buffered encoder sink implementation
+ *
+ * The buffer at index `fill` is filled by the encoder, `busy` tells whether
+ * the other buffer is being written. A full buffer is only submitted once
+ * the other buffer is no longer busy, after which the buffers swap roles.
+ * The completing context stores the write result in `status` before
+ * clearing `busy` with release ordering, the encoder reads `status` after
+ * observing a cleared `busy` with acquire ordering. A failed write is picked
+ * up by the encoder at the next swap, keeping the flag out of the per item
+ * path.
+ *
+ * With an I/O thread, the encoder sleeps on a condition variable instead of
+ * spinning, and the I/O thread is handed the buffers under the lock.
+ * @}
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "nanocbor/config.h"
+#include "nanocbor/nanocbor.h"
+#include "nanocbor/sink.h"
+
+#if NANOCBOR_SINK
+
+static bool _is_busy(const nanocbor_sink_t *sink)
+{
+    return __atomic_load_n(&sink->busy, __ATOMIC_ACQUIRE);
+}
+
+static void _set_busy(nanocbor_sink_t *sink, bool busy)
+{
+    __atomic_store_n(&sink->busy, busy, __ATOMIC_RELEASE);
+}
+
+#if NANOCBOR_SINK_THREAD
+#include <pthread.h>
+
+static int _sync_init(nanocbor_sink_t *sink)
+{
+    if (pthread_mutex_init(&sink->lock, NULL) != 0) {
+        return NANOCBOR_ERR_OVERFLOW;
+    }
+    if (pthread_cond_init(&sink->cond, NULL) != 0) {
+        pthread_mutex_destroy(&sink->lock);
+        return NANOCBOR_ERR_OVERFLOW;
+    }
+    return NANOCBOR_OK;
+}
+
+static void _sync_destroy(nanocbor_sink_t *sink)
+{
+    pthread_cond_destroy(&sink->cond);
+    pthread_mutex_destroy(&sink->lock);
+}
+
+static void _thread_submit(nanocbor_sink_t *sink, void *ctx,
+                           const uint8_t *buf, size_t len)
+{
+    (void)ctx;
+    pthread_mutex_lock(&sink->lock);
+    sink->pending = buf;
+    sink->pending_len = len;
+    pthread_cond_broadcast(&sink->cond);
+    pthread_mutex_unlock(&sink->lock);
+}
+
+static void *_thread_main(void *arg)
+{
+    nanocbor_sink_t *sink = arg;
+
+    pthread_mutex_lock(&sink->lock);
+    while (true) {
+        while (!sink->pending && !sink->stop) {
+            pthread_cond_wait(&sink->cond, &sink->lock);
+        }
+        if (!sink->pending) {
+            break;
+        }
+        const uint8_t *buf = sink->pending;
+        size_t len = sink->pending_len;
+        sink->pending = NULL;
+        pthread_mutex_unlock(&sink->lock);
+        int res = sink->write(sink->ctx, buf, len);
+        nanocbor_sink_complete(sink, res);
+        pthread_mutex_lock(&sink->lock);
+    }
+    pthread_mutex_unlock(&sink->lock);
+    return NULL;
+}
+#endif
+
+/* Waits until no buffer is being written */
+static void _wait_idle(nanocbor_sink_t *sink)
+{
+#if NANOCBOR_SINK_THREAD
+    if (sink->threaded) {
+        pthread_mutex_lock(&sink->lock);
+        while (_is_busy(sink)) {
+            pthread_cond_wait(&sink->cond, &sink->lock);
+        }
+        pthread_mutex_unlock(&sink->lock);
+        return;
+    }
+#endif
+    while (_is_busy(sink)) {
+        /* Completed by an interrupt handler or another thread */
+    }
+}
+
+/* Submits the buffer being filled and swaps buffers */
+static int _swap(nanocbor_sink_t *sink)
+{
+    const uint8_t *buf = sink->bufs[sink->fill];
+    size_t len = sink->used;
+
+    _wait_idle(sink);
+    int status = sink->status;
+    sink->failed = status < 0;
+    if (status == NANOCBOR_OK && len > 0) {
+        sink->fill ^= 1U;
+        sink->used = 0;
+        _set_busy(sink, true);
+        sink->submit(sink, sink->ctx, buf, len);
+    }
+    return status;
+}
+
+static bool _sink_fits(nanocbor_encoder_t *enc, void *ctx, size_t len)
+{
+    const nanocbor_sink_t *sink = ctx;
+
+    (void)enc;
+    (void)len;
+    return !sink->failed;
+}
+
+static void _sink_append(nanocbor_encoder_t *enc, void *ctx,
+                         const uint8_t *data, size_t len)
+{
+    nanocbor_sink_t *sink = ctx;
+
+    (void)enc;
+    while (len > 0) {
+        if (sink->used == sink->size && _swap(sink) < 0) {
+            /* Data is dropped, the error is reported by the next call */
+            return;
+        }
+        size_t chunk = sink->size - sink->used;
+        if (chunk > len) {
+            chunk = len;
+        }
+        memcpy(sink->bufs[sink->fill] + sink->used, data, chunk);
+        sink->used += chunk;
+        data += chunk;
+        len -= chunk;
+    }
+}
+
+int nanocbor_sink_init(nanocbor_sink_t *sink, uint8_t *buf, size_t len,
+                       nanocbor_sink_submit submit, void *ctx)
+{
+    if (len < 2) {
+        return NANOCBOR_ERR_OVERFLOW;
+    }
+    memset(sink, 0, sizeof(*sink));
+    sink->size = len / 2;
+    sink->bufs[0] = buf;
+    sink->bufs[1] = buf + sink->size;
+    sink->submit = submit;
+    sink->ctx = ctx;
+    return NANOCBOR_OK;
+}
+
+#if NANOCBOR_SINK_THREAD
+int nanocbor_sink_init_thread(nanocbor_sink_t *sink, uint8_t *buf, size_t len,
+                              nanocbor_sink_write write, void *ctx)
+{
+    int res = nanocbor_sink_init(sink, buf, len, _thread_submit, ctx);
+
+    if (res < 0) {
+        return res;
+    }
+    res = _sync_init(sink);
+    if (res < 0) {
+        return res;
+    }
+    sink->write = write;
+    if (pthread_create(&sink->thread, NULL, _thread_main, sink) != 0) {
+        _sync_destroy(sink);
+        return NANOCBOR_ERR_OVERFLOW;
+    }
+    sink->threaded = true;
+    return NANOCBOR_OK;
+}
+#endif
+
+void nanocbor_sink_encoder_init(nanocbor_encoder_t *enc,
+                                nanocbor_sink_t *sink)
+{
+    nanocbor_encoder_stream_init(enc, sink, _sink_append, _sink_fits);
+}
+
+void nanocbor_sink_complete(nanocbor_sink_t *sink, int res)
+{
+    /* Only the completing context writes the status while busy */
+    if (res < 0 && sink->status == NANOCBOR_OK) {
+        sink->status = res;
+    }
+    _set_busy(sink, false);
+#if NANOCBOR_SINK_THREAD
+    if (sink->threaded) {
+        pthread_mutex_lock(&sink->lock);
+        pthread_cond_broadcast(&sink->cond);
+        pthread_mutex_unlock(&sink->lock);
+    }
+#endif
+}
+
+int nanocbor_sink_flush(nanocbor_sink_t *sink)
+{
+    int res = _swap(sink);
+
+    if (res < 0) {
+        return res;
+    }
+    _wait_idle(sink);
+    return sink->status;
+}
+
+int nanocbor_sink_close(nanocbor_sink_t *sink)
+{
+    int res = nanocbor_sink_flush(sink);
+
+#if NANOCBOR_SINK_THREAD
+    if (sink->threaded) {
+        pthread_mutex_lock(&sink->lock);
+        sink->stop = true;
+        pthread_cond_broadcast(&sink->cond);
+        pthread_mutex_unlock(&sink->lock);
+        pthread_join(sink->thread, NULL);
+        _sync_destroy(sink);
+    }
+#endif
+    return res;
+}
+
+#endif /* NANOCBOR_SINK */
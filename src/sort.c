@@ -0,0 +1,161 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @ingroup nanocbor_sort
+ * @{
+ * @file
+ * @brief   CBOR sequence sorting implementation
+ *
+ * The merge keeps the runs in a binary min-heap ordered by their head
+ * record, with the original run index as head sequence number.
+ * @}
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "nanocbor/nanocbor.h"
+#include "nanocbor/query.h"
+#include "nanocbor/sort.h"
+
+static bool _path_valid(const char *path)
+{
+    return *path == '\0' || *path == '/';
+}
+
+static int _read_entry(nanocbor_value_t *it, const char *path,
+                       nanocbor_sort_entry_t *entry, size_t seq)
+{
+    nanocbor_value_t record = *it;
+
+    int res = nanocbor_get_subcbor(it, &entry->record, &entry->len);
+    if (res < 0) {
+        return res;
+    }
+    if (nanocbor_query_path(&record, path, &entry->key) < 0) {
+        nanocbor_decoder_init(&entry->key, NULL, 0);
+    }
+    entry->seq = seq;
+    return NANOCBOR_OK;
+}
+
+static int _compare_entry(const nanocbor_sort_entry_t *a,
+                          const nanocbor_sort_entry_t *b)
+{
+    bool a_missing = nanocbor_at_end(&a->key);
+    bool b_missing = nanocbor_at_end(&b->key);
+    int cmp = 0;
+
+    if (a_missing || b_missing) {
+        cmp = b_missing - a_missing;
+    }
+    else {
+        cmp = nanocbor_compare(&a->key, &b->key);
+    }
+    if (cmp == 0) {
+        cmp = (a->seq > b->seq) - (a->seq < b->seq);
+    }
+    return cmp;
+}
+
+static int _qsort_cmp(const void *a, const void *b)
+{
+    return _compare_entry(a, b);
+}
+
+int nanocbor_sort_collect(nanocbor_value_t *it, const char *path,
+                          nanocbor_sort_entry_t *entries, size_t *num_entries)
+{
+    size_t count = 0;
+
+    if (!_path_valid(path)) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    while (count < *num_entries && !nanocbor_at_end(it)) {
+        int res = _read_entry(it, path, &entries[count], count);
+        if (res < 0) {
+            return res;
+        }
+        count++;
+    }
+    *num_entries = count;
+    return NANOCBOR_OK;
+}
+
+void nanocbor_sort_entries(nanocbor_sort_entry_t *entries, size_t num_entries)
+{
+    qsort(entries, num_entries, sizeof(*entries), _qsort_cmp);
+}
+
+static void _sift_down(nanocbor_sort_run_t *runs, size_t num_runs, size_t pos)
+{
+    for (;;) {
+        size_t min = pos;
+        size_t left = 2 * pos + 1;
+        size_t right = left + 1;
+
+        if (left < num_runs
+            && _compare_entry(&runs[left].head, &runs[min].head) < 0) {
+            min = left;
+        }
+        if (right < num_runs
+            && _compare_entry(&runs[right].head, &runs[min].head) < 0) {
+            min = right;
+        }
+        if (min == pos) {
+            return;
+        }
+        nanocbor_sort_run_t tmp = runs[pos];
+        runs[pos] = runs[min];
+        runs[min] = tmp;
+        pos = min;
+    }
+}
+
+int nanocbor_sort_merge(nanocbor_sort_run_t *runs, size_t num_runs,
+                        const char *path, nanocbor_sort_cb_t cb, void *ctx)
+{
+    size_t active = 0;
+
+    if (!_path_valid(path)) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    /* Drop empty runs and load the first record of the others */
+    for (size_t i = 0; i < num_runs; i++) {
+        if (nanocbor_at_end(&runs[i].it)) {
+            continue;
+        }
+        runs[active].it = runs[i].it;
+        int res = _read_entry(&runs[active].it, path, &runs[active].head, i);
+        if (res < 0) {
+            return res;
+        }
+        active++;
+    }
+    for (size_t i = active / 2; i > 0; i--) {
+        _sift_down(runs, active, i - 1);
+    }
+
+    while (active > 0) {
+        nanocbor_sort_run_t *top = &runs[0];
+        int res = cb(ctx, top->head.record, top->head.len);
+        if (res < 0) {
+            return res;
+        }
+        if (nanocbor_at_end(&top->it)) {
+            runs[0] = runs[--active];
+        }
+        else {
+            res = _read_entry(&top->it, path, &top->head, top->head.seq);
+            if (res < 0) {
+                return res;
+            }
+        }
+        _sift_down(runs, active, 0);
+    }
+    return NANOCBOR_OK;
+}
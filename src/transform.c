@@ -0,0 +1,425 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @ingroup nanocbor_transform
+ * @{
+ * @file
+ * @brief   Transform implementation
+ *
+ * Every item is visited with the position of each rule in its path, NULL
+ * for rules that do not address anything below the item. An item without
+ * active rules is copied raw. For the entries of a container the next
+ * segment of every active rule is matched against the key or index: a rule
+ * with no segments left applies to the entry, the others stay active for
+ * the value of the entry.
+ * @}
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "nanocbor/config.h"
+#include "nanocbor/nanocbor.h"
+#include "nanocbor/transform.h"
+
+typedef struct {
+    const nanocbor_transform_rule_t *rules;
+    size_t num_rules;
+    nanocbor_encoder_t *enc;
+} _transform_t;
+
+/* Rules applying to a single entry */
+typedef struct {
+    const nanocbor_transform_rule_t *rename;
+    const nanocbor_transform_rule_t *value;
+} _match_t;
+
+static bool _parse_index(const char *seg, size_t len, int64_t *index)
+{
+    bool negative = false;
+    uint64_t value = 0;
+
+    if (len > 0 && seg[0] == '-') {
+        negative = true;
+        seg++;
+        len--;
+    }
+    if (len == 0 || len > 18) {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (seg[i] < '0' || seg[i] > '9') {
+            return false;
+        }
+        value = value * 10 + (uint64_t)(seg[i] - '0');
+    }
+    *index = negative ? -(int64_t)value : (int64_t)value;
+    return true;
+}
+
+static bool _is_wildcard(const char *seg, size_t len)
+{
+    return len == 1 && seg[0] == '*';
+}
+
+static bool _key_matches(const nanocbor_value_t *key, const char *seg,
+                         size_t len)
+{
+    nanocbor_value_t it = *key;
+    int type = nanocbor_get_type(&it);
+    int64_t index = 0;
+
+    if (_is_wildcard(seg, len)) {
+        return true;
+    }
+    if (type == NANOCBOR_TYPE_TSTR) {
+        const uint8_t *str = NULL;
+        size_t str_len = 0;
+        return nanocbor_get_tstr(&it, &str, &str_len) >= 0 && str_len == len
+            && !memcmp(str, seg, len);
+    }
+    if ((type == NANOCBOR_TYPE_UINT || type == NANOCBOR_TYPE_NINT)
+        && _parse_index(seg, len, &index)) {
+        int64_t num = 0;
+        return nanocbor_get_int64(&it, &num) >= 0 && num == index;
+    }
+    return false;
+}
+
+static bool _index_matches(uint64_t index, const char *seg, size_t len)
+{
+    int64_t num = 0;
+
+    if (_is_wildcard(seg, len)) {
+        return true;
+    }
+    return _parse_index(seg, len, &num) && num >= 0 && (uint64_t)num == index;
+}
+
+static bool _any_active(const _transform_t *tf, const char *const *pos)
+{
+    for (size_t i = 0; i < tf->num_rules; i++) {
+        if (pos[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Matches the next path segment of the active rules against an entry,
+ * filling the rule positions for the value of the entry */
+static _match_t _match(const _transform_t *tf, const char *const *pos,
+                       const nanocbor_value_t *key, uint64_t index,
+                       const char **child)
+{
+    _match_t match = { NULL, NULL };
+
+    for (size_t i = 0; i < tf->num_rules; i++) {
+        child[i] = NULL;
+        if (!pos[i]) {
+            continue;
+        }
+        const char *seg = pos[i] + 1;
+        size_t len = strcspn(seg, "/");
+        bool matches = key ? _key_matches(key, seg, len)
+                           : _index_matches(index, seg, len);
+        if (!matches) {
+            continue;
+        }
+        if (seg[len] != '\0') {
+            child[i] = seg + len;
+        }
+        else if (tf->rules[i].op == NANOCBOR_TRANSFORM_RENAME) {
+            if (key && !match.rename) {
+                match.rename = &tf->rules[i];
+            }
+        }
+        else if (!match.value) {
+            match.value = &tf->rules[i];
+        }
+    }
+    return match;
+}
+
+static int _copy(const _transform_t *tf, nanocbor_value_t *it)
+{
+    const uint8_t *start = NULL;
+    size_t len = 0;
+
+    int res = nanocbor_get_subcbor(it, &start, &len);
+    if (res < 0) {
+        return res;
+    }
+    return nanocbor_put_raw(tf->enc, start, len);
+}
+
+static int _redact(const _transform_t *tf, nanocbor_value_t *it)
+{
+    nanocbor_encoder_t *enc = tf->enc;
+    int res = NANOCBOR_OK;
+
+    /* Tags are dropped together with the content */
+    while (nanocbor_get_type(it) == NANOCBOR_TYPE_TAG) {
+        uint64_t tag = 0;
+        res = nanocbor_get_tag64(it, &tag);
+        if (res < 0) {
+            return res;
+        }
+    }
+    switch (nanocbor_get_type(it)) {
+    case NANOCBOR_TYPE_UINT:
+    case NANOCBOR_TYPE_NINT:
+        res = nanocbor_fmt_uint(enc, 0);
+        break;
+    case NANOCBOR_TYPE_BSTR:
+        res = nanocbor_fmt_bstr(enc, 0);
+        break;
+    case NANOCBOR_TYPE_TSTR:
+        res = nanocbor_fmt_tstr(enc, 0);
+        break;
+    case NANOCBOR_TYPE_ARR:
+        res = nanocbor_fmt_array(enc, 0);
+        break;
+    case NANOCBOR_TYPE_MAP:
+        res = nanocbor_fmt_map(enc, 0);
+        break;
+    default:
+        res = nanocbor_fmt_null(enc);
+        break;
+    }
+    if (res < 0) {
+        return res;
+    }
+    return nanocbor_skip(it);
+}
+
+static int _item(const _transform_t *tf, nanocbor_value_t *it,
+                 const char *const *pos, unsigned depth);
+
+/* Writes the value of an entry, @p it is positioned at the value */
+static int _value(const _transform_t *tf, nanocbor_value_t *it,
+                  const _match_t *match, const char *const *child,
+                  unsigned depth)
+{
+    if (!match->value) {
+        return _item(tf, it, child, depth);
+    }
+    if (match->value->op == NANOCBOR_TRANSFORM_REDACT) {
+        return _redact(tf, it);
+    }
+    /* Replaced */
+    int res = nanocbor_put_raw(tf->enc, match->value->data, match->value->len);
+    if (res < 0) {
+        return res;
+    }
+    return nanocbor_skip(it);
+}
+
+static bool _is_dropped(const _match_t *match)
+{
+    return match->value && match->value->op == NANOCBOR_TRANSFORM_DROP;
+}
+
+/* Counts the entries of a definite-length container left after drops */
+static int _count(const _transform_t *tf, const nanocbor_value_t *container,
+                  const char *const *pos, bool map, uint64_t *count)
+{
+    const char *child[NANOCBOR_TRANSFORM_RULES_MAX];
+    nanocbor_value_t it = *container;
+
+    *count = 0;
+    for (uint64_t index = 0; !nanocbor_at_end(&it); index++) {
+        _match_t match = _match(tf, pos, map ? &it : NULL, index, child);
+        if (!_is_dropped(&match)) {
+            (*count)++;
+        }
+        int res = nanocbor_skip(&it);
+        if (res >= 0 && map) {
+            res = nanocbor_skip(&it);
+        }
+        if (res < 0) {
+            return res;
+        }
+    }
+    return NANOCBOR_OK;
+}
+
+/* Whether a rule may drop an entry of the container */
+static bool _may_drop(const _transform_t *tf, const char *const *pos)
+{
+    for (size_t i = 0; i < tf->num_rules; i++) {
+        if (pos[i] && tf->rules[i].op == NANOCBOR_TRANSFORM_DROP
+            && !strchr(pos[i] + 1, '/')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int _header(const _transform_t *tf, const nanocbor_value_t *container,
+                   const char *const *pos, bool map)
+{
+    uint64_t count = map ? nanocbor_map_items_remaining(container)
+                         : nanocbor_array_items_remaining(container);
+
+    if (nanocbor_container_indefinite(container)) {
+        return map ? nanocbor_fmt_map_indefinite(tf->enc)
+                   : nanocbor_fmt_array_indefinite(tf->enc);
+    }
+    if (_may_drop(tf, pos)) {
+        int res = _count(tf, container, pos, map, &count);
+        if (res < 0) {
+            return res;
+        }
+    }
+    return map ? nanocbor_fmt_map(tf->enc, count)
+               : nanocbor_fmt_array(tf->enc, count);
+}
+
+static int _entry(const _transform_t *tf, nanocbor_value_t *container,
+                  const char *const *pos, bool map, uint64_t index,
+                  unsigned depth)
+{
+    const char *child[NANOCBOR_TRANSFORM_RULES_MAX];
+    _match_t match = _match(tf, pos, map ? container : NULL, index, child);
+    int res = NANOCBOR_OK;
+
+    if (_is_dropped(&match)) {
+        res = nanocbor_skip(container);
+        if (res >= 0 && map) {
+            res = nanocbor_skip(container);
+        }
+        return res;
+    }
+    if (map) {
+        if (match.rename) {
+            res = nanocbor_put_raw(tf->enc, match.rename->data,
+                                   match.rename->len);
+            if (res >= 0) {
+                res = nanocbor_skip(container);
+            }
+        }
+        else {
+            res = _copy(tf, container);
+        }
+        if (res < 0) {
+            return res;
+        }
+    }
+    return _value(tf, container, &match, child, depth);
+}
+
+static int _container(const _transform_t *tf, nanocbor_value_t *it,
+                      const char *const *pos, unsigned depth)
+{
+    nanocbor_value_t container;
+    bool map = nanocbor_get_type(it) == NANOCBOR_TYPE_MAP;
+
+    int res = map ? nanocbor_enter_map(it, &container)
+                  : nanocbor_enter_array(it, &container);
+    if (res < 0) {
+        return res;
+    }
+    res = _header(tf, &container, pos, map);
+    for (uint64_t index = 0; res >= 0 && !nanocbor_at_end(&container);
+         index++) {
+        res = _entry(tf, &container, pos, map, index, depth + 1);
+    }
+    if (res < 0) {
+        return res;
+    }
+    if (nanocbor_container_indefinite(&container)) {
+        res = nanocbor_fmt_end_indefinite(tf->enc);
+        if (res < 0) {
+            return res;
+        }
+    }
+    nanocbor_leave_container(it, &container);
+    return NANOCBOR_OK;
+}
+
+static int _item(const _transform_t *tf, nanocbor_value_t *it,
+                 const char *const *pos, unsigned depth)
+{
+    if (!_any_active(tf, pos)) {
+        return _copy(tf, it);
+    }
+    if (depth >= NANOCBOR_RECURSION_MAX) {
+        return NANOCBOR_ERR_RECURSION;
+    }
+    while (nanocbor_get_type(it) == NANOCBOR_TYPE_TAG) {
+        uint64_t tag = 0;
+        int res = nanocbor_get_tag64(it, &tag);
+        if (res >= 0) {
+            res = nanocbor_fmt_tag(tf->enc, tag);
+        }
+        if (res < 0) {
+            return res;
+        }
+    }
+    int type = nanocbor_get_type(it);
+    if (type == NANOCBOR_TYPE_MAP || type == NANOCBOR_TYPE_ARR) {
+        return _container(tf, it, pos, depth);
+    }
+    /* The remaining path does not exist below a leaf */
+    return _copy(tf, it);
+}
+
+static int _check(const nanocbor_transform_rule_t *rules, size_t num_rules)
+{
+    if (num_rules > NANOCBOR_TRANSFORM_RULES_MAX) {
+        return NANOCBOR_ERR_OVERFLOW;
+    }
+    for (size_t i = 0; i < num_rules; i++) {
+        const char *path = rules[i].path;
+        if (*path != '\0' && *path != '/') {
+            return NANOCBOR_ERR_INVALID_TYPE;
+        }
+        if ((rules[i].op == NANOCBOR_TRANSFORM_RENAME
+             || rules[i].op == NANOCBOR_TRANSFORM_REPLACE)
+            && !rules[i].data) {
+            return NANOCBOR_ERR_INVALID_TYPE;
+        }
+    }
+    return NANOCBOR_OK;
+}
+
+int nanocbor_transform(const nanocbor_transform_rule_t *rules,
+                       size_t num_rules, nanocbor_value_t *it,
+                       nanocbor_encoder_t *enc)
+{
+    const _transform_t tf = { rules, num_rules, enc };
+    const char *pos[NANOCBOR_TRANSFORM_RULES_MAX];
+    _match_t match = { NULL, NULL };
+
+    int res = _check(rules, num_rules);
+    if (res < 0) {
+        return res;
+    }
+    /* Rules with the empty path apply to the items of the sequence */
+    for (size_t i = 0; i < num_rules; i++) {
+        pos[i] = NULL;
+        if (rules[i].path[0] != '\0') {
+            pos[i] = rules[i].path;
+        }
+        else if (rules[i].op != NANOCBOR_TRANSFORM_RENAME && !match.value) {
+            match.value = &rules[i];
+        }
+    }
+    while (!nanocbor_at_end(it)) {
+        if (_is_dropped(&match)) {
+            res = nanocbor_skip(it);
+        }
+        else {
+            res = _value(&tf, it, &match, pos, 0);
+        }
+        if (res < 0) {
+            return res;
+        }
+    }
+    return NANOCBOR_OK;
+}
@@ -0,0 +1,472 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @ingroup nanocbor_walk
+ * @{
+ * @file
+ * @brief   Document walker implementation
+ *
+ * A task is a range of consecutive items of a container. The walker visits
+ * the items of a task with an explicit stack of containers, using the
+ * structural index to find the end of a container without decoding it.
+ *
+ * The multithreaded walker keeps a deque of tasks per thread. A thread
+ * splits its task in halves by item count, pushing one half onto its own
+ * deque, until the task is below the grain size. A task of a single
+ * container is replaced by the items of the container. Idle threads steal
+ * the oldest, and thus largest, task from the deques of the other threads.
+ * @}
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "nanocbor/config.h"
+#include "nanocbor/index.h"
+#include "nanocbor/nanocbor.h"
+#include "nanocbor/walk.h"
+
+#if NANOCBOR_WALK_PARALLEL
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#endif
+
+#define COUNT_UNTIL_END UINT32_MAX
+
+typedef struct {
+    uint32_t node; /**< Container of the items */
+    uint32_t index; /**< Position of the first item in the container */
+    uint32_t count; /**< Number of items, or COUNT_UNTIL_END */
+    uint32_t start; /**< Offset of the first item */
+    uint32_t end; /**< Offset after the last item */
+} _task_t;
+
+typedef struct {
+    nanocbor_value_t it;
+    uint32_t node;
+    uint32_t index;
+    uint32_t remaining;
+    uint32_t end;
+} _frame_t;
+
+typedef struct {
+    const uint8_t *buf;
+    const nanocbor_index_node_t *nodes;
+    size_t num_nodes;
+    const nanocbor_walk_ops_t *ops;
+    void *ctx;
+} _walk_t;
+
+static void _frame_init(const _walk_t *walk, _frame_t *frame,
+                        const _task_t *task)
+{
+    nanocbor_decoder_init(&frame->it, walk->buf + task->start,
+                          task->end - task->start);
+    frame->node = task->node;
+    frame->index = task->index;
+    frame->remaining = task->count;
+    frame->end = task->end;
+}
+
+static bool _is_container(const nanocbor_value_t *it)
+{
+    int type = nanocbor_get_type(it);
+    return type == NANOCBOR_TYPE_ARR || type == NANOCBOR_TYPE_MAP;
+}
+
+/* Creates the task of all items of a container */
+static int _node_task(const _walk_t *walk, uint32_t node, _task_t *task)
+{
+    const nanocbor_index_node_t *cur = &walk->nodes[node];
+    nanocbor_value_t it;
+    nanocbor_value_t container;
+
+    nanocbor_decoder_init(&it, walk->buf + cur->offset, cur->len);
+    int res = nanocbor_get_type(&it) == NANOCBOR_TYPE_ARR
+        ? nanocbor_enter_array(&it, &container)
+        : nanocbor_enter_map(&it, &container);
+    if (res < 0) {
+        return res;
+    }
+    task->node = node;
+    task->index = 0;
+    task->count = cur->items;
+    task->start = (uint32_t)(container.cur - walk->buf);
+    task->end = cur->offset + cur->len;
+    return NANOCBOR_OK;
+}
+
+static uint32_t _container_node(const _walk_t *walk,
+                                const nanocbor_value_t *it)
+{
+    return nanocbor_index_lookup(walk->nodes, walk->num_nodes,
+                                 (size_t)(it->cur - walk->buf));
+}
+
+/* Moves past a container, using the index for its length */
+static void _jump(const _walk_t *walk, nanocbor_value_t *it, uint32_t node,
+                  uint32_t end)
+{
+    uint32_t next = walk->nodes[node].offset + walk->nodes[node].len;
+    nanocbor_decoder_init(it, walk->buf + next, end - next);
+}
+
+static int _walk_task(const _walk_t *walk, const _task_t *task, void *acc)
+{
+    _frame_t stack[NANOCBOR_RECURSION_MAX + 1];
+    size_t depth = 0;
+
+    _frame_init(walk, &stack[0], task);
+    for (;;) {
+        _frame_t *frame = &stack[depth];
+
+        if (frame->remaining == 0 || nanocbor_at_end(&frame->it)) {
+            if (depth == 0) {
+                return NANOCBOR_OK;
+            }
+            depth--;
+            continue;
+        }
+        int res = nanocbor_skip_tags(&frame->it);
+        if (res < 0) {
+            return res;
+        }
+        if (_is_container(&frame->it)) {
+            uint32_t node = _container_node(walk, &frame->it);
+            _task_t sub;
+            if (node == NANOCBOR_INDEX_NONE) {
+                return NANOCBOR_ERR_INVALID_TYPE;
+            }
+            if (depth == NANOCBOR_RECURSION_MAX) {
+                return NANOCBOR_ERR_RECURSION;
+            }
+            res = _node_task(walk, node, &sub);
+            if (res < 0) {
+                return res;
+            }
+            _jump(walk, &frame->it, node, frame->end);
+            _frame_init(walk, &stack[++depth], &sub);
+        }
+        else {
+            res = walk->ops->visit(walk->ctx, acc, &frame->it, frame->node,
+                                   frame->index);
+            if (res < 0) {
+                return res;
+            }
+            res = nanocbor_skip(&frame->it);
+            if (res < 0) {
+                return res;
+            }
+        }
+        frame->index++;
+        frame->remaining--;
+    }
+}
+
+int nanocbor_walk(const uint8_t *buf, size_t len,
+                  const nanocbor_index_node_t *nodes, size_t num_nodes,
+                  const nanocbor_walk_ops_t *ops, void *ctx, void *result)
+{
+    _walk_t walk = { buf, nodes, num_nodes, ops, ctx };
+    _task_t root = { NANOCBOR_INDEX_NONE, 0, COUNT_UNTIL_END, 0,
+                     (uint32_t)len };
+
+    if (len > UINT32_MAX) {
+        return NANOCBOR_ERR_OVERFLOW;
+    }
+    ops->init(ctx, result);
+    return _walk_task(&walk, &root, result);
+}
+
+#if NANOCBOR_WALK_PARALLEL
+
+#define DEQUE_SIZE 128
+
+typedef struct {
+    pthread_mutex_t lock;
+    _task_t tasks[DEQUE_SIZE];
+    size_t head; /**< Oldest task, taken by other threads */
+    size_t tail; /**< After the newest task, taken by the owner */
+} _deque_t;
+
+typedef struct _pool _pool_t;
+
+typedef struct {
+    _pool_t *pool;
+    _deque_t deque;
+    void *acc;
+    unsigned id;
+} _worker_t;
+
+struct _pool {
+    _walk_t walk;
+    size_t grain;
+    _worker_t *workers;
+    unsigned num_workers;
+    pthread_mutex_t lock;
+    size_t pending; /**< Tasks queued or running */
+    int error;
+};
+
+static bool _deque_push(_deque_t *deque, const _task_t *task)
+{
+    bool pushed = false;
+
+    pthread_mutex_lock(&deque->lock);
+    if (deque->tail == DEQUE_SIZE && deque->head > 0) {
+        for (size_t i = deque->head; i < deque->tail; i++) {
+            deque->tasks[i - deque->head] = deque->tasks[i];
+        }
+        deque->tail -= deque->head;
+        deque->head = 0;
+    }
+    if (deque->tail < DEQUE_SIZE) {
+        deque->tasks[deque->tail++] = *task;
+        pushed = true;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return pushed;
+}
+
+static bool _deque_take(_deque_t *deque, _task_t *task, bool oldest)
+{
+    bool taken = false;
+
+    pthread_mutex_lock(&deque->lock);
+    if (deque->tail > deque->head) {
+        *task = oldest ? deque->tasks[deque->head++]
+                       : deque->tasks[--deque->tail];
+        taken = true;
+        if (deque->head == deque->tail) {
+            deque->head = 0;
+            deque->tail = 0;
+        }
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return taken;
+}
+
+static bool _steal(_worker_t *worker, _task_t *task)
+{
+    _pool_t *pool = worker->pool;
+
+    for (unsigned i = 1; i < pool->num_workers; i++) {
+        _worker_t *victim
+            = &pool->workers[(worker->id + i) % pool->num_workers];
+        if (_deque_take(&victim->deque, task, true)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool _pool_active(_pool_t *pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    bool active = pool->pending > 0 && pool->error == 0;
+    pthread_mutex_unlock(&pool->lock);
+    return active;
+}
+
+static void _pool_update(_pool_t *pool, bool added, int res)
+{
+    pthread_mutex_lock(&pool->lock);
+    if (added) {
+        pool->pending++;
+    }
+    else {
+        pool->pending--;
+    }
+    if (res < 0 && pool->error == 0) {
+        pool->error = res;
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+static int _skip_item(const _walk_t *walk, nanocbor_value_t *it, uint32_t end)
+{
+    int res = nanocbor_skip_tags(it);
+    if (res < 0) {
+        return res;
+    }
+    if (_is_container(it)) {
+        uint32_t node = _container_node(walk, it);
+        if (node == NANOCBOR_INDEX_NONE) {
+            return NANOCBOR_ERR_INVALID_TYPE;
+        }
+        _jump(walk, it, node, end);
+        return NANOCBOR_OK;
+    }
+    return nanocbor_skip(it);
+}
+
+static int _count_items(const _walk_t *walk, _task_t *task)
+{
+    nanocbor_value_t it;
+
+    nanocbor_decoder_init(&it, walk->buf + task->start,
+                          task->end - task->start);
+    for (task->count = 0; !nanocbor_at_end(&it); task->count++) {
+        int res = _skip_item(walk, &it, task->end);
+        if (res < 0) {
+            return res;
+        }
+    }
+    return NANOCBOR_OK;
+}
+
+/* Splits off the second half of the items of a task */
+static int _split(const _walk_t *walk, _task_t *task, _task_t *second)
+{
+    nanocbor_value_t it;
+    uint32_t half = task->count / 2;
+
+    nanocbor_decoder_init(&it, walk->buf + task->start,
+                          task->end - task->start);
+    for (uint32_t i = 0; i < half; i++) {
+        int res = _skip_item(walk, &it, task->end);
+        if (res < 0) {
+            return res;
+        }
+    }
+    *second = *task;
+    second->index += half;
+    second->count -= half;
+    second->start = (uint32_t)(it.cur - walk->buf);
+    task->count = half;
+    task->end = second->start;
+    return NANOCBOR_OK;
+}
+
+static int _run_task(_worker_t *worker, _task_t task)
+{
+    _pool_t *pool = worker->pool;
+    const _walk_t *walk = &pool->walk;
+
+    while (task.end - task.start > pool->grain) {
+        if (task.count >= 2) {
+            _task_t first = task;
+            _task_t second;
+            int res = _split(walk, &first, &second);
+            if (res < 0) {
+                return res;
+            }
+            _pool_update(pool, true, NANOCBOR_OK);
+            if (!_deque_push(&worker->deque, &second)) {
+                /* Deque is full, walk the task as a whole */
+                _pool_update(pool, false, NANOCBOR_OK);
+                break;
+            }
+            task = first;
+            continue;
+        }
+        nanocbor_value_t it;
+        nanocbor_decoder_init(&it, walk->buf + task.start,
+                              task.end - task.start);
+        int res = nanocbor_skip_tags(&it);
+        if (res < 0) {
+            return res;
+        }
+        if (!_is_container(&it)) {
+            break;
+        }
+        uint32_t node = _container_node(walk, &it);
+        if (node == NANOCBOR_INDEX_NONE) {
+            return NANOCBOR_ERR_INVALID_TYPE;
+        }
+        res = _node_task(walk, node, &task);
+        if (res < 0) {
+            return res;
+        }
+    }
+    return _walk_task(walk, &task, worker->acc);
+}
+
+static void *_worker_main(void *arg)
+{
+    _worker_t *worker = arg;
+    _pool_t *pool = worker->pool;
+
+    while (_pool_active(pool)) {
+        _task_t task;
+        if (!_deque_take(&worker->deque, &task, false)
+            && !_steal(worker, &task)) {
+            sched_yield();
+            continue;
+        }
+        _pool_update(pool, false, _run_task(worker, task));
+    }
+    return NULL;
+}
+
+int nanocbor_walk_parallel(const uint8_t *buf, size_t len,
+                           const nanocbor_index_node_t *nodes,
+                           size_t num_nodes, const nanocbor_walk_ops_t *ops,
+                           void *ctx, unsigned threads, size_t grain,
+                           void *result)
+{
+    pthread_t tids[NANOCBOR_WALK_THREADS_MAX];
+    bool started[NANOCBOR_WALK_THREADS_MAX] = { false };
+    _pool_t pool = {
+        .walk = { buf, nodes, num_nodes, ops, ctx },
+        .grain = grain,
+        .num_workers = threads,
+        .pending = 1,
+    };
+    _task_t root = { NANOCBOR_INDEX_NONE, 0, 0, 0, (uint32_t)len };
+
+    if (threads == 0 || threads > NANOCBOR_WALK_THREADS_MAX
+        || len > UINT32_MAX) {
+        return NANOCBOR_ERR_OVERFLOW;
+    }
+    int res = _count_items(&pool.walk, &root);
+    if (res < 0) {
+        return res;
+    }
+    pool.workers = calloc(threads, sizeof(_worker_t));
+    uint8_t *accs = calloc(threads, ops->acc_size ? ops->acc_size : 1);
+    if (!pool.workers || !accs) {
+        free(pool.workers);
+        free(accs);
+        return NANOCBOR_ERR_OVERFLOW;
+    }
+    pthread_mutex_init(&pool.lock, NULL);
+    for (unsigned i = 0; i < threads; i++) {
+        _worker_t *worker = &pool.workers[i];
+        worker->pool = &pool;
+        worker->id = i;
+        worker->acc = accs + (size_t)i * ops->acc_size;
+        pthread_mutex_init(&worker->deque.lock, NULL);
+        ops->init(ctx, worker->acc);
+    }
+    _deque_push(&pool.workers[0].deque, &root);
+
+    /* The calling thread is the first worker */
+    for (unsigned i = 1; i < threads; i++) {
+        started[i] = pthread_create(&tids[i], NULL, _worker_main,
+                                    &pool.workers[i])
+            == 0;
+    }
+    _worker_main(&pool.workers[0]);
+
+    for (unsigned i = 1; i < threads; i++) {
+        if (started[i]) {
+            pthread_join(tids[i], NULL);
+        }
+    }
+    ops->init(ctx, result);
+    for (unsigned i = 0; i < threads; i++) {
+        ops->combine(ctx, result, pool.workers[i].acc);
+        pthread_mutex_destroy(&pool.workers[i].deque.lock);
+    }
+    pthread_mutex_destroy(&pool.lock);
+    free(pool.workers);
+    free(accs);
+    return pool.error;
+}
+
+#endif /* NANOCBOR_WALK_PARALLEL */
@@ -12,6 +12,21 @@
 
 extern const test_t tests_decoder[];
 extern const test_t tests_encoder[];
+extern const test_t tests_schema[];
+extern const test_t tests_query[];
+extern const test_t tests_sort[];
+extern const test_t tests_log[];
+extern const test_t tests_index[];
+extern const test_t tests_walk[];
+extern const test_t tests_sink[];
+extern const test_t tests_pool[];
+extern const test_t tests_transform[];
+extern const test_t tests_resume[];
+extern const test_t tests_arrow[];
+extern const test_t tests_diff[];
+extern const test_t tests_base64[];
+extern const test_t tests_mmap[];
+extern const test_t tests_dict[];
 
 static int add_tests(CU_pSuite pSuite, const test_t *tests)
 {
@@ -46,6 +61,111 @@ int main()
     }
     add_tests(pSuite, tests_encoder);
 
+    pSuite = CU_add_suite("Nanocbor schema", NULL, NULL);
+    if (NULL == pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    add_tests(pSuite, tests_schema);
+
+    pSuite = CU_add_suite("Nanocbor query", NULL, NULL);
+    if (NULL == pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    add_tests(pSuite, tests_query);
+
+    pSuite = CU_add_suite("Nanocbor sort", NULL, NULL);
+    if (NULL == pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    add_tests(pSuite, tests_sort);
+
+    pSuite = CU_add_suite("Nanocbor log", NULL, NULL);
+    if (NULL == pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    add_tests(pSuite, tests_log);
+
+    pSuite = CU_add_suite("Nanocbor index", NULL, NULL);
+    if (NULL == pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    add_tests(pSuite, tests_index);
+
+    pSuite = CU_add_suite("Nanocbor walk", NULL, NULL);
+    if (NULL == pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    add_tests(pSuite, tests_walk);
+
+    pSuite = CU_add_suite("Nanocbor sink", NULL, NULL);
+    if (NULL == pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    add_tests(pSuite, tests_sink);
+
+    pSuite = CU_add_suite("Nanocbor pool", NULL, NULL);
+    if (NULL == pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    add_tests(pSuite, tests_pool);
+
+    pSuite = CU_add_suite("Nanocbor transform", NULL, NULL);
+    if (NULL == pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    add_tests(pSuite, tests_transform);
+
+    pSuite = CU_add_suite("Nanocbor resume", NULL, NULL);
+    if (NULL == pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    add_tests(pSuite, tests_resume);
+
+    pSuite = CU_add_suite("Nanocbor arrow", NULL, NULL);
+    if (NULL == pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    add_tests(pSuite, tests_arrow);
+
+    pSuite = CU_add_suite("Nanocbor diff", NULL, NULL);
+    if (NULL == pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    add_tests(pSuite, tests_diff);
+
+    pSuite = CU_add_suite("Nanocbor base64", NULL, NULL);
+    if (NULL == pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    add_tests(pSuite, tests_base64);
+
+    pSuite = CU_add_suite("Nanocbor mmap", NULL, NULL);
+    if (NULL == pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    add_tests(pSuite, tests_mmap);
+
+    pSuite = CU_add_suite("Nanocbor dict", NULL, NULL);
+    if (NULL == pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+    add_tests(pSuite, tests_dict);
+
     CU_basic_set_mode(CU_BRM_VERBOSE);
     CU_basic_run_tests();
     printf("\n");
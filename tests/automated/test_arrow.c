@@ -0,0 +1,235 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "nanocbor/arrow.h"
+#include "nanocbor/nanocbor.h"
+#include "nanocbor/query.h"
+#include "test.h"
+#include <CUnit/CUnit.h>
+#include <string.h>
+
+/* NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers) */
+
+static const char long_name[] = "a name longer than a view";
+
+/* Records {"id": i, "t": i / 2, "name": ...} with some values missing or of
+ * another type */
+static size_t _build(uint8_t *buf, size_t len)
+{
+    nanocbor_encoder_t enc;
+
+    nanocbor_encoder_init(&enc, buf, len);
+    for (unsigned i = 0; i < 12; i++) {
+        nanocbor_fmt_map(&enc, i == 5 ? 2 : 3);
+        nanocbor_put_tstr(&enc, "id");
+        if (i == 7) {
+            nanocbor_put_tstr(&enc, "seven");
+        }
+        else {
+            nanocbor_fmt_int(&enc, (int64_t)i - 2);
+        }
+        nanocbor_put_tstr(&enc, "t");
+        if (i % 2) {
+            nanocbor_fmt_float(&enc, (float)i / 2);
+        }
+        else {
+            nanocbor_fmt_tag(&enc, 1);
+            nanocbor_fmt_uint(&enc, i / 2);
+        }
+        if (i != 5) {
+            nanocbor_put_tstr(&enc, "name");
+            nanocbor_put_tstr(&enc, i == 9 ? long_name : "ab");
+        }
+    }
+    return nanocbor_encoded_len(&enc);
+}
+
+static int64_t _int64(const struct ArrowArray *array, size_t row)
+{
+    int64_t value = 0;
+    memcpy(&value, (const uint8_t *)array->buffers[1] + row * 8, 8);
+    return value;
+}
+
+static bool _valid(const struct ArrowArray *array, size_t row)
+{
+    const uint8_t *validity = array->buffers[0];
+    return validity[row / 8] & (1U << (row % 8));
+}
+
+static void test_arrow_export(void)
+{
+    uint8_t buf[512];
+    size_t len = _build(buf, sizeof(buf));
+    nanocbor_value_t it;
+    struct ArrowArray array;
+    struct ArrowSchema schema;
+    static const char *const select[] = { "/id", "/t", "/name", "/name" };
+    static const nanocbor_query_pred_t where[] = {
+        { .path = "/t", .op = NANOCBOR_QUERY_NE, .type = NANOCBOR_QUERY_INT,
+          .value.i = 1 },
+    };
+    static const nanocbor_arrow_column_t columns[] = {
+        { .name = "id", .type = NANOCBOR_ARROW_INT64 },
+        { .name = NULL, .type = NANOCBOR_ARROW_DOUBLE },
+        { .name = "name", .type = NANOCBOR_ARROW_UTF8 },
+        { .name = "view", .type = NANOCBOR_ARROW_UTF8_VIEW },
+    };
+    nanocbor_query_t query = {
+        .where = where,
+        .num_where = 1,
+        .select = select,
+        .num_select = 4,
+    };
+
+    nanocbor_decoder_init(&it, buf, len);
+    CU_ASSERT_EQUAL(nanocbor_arrow_export(&query, columns, &it, &array,
+                                          &schema),
+                    NANOCBOR_OK);
+    CU_ASSERT(nanocbor_at_end(&it));
+
+    /* Record 2 with t 1 is filtered */
+    CU_ASSERT_STRING_EQUAL(schema.format, "+s");
+    CU_ASSERT_EQUAL(schema.n_children, 4);
+    CU_ASSERT_STRING_EQUAL(schema.children[0]->format, "l");
+    CU_ASSERT_STRING_EQUAL(schema.children[0]->name, "id");
+    CU_ASSERT_STRING_EQUAL(schema.children[1]->format, "g");
+    CU_ASSERT_STRING_EQUAL(schema.children[1]->name, "/t");
+    CU_ASSERT_STRING_EQUAL(schema.children[2]->format, "u");
+    CU_ASSERT_STRING_EQUAL(schema.children[3]->format, "vu");
+    CU_ASSERT_EQUAL(schema.children[3]->flags, ARROW_FLAG_NULLABLE);
+    CU_ASSERT_EQUAL(array.length, 11);
+    CU_ASSERT_EQUAL(array.n_children, 4);
+
+    /* Integer column, the text string id of record 7 is null */
+    const struct ArrowArray *ids = array.children[0];
+    CU_ASSERT_EQUAL(ids->length, 11);
+    CU_ASSERT_EQUAL(ids->n_buffers, 2);
+    CU_ASSERT_EQUAL(ids->null_count, 1);
+    CU_ASSERT_EQUAL(_int64(ids, 0), -2);
+    CU_ASSERT_EQUAL(_int64(ids, 2), 1);
+    CU_ASSERT(!_valid(ids, 6));
+    CU_ASSERT(_valid(ids, 10));
+    CU_ASSERT_EQUAL(_int64(ids, 10), 9);
+
+    /* Double column from tagged integers and floats */
+    const struct ArrowArray *times = array.children[1];
+    double time = 0;
+    CU_ASSERT_EQUAL(times->null_count, 0);
+    memcpy(&time, (const uint8_t *)times->buffers[1] + 3 * 8, 8);
+    CU_ASSERT_EQUAL(time, 2.0);
+    memcpy(&time, (const uint8_t *)times->buffers[1] + 4 * 8, 8);
+    CU_ASSERT_EQUAL(time, 2.5);
+
+    /* Copied strings, record 5 has no name */
+    const struct ArrowArray *names = array.children[2];
+    const int32_t *offsets = names->buffers[1];
+    const char *data = names->buffers[2];
+    CU_ASSERT_EQUAL(names->n_buffers, 3);
+    CU_ASSERT_EQUAL(names->null_count, 1);
+    CU_ASSERT(!_valid(names, 4));
+    CU_ASSERT_EQUAL(offsets[0], 0);
+    CU_ASSERT_EQUAL(offsets[4], 8);
+    CU_ASSERT_EQUAL(offsets[5], 8);
+    CU_ASSERT_EQUAL(offsets[9] - offsets[8], (int32_t)strlen(long_name));
+    CU_ASSERT_EQUAL(memcmp(data + offsets[8], long_name, strlen(long_name)),
+                    0);
+    CU_ASSERT_EQUAL(offsets[11], 2 * 9 + (int32_t)strlen(long_name));
+
+    /* Views inline short strings and reference long strings in the input */
+    const struct ArrowArray *views = array.children[3];
+    const uint8_t *view = (const uint8_t *)views->buffers[1] + 8 * 16;
+    int32_t view_len = 0;
+    int32_t view_index = -1;
+    int32_t view_offset = 0;
+    int64_t size = 0;
+    CU_ASSERT_EQUAL(views->n_buffers, 4);
+    CU_ASSERT_EQUAL(views->null_count, 1);
+    CU_ASSERT(views->buffers[2] == buf);
+    memcpy(&size, views->buffers[3], sizeof(size));
+    CU_ASSERT_EQUAL(size, (int64_t)len);
+    memcpy(&view_len, view, 4);
+    memcpy(&view_index, view + 8, 4);
+    memcpy(&view_offset, view + 12, 4);
+    CU_ASSERT_EQUAL(view_len, (int32_t)strlen(long_name));
+    CU_ASSERT_EQUAL(memcmp(view + 4, long_name, 4), 0);
+    CU_ASSERT_EQUAL(view_index, 0);
+    CU_ASSERT_EQUAL(memcmp(buf + view_offset, long_name, strlen(long_name)),
+                    0);
+    view = (const uint8_t *)views->buffers[1];
+    memcpy(&view_len, view, 4);
+    CU_ASSERT_EQUAL(view_len, 2);
+    CU_ASSERT_EQUAL(memcmp(view + 4, "ab\0\0", 4), 0);
+
+    /* A child moved out of the parent outlives it */
+    struct ArrowArray moved = *array.children[2];
+    array.children[2]->release = NULL;
+    array.release(&array);
+    CU_ASSERT_PTR_NULL(array.release);
+    CU_ASSERT_EQUAL(((const int32_t *)moved.buffers[1])[1], 2);
+    moved.release(&moved);
+    CU_ASSERT_PTR_NULL(moved.release);
+    schema.release(&schema);
+    CU_ASSERT_PTR_NULL(schema.release);
+}
+
+static void test_arrow_empty(void)
+{
+    uint8_t buf[512];
+    size_t len = _build(buf, sizeof(buf));
+    nanocbor_value_t it;
+    struct ArrowArray array = { 0 };
+    struct ArrowSchema schema = { 0 };
+    static const char *const select[] = { "/name" };
+    static const nanocbor_query_pred_t where[] = {
+        { .path = "/id", .op = NANOCBOR_QUERY_GT, .type = NANOCBOR_QUERY_INT,
+          .value.i = 100 },
+    };
+    static const nanocbor_arrow_column_t columns[] = {
+        { .name = NULL, .type = NANOCBOR_ARROW_BINARY },
+    };
+    nanocbor_query_t query = {
+        .where = where,
+        .num_where = 1,
+        .select = select,
+        .num_select = 1,
+    };
+
+    nanocbor_decoder_init(&it, buf, len);
+    CU_ASSERT_EQUAL(nanocbor_arrow_export(&query, columns, &it, &array,
+                                          &schema),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(array.length, 0);
+    CU_ASSERT_EQUAL(array.children[0]->length, 0);
+    CU_ASSERT_EQUAL(((const int32_t *)array.children[0]->buffers[1])[0], 0);
+    CU_ASSERT_STRING_EQUAL(schema.children[0]->format, "z");
+    CU_ASSERT_STRING_EQUAL(schema.children[0]->name, "/name");
+    array.release(&array);
+    schema.release(&schema);
+
+    /* Truncated input leaves the outputs untouched */
+    query.num_where = 0;
+    nanocbor_decoder_init(&it, buf, len - 1);
+    CU_ASSERT(nanocbor_arrow_export(&query, columns, &it, &array, &schema)
+              < 0);
+    CU_ASSERT_PTR_NULL(array.release);
+    CU_ASSERT_PTR_NULL(schema.release);
+}
+
+const test_t tests_arrow[] = {
+    {
+        .f = test_arrow_export,
+        .n = "Arrow export test",
+    },
+    {
+        .f = test_arrow_empty,
+        .n = "Arrow export without records test",
+    },
+    {
+        .f = NULL,
+        .n = NULL,
+    },
+};
+
+/* NOLINTEND(cppcoreguidelines-avoid-magic-numbers) */
@@ -0,0 +1,126 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "nanocbor/base64.h"
+#include "nanocbor/nanocbor.h"
+#include "test.h"
+#include <CUnit/CUnit.h>
+#include <string.h>
+
+/* NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers) */
+
+static int _decode(const char *text, uint8_t *out, size_t max_len,
+                   size_t chunk, size_t *len)
+{
+    nanocbor_base64_t b64;
+    nanocbor_value_t value;
+    size_t text_len = strlen(text);
+
+    nanocbor_base64_init(&b64, out, max_len);
+    for (size_t i = 0; i < text_len; i += chunk) {
+        size_t n = text_len - i < chunk ? text_len - i : chunk;
+        int res = nanocbor_base64_update(&b64, text + i, n);
+        if (res < 0) {
+            return res;
+        }
+    }
+    int res = nanocbor_base64_finish(&b64, &value);
+    *len = (size_t)(value.end - value.cur);
+    return res;
+}
+
+static void test_base64_vectors(void)
+{
+    /* RFC 4648 test vectors, padded and unpadded */
+    static const char *const texts[] = {
+        "", "Zg==", "Zm8=", "Zm9v", "Zm9vYg==", "Zm9vYmE=", "Zm9vYmFy",
+        "Zg", "Zm8", "Zm9vYg", "Zm9vYmE",
+    };
+    static const char *const plain[] = {
+        "", "f", "fo", "foo", "foob", "fooba", "foobar",
+        "f", "fo", "foob", "fooba",
+    };
+    uint8_t out[16];
+    size_t len = 0;
+
+    for (size_t i = 0; i < sizeof(texts) / sizeof(texts[0]); i++) {
+        for (size_t chunk = 1; chunk <= 9; chunk++) {
+            CU_ASSERT_EQUAL(_decode(texts[i], out, sizeof(out), chunk, &len),
+                            NANOCBOR_OK);
+            CU_ASSERT_EQUAL(len, strlen(plain[i]));
+            CU_ASSERT_EQUAL(memcmp(out, plain[i], len), 0);
+        }
+    }
+
+    /* Both alphabets */
+    static const uint8_t bytes[] = { 0xfb, 0xff, 0xbf, 0xfb, 0xef };
+    CU_ASSERT_EQUAL(_decode("-_-_--8", out, sizeof(out), 16, &len),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(len, sizeof(bytes));
+    CU_ASSERT_EQUAL(memcmp(out, bytes, sizeof(bytes)), 0);
+    CU_ASSERT_EQUAL(_decode("+/+/++8=", out, sizeof(out), 3, &len),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(memcmp(out, bytes, sizeof(bytes)), 0);
+
+    /* Invalid text */
+    CU_ASSERT_EQUAL(_decode("Zm9v Zg==", out, sizeof(out), 16, &len),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    CU_ASSERT_EQUAL(_decode("Z===", out, sizeof(out), 16, &len),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    CU_ASSERT_EQUAL(_decode("Zg=a", out, sizeof(out), 16, &len),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    CU_ASSERT_EQUAL(_decode("Zg===", out, sizeof(out), 16, &len),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    CU_ASSERT_EQUAL(_decode("Zm9vY", out, sizeof(out), 16, &len),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    CU_ASSERT_EQUAL(_decode("Zm9v\x80m9v", out, sizeof(out), 16, &len),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    CU_ASSERT_EQUAL(_decode("Zm9vYmFy", out, 5, 16, &len), NANOCBOR_ERR_END);
+    CU_ASSERT_EQUAL(_decode("Zm9vYmE", out, 4, 2, &len), NANOCBOR_ERR_END);
+}
+
+static void test_base64_in_place(void)
+{
+    /* {"a": [1, 2], "b": h'00ff'} */
+    static const uint8_t cbor[] = { 0xa2, 0x61, 0x61, 0x82, 0x01, 0x02,
+                                    0x61, 0x62, 0x42, 0x00, 0xff };
+    char text[] = "omFhggECYWJCAP8";
+    nanocbor_value_t it;
+    nanocbor_value_t map;
+    const uint8_t *str = NULL;
+    size_t len = 0;
+
+    CU_ASSERT_EQUAL(nanocbor_decoder_init_base64(&it, (uint8_t *)text,
+                                                 strlen(text)),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(it.end - it.cur, (ptrdiff_t)sizeof(cbor));
+    CU_ASSERT_EQUAL(memcmp(it.cur, cbor, sizeof(cbor)), 0);
+    CU_ASSERT_EQUAL(nanocbor_enter_map(&it, &map), NANOCBOR_OK);
+    nanocbor_value_t value;
+    CU_ASSERT_EQUAL(nanocbor_get_key_tstr(&map, "b", &value), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_get_bstr(&value, &str, &len), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(len, 2);
+
+    char invalid[] = "omFh.gECYWJCAP8";
+    CU_ASSERT_EQUAL(nanocbor_decoder_init_base64(&it, (uint8_t *)invalid,
+                                                 strlen(invalid)),
+                    NANOCBOR_ERR_INVALID_TYPE);
+}
+
+const test_t tests_base64[] = {
+    {
+        .f = test_base64_vectors,
+        .n = "Base64 decoding test",
+    },
+    {
+        .f = test_base64_in_place,
+        .n = "Base64 decoding in place test",
+    },
+    {
+        .f = NULL,
+        .n = NULL,
+    },
+};
+
+/* NOLINTEND(cppcoreguidelines-avoid-magic-numbers) */
@@ -5,6 +5,8 @@
 #include "nanocbor/nanocbor.h"
 #include "test.h"
 #include <CUnit/CUnit.h>
+#include <math.h>
+#include <string.h>
 
 /* NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers) */
 
@@ -170,6 +172,91 @@ static void test_double_tag(void)
     CU_ASSERT_EQUAL(nanocbor_at_end(&val), true);
 }
 
+static void test_tag64(void)
+{
+    /* [1(2), 4294967296(3), 4] */
+    static const uint8_t tagged[] = { 0x83, 0xc1, 0x02, 0xdb, 0x00, 0x00,
+                                      0x00, 0x01, 0x00, 0x00, 0x00, 0x00,
+                                      0x03, 0x04 };
+
+    nanocbor_value_t val;
+    nanocbor_value_t arr;
+    uint64_t tag = 0;
+    uint32_t tmp = 0;
+
+    nanocbor_decoder_init(&val, tagged, sizeof(tagged));
+    CU_ASSERT_EQUAL(nanocbor_enter_array(&val, &arr), NANOCBOR_OK);
+
+    /* A tag does not count as an item of its container */
+    CU_ASSERT_EQUAL(nanocbor_get_tag64(&arr, &tag), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(tag, 1);
+    CU_ASSERT_EQUAL(arr.remaining, 3);
+    CU_ASSERT(nanocbor_get_uint32(&arr, &tmp) > 0);
+    CU_ASSERT_EQUAL(tmp, 2);
+
+    CU_ASSERT_EQUAL(nanocbor_get_tag64(&arr, &tag), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(tag, 4294967296U);
+    CU_ASSERT_EQUAL(arr.remaining, 2);
+    CU_ASSERT(nanocbor_get_uint32(&arr, &tmp) > 0);
+    CU_ASSERT_EQUAL(tmp, 3);
+
+    CU_ASSERT_EQUAL(nanocbor_get_tag64(&arr, &tag), NANOCBOR_ERR_INVALID_TYPE);
+    CU_ASSERT(nanocbor_get_uint32(&arr, &tmp) > 0);
+    CU_ASSERT_EQUAL(tmp, 4);
+    CU_ASSERT(nanocbor_at_end(&arr));
+    nanocbor_leave_container(&val, &arr);
+    CU_ASSERT(nanocbor_at_end(&val));
+}
+
+static void test_decode_str_truncated(void)
+{
+    /* bstr(3) 'BOR', tstr(24) with a one byte length, tstr(1) 'a' */
+    static const uint8_t strs[] = { 0x43, 0x42, 0x4F, 0x52, 0x78, 0x18, 'a',
+                                    'b',  'c',  'd',  'e',  'f',  'g',  'h',
+                                    'i',  'j',  'k',  'l',  'm',  'n',  'o',
+                                    'p',  'q',  'r',  's',  't',  'u',  'v',
+                                    'w',  'x',  0x61, 'a' };
+
+    nanocbor_value_t val;
+    const uint8_t *str = NULL;
+    size_t len = 0;
+
+    /* Exactly fitting strings */
+    nanocbor_decoder_init(&val, strs, 4);
+    CU_ASSERT_EQUAL(nanocbor_get_bstr(&val, &str, &len), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(len, 3);
+    CU_ASSERT_EQUAL(str, strs + 1);
+    CU_ASSERT_EQUAL(nanocbor_at_end(&val), true);
+    nanocbor_decoder_init(&val, strs + 4, 26);
+    CU_ASSERT_EQUAL(nanocbor_get_tstr(&val, &str, &len), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(len, 24);
+    CU_ASSERT_EQUAL(str, strs + 6);
+    CU_ASSERT_EQUAL(nanocbor_at_end(&val), true);
+
+    /* Strings truncated by up to the size of their header are rejected
+     * without advancing */
+    for (size_t cut = 1; cut <= 2; cut++) {
+        nanocbor_decoder_init(&val, strs, 4 - cut);
+        CU_ASSERT_EQUAL(nanocbor_get_bstr(&val, &str, &len),
+                        NANOCBOR_ERR_END);
+        CU_ASSERT_EQUAL(val.cur, strs);
+        nanocbor_decoder_init(&val, strs + 4, 26 - cut);
+        CU_ASSERT_EQUAL(nanocbor_get_tstr(&val, &str, &len),
+                        NANOCBOR_ERR_END);
+        CU_ASSERT_EQUAL(val.cur, strs + 4);
+    }
+    /* Header without its length byte */
+    nanocbor_decoder_init(&val, strs + 4, 1);
+    CU_ASSERT(nanocbor_get_tstr(&val, &str, &len) < 0);
+    CU_ASSERT_EQUAL(val.cur, strs + 4);
+
+    /* A truncated string after complete ones */
+    nanocbor_decoder_init(&val, strs, sizeof(strs) - 1);
+    CU_ASSERT_EQUAL(nanocbor_get_bstr(&val, &str, &len), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_get_tstr(&val, &str, &len), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_get_tstr(&val, &str, &len), NANOCBOR_ERR_END);
+}
+
 static void test_decode_none(void)
 {
     nanocbor_value_t val;
@@ -248,6 +335,274 @@ static void test_decode_skip(void)
     _decode_skip_simple(test_simple, sizeof(test_simple));
 }
 
+static void test_skip_truncated(void)
+{
+    /* [1, missing] */
+    static const uint8_t array[] = { 0x82, 0x01 };
+    /* {1: missing} */
+    static const uint8_t map[] = { 0xa1, 0x01 };
+    /* [[1, missing]] */
+    static const uint8_t nested[] = { 0x81, 0x82, 0x01 };
+    /* [_ 1, missing break] */
+    static const uint8_t indefinite[] = { 0x9f, 0x01 };
+    /* 1([1, missing]) */
+    static const uint8_t tagged[] = { 0xc1, 0x82, 0x01 };
+    static const uint8_t *const inputs[] = { array, map, nested, indefinite,
+                                             tagged };
+    static const size_t lens[] = { sizeof(array), sizeof(map),
+                                   sizeof(nested), sizeof(indefinite),
+                                   sizeof(tagged) };
+
+    for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++) {
+        nanocbor_value_t val;
+        nanocbor_decoder_init(&val, inputs[i], lens[i]);
+        CU_ASSERT_EQUAL(nanocbor_skip(&val), NANOCBOR_ERR_END);
+    }
+}
+
+static void test_skip_tag(void)
+{
+    /* [1(2), 3] */
+    static const uint8_t tagged[] = { 0x82, 0xc1, 0x02, 0x03 };
+    /* [[[[[[[[[1(0)]]]]]]]]] */
+    static const uint8_t nested[] = { 0x81, 0x81, 0x81, 0x81, 0x81, 0x81,
+                                      0x81, 0x81, 0x81, 0xc1, 0x00 };
+    /* 1(1(1(1(1(1(1(1(1(1(0)))))))))) */
+    static const uint8_t chain[] = { 0xc1, 0xc1, 0xc1, 0xc1, 0xc1, 0xc1,
+                                     0xc1, 0xc1, 0xc1, 0xc1, 0x00 };
+    /* Tag without tagged item */
+    static const uint8_t truncated[] = { 0xc1 };
+
+    nanocbor_value_t val;
+    nanocbor_value_t arr;
+    uint32_t tmp = 0;
+
+    /* The tag is skipped together with the tagged item */
+    nanocbor_decoder_init(&val, tagged, sizeof(tagged));
+    CU_ASSERT_EQUAL(nanocbor_enter_array(&val, &arr), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_skip(&arr), NANOCBOR_OK);
+    CU_ASSERT(nanocbor_get_uint32(&arr, &tmp) > 0);
+    CU_ASSERT_EQUAL(tmp, 3);
+    CU_ASSERT(nanocbor_at_end(&arr));
+
+    /* Tags don't use up the recursion limit */
+    nanocbor_decoder_init(&val, nested, sizeof(nested));
+    CU_ASSERT_EQUAL(nanocbor_skip(&val), NANOCBOR_OK);
+    CU_ASSERT(nanocbor_at_end(&val));
+    nanocbor_decoder_init(&val, chain, sizeof(chain));
+    CU_ASSERT_EQUAL(nanocbor_skip(&val), NANOCBOR_OK);
+    CU_ASSERT(nanocbor_at_end(&val));
+
+    nanocbor_decoder_init(&val, truncated, sizeof(truncated));
+    CU_ASSERT_EQUAL(nanocbor_skip(&val), NANOCBOR_ERR_END);
+
+    /* Skipping only the tags leaves the tagged item */
+    nanocbor_decoder_init(&val, chain, sizeof(chain));
+    CU_ASSERT_EQUAL(nanocbor_skip_tags(&val), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(val.cur, chain + 10);
+    CU_ASSERT_EQUAL(nanocbor_skip_tags(&val), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(val.cur, chain + 10);
+    nanocbor_decoder_init(&val, chain, 1);
+    CU_ASSERT_EQUAL(nanocbor_skip_tags(&val), NANOCBOR_OK);
+    CU_ASSERT(nanocbor_at_end(&val));
+}
+
+static void test_decode_number(void)
+{
+    /* [-2, 18446744073709551615, 1.5, 7, "a"] */
+    static const uint8_t nums[] = { 0x85, 0x21, 0x1b, 0xff, 0xff, 0xff, 0xff,
+                                    0xff, 0xff, 0xff, 0xff, 0xf9, 0x3e, 0x00,
+                                    0x07, 0x61, 0x61 };
+
+    nanocbor_value_t val;
+    nanocbor_value_t arr;
+    nanocbor_number_t num;
+
+    nanocbor_decoder_init(&val, nums, sizeof(nums));
+    CU_ASSERT_EQUAL(nanocbor_enter_array(&val, &arr), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_get_number(&arr, &num), NANOCBOR_OK);
+    CU_ASSERT(num.is_int);
+    CU_ASSERT_EQUAL(num.i, -2);
+    CU_ASSERT_DOUBLE_EQUAL(num.f, -2.0, 0);
+    /* Too large for an int64_t */
+    CU_ASSERT_EQUAL(nanocbor_get_number(&arr, &num), NANOCBOR_OK);
+    CU_ASSERT(!num.is_int);
+    CU_ASSERT_DOUBLE_EQUAL(num.f, 18446744073709551615.0, 0);
+    CU_ASSERT_EQUAL(nanocbor_get_number(&arr, &num), NANOCBOR_OK);
+    CU_ASSERT(!num.is_int);
+    CU_ASSERT_DOUBLE_EQUAL(num.f, 1.5, 0);
+    /* Truncated item */
+    nanocbor_value_t cut = arr;
+    cut.end = cut.cur;
+    CU_ASSERT(nanocbor_get_number(&cut, &num) < 0);
+    CU_ASSERT_EQUAL(nanocbor_get_number(&arr, &num), NANOCBOR_OK);
+    CU_ASSERT(num.is_int);
+    CU_ASSERT_EQUAL(num.i, 7);
+    CU_ASSERT_EQUAL(nanocbor_get_number(&arr, &num),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    CU_ASSERT_EQUAL(nanocbor_skip(&arr), NANOCBOR_OK);
+    CU_ASSERT(nanocbor_at_end(&arr));
+}
+
+static void test_leave_container_early(void)
+{
+    /* [{1: 2, 3: [4, 5], 6: {7: 8}}, 9] */
+    static const uint8_t map_in_array[] = { 0x82, 0xa3, 0x01, 0x02, 0x03, 0x82,
+                                            0x04, 0x05, 0x06, 0xa1, 0x07, 0x08,
+                                            0x09 };
+    /* [[_ 1, [2, 3], 4], 5] */
+    static const uint8_t indefinite[]
+        = { 0x82, 0x9f, 0x01, 0x82, 0x02, 0x03, 0x04, 0xff, 0x05 };
+    /* {1: 2, 3: truncated */
+    static const uint8_t truncated[] = { 0xa2, 0x01, 0x02, 0x03 };
+
+    nanocbor_value_t val;
+    nanocbor_value_t arr;
+    nanocbor_value_t cont;
+    uint32_t tmp = 0;
+
+    nanocbor_decoder_init(&val, map_in_array, sizeof(map_in_array));
+    CU_ASSERT_EQUAL(nanocbor_enter_array(&val, &arr), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_enter_map(&arr, &cont), NANOCBOR_OK);
+    CU_ASSERT(nanocbor_get_uint32(&cont, &tmp) > 0);
+    CU_ASSERT_EQUAL(tmp, 1);
+    CU_ASSERT_EQUAL(nanocbor_leave_container_early(&arr, &cont), NANOCBOR_OK);
+    CU_ASSERT(nanocbor_get_uint32(&arr, &tmp) > 0);
+    CU_ASSERT_EQUAL(tmp, 9);
+    CU_ASSERT_EQUAL(nanocbor_at_end(&arr), true);
+
+    /* Leaving without consuming anything */
+    nanocbor_decoder_init(&val, map_in_array, sizeof(map_in_array));
+    CU_ASSERT_EQUAL(nanocbor_enter_array(&val, &arr), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_leave_container_early(&val, &arr), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_at_end(&val), true);
+
+    nanocbor_decoder_init(&val, indefinite, sizeof(indefinite));
+    CU_ASSERT_EQUAL(nanocbor_enter_array(&val, &arr), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_enter_array(&arr, &cont), NANOCBOR_OK);
+    CU_ASSERT(nanocbor_get_uint32(&cont, &tmp) > 0);
+    CU_ASSERT_EQUAL(nanocbor_leave_container_early(&arr, &cont), NANOCBOR_OK);
+    CU_ASSERT(nanocbor_get_uint32(&arr, &tmp) > 0);
+    CU_ASSERT_EQUAL(tmp, 5);
+    CU_ASSERT_EQUAL(nanocbor_at_end(&arr), true);
+
+    nanocbor_decoder_init(&val, truncated, sizeof(truncated));
+    CU_ASSERT_EQUAL(nanocbor_enter_map(&val, &cont), NANOCBOR_OK);
+    CU_ASSERT(nanocbor_leave_container_early(&val, &cont) < 0);
+}
+
+static void test_decode_int64_array(void)
+{
+    static const int64_t series[] = { 1000000, 1000001, 1000003, 999990,
+                                      INT64_MIN, INT64_MAX, 0 };
+    static const uint8_t plain[] = { 0x83, 0x01, 0x20, 0x18, 0x64 };
+    /* Delta array with an unknown tag */
+    static const uint8_t bad_tag[] = { 0xc1, 0x81, 0x01 };
+    uint8_t buf[128];
+    int64_t values[8];
+    size_t len = 0;
+    nanocbor_encoder_t enc;
+    nanocbor_value_t val;
+
+    nanocbor_encoder_init(&enc, buf, sizeof(buf));
+    CU_ASSERT(nanocbor_fmt_delta_array(&enc, series, 7) > 0);
+    size_t delta_len = nanocbor_encoded_len(&enc);
+    nanocbor_encoder_init(&enc, NULL, 0);
+    nanocbor_fmt_int64_array(&enc, series, 4);
+    nanocbor_encoder_t delta_enc;
+    nanocbor_encoder_init(&delta_enc, NULL, 0);
+    nanocbor_fmt_delta_array(&delta_enc, series, 4);
+    CU_ASSERT(nanocbor_encoded_len(&delta_enc) < nanocbor_encoded_len(&enc));
+
+    nanocbor_decoder_init(&val, buf, delta_len);
+    len = 8;
+    CU_ASSERT_EQUAL(nanocbor_get_int64_array(&val, values, &len), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(len, 7);
+    CU_ASSERT_EQUAL(memcmp(values, series, sizeof(series)), 0);
+    CU_ASSERT_EQUAL(nanocbor_at_end(&val), true);
+
+    nanocbor_decoder_init(&val, buf, delta_len);
+    len = 6;
+    CU_ASSERT_EQUAL(nanocbor_get_int64_array(&val, values, &len),
+                    NANOCBOR_ERR_OVERFLOW);
+
+    nanocbor_decoder_init(&val, buf, delta_len - 1);
+    len = 8;
+    CU_ASSERT_EQUAL(nanocbor_get_int64_array(&val, values, &len),
+                    NANOCBOR_ERR_END);
+
+    nanocbor_decoder_init(&val, plain, sizeof(plain));
+    len = 8;
+    CU_ASSERT_EQUAL(nanocbor_get_int64_array(&val, values, &len), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(len, 3);
+    CU_ASSERT_EQUAL(values[0], 1);
+    CU_ASSERT_EQUAL(values[1], -1);
+    CU_ASSERT_EQUAL(values[2], 100);
+
+    nanocbor_decoder_init(&val, bad_tag, sizeof(bad_tag));
+    len = 8;
+    CU_ASSERT_EQUAL(nanocbor_get_int64_array(&val, values, &len),
+                    NANOCBOR_ERR_INVALID_TYPE);
+}
+
+static void test_decode_half_float(void)
+{
+    /* -0.0, 1.0, 5.960464477539063e-8, -5.960464477539063e-8 */
+    static const uint8_t halves[] = { 0xf9, 0x80, 0x00, 0xf9, 0x3c, 0x00,
+                                      0xf9, 0x00, 0x01, 0xf9, 0x80, 0x01 };
+    nanocbor_value_t val;
+    float value = 1;
+
+    nanocbor_decoder_init(&val, halves, sizeof(halves));
+    CU_ASSERT(nanocbor_get_float(&val, &value) > 0);
+    CU_ASSERT(value == 0 && signbit(value));
+    CU_ASSERT(nanocbor_get_float(&val, &value) > 0);
+    CU_ASSERT(value == 1);
+    CU_ASSERT(nanocbor_get_float(&val, &value) > 0);
+    CU_ASSERT(value == 0x1p-24f);
+    CU_ASSERT(nanocbor_get_float(&val, &value) > 0);
+    CU_ASSERT(value == -0x1p-24f);
+}
+
+static void test_compare(void)
+{
+    /* Sequence in ascending order:
+     * -1, 0, 1, 1.0, 1.5, 1(3), 1e18, 18446744073709551615, NaN, h'', "a",
+     * "ab", "b", [], true */
+    static const uint8_t items[] = {
+        0x20, 0x00, 0x01, 0xf9, 0x3c, 0x00, 0xf9, 0x3e, 0x00, 0xc1, 0x03,
+        0xfb, 0x43, 0xab, 0xc1, 0x6d, 0x67, 0x4e, 0xc8, 0x00, 0x1b, 0xff,
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf9, 0x7e, 0x00, 0x40,
+        0x61, 0x61, 0x62, 0x61, 0x62, 0x61, 0x62, 0x80, 0xf5,
+    };
+    nanocbor_value_t values[15];
+    nanocbor_value_t it;
+    size_t num = 0;
+
+    nanocbor_decoder_init(&it, items, sizeof(items));
+    while (!nanocbor_at_end(&it) && num < 15) {
+        values[num++] = it;
+        CU_ASSERT_EQUAL(nanocbor_skip(&it), NANOCBOR_OK);
+    }
+    CU_ASSERT_EQUAL(num, 15);
+    CU_ASSERT_EQUAL(nanocbor_at_end(&it), true);
+
+    for (size_t i = 0; i < num; i++) {
+        for (size_t j = 0; j < num; j++) {
+            int cmp = nanocbor_compare(&values[i], &values[j]);
+            if (i < j) {
+                CU_ASSERT(cmp < 0);
+            }
+            else if (i > j) {
+                CU_ASSERT(cmp > 0);
+            }
+            else {
+                CU_ASSERT_EQUAL(cmp, 0);
+            }
+        }
+    }
+}
+
 const test_t tests_decoder[] = {
     {
         .f = test_decode_none,
@@ -273,10 +628,46 @@ const test_t tests_decoder[] = {
         .f = test_double_tag,
         .n = "CBOR double tag decode test",
     },
+    {
+        .f = test_tag64,
+        .n = "CBOR 64 bit tag decode test",
+    },
+    {
+        .f = test_decode_str_truncated,
+        .n = "CBOR truncated string decode test",
+    },
     {
         .f = test_decode_skip,
         .n = "CBOR simple skip test",
     },
+    {
+        .f = test_skip_truncated,
+        .n = "CBOR truncated container skip test",
+    },
+    {
+        .f = test_skip_tag,
+        .n = "CBOR tagged item skip test",
+    },
+    {
+        .f = test_decode_number,
+        .n = "CBOR number decode test",
+    },
+    {
+        .f = test_leave_container_early,
+        .n = "CBOR leave container early test",
+    },
+    {
+        .f = test_decode_int64_array,
+        .n = "CBOR integer array and delta array decode test",
+    },
+    {
+        .f = test_decode_half_float,
+        .n = "CBOR half precision float decode test",
+    },
+    {
+        .f = test_compare,
+        .n = "CBOR item comparison test",
+    },
     {
         .f = NULL,
         .n = NULL,
@@ -0,0 +1,189 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "nanocbor/config.h"
+#include "nanocbor/dict.h"
+#include "nanocbor/nanocbor.h"
+#include "test.h"
+#include <CUnit/CUnit.h>
+#include <string.h>
+
+/* NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers) */
+
+static const uint8_t _blob[] = { 0xde, 0xad, 0xbe, 0xef, 0x01, 0x02 };
+
+/* Encodes a record of the session, prefixed with any update record */
+static size_t _message(nanocbor_dict_t *dict, uint8_t *buf, size_t len,
+                       uint32_t seq)
+{
+    nanocbor_encoder_t enc;
+
+    nanocbor_encoder_init(&enc, buf, len);
+    CU_ASSERT_EQUAL(nanocbor_dict_fmt_update(dict, &enc), NANOCBOR_OK);
+    nanocbor_fmt_map(&enc, 4);
+    CU_ASSERT_EQUAL(nanocbor_dict_put_tstr(dict, &enc, "temperature"),
+                    NANOCBOR_OK);
+    nanocbor_fmt_uint(&enc, 20 + seq);
+    CU_ASSERT_EQUAL(nanocbor_dict_put_tstr(dict, &enc, "unit"), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_dict_put_tstr(dict, &enc, "degrees celsius"),
+                    NANOCBOR_OK);
+    nanocbor_dict_put_tstr(dict, &enc, "id");
+    nanocbor_fmt_uint(&enc, seq);
+    nanocbor_dict_put_tstr(dict, &enc, "key");
+    CU_ASSERT_EQUAL(nanocbor_dict_put_bstr(dict, &enc, _blob, sizeof(_blob)),
+                    NANOCBOR_OK);
+    return nanocbor_encoded_len(&enc);
+}
+
+static void _check(const nanocbor_dict_t *dict, nanocbor_value_t *map,
+                   const char *expected)
+{
+    const uint8_t *str = NULL;
+    size_t len = 0;
+
+    CU_ASSERT_EQUAL(nanocbor_dict_get_tstr(dict, map, &str, &len),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(len, strlen(expected));
+    CU_ASSERT_EQUAL(memcmp(str, expected, len), 0);
+}
+
+static void test_dict_session(void)
+{
+    nanocbor_dict_entry_t tx_entries[8];
+    nanocbor_dict_entry_t rx_entries[8];
+    uint8_t tx_arena[64];
+    uint8_t rx_arena[64];
+    nanocbor_dict_t tx;
+    nanocbor_dict_t rx;
+    uint8_t buf[128];
+    size_t sizes[6];
+
+    nanocbor_dict_init(&tx, tx_entries, 8, tx_arena, sizeof(tx_arena));
+    nanocbor_dict_init(&rx, rx_entries, 8, rx_arena, sizeof(rx_arena));
+    for (uint32_t seq = 0; seq < 6; seq++) {
+        sizes[seq] = _message(&tx, buf, sizeof(buf), seq);
+
+        nanocbor_value_t it;
+        nanocbor_value_t map;
+        const uint8_t *str = NULL;
+        size_t len = 0;
+        uint32_t val = 0;
+        nanocbor_decoder_init(&it, buf, sizes[seq]);
+        CU_ASSERT_EQUAL(nanocbor_dict_get_update(&rx, &it),
+                        seq == 3 ? NANOCBOR_OK : NANOCBOR_NOT_FOUND);
+        CU_ASSERT_EQUAL(nanocbor_enter_map(&it, &map), NANOCBOR_OK);
+        _check(&rx, &map, "temperature");
+        CU_ASSERT(nanocbor_get_uint32(&map, &val) > 0);
+        CU_ASSERT_EQUAL(val, 20 + seq);
+        _check(&rx, &map, "unit");
+        _check(&rx, &map, "degrees celsius");
+        _check(&rx, &map, "id");
+        CU_ASSERT(nanocbor_get_uint32(&map, &val) > 0);
+        CU_ASSERT_EQUAL(val, seq);
+        _check(&rx, &map, "key");
+        CU_ASSERT_EQUAL(nanocbor_dict_get_bstr(&rx, &map, &str, &len),
+                        NANOCBOR_OK);
+        CU_ASSERT_EQUAL(len, sizeof(_blob));
+        CU_ASSERT_EQUAL(memcmp(str, _blob, len), 0);
+        /* References resolve into the dictionary */
+        if (seq > 3) {
+            CU_ASSERT(str >= rx_arena && str < rx_arena + sizeof(rx_arena));
+        }
+        CU_ASSERT(nanocbor_at_end(&map));
+        nanocbor_leave_container(&it, &map);
+        CU_ASSERT(nanocbor_at_end(&it));
+    }
+
+    /* Strings are learned after three occurrences and announced once, short
+     * strings are not learned */
+    CU_ASSERT_EQUAL(sizes[1], sizes[0]);
+    CU_ASSERT_EQUAL(sizes[2], sizes[0]);
+    CU_ASSERT(sizes[3] > sizes[0]);
+    CU_ASSERT(sizes[4] < sizes[0] * 2 / 3);
+    CU_ASSERT_EQUAL(sizes[5], sizes[4]);
+    CU_ASSERT_EQUAL(tx.num_entries, 4);
+    CU_ASSERT_EQUAL(tx.announced, 4);
+    CU_ASSERT_EQUAL(rx.num_entries, 4);
+    CU_ASSERT_EQUAL(rx.arena_used, tx.arena_used);
+}
+
+static void test_dict_invalid(void)
+{
+    nanocbor_dict_entry_t entries[2];
+    uint8_t arena[32];
+    nanocbor_dict_t dict;
+    nanocbor_value_t it;
+    const uint8_t *str = NULL;
+    size_t len = 0;
+
+    /* Update record with a text and a byte string */
+    static const uint8_t update[] = { 0xd9, 0xde, 0x1e, 0x83, 0x00, 0x63,
+                                      'a',  'b',  'c',  0x42, 0x01, 0x02 };
+    /* Reference to the second entry */
+    static const uint8_t ref[] = { 0xd9, 0xde, 0x1d, 0x01 };
+    static const uint8_t unknown[] = { 0xd9, 0xde, 0x1d, 0x05 };
+    static const uint8_t other_tag[] = { 0xc1, 0x01 };
+    /* Update record starting at the third entry */
+    static const uint8_t third[] = { 0xd9, 0xde, 0x1e, 0x82, 0x02, 0x61, 'x' };
+    static const uint8_t not_str[] = { 0xd9, 0xde, 0x1e, 0x82, 0x00, 0x01 };
+
+    nanocbor_dict_init(&dict, entries, 2, arena, sizeof(arena));
+    nanocbor_decoder_init(&it, other_tag, sizeof(other_tag));
+    CU_ASSERT_EQUAL(nanocbor_dict_get_update(&dict, &it), NANOCBOR_NOT_FOUND);
+    CU_ASSERT_EQUAL(nanocbor_dict_get_tstr(&dict, &it, &str, &len),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    nanocbor_decoder_init(&it, not_str, sizeof(not_str));
+    CU_ASSERT_EQUAL(nanocbor_dict_get_update(&dict, &it),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    CU_ASSERT_EQUAL(dict.num_entries, 0);
+
+    nanocbor_decoder_init(&it, update, sizeof(update));
+    CU_ASSERT_EQUAL(nanocbor_dict_get_update(&dict, &it), NANOCBOR_OK);
+    CU_ASSERT(nanocbor_at_end(&it));
+    CU_ASSERT_EQUAL(dict.num_entries, 2);
+
+    nanocbor_decoder_init(&it, ref, sizeof(ref));
+    CU_ASSERT_EQUAL(nanocbor_dict_get_tstr(&dict, &it, &str, &len),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    CU_ASSERT_EQUAL(nanocbor_dict_get_bstr(&dict, &it, &str, &len),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(len, 2);
+    CU_ASSERT_EQUAL(str, arena + 3);
+    CU_ASSERT(nanocbor_at_end(&it));
+    nanocbor_decoder_init(&it, unknown, sizeof(unknown));
+    CU_ASSERT_EQUAL(nanocbor_dict_get_tstr(&dict, &it, &str, &len),
+                    NANOCBOR_NOT_FOUND);
+
+    /* A record not continuing the dictionary, as after a lost message */
+    nanocbor_dict_init(&dict, entries, 2, arena, sizeof(arena));
+    nanocbor_decoder_init(&it, third, sizeof(third));
+    CU_ASSERT_EQUAL(nanocbor_dict_get_update(&dict, &it),
+                    NANOCBOR_ERR_INVALID_TYPE);
+
+    /* Dictionary full */
+    nanocbor_decoder_init(&it, update, sizeof(update));
+    CU_ASSERT_EQUAL(nanocbor_dict_get_update(&dict, &it), NANOCBOR_OK);
+    nanocbor_decoder_init(&it, third, sizeof(third));
+    CU_ASSERT_EQUAL(nanocbor_dict_get_update(&dict, &it),
+                    NANOCBOR_ERR_OVERFLOW);
+    CU_ASSERT_EQUAL(dict.num_entries, 2);
+    CU_ASSERT_EQUAL(dict.arena_used, 5);
+}
+
+const test_t tests_dict[] = {
+    {
+        .f = test_dict_session,
+        .n = "Session dictionary encode and decode test",
+    },
+    {
+        .f = test_dict_invalid,
+        .n = "Session dictionary invalid input test",
+    },
+    {
+        .f = NULL,
+        .n = NULL,
+    },
+};
+
+/* NOLINTEND(cppcoreguidelines-avoid-magic-numbers) */
@@ -0,0 +1,242 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "nanocbor/diff.h"
+#include "nanocbor/nanocbor.h"
+#include "test.h"
+#include <CUnit/CUnit.h>
+#include <string.h>
+
+/* NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers) */
+
+/* Diffs two items, applies the patch and returns the patch size */
+static size_t _roundtrip(const uint8_t *old, size_t old_len,
+                         const uint8_t *updated, size_t updated_len)
+{
+    uint8_t patch[256];
+    uint8_t out[256];
+    nanocbor_value_t from;
+    nanocbor_value_t to;
+    nanocbor_value_t it;
+    nanocbor_encoder_t enc;
+
+    nanocbor_decoder_init(&from, old, old_len);
+    nanocbor_decoder_init(&to, updated, updated_len);
+    nanocbor_encoder_init(&enc, patch, sizeof(patch));
+    CU_ASSERT_EQUAL(nanocbor_diff(&from, &to, &enc), NANOCBOR_OK);
+    CU_ASSERT(nanocbor_at_end(&from));
+    CU_ASSERT(nanocbor_at_end(&to));
+    size_t patch_len = nanocbor_encoded_len(&enc);
+
+    nanocbor_decoder_init(&from, old, old_len);
+    nanocbor_decoder_init(&it, patch, patch_len);
+    nanocbor_encoder_init(&enc, out, sizeof(out));
+    CU_ASSERT_EQUAL(nanocbor_patch(&from, &it, &enc), NANOCBOR_OK);
+    CU_ASSERT(nanocbor_at_end(&it));
+    CU_ASSERT_EQUAL(nanocbor_encoded_len(&enc), updated_len);
+    CU_ASSERT_EQUAL(memcmp(out, updated, updated_len), 0);
+    return patch_len;
+}
+
+/* State with a removed entry at the end of the old and an added entry at
+ * the end of the new version, so both patch directions keep the order */
+static size_t _state(uint8_t *buf, size_t len, bool updated)
+{
+    nanocbor_encoder_t enc;
+
+    nanocbor_encoder_init(&enc, buf, len);
+    nanocbor_fmt_map(&enc, 6);
+    nanocbor_put_tstr(&enc, "id");
+    nanocbor_fmt_uint(&enc, 7);
+    nanocbor_put_tstr(&enc, "name");
+    nanocbor_put_tstr(&enc, "a device with a long name");
+    nanocbor_put_tstr(&enc, "cfg");
+    nanocbor_fmt_map(&enc, updated ? 3 : 2);
+    nanocbor_put_tstr(&enc, "rate");
+    nanocbor_fmt_uint(&enc, updated ? 20 : 10);
+    nanocbor_put_tstr(&enc, "mode");
+    nanocbor_put_tstr(&enc, "automatic");
+    if (updated) {
+        nanocbor_put_tstr(&enc, "new");
+        nanocbor_fmt_bool(&enc, true);
+    }
+    nanocbor_put_tstr(&enc, "log");
+    nanocbor_fmt_array(&enc, updated ? 4 : 3);
+    for (unsigned i = 0; i < (updated ? 4U : 3U); i++) {
+        nanocbor_put_tstr(&enc, "a log line");
+    }
+    nanocbor_put_tstr(&enc, "tagged");
+    nanocbor_fmt_tag(&enc, 1);
+    nanocbor_fmt_map(&enc, 1);
+    nanocbor_fmt_uint(&enc, 1);
+    nanocbor_fmt_uint(&enc, updated ? 2 : 1);
+    nanocbor_put_tstr(&enc, updated ? "added" : "removed");
+    nanocbor_fmt_null(&enc);
+    return nanocbor_encoded_len(&enc);
+}
+
+static void test_diff_roundtrip(void)
+{
+    uint8_t old[256];
+    uint8_t updated[256];
+    size_t old_len = _state(old, sizeof(old), false);
+    size_t updated_len = _state(updated, sizeof(updated), true);
+
+    /* The patch holds only the changes */
+    size_t patch_len = _roundtrip(old, old_len, updated, updated_len);
+    CU_ASSERT(patch_len < updated_len * 2 / 3);
+    CU_ASSERT(_roundtrip(updated, updated_len, old, old_len) < old_len * 2 / 3);
+
+    /* Unchanged item */
+    uint8_t patch[8];
+    nanocbor_value_t from;
+    nanocbor_value_t to;
+    nanocbor_encoder_t enc;
+    nanocbor_decoder_init(&from, old, old_len);
+    nanocbor_decoder_init(&to, old, old_len);
+    nanocbor_encoder_init(&enc, patch, sizeof(patch));
+    CU_ASSERT_EQUAL(nanocbor_diff(&from, &to, &enc), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_encoded_len(&enc), 2);
+    CU_ASSERT_EQUAL(patch[0], 0x81);
+    CU_ASSERT_EQUAL(patch[1], NANOCBOR_PATCH_KEEP);
+    CU_ASSERT_EQUAL(_roundtrip(old, old_len, old, old_len), 2);
+
+    /* Truncated array with a changed nested element */
+    static const uint8_t arr_old[] = { 0x84, 0x01, 0x82, 0x02, 0x03, 0x04,
+                                       0x05 };
+    static const uint8_t arr_new[] = { 0x82, 0x01, 0x82, 0x02, 0x09 };
+    _roundtrip(arr_old, sizeof(arr_old), arr_new, sizeof(arr_new));
+    _roundtrip(arr_new, sizeof(arr_new), arr_old, sizeof(arr_old));
+
+    /* Items of another type or tag are replaced */
+    static const uint8_t map[] = { 0xa1, 0x61, 0x61, 0x01 };
+    static const uint8_t tagged[] = { 0xc1, 0xa1, 0x61, 0x61, 0x01 };
+    static const uint8_t replace[] = { 0x82, 0x01, 0xc1, 0xa1,
+                                       0x61, 0x61, 0x01 };
+    CU_ASSERT_EQUAL(_roundtrip(map, sizeof(map), tagged, sizeof(tagged)),
+                    sizeof(replace));
+    nanocbor_decoder_init(&from, map, sizeof(map));
+    nanocbor_decoder_init(&to, tagged, sizeof(tagged));
+    nanocbor_encoder_init(&enc, patch, sizeof(patch));
+    CU_ASSERT_EQUAL(nanocbor_diff(&from, &to, &enc), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(memcmp(patch, replace, sizeof(replace)), 0);
+
+    /* Encoder too small */
+    nanocbor_decoder_init(&from, old, old_len);
+    nanocbor_decoder_init(&to, updated, updated_len);
+    nanocbor_encoder_init(&enc, patch, sizeof(patch));
+    CU_ASSERT(nanocbor_diff(&from, &to, &enc) < 0);
+}
+
+/* Containers nested @p depth deep with an unchanged sibling on every level,
+ * maps on the levels set in @p maps, around the leaf @p leaf */
+static size_t _nested(uint8_t *buf, size_t len, unsigned depth, unsigned maps,
+                      uint32_t leaf)
+{
+    nanocbor_encoder_t enc;
+
+    nanocbor_encoder_init(&enc, buf, len);
+    for (unsigned i = 0; i < depth; i++) {
+        if (maps & (1U << i)) {
+            nanocbor_fmt_map(&enc, 2);
+            nanocbor_fmt_uint(&enc, 0);
+            nanocbor_fmt_uint(&enc, i);
+            nanocbor_fmt_uint(&enc, 1);
+        }
+        else {
+            nanocbor_fmt_array(&enc, 2);
+            nanocbor_fmt_uint(&enc, i);
+        }
+    }
+    nanocbor_fmt_uint(&enc, leaf);
+    return nanocbor_encoded_len(&enc);
+}
+
+static void test_diff_deep(void)
+{
+    static const unsigned maps[] = { 0x000, 0x3ff, 0x155, 0x2aa };
+    uint8_t old[64];
+    uint8_t updated[64];
+
+    /* Patches of items nested up to the decoder limit stay decodable */
+    for (unsigned depth = 1; depth < NANOCBOR_RECURSION_MAX; depth++) {
+        for (unsigned i = 0; i < sizeof(maps) / sizeof(maps[0]); i++) {
+            size_t old_len = _nested(old, sizeof(old), depth, maps[i], 1);
+            size_t updated_len
+                = _nested(updated, sizeof(updated), depth, maps[i], 2);
+            _roundtrip(old, old_len, updated, updated_len);
+        }
+    }
+
+    /* [[[[[1]]]]] to [[[[[2]]]]] */
+    static const uint8_t deep_old[] = { 0x81, 0x81, 0x81, 0x81, 0x81, 0x01 };
+    static const uint8_t deep_new[] = { 0x81, 0x81, 0x81, 0x81, 0x81, 0x02 };
+    _roundtrip(deep_old, sizeof(deep_old), deep_new, sizeof(deep_new));
+}
+
+static void test_patch_invalid(void)
+{
+    uint8_t out[32];
+    nanocbor_value_t old;
+    nanocbor_value_t patch;
+    nanocbor_encoder_t enc;
+    static const uint8_t arr[] = { 0x82, 0x01, 0x02 };
+    static const uint8_t map[] = { 0xa1, 0x01, 0x02 };
+    static const uint8_t remove[] = { 0x81, NANOCBOR_PATCH_REMOVE };
+    static const uint8_t map_patch[] = { 0x82, NANOCBOR_PATCH_MAP, 0xa0 };
+    /* Keeping 3 elements of an array of 2 */
+    static const uint8_t keep[] = { 0x83, NANOCBOR_PATCH_ARRAY, 0x03, 0xa0 };
+    /* Adding an entry without a replacement */
+    static const uint8_t add[] = { 0x82, NANOCBOR_PATCH_MAP, 0xa1,
+                                   0x02, 0x81, NANOCBOR_PATCH_KEEP };
+    /* Removing an entry */
+    static const uint8_t removed[] = { 0x82, NANOCBOR_PATCH_MAP, 0xa1,
+                                       0x01, 0x81, NANOCBOR_PATCH_REMOVE };
+
+    nanocbor_encoder_init(&enc, out, sizeof(out));
+    nanocbor_decoder_init(&old, arr, sizeof(arr));
+    nanocbor_decoder_init(&patch, remove, sizeof(remove));
+    CU_ASSERT_EQUAL(nanocbor_patch(&old, &patch, &enc),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    nanocbor_decoder_init(&old, arr, sizeof(arr));
+    nanocbor_decoder_init(&patch, map_patch, sizeof(map_patch));
+    CU_ASSERT_EQUAL(nanocbor_patch(&old, &patch, &enc),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    nanocbor_decoder_init(&old, arr, sizeof(arr));
+    nanocbor_decoder_init(&patch, keep, sizeof(keep));
+    CU_ASSERT_EQUAL(nanocbor_patch(&old, &patch, &enc),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    nanocbor_decoder_init(&old, map, sizeof(map));
+    nanocbor_decoder_init(&patch, add, sizeof(add));
+    CU_ASSERT_EQUAL(nanocbor_patch(&old, &patch, &enc),
+                    NANOCBOR_ERR_INVALID_TYPE);
+
+    nanocbor_encoder_init(&enc, out, sizeof(out));
+    nanocbor_decoder_init(&old, map, sizeof(map));
+    nanocbor_decoder_init(&patch, removed, sizeof(removed));
+    CU_ASSERT_EQUAL(nanocbor_patch(&old, &patch, &enc), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_encoded_len(&enc), 1);
+    CU_ASSERT_EQUAL(out[0], 0xa0);
+}
+
+const test_t tests_diff[] = {
+    {
+        .f = test_diff_roundtrip,
+        .n = "Diff and patch roundtrip test",
+    },
+    {
+        .f = test_diff_deep,
+        .n = "Diff and patch roundtrip of nested items test",
+    },
+    {
+        .f = test_patch_invalid,
+        .n = "Patch of mismatching items test",
+    },
+    {
+        .f = NULL,
+        .n = NULL,
+    },
+};
+
+/* NOLINTEND(cppcoreguidelines-avoid-magic-numbers) */
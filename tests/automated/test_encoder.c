@@ -7,6 +7,7 @@
 #include <CUnit/CUnit.h>
 #include <float.h>
 #include <math.h>
+#include <string.h>
 
 static void print_bytestr(const uint8_t *bytes, size_t len)
 {
@@ -89,6 +90,268 @@ static void test_encode_double_to_float(void)
     print_bytestr(buf, nanocbor_encoded_len(&enc));
 }
 
+static void test_encode_indefinite_str(void)
+{
+    static const uint8_t expected[] = {
+        0x83, /* [ */
+        0x5f, 0x42, 0x01, 0x02, 0x41, 0x03, 0xff, /* (_ h'0102', h'03'), */
+        0x7f, 0x62, 0x61, 0x62, 0x61, 0x63, 0xff, /* (_ "ab", "c"), */
+        0x05, /* 5] */
+    };
+    static const uint8_t bytes[] = { 0x01, 0x02, 0x03 };
+    uint8_t buf[64];
+    nanocbor_encoder_t enc;
+    nanocbor_encoder_init(&enc, buf, sizeof(buf));
+
+    CU_ASSERT_EQUAL(nanocbor_fmt_array(&enc, 3), 1);
+    CU_ASSERT_EQUAL(nanocbor_fmt_bstr_indefinite(&enc), 1);
+    CU_ASSERT_EQUAL(nanocbor_put_bstr_chunk(&enc, bytes, 2), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_put_bstr_chunk(&enc, bytes + 2, 1), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_fmt_end_indefinite(&enc), 1);
+
+    CU_ASSERT_EQUAL(nanocbor_fmt_tstr_indefinite(&enc), 1);
+    CU_ASSERT_EQUAL(nanocbor_put_tstr_chunk(&enc, "abc", 2), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_put_tstr_chunk(&enc, "c", 1), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_fmt_end_indefinite(&enc), 1);
+    CU_ASSERT(nanocbor_fmt_uint(&enc, 5) > 0);
+
+    size_t len = nanocbor_encoded_len(&enc);
+    CU_ASSERT_EQUAL(len, sizeof(expected));
+    CU_ASSERT_EQUAL(memcmp(buf, expected, sizeof(expected)), 0);
+
+    /* Skip the strings and decode their chunks */
+    nanocbor_value_t val;
+    nanocbor_value_t arr;
+    nanocbor_value_t chunks;
+    const uint8_t *str = NULL;
+    size_t str_len = 0;
+    uint32_t tmp = 0;
+
+    nanocbor_decoder_init(&val, buf, len);
+    CU_ASSERT_EQUAL(nanocbor_skip(&val), NANOCBOR_OK);
+    CU_ASSERT(nanocbor_at_end(&val));
+
+    nanocbor_decoder_init(&val, buf, len);
+    CU_ASSERT_EQUAL(nanocbor_enter_array(&val, &arr), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_get_subcbor(&arr, &str, &str_len), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(str_len, 7);
+    nanocbor_decoder_init(&chunks, str + 1, str_len - 1);
+    CU_ASSERT_EQUAL(nanocbor_get_bstr(&chunks, &str, &str_len), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(str_len, 2);
+    CU_ASSERT_EQUAL(memcmp(str, bytes, 2), 0);
+    CU_ASSERT_EQUAL(nanocbor_get_bstr(&chunks, &str, &str_len), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(str_len, 1);
+    CU_ASSERT_EQUAL(str[0], 0x03);
+    CU_ASSERT_EQUAL(nanocbor_skip_simple(&arr), NANOCBOR_OK);
+    CU_ASSERT(nanocbor_get_uint32(&arr, &tmp) > 0);
+    CU_ASSERT_EQUAL(tmp, 5);
+    CU_ASSERT(nanocbor_at_end(&arr));
+
+    /* Missing break, chunk of another type */
+    nanocbor_decoder_init(&val, buf + 1, 6);
+    CU_ASSERT_EQUAL(nanocbor_skip(&val), NANOCBOR_ERR_END);
+    static const uint8_t mixed[] = { 0x5f, 0x61, 0x61, 0xff };
+    nanocbor_decoder_init(&val, mixed, sizeof(mixed));
+    CU_ASSERT_EQUAL(nanocbor_skip(&val), NANOCBOR_ERR_INVALID_TYPE);
+}
+
+static void _check_lossy(double num, double abs_tol, double rel_tol,
+                         int size)
+{
+    uint8_t buf[16];
+    nanocbor_encoder_t enc;
+    nanocbor_value_t val;
+    double res = 0;
+
+    nanocbor_encoder_init(&enc, buf, sizeof(buf));
+    CU_ASSERT_EQUAL(nanocbor_fmt_double_lossy(&enc, num, abs_tol, rel_tol),
+                    size);
+    nanocbor_decoder_init(&val, buf, nanocbor_encoded_len(&enc));
+    CU_ASSERT(nanocbor_get_double(&val, &res) > 0);
+    CU_ASSERT(res == num || fabs(res - num) <= abs_tol
+              || fabs(res - num) <= rel_tol * fabs(num));
+}
+
+static void test_encode_double_lossy(void)
+{
+    // NOLINTBEGIN
+    _check_lossy(0.1, 1e-3, 0, 3);
+    _check_lossy(0.1, 1e-6, 0, 5);
+    _check_lossy(0.1, 0, 0, 9);
+    _check_lossy(3.14159265358979, 0, 1e-3, 3);
+    _check_lossy(3.14159265358979, 0, 1e-6, 5);
+    _check_lossy(-100000.3, 1, 0, 5);
+    _check_lossy(1e-300, 0, 0.5, 9);
+    _check_lossy(1e-300, 1e-200, 0, 3);
+    _check_lossy(0x1p-20 + 0x1p-40, 1e-9, 0, 3);
+    _check_lossy(1.75, 0, 0, 3);
+    _check_lossy(INFINITY, 0, 0, 3);
+
+    /* Ties round to even */
+    uint8_t buf[64];
+    nanocbor_encoder_t enc;
+    nanocbor_encoder_init(&enc, buf, sizeof(buf));
+    CU_ASSERT_EQUAL(nanocbor_fmt_double_lossy(&enc, 1.0 + 0x1p-11 + 0x1p-40,
+                                              0x1p-10, 0),
+                    3);
+    CU_ASSERT_EQUAL(nanocbor_fmt_double_lossy(&enc, 1.0 + 0x1p-11, 0x1p-10, 0),
+                    3);
+    CU_ASSERT_EQUAL(nanocbor_fmt_double_lossy(&enc, 1.0 + 0x3p-11, 0x1p-10, 0),
+                    3);
+    static const uint8_t expected[] = { 0xf9, 0x3c, 0x01, 0xf9, 0x3c, 0x00,
+                                        0xf9, 0x3c, 0x02 };
+    CU_ASSERT_EQUAL(memcmp(buf, expected, sizeof(expected)), 0);
+
+    static const double values[] = { 0.5, 0.1, 1e10 + 0.5 };
+    nanocbor_encoder_init(&enc, buf, sizeof(buf));
+    CU_ASSERT_EQUAL(nanocbor_fmt_double_array_lossy(&enc, values, 3, 1e-3, 0),
+                    1 + 3 + 3 + 9);
+    // NOLINTEND
+}
+
+struct sensor {
+    uint32_t id;
+    int16_t temp;
+    bool active;
+    const char *name;
+    float value;
+};
+
+static const nanocbor_field_t sensor_fields[] = {
+    NANOCBOR_FIELD("\x01", NANOCBOR_FIELD_UINT32, struct sensor, id, 0),
+    NANOCBOR_FIELD("\x02", NANOCBOR_FIELD_INT16, struct sensor, temp,
+                   NANOCBOR_FIELD_FLAG_OMIT_DEFAULT),
+    NANOCBOR_FIELD("\x66" "active", NANOCBOR_FIELD_BOOL, struct sensor, active,
+                   NANOCBOR_FIELD_FLAG_OMIT_DEFAULT),
+    NANOCBOR_FIELD("\x64" "name", NANOCBOR_FIELD_TSTR, struct sensor, name,
+                   NANOCBOR_FIELD_FLAG_OMIT_DEFAULT),
+    NANOCBOR_FIELD("\x20", NANOCBOR_FIELD_FLOAT, struct sensor, value, 0),
+};
+
+static void test_encode_struct(void)
+{
+    static const uint8_t expected_map[] = {
+        0xa4, 0x01, 0x19, 0x01, 0x00, 0x02, 0x38, 0x1d, 0x64, 0x6e, 0x61,
+        0x6d, 0x65, 0x62, 0x74, 0x31, 0x20, 0xf9, 0x3e, 0x00,
+    };
+    static const uint8_t expected_array[] = {
+        0x85, 0x19, 0x01, 0x00, 0x38, 0x1d, 0xf4,
+        0x62, 0x74, 0x31, 0xf9, 0x3e, 0x00,
+    };
+    const struct sensor sensor = {
+        .id = 256, .temp = -30, .active = false, .name = "t1", .value = 1.5f
+    };
+    uint8_t buf[64];
+    nanocbor_encoder_t enc;
+
+    nanocbor_encoder_init(&enc, buf, sizeof(buf));
+    CU_ASSERT_EQUAL(nanocbor_fmt_struct_map(&enc, sensor_fields, 5, &sensor),
+                    sizeof(expected_map));
+    CU_ASSERT_EQUAL(nanocbor_encoded_len(&enc), sizeof(expected_map));
+    CU_ASSERT_EQUAL(memcmp(buf, expected_map, sizeof(expected_map)), 0);
+
+    nanocbor_encoder_init(&enc, buf, sizeof(buf));
+    CU_ASSERT_EQUAL(nanocbor_fmt_struct_array(&enc, sensor_fields, 5, &sensor),
+                    sizeof(expected_array));
+    CU_ASSERT_EQUAL(memcmp(buf, expected_array, sizeof(expected_array)), 0);
+
+    /* Too small buffer */
+    nanocbor_encoder_init(&enc, buf, 4);
+    CU_ASSERT(nanocbor_fmt_struct_map(&enc, sensor_fields, 5, &sensor) < 0);
+    CU_ASSERT_EQUAL(nanocbor_encoded_len(&enc), sizeof(expected_map));
+}
+
+typedef struct {
+    uint8_t data[256];
+    size_t len;
+    unsigned fits;
+    unsigned appends;
+    unsigned vecs;
+} _stream_t;
+
+static bool _stream_fits(nanocbor_encoder_t *enc, void *ctx, size_t len)
+{
+    _stream_t *stream = ctx;
+
+    (void)enc;
+    stream->fits++;
+    return sizeof(stream->data) - stream->len >= len;
+}
+
+static void _stream_append(nanocbor_encoder_t *enc, void *ctx,
+                           const uint8_t *data, size_t len)
+{
+    _stream_t *stream = ctx;
+
+    (void)enc;
+    stream->appends++;
+    memcpy(stream->data + stream->len, data, len);
+    stream->len += len;
+}
+
+static void _stream_append_vec(nanocbor_encoder_t *enc, void *ctx,
+                               const nanocbor_encoder_vec_t *vec, size_t num)
+{
+    _stream_t *stream = ctx;
+
+    (void)enc;
+    stream->vecs++;
+    for (size_t i = 0; i < num; i++) {
+        memcpy(stream->data + stream->len, vec[i].data, vec[i].len);
+        stream->len += vec[i].len;
+    }
+}
+
+static void _encode_items(nanocbor_encoder_t *enc)
+{
+    static const uint8_t blob[100] = { 1, 2, 3 };
+
+    nanocbor_fmt_uint(enc, 1000);
+    nanocbor_fmt_int(enc, -5000000000);
+    nanocbor_put_tstr(enc, "short");
+    nanocbor_put_bstr(enc, blob, sizeof(blob));
+    nanocbor_fmt_float(enc, 1.1f);
+    nanocbor_fmt_double(enc, 1.1);
+}
+
+static void test_encode_stream_calls(void)
+{
+    uint8_t expected[256];
+    nanocbor_encoder_t enc;
+    _stream_t stream = { 0 };
+
+    nanocbor_encoder_init(&enc, expected, sizeof(expected));
+    _encode_items(&enc);
+    size_t len = nanocbor_encoded_len(&enc);
+
+    /* One fits and one append per item, the large string takes two */
+    nanocbor_encoder_stream_init(&enc, &stream, _stream_append, _stream_fits);
+    _encode_items(&enc);
+    CU_ASSERT_EQUAL(stream.len, len);
+    CU_ASSERT_EQUAL(memcmp(stream.data, expected, len), 0);
+    CU_ASSERT_EQUAL(stream.fits, 6);
+    CU_ASSERT_EQUAL(stream.appends, 7);
+
+    memset(&stream, 0, sizeof(stream));
+    nanocbor_encoder_stream_init(&enc, &stream, _stream_append, _stream_fits);
+    nanocbor_encoder_set_append_vec(&enc, _stream_append_vec);
+    _encode_items(&enc);
+    CU_ASSERT_EQUAL(stream.len, len);
+    CU_ASSERT_EQUAL(memcmp(stream.data, expected, len), 0);
+    CU_ASSERT_EQUAL(stream.fits, 6);
+    CU_ASSERT_EQUAL(stream.appends, 4);
+    CU_ASSERT_EQUAL(stream.vecs, 2);
+
+    /* A string is appended completely or not at all */
+    memset(&stream, 0, sizeof(stream));
+    stream.len = sizeof(stream.data) - 4;
+    nanocbor_encoder_stream_init(&enc, &stream, _stream_append, _stream_fits);
+    CU_ASSERT_EQUAL(nanocbor_put_tstr(&enc, "four"), NANOCBOR_ERR_END);
+    CU_ASSERT_EQUAL(stream.appends, 0);
+    CU_ASSERT_EQUAL(nanocbor_put_tstr(&enc, "abc"), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(stream.appends, 1);
+}
+
 const test_t tests_encoder[] = {
     {
         .f = test_encode_float_specials,
@@ -102,6 +365,22 @@ const test_t tests_encoder[] = {
         .f = test_encode_double_to_float,
         .n = "Double reduction encoder test",
     },
+    {
+        .f = test_encode_indefinite_str,
+        .n = "Indefinite-length string encode and skip test",
+    },
+    {
+        .f = test_encode_double_lossy,
+        .n = "Double lossy reduction encoder test",
+    },
+    {
+        .f = test_encode_struct,
+        .n = "Struct descriptor encoder test",
+    },
+    {
+        .f = test_encode_stream_calls,
+        .n = "Coalesced stream encoder calls test",
+    },
     {
         .f = NULL,
         .n = NULL,
@@ -0,0 +1,349 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "nanocbor/index.h"
+#include "nanocbor/merkle.h"
+#include "nanocbor/nanocbor.h"
+#include "test.h"
+#include <CUnit/CUnit.h>
+#include <string.h>
+
+/* NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers) */
+
+/* {"a": [1, 2, {"b": 3}], "c": 1([4]), "d": "x"} */
+static const uint8_t document[] = {
+    0xa3, 0x61, 0x61, 0x83, 0x01, 0x02, 0xa1, 0x61, 0x62, 0x03,
+    0x61, 0x63, 0xc1, 0x81, 0x04, 0x61, 0x64, 0x61, 0x78,
+};
+
+static void test_index_build(void)
+{
+    nanocbor_index_node_t nodes[4];
+    size_t num = 0;
+    static const nanocbor_index_node_t expected[] = {
+        { .offset = 0, .len = 19, .parent = NANOCBOR_INDEX_NONE, .next = 4,
+          .items = 6 },
+        { .offset = 3, .len = 7, .parent = 0, .next = 3, .items = 3 },
+        { .offset = 6, .len = 4, .parent = 1, .next = 3, .items = 2 },
+        { .offset = 13, .len = 2, .parent = 0, .next = 4, .items = 1 },
+    };
+
+    CU_ASSERT_EQUAL(nanocbor_index_build(document, sizeof(document), NULL,
+                                         &num),
+                    NANOCBOR_ERR_OVERFLOW);
+    CU_ASSERT_EQUAL(num, 4);
+    num = 2;
+    CU_ASSERT_EQUAL(nanocbor_index_build(document, sizeof(document), nodes,
+                                         &num),
+                    NANOCBOR_ERR_OVERFLOW);
+    CU_ASSERT_EQUAL(num, 4);
+    CU_ASSERT_EQUAL(nanocbor_index_build(document, sizeof(document), nodes,
+                                         &num),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(num, 4);
+    for (size_t i = 0; i < num; i++) {
+        CU_ASSERT_EQUAL(nodes[i].offset, expected[i].offset);
+        CU_ASSERT_EQUAL(nodes[i].len, expected[i].len);
+        CU_ASSERT_EQUAL(nodes[i].parent, expected[i].parent);
+        CU_ASSERT_EQUAL(nodes[i].next, expected[i].next);
+        CU_ASSERT_EQUAL(nodes[i].items, expected[i].items);
+    }
+
+    CU_ASSERT_EQUAL(nanocbor_index_find(nodes, num, 9), 2);
+    CU_ASSERT_EQUAL(nanocbor_index_find(nodes, num, 4), 1);
+    CU_ASSERT_EQUAL(nanocbor_index_find(nodes, num, 14), 3);
+    CU_ASSERT_EQUAL(nanocbor_index_find(nodes, num, 17), 0);
+    CU_ASSERT_EQUAL(nanocbor_index_find(nodes, num, 19), NANOCBOR_INDEX_NONE);
+
+    num = 4;
+    CU_ASSERT(nanocbor_index_build(document, sizeof(document) - 1, nodes,
+                                   &num)
+              < 0);
+    static const uint8_t deep[] = { 0x81, 0x81, 0x81, 0x81, 0x81, 0x81,
+                                    0x81, 0x81, 0x81, 0x81, 0x81, 0x00 };
+    num = 4;
+    CU_ASSERT_EQUAL(nanocbor_index_build(deep, sizeof(deep), nodes, &num),
+                    NANOCBOR_ERR_RECURSION);
+}
+
+static void test_index_map(void)
+{
+    nanocbor_index_node_t nodes[48];
+    size_t num = 4;
+    uint32_t keys[40];
+    nanocbor_index_map_t map;
+    nanocbor_value_t value;
+    uint32_t num_value = 0;
+    const uint8_t *str = NULL;
+    size_t len = 0;
+
+    CU_ASSERT_EQUAL(nanocbor_index_build(document, sizeof(document), nodes,
+                                         &num),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_index_map_init(&map, document, nodes, num, 0,
+                                            keys, 2),
+                    NANOCBOR_ERR_OVERFLOW);
+    CU_ASSERT_EQUAL(nanocbor_index_map_init(&map, document, nodes, num, 1,
+                                            keys, 3),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    CU_ASSERT_EQUAL(nanocbor_index_map_init(&map, document, nodes, num, 0,
+                                            keys, 3),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(map.num_keys, 3);
+    CU_ASSERT(map.sorted);
+    CU_ASSERT_EQUAL(nanocbor_index_map_get_tstr(&map, "d", &value),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_get_tstr(&value, &str, &len), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(len, 1);
+    CU_ASSERT_EQUAL(nanocbor_get_type(&value), NANOCBOR_ERR_END);
+    CU_ASSERT_EQUAL(nanocbor_index_map_get_tstr(&map, "c", &value),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_get_type(&value), NANOCBOR_TYPE_TAG);
+    CU_ASSERT_EQUAL(nanocbor_index_map_get_tstr(&map, "b", &value),
+                    NANOCBOR_NOT_FOUND);
+    CU_ASSERT_EQUAL(nanocbor_index_map_get_int(&map, 1, &value),
+                    NANOCBOR_NOT_FOUND);
+
+    /* {0: [0], 1: [1], ..., 39: [39]} in deterministic order */
+    uint8_t buf[256];
+    nanocbor_encoder_t enc;
+    nanocbor_encoder_init(&enc, buf, sizeof(buf));
+    nanocbor_fmt_map(&enc, 40);
+    for (unsigned i = 0; i < 40; i++) {
+        nanocbor_fmt_uint(&enc, i);
+        nanocbor_fmt_array(&enc, 1);
+        nanocbor_fmt_uint(&enc, i);
+    }
+    num = 48;
+    CU_ASSERT_EQUAL(nanocbor_index_build(buf, nanocbor_encoded_len(&enc),
+                                         nodes, &num),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_index_map_init(&map, buf, nodes, num, 0, keys,
+                                            40),
+                    NANOCBOR_OK);
+    CU_ASSERT(map.sorted);
+    unsigned bad = 0;
+    for (unsigned i = 0; i < 40; i++) {
+        nanocbor_value_t arr;
+        if (nanocbor_index_map_get_int(&map, i, &value) != NANOCBOR_OK
+            || nanocbor_enter_array(&value, &arr) != NANOCBOR_OK
+            || nanocbor_get_uint32(&arr, &num_value) < 0 || num_value != i) {
+            bad++;
+        }
+    }
+    CU_ASSERT_EQUAL(bad, 0);
+    CU_ASSERT_EQUAL(nanocbor_index_map_get_int(&map, 40, &value),
+                    NANOCBOR_NOT_FOUND);
+    CU_ASSERT_EQUAL(nanocbor_index_map_get_int(&map, -1, &value),
+                    NANOCBOR_NOT_FOUND);
+
+    /* Unsorted keys and keys in non-preferred encoding use a linear scan */
+    static const uint8_t unsorted[] = { 0xa3, 0x20, 0x0a, 0x02, 0x80,
+                                        0x61, 0x61, 0x0b };
+    static const uint8_t wide[] = { 0xa2, 0x01, 0x0a, 0x18, 0x02, 0x0b };
+    num = 48;
+    CU_ASSERT_EQUAL(nanocbor_index_build(unsorted, sizeof(unsorted), nodes,
+                                         &num),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_index_map_init(&map, unsorted, nodes, num, 0,
+                                            keys, 40),
+                    NANOCBOR_OK);
+    CU_ASSERT(!map.sorted);
+    CU_ASSERT_EQUAL(nanocbor_index_map_get_int(&map, -1, &value),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_get_uint32(&value, &num_value), 1);
+    CU_ASSERT_EQUAL(num_value, 10);
+    CU_ASSERT_EQUAL(nanocbor_index_map_get_tstr(&map, "a", &value),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_get_uint32(&value, &num_value), 1);
+    CU_ASSERT_EQUAL(num_value, 11);
+    num = 48;
+    CU_ASSERT_EQUAL(nanocbor_index_build(wide, sizeof(wide), nodes, &num),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_index_map_init(&map, wide, nodes, num, 0, keys,
+                                            40),
+                    NANOCBOR_OK);
+    CU_ASSERT(!map.sorted);
+    CU_ASSERT_EQUAL(nanocbor_index_map_get_int(&map, 1, &value),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_index_map_get_int(&map, 2, &value),
+                    NANOCBOR_NOT_FOUND);
+}
+
+#if NANOCBOR_WALK_PARALLEL
+static void _check_parallel(const uint8_t *buf, size_t len)
+{
+    static nanocbor_index_node_t serial[512];
+    static nanocbor_index_node_t parallel[512];
+    size_t num_serial = 512;
+    int res = nanocbor_index_build(buf, len, serial, &num_serial);
+
+    for (unsigned threads = 1; threads <= 9; threads++) {
+        size_t num = 512;
+        memset(parallel, 0xaa, sizeof(parallel));
+        CU_ASSERT_EQUAL(nanocbor_index_build_parallel(buf, len, parallel, &num,
+                                                      threads)
+                            < 0,
+                        res < 0);
+        if (res < 0) {
+            continue;
+        }
+        CU_ASSERT_EQUAL(num, num_serial);
+        CU_ASSERT_EQUAL(memcmp(parallel, serial, num * sizeof(serial[0])), 0);
+    }
+}
+
+/* Array of records with strings containing container and break bytes */
+static size_t _records(uint8_t *buf, size_t len)
+{
+    nanocbor_encoder_t enc;
+    static const uint8_t blob[] = { 0x9f, 0xbf, 0xff, 0x83, 0xa2, 0xc1,
+                                    0x5f, 0x81, 0x9f, 0x9f, 0xff, 0xff };
+
+    nanocbor_encoder_init(&enc, buf, len);
+    nanocbor_fmt_array(&enc, 60);
+    for (unsigned i = 0; i < 60; i++) {
+        nanocbor_fmt_map(&enc, 4);
+        nanocbor_put_tstr(&enc, "id");
+        nanocbor_fmt_tag(&enc, 1);
+        nanocbor_fmt_uint(&enc, i);
+        nanocbor_put_tstr(&enc, "blob");
+        nanocbor_put_bstr(&enc, blob, i % sizeof(blob));
+        nanocbor_put_tstr(&enc, "list");
+        nanocbor_fmt_array_indefinite(&enc);
+        for (unsigned j = 0; j < i % 4; j++) {
+            nanocbor_fmt_array(&enc, 1);
+            nanocbor_fmt_array(&enc, 0);
+        }
+        nanocbor_fmt_end_indefinite(&enc);
+        nanocbor_fmt_uint(&enc, 7);
+        nanocbor_fmt_map_indefinite(&enc);
+        nanocbor_fmt_end_indefinite(&enc);
+    }
+    return nanocbor_encoded_len(&enc);
+}
+
+static void test_index_parallel(void)
+{
+    static uint8_t buf[4096];
+    size_t len = _records(buf, sizeof(buf));
+    size_t num = 0;
+
+    _check_parallel(document, sizeof(document));
+    _check_parallel(buf, len);
+    _check_parallel(buf, len - 1);
+    _check_parallel(buf, 0);
+
+    /* A sequence of items with one deeply nested item */
+    static const uint8_t sequence[] = {
+        0x01, 0x80, 0x9f, 0xff, 0x81, 0x81, 0x81, 0x81, 0x81, 0x81,
+        0x81, 0x81, 0x02, 0x61, 0x61, 0xa1, 0x01, 0x9f, 0x01, 0xff,
+    };
+    _check_parallel(sequence, sizeof(sequence));
+    static const uint8_t deep[] = { 0x81, 0x81, 0x81, 0x81, 0x81, 0x81,
+                                    0x81, 0x81, 0x81, 0x81, 0x81, 0x00 };
+    _check_parallel(deep, sizeof(deep));
+    CU_ASSERT_EQUAL(nanocbor_index_build_parallel(deep, sizeof(deep), NULL,
+                                                  &num, 3),
+                    NANOCBOR_ERR_RECURSION);
+
+    /* Malformed items at the floor of a chunk */
+    static uint8_t bad[4096];
+    for (size_t pos = 1; pos < len; pos += 29) {
+        _check_parallel(buf, pos);
+        memcpy(bad, buf, len);
+        bad[pos] = (uint8_t)(pos % 2 ? 0xff : 0x1c);
+        _check_parallel(bad, len);
+    }
+
+    CU_ASSERT_EQUAL(nanocbor_index_build_parallel(buf, len, NULL, &num, 4),
+                    NANOCBOR_ERR_OVERFLOW);
+    CU_ASSERT_EQUAL(num, 361);
+    CU_ASSERT_EQUAL(nanocbor_index_build_parallel(buf, len, NULL, &num, 0),
+                    NANOCBOR_ERR_OVERFLOW);
+}
+#endif
+
+static void test_merkle(void)
+{
+    nanocbor_index_node_t nodes[4];
+    size_t num = 4;
+    uint8_t buf[sizeof(document)];
+    uint8_t digests[4][8];
+    uint8_t before[4][8];
+    uint8_t rebuilt[4][8];
+    uint64_t state = 0;
+    const nanocbor_hash_t *hash = &nanocbor_hash_fnv1a64;
+
+    memcpy(buf, document, sizeof(buf));
+    CU_ASSERT_EQUAL(nanocbor_index_build(buf, sizeof(buf), nodes, &num),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_merkle_build(buf, nodes, num, hash, &state,
+                                          &digests[0][0]),
+                    NANOCBOR_OK);
+    memcpy(before, digests, sizeof(before));
+
+    /* Replace the 3 in the inner map by 5 */
+    buf[9] = 0x05;
+    CU_ASSERT_EQUAL(nanocbor_merkle_update(buf, nodes, num, 9, hash, &state,
+                                           &digests[0][0]),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_merkle_build(buf, nodes, num, hash, &state,
+                                          &rebuilt[0][0]),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(memcmp(digests, rebuilt, sizeof(digests)), 0);
+    CU_ASSERT_NOT_EQUAL(memcmp(digests[0], before[0], 8), 0);
+    CU_ASSERT_NOT_EQUAL(memcmp(digests[1], before[1], 8), 0);
+    CU_ASSERT_NOT_EQUAL(memcmp(digests[2], before[2], 8), 0);
+    CU_ASSERT_EQUAL(memcmp(digests[3], before[3], 8), 0);
+    CU_ASSERT_EQUAL(nanocbor_merkle_update(buf, nodes, num, 19, hash, &state,
+                                           &digests[0][0]),
+                    NANOCBOR_NOT_FOUND);
+
+    /* An index missing the nested containers is rejected */
+    CU_ASSERT_EQUAL(nanocbor_merkle_build(buf, nodes, 1, hash, &state,
+                                          &digests[0][0]),
+                    NANOCBOR_ERR_INVALID_TYPE);
+
+    /* [[], []]: equal subtrees have equal digests */
+    static const uint8_t pair[] = { 0x82, 0x80, 0x80 };
+    static const uint8_t empty[] = { 0x09, 0x1a, 0x20, 0x07,
+                                     0xb5, 0xb0, 0xa0, 0x51 };
+    num = 4;
+    CU_ASSERT_EQUAL(nanocbor_index_build(pair, sizeof(pair), nodes, &num),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(num, 3);
+    CU_ASSERT_EQUAL(nanocbor_merkle_build(pair, nodes, num, hash, &state,
+                                          &digests[0][0]),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(memcmp(digests[1], empty, 8), 0);
+    CU_ASSERT_EQUAL(memcmp(digests[2], empty, 8), 0);
+}
+
+const test_t tests_index[] = {
+    {
+        .f = test_index_build,
+        .n = "Structural index test",
+    },
+    {
+        .f = test_index_map,
+        .n = "Indexed map lookup test",
+    },
+#if NANOCBOR_WALK_PARALLEL
+    {
+        .f = test_index_parallel,
+        .n = "Parallel structural index test",
+    },
+#endif
+    {
+        .f = test_merkle,
+        .n = "Merkle hash test",
+    },
+    {
+        .f = NULL,
+        .n = NULL,
+    },
+};
+
+/* NOLINTEND(cppcoreguidelines-avoid-magic-numbers) */
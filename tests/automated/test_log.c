@@ -0,0 +1,168 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "nanocbor/log.h"
+#include "nanocbor/nanocbor.h"
+#include "test.h"
+#include <CUnit/CUnit.h>
+#include <string.h>
+
+/* NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers) */
+
+#define NUM_RECORDS 100
+
+static uint8_t storage[2048];
+static uint8_t block[16];
+
+/* Record [i, "x"] with key i * 10 */
+static int _append(nanocbor_log_writer_t *log, uint32_t i)
+{
+    uint8_t record[16];
+    nanocbor_encoder_t enc;
+
+    nanocbor_encoder_init(&enc, record, sizeof(record));
+    nanocbor_fmt_array(&enc, 2);
+    nanocbor_fmt_uint(&enc, i);
+    nanocbor_put_tstr(&enc, "x");
+    return nanocbor_log_append(log, (int64_t)i * 10, record,
+                               nanocbor_encoded_len(&enc));
+}
+
+static uint32_t _read(nanocbor_log_reader_t *reader)
+{
+    const uint8_t *record = NULL;
+    size_t len = 0;
+    nanocbor_value_t it;
+    nanocbor_value_t arr;
+    uint32_t i = UINT32_MAX;
+
+    if (nanocbor_log_read(reader, &record, &len) < 0) {
+        return UINT32_MAX;
+    }
+    nanocbor_decoder_init(&it, record, len);
+    if (nanocbor_enter_array(&it, &arr) < 0
+        || nanocbor_get_uint32(&arr, &i) < 0) {
+        return UINT32_MAX;
+    }
+    return i;
+}
+
+static size_t _write_log(void)
+{
+    nanocbor_log_writer_t log;
+    nanocbor_encoder_t out;
+
+    nanocbor_encoder_init(&out, storage, sizeof(storage));
+    nanocbor_log_writer_init(&log, &out, block, sizeof(block), NULL);
+    for (uint32_t i = 0; i < NUM_RECORDS; i++) {
+        CU_ASSERT_EQUAL(_append(&log, i), NANOCBOR_OK);
+    }
+    CU_ASSERT_EQUAL(nanocbor_log_flush(&log), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(log.offset, nanocbor_encoded_len(&out));
+    return nanocbor_encoded_len(&out);
+}
+
+static void test_log_read(void)
+{
+    nanocbor_log_info_t info;
+    nanocbor_log_reader_t reader;
+    const uint8_t *record = NULL;
+    size_t record_len = 0;
+
+    size_t len = _write_log();
+    CU_ASSERT_EQUAL(nanocbor_log_recover(storage, len, &info), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(info.len, len);
+    CU_ASSERT_EQUAL(info.records, NUM_RECORDS);
+    CU_ASSERT_EQUAL(info.has_index, true);
+
+    nanocbor_log_reader_init(&reader, storage, &info);
+    for (uint32_t i = 0; i < NUM_RECORDS; i++) {
+        CU_ASSERT_EQUAL(_read(&reader), i);
+    }
+    CU_ASSERT_EQUAL(nanocbor_log_read(&reader, &record, &record_len),
+                    NANOCBOR_ERR_END);
+
+    CU_ASSERT_EQUAL(nanocbor_log_seek_record(&reader, 57), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(_read(&reader), 57);
+    CU_ASSERT_EQUAL(_read(&reader), 58);
+    CU_ASSERT_EQUAL(nanocbor_log_seek_record(&reader, 0), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(_read(&reader), 0);
+    CU_ASSERT_EQUAL(nanocbor_log_seek_record(&reader, NUM_RECORDS - 1),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(_read(&reader), NUM_RECORDS - 1);
+    CU_ASSERT_EQUAL(nanocbor_log_seek_record(&reader, NUM_RECORDS),
+                    NANOCBOR_NOT_FOUND);
+
+    /* Positioned at the block with the record with key 575 */
+    CU_ASSERT_EQUAL(nanocbor_log_seek_key(&reader, 575), NANOCBOR_OK);
+    uint32_t i = _read(&reader);
+    CU_ASSERT(i <= 57 && i + 3 > 57);
+    CU_ASSERT_EQUAL(nanocbor_log_seek_key(&reader, -5), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(_read(&reader), 0);
+    CU_ASSERT_EQUAL(nanocbor_log_seek_key(&reader, 100000), NANOCBOR_OK);
+    CU_ASSERT(_read(&reader) + 3 > NUM_RECORDS - 1);
+}
+
+static void test_log_recover(void)
+{
+    nanocbor_log_info_t info;
+    nanocbor_log_reader_t reader;
+    nanocbor_log_writer_t log;
+    nanocbor_encoder_t out;
+    uint8_t large[32] = { 0x58, 0x1e };
+
+    /* Interrupted write at the end of the log */
+    size_t len = _write_log();
+    CU_ASSERT_EQUAL(nanocbor_log_recover(storage, len - 3, &info),
+                    NANOCBOR_ERR_END);
+    CU_ASSERT(info.len < len - 3);
+    CU_ASSERT(info.records <= NUM_RECORDS);
+    CU_ASSERT(info.records > NUM_RECORDS - 4);
+
+    /* Continue the log after recovery, with a record larger than a block */
+    uint64_t records = info.records;
+    nanocbor_encoder_init(&out, storage + info.len, sizeof(storage) - info.len);
+    nanocbor_log_writer_init(&log, &out, block, sizeof(block), &info);
+    CU_ASSERT_EQUAL(_append(&log, (uint32_t)records), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_log_append(&log, 0, large, sizeof(large)),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_log_flush(&log), NANOCBOR_OK);
+    len = log.offset;
+    CU_ASSERT_EQUAL(nanocbor_log_recover(storage, len, &info), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(info.records, records + 2);
+
+    nanocbor_log_reader_init(&reader, storage, &info);
+    CU_ASSERT_EQUAL(nanocbor_log_seek_record(&reader, records), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(_read(&reader), records);
+
+    /* Corrupted records of the last block are caught by the CRC */
+    storage[len - 2] ^= 0x01;
+    CU_ASSERT_EQUAL(nanocbor_log_recover(storage, len, &info),
+                    NANOCBOR_ERR_END);
+    CU_ASSERT_EQUAL(info.records, records + 1);
+
+    /* Garbage at the end */
+    memset(storage, 0xff, sizeof(storage));
+    CU_ASSERT_EQUAL(nanocbor_log_recover(storage, sizeof(storage), &info),
+                    NANOCBOR_ERR_END);
+    CU_ASSERT_EQUAL(info.len, 0);
+    CU_ASSERT_EQUAL(info.records, 0);
+}
+
+const test_t tests_log[] = {
+    {
+        .f = test_log_read,
+        .n = "Log read and seek test",
+    },
+    {
+        .f = test_log_recover,
+        .n = "Log recovery test",
+    },
+    {
+        .f = NULL,
+        .n = NULL,
+    },
+};
+
+/* NOLINTEND(cppcoreguidelines-avoid-magic-numbers) */
@@ -0,0 +1,148 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "nanocbor/config.h"
+#include "nanocbor/mmap.h"
+#include "nanocbor/nanocbor.h"
+#include "test.h"
+#include <CUnit/CUnit.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers) */
+
+#if NANOCBOR_ENCODER_MMAP
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static uint8_t _payload[10000];
+
+/* Encodes enough items to grow a page sized step multiple times */
+static int _encode(nanocbor_encoder_t *enc)
+{
+    int res = nanocbor_fmt_array_indefinite(enc);
+
+    for (unsigned i = 0; i < 4000 && res >= 0; i++) {
+        res = nanocbor_fmt_uint(enc, i * 1000U);
+    }
+    for (unsigned i = 0; i < 3 && res >= 0; i++) {
+        res = nanocbor_put_bstr(enc, _payload, sizeof(_payload));
+    }
+    if (res >= 0) {
+        res = nanocbor_fmt_end_indefinite(enc);
+    }
+    return res < 0 ? res : NANOCBOR_OK;
+}
+
+static int _tmpfile(char *path)
+{
+    strcpy(path, "/tmp/nanocbor-mmap-XXXXXX");
+    int fd = mkstemp(path);
+    CU_ASSERT(fd >= 0);
+    return fd;
+}
+
+static void test_mmap_encode(void)
+{
+    char path[32];
+    nanocbor_mmap_t target;
+    nanocbor_encoder_t enc;
+    struct stat st;
+
+    for (size_t i = 0; i < sizeof(_payload); i++) {
+        _payload[i] = (uint8_t)(i * 7U);
+    }
+    uint8_t *expected = malloc(65536);
+    uint8_t *written = malloc(65536);
+    nanocbor_encoder_init(&enc, expected, 65536);
+    CU_ASSERT_EQUAL(_encode(&enc), NANOCBOR_OK);
+    size_t len = nanocbor_encoded_len(&enc);
+
+    int fd = _tmpfile(path);
+    /* Leftover content is truncated */
+    CU_ASSERT_EQUAL(write(fd, "stale", 5), 5);
+    CU_ASSERT_EQUAL(nanocbor_mmap_init(&target, fd, 1), NANOCBOR_OK);
+    CU_ASSERT(target.step >= 1);
+    nanocbor_mmap_encoder_init(&enc, &target);
+    CU_ASSERT_EQUAL(_encode(&enc), NANOCBOR_OK);
+    CU_ASSERT(target.size >= len);
+    CU_ASSERT(target.size < len + target.step);
+    CU_ASSERT_EQUAL(nanocbor_mmap_close(&target, &enc), NANOCBOR_OK);
+
+    CU_ASSERT_EQUAL(fstat(fd, &st), 0);
+    CU_ASSERT_EQUAL((size_t)st.st_size, len);
+    CU_ASSERT_EQUAL(pread(fd, written, 65536, 0), (ssize_t)len);
+    CU_ASSERT_EQUAL(memcmp(written, expected, len), 0);
+
+    /* Nothing encoded */
+    CU_ASSERT_EQUAL(nanocbor_mmap_init(&target, fd, 0), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(target.step % 4096, 0);
+    nanocbor_mmap_encoder_init(&enc, &target);
+    CU_ASSERT_EQUAL(nanocbor_mmap_close(&target, &enc), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(fstat(fd, &st), 0);
+    CU_ASSERT_EQUAL(st.st_size, 0);
+
+    close(fd);
+    unlink(path);
+    free(expected);
+    free(written);
+}
+
+static void test_mmap_failure(void)
+{
+    char path[32];
+    nanocbor_mmap_t target;
+    nanocbor_encoder_t enc;
+    struct stat st;
+
+    int fd = _tmpfile(path);
+    int ro = open(path, O_RDONLY);
+    CU_ASSERT(ro >= 0);
+    CU_ASSERT_EQUAL(nanocbor_mmap_init(&target, ro, 1),
+                    NANOCBOR_ERR_OVERFLOW);
+
+    /* Growing fails once the file can no longer be extended */
+    CU_ASSERT_EQUAL(nanocbor_mmap_init(&target, fd, 1), NANOCBOR_OK);
+    nanocbor_mmap_encoder_init(&enc, &target);
+    CU_ASSERT(nanocbor_fmt_uint(&enc, 1000) > 0);
+    size_t used = target.used;
+    target.fd = ro;
+    CU_ASSERT_EQUAL(_encode(&enc), NANOCBOR_ERR_END);
+    CU_ASSERT(target.failed);
+    CU_ASSERT_EQUAL(nanocbor_fmt_uint(&enc, 1), NANOCBOR_ERR_END);
+    target.fd = fd;
+    CU_ASSERT_EQUAL(nanocbor_mmap_close(&target, &enc),
+                    NANOCBOR_ERR_OVERFLOW);
+
+    /* Only the complete items before the failure are kept */
+    CU_ASSERT_EQUAL(fstat(fd, &st), 0);
+    CU_ASSERT(target.used > used);
+    CU_ASSERT(target.used <= target.size);
+    CU_ASSERT_EQUAL(st.st_size, (off_t)target.used);
+
+    close(ro);
+    close(fd);
+    unlink(path);
+}
+#endif
+
+const test_t tests_mmap[] = {
+#if NANOCBOR_ENCODER_MMAP
+    {
+        .f = test_mmap_encode,
+        .n = "Memory-mapped file encoding test",
+    },
+    {
+        .f = test_mmap_failure,
+        .n = "Memory-mapped file growth failure test",
+    },
+#endif
+    {
+        .f = NULL,
+        .n = NULL,
+    },
+};
+
+/* NOLINTEND(cppcoreguidelines-avoid-magic-numbers) */
@@ -0,0 +1,164 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "nanocbor/nanocbor.h"
+#include "nanocbor/pool.h"
+#include "test.h"
+#include <CUnit/CUnit.h>
+#include <string.h>
+
+/* NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers) */
+
+static void test_pool_estimate(void)
+{
+    nanocbor_pool_class_t classes[2];
+    nanocbor_pool_t pool;
+
+    nanocbor_pool_init(&pool, classes, 2);
+    CU_ASSERT_EQUAL(nanocbor_pool_estimate(&pool, 0), 0);
+
+    /* p99 of 99 times 100 and once 1000 bytes */
+    for (unsigned i = 0; i < 99; i++) {
+        nanocbor_pool_record(&pool, 0, 100);
+    }
+    nanocbor_pool_record(&pool, 0, 1000);
+    CU_ASSERT_EQUAL(nanocbor_pool_estimate(&pool, 0), 111);
+    nanocbor_pool_record(&pool, 0, 1000);
+    nanocbor_pool_record(&pool, 0, 1000);
+    CU_ASSERT_EQUAL(nanocbor_pool_estimate(&pool, 0), 1023);
+    CU_ASSERT_EQUAL(nanocbor_pool_estimate(&pool, 1), 0);
+
+    /* The history is halved */
+    for (unsigned i = 0; i < NANOCBOR_POOL_HISTORY; i++) {
+        nanocbor_pool_record(&pool, 1, 10);
+    }
+    CU_ASSERT_EQUAL(classes[1].total, NANOCBOR_POOL_HISTORY / 2);
+
+    /* Buckets cover the size with at most 25% slack */
+    unsigned bad = 0;
+    for (size_t len = 0; len < 5000; len++) {
+        nanocbor_pool_init(&pool, classes, 1);
+        nanocbor_pool_record(&pool, 0, len);
+        size_t estimate = nanocbor_pool_estimate(&pool, 0);
+        bad += estimate < len || estimate > len + len / 4;
+    }
+    CU_ASSERT_EQUAL(bad, 0);
+    nanocbor_pool_init(&pool, classes, 1);
+    nanocbor_pool_record(&pool, 0, 1U << 20);
+    CU_ASSERT_EQUAL(nanocbor_pool_estimate(&pool, 0), 1U << 20);
+}
+
+static int _encode_uints(nanocbor_encoder_t *enc, void *arg)
+{
+    unsigned num = *(unsigned *)arg;
+
+    if (num == 0) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    int res = nanocbor_fmt_array(enc, num);
+    for (unsigned i = 0; i < num && res >= 0; i++) {
+        res = nanocbor_fmt_uint(enc, i);
+    }
+    return res < 0 ? res : NANOCBOR_OK;
+}
+
+/* Ignores the encoder results, the encoded length covers the full message */
+static int _encode_uints_unchecked(nanocbor_encoder_t *enc, void *arg)
+{
+    unsigned num = *(unsigned *)arg;
+
+    nanocbor_fmt_array(enc, num);
+    for (unsigned i = 0; i < num; i++) {
+        nanocbor_fmt_uint(enc, i);
+    }
+    return NANOCBOR_OK;
+}
+
+static void test_pool_encode(void)
+{
+    nanocbor_pool_class_t classes[1];
+    nanocbor_pool_t pool;
+    uint8_t expected[64];
+    nanocbor_encoder_t enc;
+    uint8_t *buf = NULL;
+    size_t size = 0;
+    size_t len = 0;
+    unsigned num = 20;
+
+    nanocbor_encoder_init(&enc, expected, sizeof(expected));
+    _encode_uints(&enc, &num);
+
+    nanocbor_pool_init(&pool, classes, 1);
+    /* Without history the message is encoded twice */
+    CU_ASSERT_EQUAL(nanocbor_pool_encode(&pool, 0, _encode_uints, &num, &buf,
+                                         &size, &len),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(len, nanocbor_encoded_len(&enc));
+    CU_ASSERT_EQUAL(memcmp(buf, expected, len), 0);
+    CU_ASSERT_EQUAL(classes[0].retries, 1);
+    nanocbor_pool_release(&pool, 0, buf, size);
+
+    /* The learned size and the cached buffer are used */
+    for (unsigned i = 0; i < 10; i++) {
+        CU_ASSERT_EQUAL(nanocbor_pool_encode(&pool, 0, _encode_uints, &num,
+                                             &buf, &size, &len),
+                        NANOCBOR_OK);
+        CU_ASSERT_EQUAL(memcmp(buf, expected, len), 0);
+        nanocbor_pool_release(&pool, 0, buf, size);
+    }
+    CU_ASSERT_EQUAL(classes[0].retries, 1);
+    CU_ASSERT_EQUAL(classes[0].encodes, 11);
+
+    num = 40;
+    CU_ASSERT_EQUAL(nanocbor_pool_encode(&pool, 0, _encode_uints, &num, &buf,
+                                         &size, &len),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(len, 58);
+    CU_ASSERT_EQUAL(classes[0].retries, 2);
+    nanocbor_pool_release(&pool, 0, buf, size);
+
+    /* Both kinds of encode functions are retried with the exact size */
+    num = 60;
+    CU_ASSERT_EQUAL(nanocbor_pool_encode(&pool, 0, _encode_uints_unchecked,
+                                         &num, &buf, &size, &len),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(len, 98);
+    CU_ASSERT_EQUAL(size, 98);
+    CU_ASSERT_EQUAL(classes[0].retries, 3);
+    nanocbor_pool_release(&pool, 0, buf, size);
+    num = 80;
+    CU_ASSERT_EQUAL(nanocbor_pool_encode(&pool, 0, _encode_uints, &num, &buf,
+                                         &size, &len),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(len, 138);
+    CU_ASSERT_EQUAL(size, 138);
+    CU_ASSERT_EQUAL(classes[0].retries, 4);
+    nanocbor_pool_release(&pool, 0, buf, size);
+
+    num = 0;
+    CU_ASSERT_EQUAL(nanocbor_pool_encode(&pool, 0, _encode_uints, &num, &buf,
+                                         &size, &len),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    CU_ASSERT_PTR_NULL(buf);
+    CU_ASSERT_PTR_NOT_NULL(classes[0].buf);
+    nanocbor_pool_deinit(&pool);
+    CU_ASSERT_PTR_NULL(classes[0].buf);
+}
+
+const test_t tests_pool[] = {
+    {
+        .f = test_pool_estimate,
+        .n = "Buffer pool size estimate test",
+    },
+    {
+        .f = test_pool_encode,
+        .n = "Buffer pool encode test",
+    },
+    {
+        .f = NULL,
+        .n = NULL,
+    },
+};
+
+/* NOLINTEND(cppcoreguidelines-avoid-magic-numbers) */
@@ -0,0 +1,200 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "nanocbor/nanocbor.h"
+#include "nanocbor/query.h"
+#include "test.h"
+#include <CUnit/CUnit.h>
+#include <string.h>
+
+/* NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers) */
+
+/*
+ * {"id": 1, "temp": 25, "tags": ["a"]}
+ * {"id": 2, "temp": 31.5, 7: "x"}
+ * {"id": 3, "temp": 1(40), "name": "hot"}
+ * {"id": 4}
+ */
+static const uint8_t records[] = {
+    0xa3, 0x62, 0x69, 0x64, 0x01, 0x64, 0x74, 0x65, 0x6d, 0x70, 0x18, 0x19,
+    0x64, 0x74, 0x61, 0x67, 0x73, 0x81, 0x61, 0x61,
+
+    0xa3, 0x62, 0x69, 0x64, 0x02, 0x64, 0x74, 0x65, 0x6d, 0x70, 0xf9, 0x4f,
+    0xe0, 0x07, 0x61, 0x78,
+
+    0xa3, 0x62, 0x69, 0x64, 0x03, 0x64, 0x74, 0x65, 0x6d, 0x70, 0xc1, 0x18,
+    0x28, 0x64, 0x6e, 0x61, 0x6d, 0x65, 0x63, 0x68, 0x6f, 0x74,
+
+    0xa1, 0x62, 0x69, 0x64, 0x04,
+};
+
+typedef struct {
+    unsigned calls;
+    int64_t ids[4];
+    size_t record_len;
+    bool id_missing;
+} result_t;
+
+static int _collect(void *ctx, const uint8_t *record, size_t record_len,
+                    const nanocbor_value_t *values, size_t num_values)
+{
+    result_t *result = ctx;
+    nanocbor_value_t id = values[0];
+
+    (void)record;
+    CU_ASSERT_EQUAL(num_values, 1);
+    result->record_len += record_len;
+    if (nanocbor_at_end(&id)) {
+        result->id_missing = true;
+    }
+    else if (result->calls < 4) {
+        CU_ASSERT_EQUAL(nanocbor_get_int64(&id, &result->ids[result->calls]),
+                        1);
+    }
+    result->calls++;
+    return 0;
+}
+
+static void test_query_path(void)
+{
+    nanocbor_value_t it;
+    nanocbor_value_t value;
+    const uint8_t *str = NULL;
+    size_t len = 0;
+    uint32_t num = 0;
+
+    nanocbor_decoder_init(&it, records, sizeof(records));
+    CU_ASSERT_EQUAL(nanocbor_query_path(&it, "/tags/0", &value), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_get_tstr(&value, &str, &len), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(len, 1);
+    CU_ASSERT_EQUAL(nanocbor_query_path(&it, "/tags/1", &value),
+                    NANOCBOR_NOT_FOUND);
+    CU_ASSERT_EQUAL(nanocbor_query_path(&it, "/id/0", &value),
+                    NANOCBOR_NOT_FOUND);
+    CU_ASSERT_EQUAL(nanocbor_query_path(&it, "id", &value),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    CU_ASSERT_EQUAL(nanocbor_query_path(&it, "", &value), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(value.cur, records);
+
+    /* Integer key of the second record */
+    CU_ASSERT_EQUAL(nanocbor_skip(&it), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_query_path(&it, "/7", &value), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_get_tstr(&value, &str, &len), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_query_path(&it, "/id", &value), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_get_uint32(&value, &num), 1);
+    CU_ASSERT_EQUAL(num, 2);
+}
+
+static void test_query_run(void)
+{
+    nanocbor_value_t it;
+    static const char *const select[] = { "/id" };
+    static const nanocbor_query_pred_t hot[] = {
+        {
+            .path = "/temp",
+            .op = NANOCBOR_QUERY_GT,
+            .type = NANOCBOR_QUERY_INT,
+            .value.i = 30,
+        },
+    };
+    nanocbor_query_agg_t aggs[] = {
+        { .path = "/temp" },
+        { .path = "" },
+    };
+    nanocbor_query_t query = {
+        .where = hot,
+        .num_where = 1,
+        .select = select,
+        .num_select = 1,
+        .aggs = aggs,
+        .num_aggs = 2,
+    };
+    result_t result = { 0 };
+
+    nanocbor_decoder_init(&it, records, sizeof(records));
+    CU_ASSERT_EQUAL(nanocbor_query_run(&query, &it, _collect, &result),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(result.calls, 2);
+    CU_ASSERT_EQUAL(result.ids[0], 2);
+    CU_ASSERT_EQUAL(result.ids[1], 3);
+    CU_ASSERT_EQUAL(result.record_len, 16 + 22);
+    CU_ASSERT_EQUAL(aggs[0].count, 2);
+    CU_ASSERT_EQUAL(aggs[0].numeric, 2);
+    CU_ASSERT_DOUBLE_EQUAL(aggs[0].sum, 71.5, 0.0);
+    CU_ASSERT_DOUBLE_EQUAL(aggs[0].min, 31.5, 0.0);
+    CU_ASSERT_DOUBLE_EQUAL(aggs[0].max, 40, 0.0);
+    CU_ASSERT_EQUAL(aggs[1].count, 2);
+    CU_ASSERT_EQUAL(aggs[1].numeric, 0);
+
+    /* Text comparison and existence, with a missing projection */
+    static const nanocbor_query_pred_t named[] = {
+        {
+            .path = "/name",
+            .op = NANOCBOR_QUERY_EQ,
+            .type = NANOCBOR_QUERY_TSTR,
+            .value.s = "hot",
+        },
+    };
+    static const char *const missing[] = { "/nope" };
+    query.where = named;
+    query.select = missing;
+    query.num_aggs = 0;
+    memset(&result, 0, sizeof(result));
+    nanocbor_decoder_init(&it, records, sizeof(records));
+    CU_ASSERT_EQUAL(nanocbor_query_run(&query, &it, _collect, &result),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(result.calls, 1);
+    CU_ASSERT_EQUAL(result.id_missing, true);
+
+    /* A float operand against all records; "/id" <= 2.5 */
+    static const nanocbor_query_pred_t low[] = {
+        {
+            .path = "/id",
+            .op = NANOCBOR_QUERY_LE,
+            .type = NANOCBOR_QUERY_FLOAT,
+            .value.f = 2.5,
+        },
+        {
+            .path = "/tags",
+            .op = NANOCBOR_QUERY_EXISTS,
+        },
+    };
+    query.where = low;
+    query.num_where = 2;
+    query.select = select;
+    memset(&result, 0, sizeof(result));
+    nanocbor_decoder_init(&it, records, sizeof(records));
+    CU_ASSERT_EQUAL(nanocbor_query_run(&query, &it, _collect, &result),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(result.calls, 1);
+    CU_ASSERT_EQUAL(result.ids[0], 1);
+
+    /* Truncated sequence */
+    nanocbor_decoder_init(&it, records, sizeof(records) - 1);
+    CU_ASSERT(nanocbor_query_run(&query, &it, NULL, NULL) < 0);
+
+    /* Invalid path */
+    static const char *const invalid[] = { "id" };
+    query.select = invalid;
+    nanocbor_decoder_init(&it, records, sizeof(records));
+    CU_ASSERT_EQUAL(nanocbor_query_run(&query, &it, NULL, NULL),
+                    NANOCBOR_ERR_INVALID_TYPE);
+}
+
+const test_t tests_query[] = {
+    {
+        .f = test_query_path,
+        .n = "Query path lookup test",
+    },
+    {
+        .f = test_query_run,
+        .n = "Query filter, projection and aggregate test",
+    },
+    {
+        .f = NULL,
+        .n = NULL,
+    },
+};
+
+/* NOLINTEND(cppcoreguidelines-avoid-magic-numbers) */
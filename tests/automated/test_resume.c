@@ -0,0 +1,152 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "nanocbor/nanocbor.h"
+#include "nanocbor/resume.h"
+#include "test.h"
+#include <CUnit/CUnit.h>
+#include <string.h>
+
+/* NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers) */
+
+typedef struct {
+    unsigned items;
+    unsigned max_depth;
+    uint32_t sum;
+} _visits_t;
+
+static int _visit(void *ctx, const nanocbor_value_t *item, unsigned depth)
+{
+    _visits_t *visits = ctx;
+    nanocbor_value_t tmp = *item;
+    uint32_t value = 0;
+
+    visits->items++;
+    if (depth > visits->max_depth) {
+        visits->max_depth = depth;
+    }
+    if (nanocbor_get_uint32(&tmp, &value) > 0) {
+        visits->sum += value;
+    }
+    return NANOCBOR_OK;
+}
+
+/* [{"a": 1([0, 1, 2]), "b": []}, ..., [_ "x", 7]] followed by 5 */
+static size_t _build(uint8_t *buf, size_t len)
+{
+    nanocbor_encoder_t enc;
+
+    nanocbor_encoder_init(&enc, buf, len);
+    nanocbor_fmt_array(&enc, 21);
+    for (unsigned i = 0; i < 20; i++) {
+        nanocbor_fmt_map(&enc, 2);
+        nanocbor_put_tstr(&enc, "a");
+        nanocbor_fmt_tag(&enc, 1);
+        nanocbor_fmt_array(&enc, 3);
+        for (unsigned j = 0; j < 3; j++) {
+            nanocbor_fmt_uint(&enc, i + j);
+        }
+        nanocbor_put_tstr(&enc, "b");
+        nanocbor_fmt_array(&enc, 0);
+    }
+    nanocbor_fmt_array_indefinite(&enc);
+    nanocbor_put_tstr(&enc, "x");
+    nanocbor_fmt_uint(&enc, 7);
+    nanocbor_fmt_end_indefinite(&enc);
+    nanocbor_fmt_uint(&enc, 5);
+    return nanocbor_encoded_len(&enc);
+}
+
+static void test_resume(void)
+{
+    uint8_t buf[512];
+    size_t len = _build(buf, sizeof(buf));
+    nanocbor_value_t it;
+    nanocbor_value_t expected;
+    nanocbor_resume_t state;
+    uint32_t value = 0;
+
+    nanocbor_decoder_init(&expected, buf, len);
+    CU_ASSERT_EQUAL(nanocbor_skip(&expected), NANOCBOR_OK);
+
+    for (uint32_t budget = 1; budget <= 200; budget += 7) {
+        _visits_t visits = { 0 };
+        unsigned yields = 0;
+        int res = NANOCBOR_RESUME_YIELD;
+
+        nanocbor_decoder_init(&it, buf, len);
+        nanocbor_resume_init(&state, &it, _visit, &visits);
+        while (res == NANOCBOR_RESUME_YIELD && yields <= 200) {
+            res = nanocbor_resume_run(&state, budget);
+            yields += res == NANOCBOR_RESUME_YIELD;
+        }
+        /* 184 items: the outer array, 9 items per map and the last array
+         * of 2 items */
+        CU_ASSERT_EQUAL(res, NANOCBOR_OK);
+        CU_ASSERT_EQUAL(yields, (184 - 1) / budget);
+        CU_ASSERT_EQUAL(it.cur, expected.cur);
+        CU_ASSERT_EQUAL(visits.items, 102);
+        CU_ASSERT_EQUAL(visits.max_depth, 3);
+        CU_ASSERT_EQUAL(visits.sum, 3 * 190 + 60 + 7);
+    }
+    CU_ASSERT_EQUAL(nanocbor_get_uint32(&it, &value), 1);
+    CU_ASSERT_EQUAL(value, 5);
+
+    /* Skipping without a visitor */
+    nanocbor_decoder_init(&it, buf, len);
+    nanocbor_resume_init(&state, &it, NULL, NULL);
+    CU_ASSERT_EQUAL(nanocbor_resume_run(&state, 100), NANOCBOR_RESUME_YIELD);
+    CU_ASSERT_EQUAL(nanocbor_resume_run(&state, UINT32_MAX), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(it.cur, expected.cur);
+}
+
+static void test_resume_invalid(void)
+{
+    uint8_t buf[512];
+    size_t len = _build(buf, sizeof(buf));
+    nanocbor_value_t it;
+    nanocbor_resume_t state;
+
+    /* Truncated inside the last array */
+    nanocbor_decoder_init(&it, buf, len - 2);
+    nanocbor_resume_init(&state, &it, NULL, NULL);
+    CU_ASSERT_EQUAL(nanocbor_resume_run(&state, 10), NANOCBOR_RESUME_YIELD);
+    CU_ASSERT(nanocbor_resume_run(&state, UINT32_MAX) < 0);
+
+    static const uint8_t deep[] = { 0x81, 0x81, 0x81, 0x81, 0x81, 0x81,
+                                    0x81, 0x81, 0x81, 0x81, 0x81, 0x00 };
+    nanocbor_decoder_init(&it, deep, sizeof(deep));
+    nanocbor_resume_init(&state, &it, NULL, NULL);
+    CU_ASSERT_EQUAL(nanocbor_resume_run(&state, UINT32_MAX),
+                    NANOCBOR_ERR_RECURSION);
+
+    /* A tag and an empty map at the top */
+    static const uint8_t tagged[] = { 0xc1, 0xa0 };
+    nanocbor_decoder_init(&it, tagged, sizeof(tagged));
+    nanocbor_resume_init(&state, &it, NULL, NULL);
+    CU_ASSERT_EQUAL(nanocbor_resume_run(&state, 1), NANOCBOR_RESUME_YIELD);
+    CU_ASSERT_EQUAL(nanocbor_resume_run(&state, 1), NANOCBOR_OK);
+    CU_ASSERT(nanocbor_at_end(&it));
+    CU_ASSERT_EQUAL(nanocbor_resume_run(&state, 0), NANOCBOR_RESUME_YIELD);
+
+    nanocbor_resume_init(&state, &it, NULL, NULL);
+    CU_ASSERT_EQUAL(nanocbor_resume_run(&state, 1), NANOCBOR_ERR_END);
+}
+
+const test_t tests_resume[] = {
+    {
+        .f = test_resume,
+        .n = "Resumable decoding test",
+    },
+    {
+        .f = test_resume_invalid,
+        .n = "Resumable decoding of invalid input test",
+    },
+    {
+        .f = NULL,
+        .n = NULL,
+    },
+};
+
+/* NOLINTEND(cppcoreguidelines-avoid-magic-numbers) */
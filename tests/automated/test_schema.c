@@ -0,0 +1,212 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "nanocbor/nanocbor.h"
+#include "nanocbor/schema.h"
+#include "test.h"
+#include <CUnit/CUnit.h>
+#include <string.h>
+
+/* NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers) */
+
+static const char sensor_schema[] = "; sensor reading\n"
+                                    "reading = {\n"
+                                    "  id: uint,\n"
+                                    "  ? name: tstr / null,\n"
+                                    "  1 => [* measurement],\n"
+                                    "  * tstr => any\n"
+                                    "}\n"
+                                    "measurement = [time, value: float / int]\n"
+                                    "time = #6.1(uint)\n";
+
+static uint8_t prog[256];
+
+static int _validate(const char *schema, const uint8_t *buf, size_t len)
+{
+    size_t prog_len = sizeof(prog);
+    nanocbor_value_t val;
+
+    int res = nanocbor_schema_compile(prog, &prog_len, schema, strlen(schema));
+    CU_ASSERT_EQUAL(res, NANOCBOR_OK);
+    if (res < 0) {
+        return res;
+    }
+    nanocbor_decoder_init(&val, buf, len);
+    res = nanocbor_schema_validate(prog, prog_len, &val);
+    if (res == NANOCBOR_OK) {
+        CU_ASSERT_EQUAL(nanocbor_at_end(&val), true);
+    }
+    return res;
+}
+
+static void test_schema_compile(void)
+{
+    size_t len = 0;
+    size_t required = 0;
+
+    /* Size probing */
+    CU_ASSERT_EQUAL(nanocbor_schema_compile(NULL, &required, sensor_schema,
+                                            strlen(sensor_schema)),
+                    NANOCBOR_ERR_END);
+    CU_ASSERT(required > 0 && required <= sizeof(prog));
+    len = required;
+    CU_ASSERT_EQUAL(nanocbor_schema_compile(prog, &len, sensor_schema,
+                                            strlen(sensor_schema)),
+                    NANOCBOR_OK);
+    CU_ASSERT(len <= required);
+    len = required - 1;
+    CU_ASSERT_EQUAL(nanocbor_schema_compile(prog, &len, sensor_schema,
+                                            strlen(sensor_schema)),
+                    NANOCBOR_ERR_END);
+
+    static const char *const invalid[] = {
+        "a = [uint", "a = uint uint", "= uint", "a = \"open", "a = {uint}",
+        "a = #7.1(uint)", "a = uint //",
+    };
+    for (unsigned i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        len = sizeof(prog);
+        CU_ASSERT_EQUAL(nanocbor_schema_compile(prog, &len, invalid[i],
+                                                strlen(invalid[i])),
+                        NANOCBOR_ERR_INVALID_TYPE);
+    }
+
+    len = sizeof(prog);
+    CU_ASSERT_EQUAL(nanocbor_schema_compile(prog, &len, "a = b", 5),
+                    NANOCBOR_NOT_FOUND);
+    len = sizeof(prog);
+    CU_ASSERT_EQUAL(nanocbor_schema_compile(prog, &len, "a = [* a]", 9),
+                    NANOCBOR_ERR_RECURSION);
+}
+
+static void test_schema_validate_scalar(void)
+{
+    static const uint8_t uint[] = { 0x18, 0x64 };
+    static const uint8_t nint[] = { 0x38, 0x63 };
+    static const uint8_t text[] = { 0x62, 0x6f, 0x6b };
+    static const uint8_t half[] = { 0xf9, 0x3e, 0x00 };
+    static const uint8_t null[] = { 0xf6 };
+
+    CU_ASSERT_EQUAL(_validate("a = uint", uint, sizeof(uint)), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(_validate("a = uint", nint, sizeof(nint)),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    CU_ASSERT_EQUAL(_validate("a = int", nint, sizeof(nint)), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(_validate("a = -100", nint, sizeof(nint)), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(_validate("a = 1 / 2 / 100", uint, sizeof(uint)),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(_validate("a = 1 / 2 / 0x65", uint, sizeof(uint)),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    CU_ASSERT_EQUAL(_validate("a = \"ok\"", text, sizeof(text)), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(_validate("a = \"no\"", text, sizeof(text)),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    CU_ASSERT_EQUAL(_validate("a = float16", half, sizeof(half)), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(_validate("a = tstr / nil", null, sizeof(null)),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(_validate("a = any", null, sizeof(null)), NANOCBOR_OK);
+}
+
+static void test_schema_validate_structure(void)
+{
+    /* {"id": 7, 1: [[1(1000), 1.5], [1(1001), 2]], "x": [1]} */
+    static const uint8_t reading[] = {
+        0xa3, 0x62, 0x69, 0x64, 0x07, 0x01, 0x82, 0x82, 0xc1, 0x19,
+        0x03, 0xe8, 0xf9, 0x3e, 0x00, 0x82, 0xc1, 0x19, 0x03, 0xe9,
+        0x02, 0x61, 0x78, 0x81, 0x01,
+    };
+    /* {"name": "s", "id": 7, 1: []} */
+    static const uint8_t named[] = { 0xa3, 0x64, 0x6e, 0x61, 0x6d, 0x65, 0x61,
+                                     0x73, 0x62, 0x69, 0x64, 0x07, 0x01, 0x80 };
+    /* {1: []}, missing "id" */
+    static const uint8_t missing[] = { 0xa1, 0x01, 0x80 };
+    /* {"id": 7, 1: [[1000, 1.5]]}, untagged time */
+    static const uint8_t untagged[] = { 0xa2, 0x62, 0x69, 0x64, 0x07, 0x01,
+                                        0x81, 0x82, 0x19, 0x03, 0xe8, 0xf9,
+                                        0x3e, 0x00 };
+    /* {"id": 7, 1: [[1(1000), 1.5, 3]]}, too many array items */
+    static const uint8_t extra[] = { 0xa2, 0x62, 0x69, 0x64, 0x07, 0x01,
+                                     0x81, 0x83, 0xc1, 0x19, 0x03, 0xe8,
+                                     0xf9, 0x3e, 0x00, 0x03 };
+    /* {"id": 7, 2: 3}, unknown key */
+    static const uint8_t unknown[]
+        = { 0xa2, 0x62, 0x69, 0x64, 0x07, 0x02, 0x03 };
+    /* {_ "id": 7, 1: [_ ]} */
+    static const uint8_t indefinite[]
+        = { 0xbf, 0x62, 0x69, 0x64, 0x07, 0x01, 0x9f, 0xff, 0xff };
+
+    CU_ASSERT_EQUAL(_validate(sensor_schema, reading, sizeof(reading)),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(_validate(sensor_schema, named, sizeof(named)),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(_validate(sensor_schema, missing, sizeof(missing)),
+                    NANOCBOR_NOT_FOUND);
+    CU_ASSERT_EQUAL(_validate(sensor_schema, untagged, sizeof(untagged)),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    CU_ASSERT_EQUAL(_validate(sensor_schema, extra, sizeof(extra)),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    CU_ASSERT_EQUAL(_validate("a = {id: uint, 1: [* any]}", unknown,
+                              sizeof(unknown)),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    CU_ASSERT_EQUAL(_validate(sensor_schema, indefinite, sizeof(indefinite)),
+                    NANOCBOR_OK);
+    CU_ASSERT(_validate(sensor_schema, reading, sizeof(reading) - 1) < 0);
+
+    /* Occurrence indicators */
+    static const uint8_t arr[] = { 0x83, 0x01, 0x02, 0x61, 0x61 };
+    CU_ASSERT_EQUAL(_validate("a = [+ uint, tstr]", arr, sizeof(arr)),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(_validate("a = [uint, ? uint, ? uint, tstr]", arr,
+                              sizeof(arr)),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(_validate("a = [uint, uint]", arr, sizeof(arr)),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    CU_ASSERT_EQUAL(_validate("a = [uint, uint, tstr, uint]", arr,
+                              sizeof(arr)),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    CU_ASSERT_EQUAL(_validate("a = [+ tstr, * uint]", arr, sizeof(arr)),
+                    NANOCBOR_ERR_INVALID_TYPE);
+
+    /* Nesting deeper than the validator limit */
+    static const uint8_t deep[] = { 0x81, 0x81, 0x81, 0x81, 0x81, 0x81,
+                                    0x81, 0x81, 0x81, 0x81, 0x81, 0x00 };
+    CU_ASSERT_EQUAL(_validate("a = [[[[[[[[[[[uint]]]]]]]]]]]", deep,
+                              sizeof(deep)),
+                    NANOCBOR_ERR_RECURSION);
+
+    /* Choices in keys and first member types of nested groups */
+    static const uint8_t nested[] = { 0x81, 0x81, 0x81, 0x81, 0x81, 0x81,
+                                      0x81, 0x81, 0x82, 0x61, 0x61, 0xf6 };
+    static const char nested_schema[]
+        = "a = [[[[[[[[[n: (uint / tstr) / null, ? (uint / tstr) / null]]]]]"
+          "]]]]";
+    CU_ASSERT_EQUAL(_validate(nested_schema, nested, sizeof(nested)),
+                    NANOCBOR_OK);
+    /* {2: 3} */
+    static const uint8_t choice_key[] = { 0xa1, 0x02, 0x03 };
+    CU_ASSERT_EQUAL(_validate("a = {(1 / 2) => uint / null}", choice_key,
+                              sizeof(choice_key)),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(_validate("a = {(1 / 3) => uint}", choice_key,
+                              sizeof(choice_key)),
+                    NANOCBOR_ERR_INVALID_TYPE);
+}
+
+const test_t tests_schema[] = {
+    {
+        .f = test_schema_compile,
+        .n = "Schema compile test",
+    },
+    {
+        .f = test_schema_validate_scalar,
+        .n = "Schema scalar validation test",
+    },
+    {
+        .f = test_schema_validate_structure,
+        .n = "Schema array and map validation test",
+    },
+    {
+        .f = NULL,
+        .n = NULL,
+    },
+};
+
+/* NOLINTEND(cppcoreguidelines-avoid-magic-numbers) */
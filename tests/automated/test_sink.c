@@ -0,0 +1,153 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "nanocbor/config.h"
+#include "nanocbor/nanocbor.h"
+#include "nanocbor/sink.h"
+#include "test.h"
+#include <CUnit/CUnit.h>
+#include <string.h>
+
+/* NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers) */
+
+#if NANOCBOR_SINK
+typedef struct {
+    uint8_t data[2048];
+    size_t len;
+    unsigned writes;
+    int res;
+} _out_t;
+
+static int _out_write(void *ctx, const uint8_t *buf, size_t len)
+{
+    _out_t *out = ctx;
+
+    if (out->res < 0) {
+        return out->res;
+    }
+    memcpy(out->data + out->len, buf, len);
+    out->len += len;
+    out->writes++;
+    return NANOCBOR_OK;
+}
+
+/* Leaves the write in flight until completed by the test */
+static void _out_submit(nanocbor_sink_t *sink, void *ctx, const uint8_t *buf,
+                        size_t len)
+{
+    (void)sink;
+    _out_write(ctx, buf, len);
+}
+
+static void _out_submit_sync(nanocbor_sink_t *sink, void *ctx,
+                             const uint8_t *buf, size_t len)
+{
+    nanocbor_sink_complete(sink, _out_write(ctx, buf, len));
+}
+
+static void test_sink_complete(void)
+{
+    uint8_t buf[16];
+    nanocbor_encoder_t enc;
+    nanocbor_sink_t sink;
+    _out_t out = { 0 };
+
+    CU_ASSERT_EQUAL(nanocbor_sink_init(&sink, buf, sizeof(buf), _out_submit,
+                                       &out),
+                    NANOCBOR_OK);
+    nanocbor_sink_encoder_init(&enc, &sink);
+    /* Fills the first buffer and starts on the second without blocking */
+    for (unsigned i = 0; i < 10; i++) {
+        CU_ASSERT(nanocbor_fmt_uint(&enc, i) > 0);
+    }
+    CU_ASSERT_EQUAL(out.writes, 1);
+    CU_ASSERT_EQUAL(out.len, 8);
+    nanocbor_sink_complete(&sink, NANOCBOR_OK);
+
+    /* The failed write is noticed at the next swap, dropping that item */
+    nanocbor_sink_complete(&sink, NANOCBOR_ERR_END);
+    for (unsigned i = 0; i < 7; i++) {
+        CU_ASSERT(nanocbor_fmt_uint(&enc, i) > 0);
+    }
+    CU_ASSERT_EQUAL(nanocbor_fmt_uint(&enc, 0), NANOCBOR_ERR_END);
+    CU_ASSERT_EQUAL(nanocbor_sink_close(&sink), NANOCBOR_ERR_END);
+    CU_ASSERT_EQUAL(out.writes, 1);
+
+    /* Writes completing within submit */
+    memset(&out, 0, sizeof(out));
+    CU_ASSERT_EQUAL(nanocbor_sink_init(&sink, buf, sizeof(buf),
+                                       _out_submit_sync, &out),
+                    NANOCBOR_OK);
+    nanocbor_sink_encoder_init(&enc, &sink);
+    for (unsigned i = 0; i < 20; i++) {
+        CU_ASSERT(nanocbor_fmt_uint(&enc, i) > 0);
+    }
+    CU_ASSERT_EQUAL(nanocbor_sink_flush(&sink), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(out.writes, 3);
+    CU_ASSERT_EQUAL(out.len, 20);
+    out.res = NANOCBOR_ERR_END;
+    CU_ASSERT(nanocbor_fmt_uint(&enc, 0) > 0);
+    CU_ASSERT_EQUAL(nanocbor_sink_close(&sink), NANOCBOR_ERR_END);
+}
+#endif
+
+#if NANOCBOR_SINK_THREAD
+static size_t _encode(nanocbor_encoder_t *enc)
+{
+    static const uint8_t blob[100] = { 0 };
+
+    nanocbor_fmt_array(enc, 201);
+    for (unsigned i = 0; i < 200; i++) {
+        nanocbor_fmt_uint(enc, i * 1000);
+    }
+    nanocbor_put_bstr(enc, blob, sizeof(blob));
+    return nanocbor_encoded_len(enc);
+}
+
+static void test_sink_thread(void)
+{
+    uint8_t expected[2048];
+    uint8_t buf[64];
+    nanocbor_encoder_t enc;
+    nanocbor_sink_t sink;
+    _out_t out = { 0 };
+
+    nanocbor_encoder_init(&enc, expected, sizeof(expected));
+    size_t len = _encode(&enc);
+
+    CU_ASSERT_EQUAL(nanocbor_sink_init_thread(&sink, buf, sizeof(buf),
+                                              _out_write, &out),
+                    NANOCBOR_OK);
+    nanocbor_sink_encoder_init(&enc, &sink);
+    CU_ASSERT_EQUAL(_encode(&enc), len);
+    CU_ASSERT_EQUAL(nanocbor_sink_close(&sink), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(out.len, len);
+    CU_ASSERT_EQUAL(out.writes, (len + 31) / 32);
+    CU_ASSERT_EQUAL(memcmp(out.data, expected, len), 0);
+
+    CU_ASSERT_EQUAL(nanocbor_sink_init_thread(&sink, buf, 1, _out_write, &out),
+                    NANOCBOR_ERR_OVERFLOW);
+}
+#endif
+
+const test_t tests_sink[] = {
+#if NANOCBOR_SINK
+    {
+        .f = test_sink_complete,
+        .n = "Double-buffered sink completion test",
+    },
+#endif
+#if NANOCBOR_SINK_THREAD
+    {
+        .f = test_sink_thread,
+        .n = "Double-buffered sink I/O thread test",
+    },
+#endif
+    {
+        .f = NULL,
+        .n = NULL,
+    },
+};
+
+/* NOLINTEND(cppcoreguidelines-avoid-magic-numbers) */
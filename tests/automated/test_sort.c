@@ -0,0 +1,129 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "nanocbor/nanocbor.h"
+#include "nanocbor/sort.h"
+#include "test.h"
+#include <CUnit/CUnit.h>
+#include <string.h>
+
+/* NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers) */
+
+/* [ts, id] records: [5, 0], [1, 1], [3, 2], [1, 3], [-2, 4], "x", [0.5, 6] */
+static const uint8_t records[] = {
+    0x82, 0x05, 0x00, 0x82, 0x01, 0x01, 0x82, 0x03, 0x02, 0x82,
+    0x01, 0x03, 0x82, 0x21, 0x04, 0x61, 0x78, 0x82, 0xf9, 0x38,
+    0x00, 0x06,
+};
+
+typedef struct {
+    uint8_t out[sizeof(records)];
+    size_t len;
+} output_t;
+
+static int _append(void *ctx, const uint8_t *record, size_t len)
+{
+    output_t *output = ctx;
+    if (output->len + len > sizeof(output->out)) {
+        return NANOCBOR_ERR_END;
+    }
+    memcpy(output->out + output->len, record, len);
+    output->len += len;
+    return NANOCBOR_OK;
+}
+
+/* "x", [-2, 4], [0.5, 6], [1, 1], [1, 3], [3, 2], [5, 0] */
+static const uint8_t sorted[] = {
+    0x61, 0x78, 0x82, 0x21, 0x04, 0x82, 0xf9, 0x38, 0x00, 0x06, 0x82,
+    0x01, 0x01, 0x82, 0x01, 0x03, 0x82, 0x03, 0x02, 0x82, 0x05, 0x00,
+};
+
+static void test_sort_entries(void)
+{
+    nanocbor_sort_entry_t entries[8];
+    size_t num = 8;
+    nanocbor_value_t it;
+    output_t output = { .len = 0 };
+
+    nanocbor_decoder_init(&it, records, sizeof(records));
+    CU_ASSERT_EQUAL(nanocbor_sort_collect(&it, "/0", entries, &num),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(num, 7);
+    nanocbor_sort_entries(entries, num);
+    for (size_t i = 0; i < num; i++) {
+        _append(&output, entries[i].record, entries[i].len);
+    }
+    CU_ASSERT_EQUAL(output.len, sizeof(sorted));
+    CU_ASSERT_EQUAL(memcmp(output.out, sorted, sizeof(sorted)), 0);
+
+    /* Limited capacity */
+    num = 2;
+    nanocbor_decoder_init(&it, records, sizeof(records));
+    CU_ASSERT_EQUAL(nanocbor_sort_collect(&it, "/0", entries, &num),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(num, 2);
+    CU_ASSERT_EQUAL(it.cur, records + 6);
+
+    num = 8;
+    nanocbor_decoder_init(&it, records, sizeof(records) - 1);
+    CU_ASSERT(nanocbor_sort_collect(&it, "/0", entries, &num) < 0);
+    CU_ASSERT_EQUAL(nanocbor_sort_collect(&it, "0", entries, &num),
+                    NANOCBOR_ERR_INVALID_TYPE);
+}
+
+static void test_sort_merge(void)
+{
+    nanocbor_sort_entry_t entries[8];
+    /* Runs of 3, 3 and 1 records, each sorted into its own buffer */
+    uint8_t runs_buf[3][sizeof(records)];
+    size_t runs_len[3] = { 0 };
+    nanocbor_sort_run_t runs[4];
+    nanocbor_value_t it;
+    output_t output = { .len = 0 };
+
+    nanocbor_decoder_init(&it, records, sizeof(records));
+    for (unsigned r = 0; r < 3; r++) {
+        size_t num = 3;
+        CU_ASSERT_EQUAL(nanocbor_sort_collect(&it, "/0", entries, &num),
+                        NANOCBOR_OK);
+        nanocbor_sort_entries(entries, num);
+        for (size_t i = 0; i < num; i++) {
+            memcpy(runs_buf[r] + runs_len[r], entries[i].record,
+                   entries[i].len);
+            runs_len[r] += entries[i].len;
+        }
+        nanocbor_decoder_init(&runs[r].it, runs_buf[r], runs_len[r]);
+    }
+    CU_ASSERT_EQUAL(nanocbor_at_end(&it), true);
+    /* Empty run */
+    nanocbor_decoder_init(&runs[3].it, NULL, 0);
+
+    CU_ASSERT_EQUAL(nanocbor_sort_merge(runs, 4, "/0", _append, &output),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(output.len, sizeof(sorted));
+    CU_ASSERT_EQUAL(memcmp(output.out, sorted, sizeof(sorted)), 0);
+
+    /* Callback error aborts the merge */
+    output.len = sizeof(records);
+    nanocbor_decoder_init(&runs[0].it, records, sizeof(records));
+    CU_ASSERT_EQUAL(nanocbor_sort_merge(runs, 1, "/0", _append, &output),
+                    NANOCBOR_ERR_END);
+}
+
+const test_t tests_sort[] = {
+    {
+        .f = test_sort_entries,
+        .n = "Sort run test",
+    },
+    {
+        .f = test_sort_merge,
+        .n = "Sort merge test",
+    },
+    {
+        .f = NULL,
+        .n = NULL,
+    },
+};
+
+/* NOLINTEND(cppcoreguidelines-avoid-magic-numbers) */
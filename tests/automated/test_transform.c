@@ -0,0 +1,181 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "nanocbor/nanocbor.h"
+#include "nanocbor/transform.h"
+#include "test.h"
+#include <CUnit/CUnit.h>
+#include <string.h>
+
+/* NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers) */
+
+static size_t _build_input(uint8_t *buf, size_t len)
+{
+    static const uint8_t bytes[] = { 1, 2 };
+    nanocbor_encoder_t enc;
+
+    nanocbor_encoder_init(&enc, buf, len);
+    nanocbor_fmt_map(&enc, 7);
+    nanocbor_put_tstr(&enc, "name");
+    nanocbor_put_tstr(&enc, "alice");
+    nanocbor_put_tstr(&enc, "ssn");
+    nanocbor_put_tstr(&enc, "123-45");
+    nanocbor_put_tstr(&enc, "age");
+    nanocbor_fmt_uint(&enc, 30);
+    nanocbor_put_tstr(&enc, "tags");
+    nanocbor_fmt_array(&enc, 3);
+    nanocbor_fmt_uint(&enc, 1);
+    nanocbor_fmt_uint(&enc, 2);
+    nanocbor_fmt_uint(&enc, 3);
+    nanocbor_fmt_uint(&enc, 1);
+    nanocbor_put_bstr(&enc, bytes, sizeof(bytes));
+    nanocbor_put_tstr(&enc, "users");
+    nanocbor_fmt_tag(&enc, 100);
+    nanocbor_fmt_array_indefinite(&enc);
+    nanocbor_fmt_map(&enc, 2);
+    nanocbor_put_tstr(&enc, "email");
+    nanocbor_put_tstr(&enc, "b@example.org");
+    nanocbor_put_tstr(&enc, "id");
+    nanocbor_fmt_uint(&enc, 1);
+    nanocbor_fmt_map(&enc, 1);
+    nanocbor_put_tstr(&enc, "email");
+    nanocbor_put_tstr(&enc, "c@example.org");
+    nanocbor_fmt_end_indefinite(&enc);
+    nanocbor_put_tstr(&enc, "extra");
+    nanocbor_fmt_map(&enc, 1);
+    nanocbor_put_tstr(&enc, "email");
+    nanocbor_fmt_bool(&enc, true);
+    return nanocbor_encoded_len(&enc);
+}
+
+static size_t _build_expected(uint8_t *buf, size_t len)
+{
+    nanocbor_encoder_t enc;
+
+    nanocbor_encoder_init(&enc, buf, len);
+    nanocbor_fmt_map(&enc, 6);
+    nanocbor_put_tstr(&enc, "name");
+    nanocbor_put_tstr(&enc, "anon");
+    nanocbor_put_tstr(&enc, "years");
+    nanocbor_fmt_uint(&enc, 30);
+    nanocbor_put_tstr(&enc, "tags");
+    nanocbor_fmt_array(&enc, 2);
+    nanocbor_fmt_uint(&enc, 1);
+    nanocbor_fmt_uint(&enc, 3);
+    nanocbor_fmt_uint(&enc, 1);
+    nanocbor_fmt_bstr(&enc, 0);
+    nanocbor_put_tstr(&enc, "users");
+    nanocbor_fmt_tag(&enc, 100);
+    nanocbor_fmt_array_indefinite(&enc);
+    nanocbor_fmt_map(&enc, 1);
+    nanocbor_put_tstr(&enc, "id");
+    nanocbor_fmt_uint(&enc, 1);
+    nanocbor_fmt_map(&enc, 0);
+    nanocbor_fmt_end_indefinite(&enc);
+    nanocbor_put_tstr(&enc, "extra");
+    nanocbor_fmt_map(&enc, 1);
+    nanocbor_put_tstr(&enc, "email");
+    nanocbor_fmt_bool(&enc, true);
+    return nanocbor_encoded_len(&enc);
+}
+
+static const nanocbor_transform_rule_t _rules[] = {
+    { "/ssn", NANOCBOR_TRANSFORM_DROP, NULL, 0 },
+    { "/age", NANOCBOR_TRANSFORM_RENAME, (const uint8_t *)"\x65" "years", 6 },
+    { "/name", NANOCBOR_TRANSFORM_REPLACE, (const uint8_t *)"\x64" "anon", 5 },
+    { "/1", NANOCBOR_TRANSFORM_REDACT, NULL, 0 },
+    { "/tags/1", NANOCBOR_TRANSFORM_DROP, NULL, 0 },
+    { "/users/*/email", NANOCBOR_TRANSFORM_DROP, NULL, 0 },
+    { "/missing/key", NANOCBOR_TRANSFORM_DROP, NULL, 0 },
+};
+
+static void test_transform(void)
+{
+    uint8_t input[256];
+    uint8_t expected[256];
+    uint8_t output[256];
+    nanocbor_value_t it;
+    nanocbor_encoder_t enc;
+    size_t input_len = _build_input(input, sizeof(input));
+    size_t expected_len = _build_expected(expected, sizeof(expected));
+
+    nanocbor_decoder_init(&it, input, input_len);
+    nanocbor_encoder_init(&enc, output, sizeof(output));
+    CU_ASSERT_EQUAL(nanocbor_transform(_rules, 7, &it, &enc), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_encoded_len(&enc), expected_len);
+    CU_ASSERT_EQUAL(memcmp(output, expected, expected_len), 0);
+
+    /* Without rules the sequence is copied as is */
+    nanocbor_decoder_init(&it, input, input_len);
+    nanocbor_encoder_init(&enc, output, sizeof(output));
+    CU_ASSERT_EQUAL(nanocbor_transform(NULL, 0, &it, &enc), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_encoded_len(&enc), input_len);
+    CU_ASSERT_EQUAL(memcmp(output, input, input_len), 0);
+
+    /* Encoder too small */
+    nanocbor_decoder_init(&it, input, input_len);
+    nanocbor_encoder_init(&enc, output, 20);
+    CU_ASSERT_EQUAL(nanocbor_transform(_rules, 7, &it, &enc),
+                    NANOCBOR_ERR_END);
+}
+
+static void test_transform_sequence(void)
+{
+    static const uint8_t input[] = { 0x01, 0x82, 0x02, 0x03, 0x63, 'a', 'b',
+                                     'c' };
+    static const uint8_t redacted[] = { 0x00, 0x80, 0x60 };
+    static const nanocbor_transform_rule_t redact = {
+        "", NANOCBOR_TRANSFORM_REDACT, NULL, 0
+    };
+    static const nanocbor_transform_rule_t drop = {
+        "", NANOCBOR_TRANSFORM_DROP, NULL, 0
+    };
+    static const nanocbor_transform_rule_t invalid = {
+        "ssn", NANOCBOR_TRANSFORM_DROP, NULL, 0
+    };
+    static const nanocbor_transform_rule_t no_data = {
+        "/ssn", NANOCBOR_TRANSFORM_REPLACE, NULL, 0
+    };
+    uint8_t output[16];
+    nanocbor_value_t it;
+    nanocbor_encoder_t enc;
+
+    nanocbor_decoder_init(&it, input, sizeof(input));
+    nanocbor_encoder_init(&enc, output, sizeof(output));
+    CU_ASSERT_EQUAL(nanocbor_transform(&redact, 1, &it, &enc), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_encoded_len(&enc), sizeof(redacted));
+    CU_ASSERT_EQUAL(memcmp(output, redacted, sizeof(redacted)), 0);
+
+    nanocbor_decoder_init(&it, input, sizeof(input));
+    nanocbor_encoder_init(&enc, output, sizeof(output));
+    CU_ASSERT_EQUAL(nanocbor_transform(&drop, 1, &it, &enc), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_encoded_len(&enc), 0);
+
+    nanocbor_decoder_init(&it, input, sizeof(input));
+    CU_ASSERT_EQUAL(nanocbor_transform(&invalid, 1, &it, &enc),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    CU_ASSERT_EQUAL(nanocbor_transform(&no_data, 1, &it, &enc),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    CU_ASSERT_EQUAL(nanocbor_transform(_rules,
+                                       NANOCBOR_TRANSFORM_RULES_MAX + 1, &it,
+                                       &enc),
+                    NANOCBOR_ERR_OVERFLOW);
+}
+
+const test_t tests_transform[] = {
+    {
+        .f = test_transform,
+        .n = "Transform rules test",
+    },
+    {
+        .f = test_transform_sequence,
+        .n = "Transform sequence test",
+    },
+    {
+        .f = NULL,
+        .n = NULL,
+    },
+};
+
+/* NOLINTEND(cppcoreguidelines-avoid-magic-numbers) */
@@ -0,0 +1,154 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "nanocbor/index.h"
+#include "nanocbor/nanocbor.h"
+#include "nanocbor/walk.h"
+#include "test.h"
+#include <CUnit/CUnit.h>
+#include <string.h>
+
+/* NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers) */
+
+typedef struct {
+    uint64_t sum;
+    uint32_t leaves;
+    uint32_t positions;
+} _sum_t;
+
+static void _sum_init(void *ctx, void *acc)
+{
+    (void)ctx;
+    memset(acc, 0, sizeof(_sum_t));
+}
+
+static int _sum_visit(void *ctx, void *acc, const nanocbor_value_t *item,
+                      uint32_t node, uint32_t index)
+{
+    _sum_t *sum = acc;
+    nanocbor_value_t it = *item;
+    uint32_t num = 0;
+
+    (void)ctx;
+    (void)node;
+    if (nanocbor_get_uint32(&it, &num) >= 0) {
+        sum->sum += num;
+    }
+    sum->leaves++;
+    sum->positions += index;
+    return NANOCBOR_OK;
+}
+
+static void _sum_combine(void *ctx, void *acc, const void *other)
+{
+    _sum_t *sum = acc;
+    const _sum_t *add = other;
+
+    (void)ctx;
+    sum->sum += add->sum;
+    sum->leaves += add->leaves;
+    sum->positions += add->positions;
+}
+
+static const nanocbor_walk_ops_t _sum_ops = {
+    .acc_size = sizeof(_sum_t),
+    .init = _sum_init,
+    .visit = _sum_visit,
+    .combine = _sum_combine,
+};
+
+/* [1, [2, 1(3), [_ 0, 1, ..., 199]], {"k": 6}] */
+static size_t _build(uint8_t *buf, size_t len)
+{
+    nanocbor_encoder_t enc;
+
+    nanocbor_encoder_init(&enc, buf, len);
+    nanocbor_fmt_array(&enc, 3);
+    nanocbor_fmt_uint(&enc, 1);
+    nanocbor_fmt_array(&enc, 3);
+    nanocbor_fmt_uint(&enc, 2);
+    nanocbor_fmt_tag(&enc, 1);
+    nanocbor_fmt_uint(&enc, 3);
+    nanocbor_fmt_array_indefinite(&enc);
+    for (unsigned i = 0; i < 200; i++) {
+        nanocbor_fmt_uint(&enc, i);
+    }
+    nanocbor_fmt_end_indefinite(&enc);
+    nanocbor_fmt_map(&enc, 1);
+    nanocbor_put_tstr(&enc, "k");
+    nanocbor_fmt_uint(&enc, 6);
+    return nanocbor_encoded_len(&enc);
+}
+
+static void test_walk(void)
+{
+    uint8_t buf[512];
+    nanocbor_index_node_t nodes[4];
+    size_t num = 4;
+    _sum_t result;
+    size_t len = _build(buf, sizeof(buf));
+
+    CU_ASSERT_EQUAL(nanocbor_index_build(buf, len, nodes, &num), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_walk(buf, len, nodes, num, &_sum_ops, NULL,
+                                  &result),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(result.sum, 19912);
+    CU_ASSERT_EQUAL(result.leaves, 205);
+    /* 0, 0 + 1, 0 + 1 + ... + 199 and 0 + 1 */
+    CU_ASSERT_EQUAL(result.positions, 19902);
+
+    /* The walk fails when the index does not match the buffer */
+    CU_ASSERT_EQUAL(nanocbor_walk(buf, len, nodes, 2, &_sum_ops, NULL,
+                                  &result),
+                    NANOCBOR_ERR_INVALID_TYPE);
+}
+
+#if NANOCBOR_WALK_PARALLEL
+static void test_walk_parallel(void)
+{
+    uint8_t buf[512];
+    nanocbor_index_node_t nodes[4];
+    size_t num = 4;
+    _sum_t result;
+    size_t len = _build(buf, sizeof(buf));
+
+    CU_ASSERT_EQUAL(nanocbor_index_build(buf, len, nodes, &num), NANOCBOR_OK);
+    for (size_t grain = 0; grain < 64; grain += 8) {
+        memset(&result, 0, sizeof(result));
+        CU_ASSERT_EQUAL(nanocbor_walk_parallel(buf, len, nodes, num,
+                                               &_sum_ops, NULL, 4, grain,
+                                               &result),
+                        NANOCBOR_OK);
+        CU_ASSERT_EQUAL(result.sum, 19912);
+        CU_ASSERT_EQUAL(result.leaves, 205);
+        CU_ASSERT_EQUAL(result.positions, 19902);
+    }
+    CU_ASSERT_EQUAL(nanocbor_walk_parallel(buf, len, nodes, num, &_sum_ops,
+                                           NULL, 1, 0, &result),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(result.sum, 19912);
+    CU_ASSERT_EQUAL(nanocbor_walk_parallel(buf, len, nodes, num, &_sum_ops,
+                                           NULL, 0, 0, &result),
+                    NANOCBOR_ERR_OVERFLOW);
+}
+#endif
+
+const test_t tests_walk[] = {
+    {
+        .f = test_walk,
+        .n = "Document walk test",
+    },
+#if NANOCBOR_WALK_PARALLEL
+    {
+        .f = test_walk_parallel,
+        .n = "Parallel document walk test",
+    },
+#endif
+    {
+        .f = NULL,
+        .n = NULL,
+    },
+};
+
+/* NOLINTEND(cppcoreguidelines-avoid-magic-numbers) */
@@ -0,0 +1,466 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <argp.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#include "nanocbor/index.h"
+#include "nanocbor/nanocbor.h"
+
+/* NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+ */
+
+#define NS_PER_SEC 1000000000ULL
+
+static const struct argp_option cmdline_options[] = {
+    { "counters", 'c', 0, 0,
+      "Read hardware performance counters around each benchmark", 0 },
+    { "items", 'n', "items", 0, "Number of items per benchmark run", 0 },
+    { "repeat", 'r', "repeat", 0, "Number of runs, the fastest is reported",
+      0 },
+    { 0 },
+};
+
+struct arguments {
+    bool counters;
+    size_t items;
+    unsigned repeat;
+    char **names;
+    int num_names;
+};
+
+static struct arguments _args = { false, 1 << 20, 5, NULL, 0 };
+
+static error_t _parse_opts(int key, char *arg, struct argp_state *state)
+{
+    struct arguments *arguments = state->input;
+    switch (key) {
+    case 'c':
+        arguments->counters = true;
+        break;
+    case 'n':
+        arguments->items = strtoul(arg, NULL, 0);
+        break;
+    case 'r':
+        arguments->repeat = (unsigned)strtoul(arg, NULL, 0);
+        break;
+    case ARGP_KEY_ARGS:
+        arguments->names = state->argv + state->next;
+        arguments->num_names = state->argc - state->next;
+        break;
+    case ARGP_KEY_END:
+        if (arguments->items == 0 || arguments->repeat == 0) {
+            argp_usage(state);
+        }
+        break;
+    default:
+        return ARGP_ERR_UNKNOWN;
+    }
+    return 0;
+}
+
+typedef enum {
+    COUNTER_CYCLES,
+    COUNTER_INSTRUCTIONS,
+    COUNTER_BRANCH_MISSES,
+    COUNTER_L1D_MISSES,
+    COUNTER_LLC_MISSES,
+    COUNTER_NUMOF,
+} counter_t;
+
+static const char *const _counter_names[COUNTER_NUMOF] = {
+    "cycles", "instructions", "branch-misses", "L1d-misses", "LLC-misses",
+};
+
+typedef struct {
+    int fd[COUNTER_NUMOF]; /**< Counter file descriptors, -1 if missing */
+    int leader; /**< First opened counter, controls the group */
+    unsigned slot[COUNTER_NUMOF]; /**< Position in the group read */
+    unsigned num;
+} counters_t;
+
+typedef struct {
+    uint64_t ns;
+    uint64_t value[COUNTER_NUMOF];
+    bool valid[COUNTER_NUMOF];
+} sample_t;
+
+#ifdef __linux__
+static int _perf_open(uint32_t type, uint64_t config, int group)
+{
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = group < 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+}
+
+static void _counters_open(counters_t *counters)
+{
+    static const struct {
+        uint32_t type;
+        uint64_t config;
+    } events[COUNTER_NUMOF] = {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+        { PERF_TYPE_HW_CACHE,
+          PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+              | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    };
+
+    counters->leader = -1;
+    counters->num = 0;
+    for (unsigned i = 0; i < COUNTER_NUMOF; i++) {
+        counters->fd[i]
+            = _perf_open(events[i].type, events[i].config, counters->leader);
+        if (counters->fd[i] < 0) {
+            fprintf(stderr, "Counter %s not available: %s\n",
+                    _counter_names[i], strerror(errno));
+            continue;
+        }
+        if (counters->leader < 0) {
+            counters->leader = counters->fd[i];
+        }
+        counters->slot[i] = counters->num++;
+    }
+}
+
+static void _counters_start(const counters_t *counters)
+{
+    if (counters->leader >= 0) {
+        ioctl(counters->leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(counters->leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+}
+
+static void _counters_stop(const counters_t *counters, sample_t *sample)
+{
+    uint64_t values[COUNTER_NUMOF + 1];
+
+    if (counters->leader < 0) {
+        return;
+    }
+    ioctl(counters->leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    ssize_t len = read(counters->leader, values, sizeof(values));
+    /* The group read starts with the number of counters */
+    if (len < (ssize_t)sizeof(uint64_t) || values[0] != counters->num) {
+        return;
+    }
+    for (unsigned i = 0; i < COUNTER_NUMOF; i++) {
+        sample->valid[i] = counters->fd[i] >= 0;
+        if (sample->valid[i]) {
+            sample->value[i] = values[1 + counters->slot[i]];
+        }
+    }
+}
+
+static void _counters_close(counters_t *counters)
+{
+    for (unsigned i = 0; i < COUNTER_NUMOF; i++) {
+        if (counters->fd[i] >= 0) {
+            close(counters->fd[i]);
+        }
+    }
+}
+#else
+static void _counters_open(counters_t *counters)
+{
+    fprintf(stderr, "Hardware counters are only supported on Linux\n");
+    counters->leader = -1;
+    counters->num = 0;
+}
+
+static void _counters_start(const counters_t *counters)
+{
+    (void)counters;
+}
+
+static void _counters_stop(const counters_t *counters, sample_t *sample)
+{
+    (void)counters;
+    (void)sample;
+}
+
+static void _counters_close(counters_t *counters)
+{
+    (void)counters;
+}
+#endif
+
+static uint64_t _now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * NS_PER_SEC + (uint64_t)ts.tv_nsec;
+}
+
+static uint8_t *_buf;
+static size_t _buf_len;
+static size_t _encoded_len;
+static nanocbor_index_node_t *_nodes;
+static size_t _num_nodes;
+static volatile uint64_t _sink;
+
+static void _encode_uints(nanocbor_encoder_t *enc, size_t items)
+{
+    nanocbor_fmt_array(enc, items);
+    for (size_t i = 0; i < items; i++) {
+        /* Mix of 1, 2, 3, 5 and 9 byte encodings */
+        nanocbor_fmt_uint(enc, (uint64_t)1 << ((i * 7) % 64));
+    }
+}
+
+static void _encode_records(nanocbor_encoder_t *enc, size_t items)
+{
+    nanocbor_fmt_array(enc, items);
+    for (size_t i = 0; i < items; i++) {
+        nanocbor_fmt_map(enc, 3);
+        nanocbor_put_tstr(enc, "id");
+        nanocbor_fmt_uint(enc, i);
+        nanocbor_put_tstr(enc, "name");
+        nanocbor_put_tstr(enc, "benchmark");
+        nanocbor_put_tstr(enc, "values");
+        nanocbor_fmt_array(enc, 2);
+        nanocbor_fmt_int(enc, -(int64_t)i);
+        nanocbor_fmt_float(enc, (float)i);
+    }
+}
+
+static void _prepare(void (*encode)(nanocbor_encoder_t *enc, size_t items),
+                     size_t items)
+{
+    nanocbor_encoder_t enc;
+
+    nanocbor_encoder_init(&enc, NULL, 0);
+    encode(&enc, items);
+    _encoded_len = nanocbor_encoded_len(&enc);
+    if (_encoded_len > _buf_len) {
+        free(_buf);
+        _buf = malloc(_encoded_len);
+        _buf_len = _buf ? _encoded_len : 0;
+    }
+    if (_buf) {
+        nanocbor_encoder_init(&enc, _buf, _buf_len);
+        encode(&enc, items);
+    }
+}
+
+static void _setup_uints(size_t items)
+{
+    _prepare(_encode_uints, items);
+}
+
+static void _setup_records(size_t items)
+{
+    _prepare(_encode_records, items);
+}
+
+static void _setup_index(size_t items)
+{
+    _prepare(_encode_records, items);
+    _num_nodes = 0;
+    nanocbor_index_build(_buf, _encoded_len, NULL, &_num_nodes);
+    free(_nodes);
+    _nodes = malloc(_num_nodes * sizeof(*_nodes));
+}
+
+static size_t _run_decode_uint(size_t items)
+{
+    nanocbor_value_t it;
+    nanocbor_value_t arr;
+    uint64_t sum = 0;
+
+    nanocbor_decoder_init(&it, _buf, _encoded_len);
+    nanocbor_enter_array(&it, &arr);
+    while (!nanocbor_at_end(&arr)) {
+        uint64_t value = 0;
+        if (nanocbor_get_uint64(&arr, &value) < 0) {
+            break;
+        }
+        sum += value;
+    }
+    _sink = sum;
+    return items;
+}
+
+static size_t _run_skip_records(size_t items)
+{
+    nanocbor_value_t it;
+    nanocbor_value_t arr;
+
+    nanocbor_decoder_init(&it, _buf, _encoded_len);
+    nanocbor_enter_array(&it, &arr);
+    while (!nanocbor_at_end(&arr)) {
+        if (nanocbor_skip(&arr) < 0) {
+            break;
+        }
+    }
+    _sink = (uintptr_t)arr.cur;
+    return items;
+}
+
+static size_t _run_encode_uint(size_t items)
+{
+    nanocbor_encoder_t enc;
+
+    nanocbor_encoder_init(&enc, _buf, _buf_len);
+    _encode_uints(&enc, items);
+    _sink = nanocbor_encoded_len(&enc);
+    return items;
+}
+
+static size_t _run_encode_sizing(size_t items)
+{
+    nanocbor_encoder_t enc;
+
+    nanocbor_encoder_init(&enc, NULL, 0);
+    _encode_records(&enc, items);
+    _sink = nanocbor_encoded_len(&enc);
+    return items;
+}
+
+static size_t _run_index_build(size_t items)
+{
+    size_t num = _num_nodes;
+
+    nanocbor_index_build(_buf, _encoded_len, _nodes, &num);
+    _sink = num;
+    return items;
+}
+
+typedef struct {
+    const char *name;
+    void (*setup)(size_t items);
+    size_t (*run)(size_t items); /**< Returns the number of items handled */
+} benchmark_t;
+
+static const benchmark_t _benchmarks[] = {
+    { "decode_uint", _setup_uints, _run_decode_uint },
+    { "skip_records", _setup_records, _run_skip_records },
+    { "encode_uint", _setup_uints, _run_encode_uint },
+    { "encode_sizing", _setup_records, _run_encode_sizing },
+    { "index_build", _setup_index, _run_index_build },
+};
+
+static bool _selected(const char *name)
+{
+    if (_args.num_names == 0) {
+        return true;
+    }
+    for (int i = 0; i < _args.num_names; i++) {
+        if (strcmp(_args.names[i], name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void _report(const benchmark_t *bench, const sample_t *best,
+                    size_t items)
+{
+    double per_item = (double)items;
+
+    printf("%-14s %10zu items %8.2f ns/item", bench->name, items,
+           (double)best->ns / per_item);
+    if (!_args.counters) {
+        printf("\n");
+        return;
+    }
+    if (best->valid[COUNTER_CYCLES]) {
+        printf(" %7.2f cycles/item",
+               (double)best->value[COUNTER_CYCLES] / per_item);
+    }
+    if (best->valid[COUNTER_CYCLES] && best->valid[COUNTER_INSTRUCTIONS]
+        && best->value[COUNTER_CYCLES]) {
+        printf(" %5.2f IPC",
+               (double)best->value[COUNTER_INSTRUCTIONS]
+                   / (double)best->value[COUNTER_CYCLES]);
+    }
+    for (unsigned i = COUNTER_BRANCH_MISSES; i < COUNTER_NUMOF; i++) {
+        if (best->valid[i]) {
+            printf(" %7.4f %s/item", (double)best->value[i] / per_item,
+                   _counter_names[i]);
+        }
+    }
+    printf("\n");
+}
+
+static const char doc[] = "NanoCBOR benchmarks, runs the named benchmarks "
+                           "or all of them";
+
+int main(int argc, char *argv[])
+{
+    struct argp argp = { cmdline_options, _parse_opts, "[benchmark...]", doc,
+                         NULL, NULL, NULL };
+    counters_t counters = { .leader = -1 };
+
+    argp_parse(&argp, argc, argv, 0, 0, &_args);
+    if (_args.counters) {
+        _counters_open(&counters);
+    }
+
+    for (size_t b = 0; b < sizeof(_benchmarks) / sizeof(_benchmarks[0]);
+         b++) {
+        const benchmark_t *bench = &_benchmarks[b];
+        sample_t best = { .ns = UINT64_MAX };
+        size_t items = 0;
+
+        if (!_selected(bench->name)) {
+            continue;
+        }
+        bench->setup(_args.items);
+        if (!_buf) {
+            fprintf(stderr, "Out of memory\n");
+            return EXIT_FAILURE;
+        }
+        for (unsigned r = 0; r < _args.repeat; r++) {
+            sample_t sample = { 0 };
+            if (_args.counters) {
+                _counters_start(&counters);
+            }
+            uint64_t start = _now();
+            items = bench->run(_args.items);
+            sample.ns = _now() - start;
+            if (_args.counters) {
+                _counters_stop(&counters, &sample);
+            }
+            if (sample.ns < best.ns) {
+                best = sample;
+            }
+        }
+        _report(bench, &best, items);
+    }
+
+    if (_args.counters) {
+        _counters_close(&counters);
+    }
+    free(_buf);
+    free(_nodes);
+    return EXIT_SUCCESS;
+}
+
+/* NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers) */
@@ -0,0 +1,195 @@
+#!/usr/bin/env python3
+import argparse
+import base64
+import json
+import math
+import os
+import os.path
+import sys
+
+TEST_SKIPPED = [
+        "c249010000000000000000", # Bignum
+        "3bffffffffffffffff", # negative max, can't represent in int64_t
+        "c349010000000000000000", # Negative bignum
+        "5f42010243030405ff", # Indefinite length byte string
+        "7f657374726561646d696e67ff", # Indefinite length text string
+        "f7", # Undefined, decoded as None
+        "f0", # Simple values
+        "f818",
+        "f8ff",
+        ]
+
+ROUNDTRIP_SKIPPED = [
+        "f90001", # Subnormal half float, encoded as single precision
+        ]
+
+
+def diagnostic(item):
+    """Render a decoded item in the diagnostic notation of the vectors"""
+    import nanocbor
+    if isinstance(item, nanocbor.Tag):
+        return f"{item.tag}({diagnostic(item.value)})"
+    if isinstance(item, (bytes, memoryview)):
+        return f"h'{bytes(item).hex()}'"
+    if isinstance(item, float):
+        if math.isnan(item):
+            return "NaN"
+        if math.isinf(item):
+            return "Infinity" if item > 0 else "-Infinity"
+    if isinstance(item, dict):
+        return "{" + ", ".join(f"{diagnostic(k)}: {diagnostic(v)}"
+                               for k, v in item.items()) + "}"
+    return json.dumps(item, ensure_ascii=False)
+
+
+def test_file(vector_file, nanocbor):
+    failures = 0
+    with open(vector_file, 'r') as f:
+        appendix = json.load(f)
+    for test_case in appendix:
+        if test_case['hex'] in TEST_SKIPPED:
+            continue
+        test_input = base64.b64decode(test_case["cbor"])
+        try:
+            decoded = nanocbor.loads(test_input)
+            if "decoded" in test_case:
+                assert decoded == test_case["decoded"], decoded
+            else:
+                assert diagnostic(decoded) == test_case["diagnostic"], \
+                        diagnostic(decoded)
+            zero_copy = nanocbor.loads(test_input, zero_copy=True)
+            assert diagnostic(zero_copy) == diagnostic(decoded)
+            if test_case["roundtrip"] and \
+                    test_case['hex'] not in ROUNDTRIP_SKIPPED:
+                assert nanocbor.dumps(decoded) == test_input, \
+                        nanocbor.dumps(decoded).hex()
+        except (AssertionError, ValueError) as e:
+            print(f"input {test_case['hex']} failed: {e!r}")
+            failures += 1
+    return failures
+
+
+def expect_error(error, func, *args):
+    try:
+        func(*args)
+    except error:
+        return
+    raise AssertionError(f"{func.__name__}{args!r} did not raise "
+                         f"{error.__name__}")
+
+
+def test_loads_array(nanocbor):
+    ints = nanocbor.loads_array(bytes.fromhex("83010220"))
+    assert ints.format == 'q' and ints.tolist() == [1, 2, -1], ints.tolist()
+    floats = nanocbor.loads_array(bytes.fromhex("82f93e00fb400c000000000000"),
+                                  'd')
+    assert floats.format == 'd' and floats.tolist() == [1.5, 3.5], \
+            floats.tolist()
+    assert nanocbor.loads_array(b"\x80").tolist() == []
+    assert nanocbor.loads_array(b"\x80", typecode='d').tolist() == []
+    # Delta encoded [100, 101, 103], definite and indefinite length
+    delta = nanocbor.loads_array(bytes.fromhex("d9de1a8318640102"))
+    assert delta.tolist() == [100, 101, 103], delta.tolist()
+    delta = nanocbor.loads_array(bytes.fromhex("d9de1a9f18640102ff"))
+    assert delta.tolist() == [100, 101, 103], delta.tolist()
+    assert nanocbor.loads_array(bytes.fromhex("9f0102ff")).tolist() == [1, 2]
+    assert nanocbor.loads_array(bytes.fromhex("9ff93c00f93e00ff"),
+                                'd').tolist() == [1.0, 1.5]
+
+    # Truncated, not an array, non-numeric items and an unknown tag
+    for data in ["8201", "", "01", "9f01", "826161", "c18101", "d9de1a8161"]:
+        expect_error(nanocbor.DecodeError, nanocbor.loads_array,
+                     bytes.fromhex(data))
+    expect_error(nanocbor.DecodeError, nanocbor.loads_array,
+                 bytes.fromhex("8261610102"), 'd')
+    expect_error(ValueError, nanocbor.loads_array, b"\x80", 'i')
+
+
+def test_seq(nanocbor):
+    items = [1, "a", [2, {"b": None}], b"\x00", 1.5]
+    encoded = nanocbor.dumps_seq(items)
+    assert encoded == b"".join(nanocbor.dumps(item) for item in items), \
+            encoded.hex()
+    assert nanocbor.loads_seq(encoded) == items
+    assert nanocbor.dumps_seq(iter(items)) == encoded
+    assert nanocbor.dumps_seq([]) == b""
+    assert nanocbor.loads_seq(b"") == []
+    # Truncated second item
+    expect_error(nanocbor.DecodeError, nanocbor.loads_seq,
+                 bytes.fromhex("0182"))
+    expect_error(TypeError, nanocbor.dumps_seq, 1)
+    expect_error(TypeError, nanocbor.dumps_seq, [1, object()])
+
+
+def test_dumps_buffer(nanocbor):
+    import array
+    assert nanocbor.dumps(array.array('q', [1, -2, 1000])) == \
+            bytes.fromhex("8301211903e8")
+    assert nanocbor.dumps(array.array('i', [1, -2])) == bytes.fromhex("820121")
+    assert nanocbor.dumps(array.array('H', [5, 65535])) == \
+            bytes.fromhex("820519ffff")
+    assert nanocbor.dumps(array.array('d', [1.5, -2.0])) == \
+            bytes.fromhex("82f93e00f9c000")
+    assert nanocbor.dumps(array.array('f', [0.5])) == bytes.fromhex("81f93800")
+    assert nanocbor.dumps(memoryview(array.array('h', [5, -6]))) == \
+            bytes.fromhex("820525")
+    # Byte buffers stay byte strings
+    assert nanocbor.dumps(memoryview(b"ab")) == bytes.fromhex("426162")
+    assert nanocbor.dumps(array.array('B', [1, 2])) == bytes.fromhex("420102")
+    assert nanocbor.dumps(bytearray(b"ab")) == bytes.fromhex("426162")
+    assert nanocbor.loads_array(
+            nanocbor.dumps(array.array('q', [7, -8]))).tolist() == [7, -8]
+    expect_error(TypeError, nanocbor.dumps, array.array('u', "ab"))
+
+
+def test_zero_copy(nanocbor):
+    # [h'0102', h'03']
+    data = bytearray(bytes.fromhex("824201024103"))
+    items = nanocbor.loads(data, zero_copy=True)
+    assert all(isinstance(item, memoryview) for item in items)
+    assert [bytes(item) for item in items] == [b"\x01\x02", b"\x03"]
+    # The slices keep the input exported and see changes to it
+    expect_error(BufferError, data.append, 0)
+    data[2] = 0x05
+    assert bytes(items[0]) == b"\x05\x02"
+    del items
+    data.append(0)
+
+    copied = nanocbor.loads(bytes.fromhex("824201024103"))
+    assert copied == [b"\x01\x02", b"\x03"], copied
+    seq = nanocbor.loads_seq(bytes.fromhex("42010241ff"), zero_copy=True)
+    assert [bytes(item) for item in seq] == [b"\x01\x02", b"\xff"]
+
+
+def test_bulk(nanocbor):
+    failures = 0
+    for test in [test_loads_array, test_seq, test_dumps_buffer,
+                 test_zero_copy]:
+        try:
+            test(nanocbor)
+        except Exception as e:
+            print(f"{test.__name__} failed: {e!r}")
+            failures += 1
+    return failures
+
+
+def main(script_dir):
+    import nanocbor
+    failures = 0
+    for vector_file in sorted(os.scandir(script_dir), key=lambda f: f.name):
+        if vector_file.name.endswith('.json') and vector_file.is_file():
+            failures += test_file(vector_file, nanocbor)
+    failures += test_bulk(nanocbor)
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(
+            description='RFC test vectors and bulk API tests for the nanocbor '
+                        'Python module')
+    parser.add_argument('module_dir', type=str,
+                        help='Directory containing the nanocbor module')
+    args = parser.parse_args()
+    sys.path.insert(0, args.module_dir)
+    script_dir = os.path.dirname(os.path.realpath(__file__))
+    sys.exit(main(script_dir))